@@ -152,6 +152,23 @@ namespace ml {
 			setVoxel(v.x, v.y, v.z);
 		}
 
+		//! setVoxel that may be called concurrently from several OpenMP threads (the word is updated atomically)
+		inline void setVoxelAtomic(size_t x, size_t y, size_t z) {
+			const size_t linIdx = m_dimX*m_dimY*z + m_dimX*y + x;
+			orWordAtomic(linIdx / bitsPerUInt, 1u << (linIdx % bitsPerUInt));
+		}
+
+		//! sets the voxels [x0, x1) of the row (y, z); may be called concurrently (the words are updated atomically)
+		void setVoxelsInRowAtomic(size_t x0, size_t x1, size_t y, size_t z) {
+			const size_t rowStart = (z*m_dimY + y)*m_dimX;
+			for (size_t i = rowStart + x0, end = rowStart + x1; i < end; ) {
+				const size_t word = i / bitsPerUInt, lo = i % bitsPerUInt;
+				const size_t hi = std::min<size_t>(bitsPerUInt, lo + (end - i));
+				orWordAtomic(word, rangeMask(lo, hi));
+				i += hi - lo;
+			}
+		}
+
 		inline void clearVoxel(size_t x, size_t y, size_t z) {
 			size_t linIdx = m_dimX*m_dimY*z + m_dimX*y + x;
 			size_t baseIdx = linIdx / bitsPerUInt;
@@ -229,6 +246,143 @@ namespace ml {
 			return numOccupiedEntries;
 		}
 
+		//! number of set voxels in each z-slice
+		std::vector<size_t> getNumOccupiedEntriesPerSlice() const {
+			std::vector<size_t> counts(m_dimZ, 0);
+			const size_t sliceSize = m_dimX*m_dimY;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int z = 0; z < (int)m_dimZ; z++) {
+				counts[z] = countBits(sliceSize*z, sliceSize*(z + 1));
+			}
+			return counts;
+		}
+
+		//! dilation with the 6-neighborhood, 32 voxels at a time; voxels outside the grid are unset
+		void dilate(unsigned int iterations = 1) {
+			for (unsigned int i = 0; i < iterations; i++) morphologyStep(true, false);
+		}
+
+		//! erosion with the 6-neighborhood; outsideIsSet: voxels outside the grid count as set, so the grid border does not erode
+		void erode(unsigned int iterations = 1, bool outsideIsSet = false) {
+			for (unsigned int i = 0; i < iterations; i++) morphologyStep(false, outsideIsSet);
+		}
+
+		//! removes structures thinner than the structuring element
+		void open(unsigned int iterations = 1) {
+			erode(iterations);
+			dilate(iterations);
+		}
+
+		//! fills gaps thinner than the structuring element; the outside counts as set when eroding, so no voxel is cleared
+		void close(unsigned int iterations = 1) {
+			dilate(iterations);
+			erode(iterations, true);
+		}
+
+		inline BinaryGrid3& operator&=(const BinaryGrid3& other) {
+			checkDimensions(other);
+			const int numUInts = (int)getNumUInts();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < numUInts; i++) {
+				m_data[i] &= other.m_data[i];
+			}
+			return *this;
+		}
+
+		inline BinaryGrid3& operator|=(const BinaryGrid3& other) {
+			checkDimensions(other);
+			const int numUInts = (int)getNumUInts();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < numUInts; i++) {
+				m_data[i] |= other.m_data[i];
+			}
+			return *this;
+		}
+
+		inline BinaryGrid3& operator^=(const BinaryGrid3& other) {
+			checkDimensions(other);
+			const int numUInts = (int)getNumUInts();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < numUInts; i++) {
+				m_data[i] ^= other.m_data[i];
+			}
+			return *this;
+		}
+
+		//! toggles all voxels
+		inline void invert() {
+			const int numUInts = (int)getNumUInts();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < numUInts; i++) {
+				m_data[i] = ~m_data[i];
+			}
+			clearPadding();
+		}
+
+		//! sets all unset voxels 6-connected to the seed (scanline fill; runs are found and set word-wise); returns the number of voxels set
+		size_t floodFill(size_t x, size_t y, size_t z) {
+			if (!isValidCoordinate(x, y, z) || isVoxelSet(x, y, z)) return 0;
+			size_t numFilled = 0;
+			std::vector<vec3ul> stack(1, vec3ul(x, y, z));
+			while (!stack.empty()) {
+				const vec3ul seed = stack.back();
+				stack.pop_back();
+				const size_t rowStart = (m_dimY*seed.z + seed.y)*m_dimX;
+				if (isBitSet(rowStart + seed.x)) continue;
+
+				size_t left = rowStart;
+				if (findLast(rowStart, rowStart + seed.x, true, left)) left++;
+				const size_t right = findNext(rowStart + seed.x, rowStart + m_dimX, true);
+				setBits(left, right);
+				numFilled += right - left;
+
+				//one seed per run of unset voxels in the neighboring rows
+				for (int n = 0; n < 4; n++) {
+					vec3ul neighbor = seed;
+					if (n == 0) { if (seed.y == 0) continue; neighbor.y--; }
+					if (n == 1) { if (seed.y + 1 == m_dimY) continue; neighbor.y++; }
+					if (n == 2) { if (seed.z == 0) continue; neighbor.z--; }
+					if (n == 3) { if (seed.z + 1 == m_dimZ) continue; neighbor.z++; }
+					const size_t neighborStart = (m_dimY*neighbor.z + neighbor.y)*m_dimX;
+					const size_t end = neighborStart + (right - rowStart);
+					for (size_t i = findNext(neighborStart + (left - rowStart), end, false); i < end; i = findNext(findNext(i, end, true), end, false)) {
+						stack.push_back(vec3ul(i - neighborStart, neighbor.y, neighbor.z));
+					}
+				}
+			}
+			return numFilled;
+		}
+
+		size_t floodFill(const vec3ul& seed) {
+			return floodFill(seed.x, seed.y, seed.z);
+		}
+
+		//! calls f(x) for every set voxel of the row (y, z) in increasing x; scans whole words and skips empty ones
+		template<class Function>
+		void forEachSetVoxelInRow(size_t y, size_t z, Function f) const {
+			const size_t rowStart = (z*m_dimY + y)*m_dimX, rowEnd = rowStart + m_dimX;
+			for (size_t i = rowStart; i < rowEnd; ) {
+				const size_t word = i / bitsPerUInt, lo = i % bitsPerUInt;
+				const size_t hi = std::min<size_t>(bitsPerUInt, lo + (rowEnd - i));
+				unsigned int bits = m_data[word] & rangeMask(lo, hi);
+				while (bits != 0) {
+					f(word*bitsPerUInt + math::lowestSetBit(bits) - rowStart);
+					bits &= bits - 1;
+				}
+				i += hi - lo;
+			}
+		}
+
 		inline const unsigned int* getData() const {
 			return m_data;
 		}
@@ -291,6 +445,158 @@ namespace ml {
 		}
 #endif
 
+		//! bits [lo, hi) of a word
+		static unsigned int rangeMask(size_t lo, size_t hi) {
+			return (hi - lo == bitsPerUInt) ? ~0u : (((1u << (hi - lo)) - 1) << lo);
+		}
+
+		//! bit 0 is at position phase within the period; selects the bits whose position within the period is in [begin, begin + length)
+		static unsigned int periodicMask(size_t phase, size_t period, size_t begin, size_t length) {
+			ptrdiff_t start = (ptrdiff_t)begin - (ptrdiff_t)phase;
+			if (start > 0) start -= (ptrdiff_t)period;
+			unsigned int mask = 0;
+			for (; start < (ptrdiff_t)bitsPerUInt; start += (ptrdiff_t)period) {
+				const ptrdiff_t lo = std::max<ptrdiff_t>(start, 0), hi = std::min<ptrdiff_t>(start + (ptrdiff_t)length, bitsPerUInt);
+				if (lo < hi) mask |= rangeMask(lo, hi);
+			}
+			return mask;
+		}
+
+		//! position within the period of the bit one word further
+		static size_t advancePhase(size_t phase, size_t period) {
+			phase += bitsPerUInt;
+			if (phase < period) return phase;
+			return (phase - period < period) ? phase - period : phase % period;
+		}
+
+		inline unsigned int getUInt(ptrdiff_t i) const {
+			return (i < 0 || i >= (ptrdiff_t)getNumUInts()) ? 0 : m_data[i];
+		}
+
+		//! word i of the voxel bits shifted by shift positions (bit b holds voxel i*32 + b - shift)
+		inline unsigned int getShiftedUInt(ptrdiff_t i, ptrdiff_t shift) const {
+			const ptrdiff_t source = i * (ptrdiff_t)bitsPerUInt - shift;
+			const ptrdiff_t q = (source >= 0) ? source / (ptrdiff_t)bitsPerUInt : -((-source + (ptrdiff_t)bitsPerUInt - 1) / (ptrdiff_t)bitsPerUInt);
+			const ptrdiff_t r = source - q * (ptrdiff_t)bitsPerUInt;
+			if (r == 0) return getUInt(q);
+			return (getUInt(q) >> r) | (getUInt(q + 1) << (bitsPerUInt - r));
+		}
+
+		//! one dilation or erosion step: the six neighbors of 32 voxels are gathered with shifts of the bit array, and the
+		//! neighbors that wrap around a row or slice are masked out
+		void morphologyStep(bool dilation, bool outsideIsSet) {
+			if (m_data == nullptr) return;
+			const size_t numUInts = getNumUInts();
+			const size_t sliceSize = m_dimX*m_dimY, numElements = getNumElements();
+			const ptrdiff_t shift[6] = { 1, -1, (ptrdiff_t)m_dimX, -(ptrdiff_t)m_dimX, (ptrdiff_t)sliceSize, -(ptrdiff_t)sliceSize };
+			unsigned int* result = new unsigned int[numUInts];
+
+			//the positions within the row and slice are advanced word by word inside a chunk
+			const size_t chunkSize = 1024;
+			const int numChunks = (int)((numUInts + chunkSize - 1) / chunkSize);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int c = 0; c < numChunks; c++) {
+				size_t first = c * chunkSize * bitsPerUInt;
+				size_t phaseX = first % m_dimX, phaseXY = first % sliceSize;
+				for (size_t i = c * chunkSize; i < std::min(numUInts, (c + 1) * chunkSize); i++) {
+					const unsigned int border[6] = {
+						periodicMask(phaseX, m_dimX, 0, 1), periodicMask(phaseX, m_dimX, m_dimX - 1, 1),
+						periodicMask(phaseXY, sliceSize, 0, m_dimX), periodicMask(phaseXY, sliceSize, sliceSize - m_dimX, m_dimX),
+						first < sliceSize ? periodicMask(first, numElements, 0, sliceSize) : 0,
+						first + bitsPerUInt > numElements - sliceSize ? periodicMask(first, numElements, numElements - sliceSize, sliceSize) : 0
+					};
+
+					unsigned int value = m_data[i];
+					for (int n = 0; n < 6; n++) {
+						const unsigned int neighbors = getShiftedUInt(i, shift[n]) & ~border[n];
+						if (dilation)	value |= neighbors;
+						else			value &= outsideIsSet ? (neighbors | border[n]) : neighbors;
+					}
+					result[i] = value;
+
+					first += bitsPerUInt;
+					phaseX = advancePhase(phaseX, m_dimX);
+					phaseXY = advancePhase(phaseXY, sliceSize);
+				}
+			}
+			SAFE_DELETE_ARRAY(m_data);
+			m_data = result;
+			clearPadding();
+		}
+
+		//! keeps the bits behind the last voxel zero
+		inline void clearPadding() {
+			const size_t numUsedBits = getNumElements() % bitsPerUInt;
+			if (m_data != nullptr && numUsedBits != 0) m_data[getNumUInts() - 1] &= rangeMask(0, numUsedBits);
+		}
+
+		inline void checkDimensions(const BinaryGrid3& other) const {
+			if (m_dimX != other.m_dimX || m_dimY != other.m_dimY || m_dimZ != other.m_dimZ) throw MLIB_EXCEPTION("grid dimensions do not match");
+		}
+
+		inline void orWordAtomic(size_t word, unsigned int bits) {
+			unsigned int* w = m_data + word;
+#ifdef MLIB_OPENMP
+#pragma omp atomic
+#endif
+			*w |= bits;
+		}
+
+		inline bool isBitSet(size_t i) const {
+			return ((m_data[i / bitsPerUInt] >> (i % bitsPerUInt)) & 1) != 0;
+		}
+
+		//! number of set bits in [begin, end)
+		size_t countBits(size_t begin, size_t end) const {
+			size_t count = 0;
+			for (size_t i = begin; i < end; ) {
+				const size_t word = i / bitsPerUInt, lo = i % bitsPerUInt;
+				const size_t hi = std::min<size_t>(bitsPerUInt, lo + (end - i));
+				count += math::numberOfSetBits(m_data[word] & rangeMask(lo, hi));
+				i += hi - lo;
+			}
+			return count;
+		}
+
+		//! first bit in [begin, end) with the given value; end if there is none
+		size_t findNext(size_t begin, size_t end, bool value) const {
+			for (size_t i = begin; i < end; ) {
+				const size_t word = i / bitsPerUInt;
+				const unsigned int bits = (value ? m_data[word] : ~m_data[word]) & rangeMask(i % bitsPerUInt, bitsPerUInt);
+				if (bits != 0) return std::min(word*bitsPerUInt + math::lowestSetBit(bits), end);
+				i = (word + 1)*bitsPerUInt;
+			}
+			return end;
+		}
+
+		//! last bit in [begin, end) with the given value
+		bool findLast(size_t begin, size_t end, bool value, size_t& index) const {
+			for (size_t i = end; i > begin; ) {
+				const size_t word = (i - 1) / bitsPerUInt;
+				const unsigned int bits = (value ? m_data[word] : ~m_data[word]) & rangeMask(0, (i - 1) % bitsPerUInt + 1);
+				if (bits != 0) {
+					const size_t last = word*bitsPerUInt + math::highestSetBit(bits);
+					if (last < begin) return false;
+					index = last;
+					return true;
+				}
+				i = word*bitsPerUInt;
+			}
+			return false;
+		}
+
+		//! sets the bits [begin, end)
+		void setBits(size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ) {
+				const size_t word = i / bitsPerUInt, lo = i % bitsPerUInt;
+				const size_t hi = std::min<size_t>(bitsPerUInt, lo + (end - i));
+				m_data[word] |= rangeMask(lo, hi);
+				i += hi - lo;
+			}
+		}
+
 		inline size_t getNumUInts() const {
 			size_t numEntries = getNumElements();
 			return (numEntries + bitsPerUInt - 1) / bitsPerUInt;
@@ -301,6 +607,27 @@ namespace ml {
 		unsigned int*	m_data;
 	};
 
+	inline BinaryGrid3 operator&(const BinaryGrid3& a, const BinaryGrid3& b) {
+		BinaryGrid3 result(a);
+		result &= b;
+		return result;
+	}
+	inline BinaryGrid3 operator|(const BinaryGrid3& a, const BinaryGrid3& b) {
+		BinaryGrid3 result(a);
+		result |= b;
+		return result;
+	}
+	inline BinaryGrid3 operator^(const BinaryGrid3& a, const BinaryGrid3& b) {
+		BinaryGrid3 result(a);
+		result ^= b;
+		return result;
+	}
+	inline BinaryGrid3 operator~(const BinaryGrid3& a) {
+		BinaryGrid3 result(a);
+		result.invert();
+		return result;
+	}
+
 	//! writes to a stream
 	inline std::ostream& operator<<(std::ostream& s, const BinaryGrid3& g)
 	{
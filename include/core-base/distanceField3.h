@@ -9,9 +9,9 @@ namespace ml {
 	class DistanceField3 : public Grid3 < FloatType > {
 	public:
 
-		DistanceField3() {}
-		DistanceField3(size_t dimX, size_t dimY, size_t dimZ) : Grid3<FloatType>(dimX, dimY, dimZ) {}
-		DistanceField3(const vec3ul& dim) : Grid3<FloatType>(dim.x, dim.y, dim.z) {}
+		DistanceField3() : m_numZeroVoxels(0), m_truncation(std::numeric_limits<FloatType>::infinity()) {}
+		DistanceField3(size_t dimX, size_t dimY, size_t dimZ) : Grid3<FloatType>(dimX, dimY, dimZ), m_numZeroVoxels(0), m_truncation(std::numeric_limits<FloatType>::infinity()) {}
+		DistanceField3(const vec3ul& dim) : Grid3<FloatType>(dim.x, dim.y, dim.z), m_numZeroVoxels(0), m_truncation(std::numeric_limits<FloatType>::infinity()) {}
 		DistanceField3(const BinaryGrid3& grid, FloatType trunc = std::numeric_limits<FloatType>::infinity()) : Grid3<FloatType>(grid.getDimX(), grid.getDimY(), grid.getDimZ())
 		{
 			generateFromBinaryGrid(grid, trunc);
@@ -38,16 +38,54 @@ namespace ml {
 		}
 
 		void generateFromBinaryGrid(const BinaryGrid3& grid, FloatType trunc = std::numeric_limits<FloatType>::infinity()) {
-			this->allocate(grid.getDimX(), grid.getDimY(), grid.getDimZ());
+			generateFromBinaryGridExact(grid, trunc);
+		}
 
+		//! exact Euclidean distance (in voxels) to the closest set voxel; separable transform along x, y and z (Felzenszwalb and
+		//! Huttenlocher), linear in the number of voxels and parallel over the grid lines. Distances above the truncation are
+		//! set to infinity (-infinity inside), which the evaluation functions skip. In signed mode, set voxels receive the
+		//! negative distance to the closest unset voxel.
+		void generateFromBinaryGridExact(const BinaryGrid3& grid, FloatType trunc = std::numeric_limits<FloatType>::infinity(), bool signedDistance = false) {
 			m_truncation = trunc;
+			if (grid.getNumElements() == 0) {
+				//allocate keeps the previous dimensions for an empty size, so the field is reset instead
+				Grid3<FloatType>::operator=(Grid3<FloatType>());
+				m_numZeroVoxels = 0;
+				return;
+			}
+			this->allocate(grid.getDimX(), grid.getDimY(), grid.getDimZ());
+
+			squaredDistanceTransform(grid, true, this->getData());
+			FloatType* data = this->getData();
+			const int n = (int)this->getNumElements();
+			m_numZeroVoxels = 0;
+			for (int i = 0; i < n; i++) {
+				if (data[i] == (FloatType)0) m_numZeroVoxels++;
+			}
+
+			if (signedDistance) {
+				std::vector<FloatType> inside(this->getNumElements());
+				squaredDistanceTransform(grid, false, inside.data());
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+				for (int i = 0; i < n; i++) {
+					if (data[i] == (FloatType)0) data[i] = -inside[i];
+				}
+			}
 
-			//the simple variant appears to be much faster
-			generateFromBinaryGridSimple(grid, trunc);
-			//generateFromBinaryGridQueue(grid);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < n; i++) {
+				const FloatType d = data[i] < (FloatType)0 ? -std::sqrt(-data[i]) : std::sqrt(data[i]);
+				if (std::abs(d) > trunc)	data[i] = d < (FloatType)0 ? -std::numeric_limits<FloatType>::infinity() : std::numeric_limits<FloatType>::infinity();
+				else						data[i] = d;
+			}
 		}
 
-		//! computes the distance when projecting all grid points into the distance field (returns distance and valid comparisons)
+		//! computes the distance when projecting all grid points into the distance field (returns distance and valid comparisons);
+		//! voxels at or beyond the truncation are skipped, and the absolute values of signed distances are summed
 		std::pair<FloatType, size_t> evalDist(const BinaryGrid3& grid, const Matrix4x4<FloatType>& gridToDF, bool squaredSum = false) const {
 
 			FloatType dist = (FloatType)0;
@@ -72,11 +110,11 @@ namespace ml {
 
 			for (size_t z = bbBox.getMinZ(); z < bbBox.getMaxZ(); z++) {
 				for (size_t y = bbBox.getMinY(); y < bbBox.getMaxY(); y++) {
-					for (size_t x = bbBox.getMinZ(); x < bbBox.getMaxX(); x++) {
+					for (size_t x = bbBox.getMinX(); x < bbBox.getMaxX(); x++) {
 						vec3<FloatType> p = gridToDF * vec3<FloatType>((FloatType)x, (FloatType)y, (FloatType)z);
 						vec3ul pi(math::round(p));
 						if (this->isValidCoordinate(pi.x, pi.y, pi.z)) {
-							const FloatType& d = (*this)(pi.x, pi.y, pi.z);
+							const FloatType d = std::abs((*this)(pi.x, pi.y, pi.z));
 							if (d < m_truncation) {
 								if (squaredSum) {
 									dist += d*d;
@@ -94,6 +132,47 @@ namespace ml {
 			return std::make_pair(dist, numComparisons);
 		}
 
+		//! projects the set voxels of grid into the distance field (nearest voxel; gridToDF must be affine) and returns the sum of their
+		//! absolute distances and the number of voxels that hit the field below the truncation. Rows are bit-scanned and transformed incrementally;
+		//! the slices are evaluated in parallel and summed in order, so the result does not depend on the number of threads.
+		std::pair<FloatType, size_t> evalDistOfSetVoxels(const BinaryGrid3& grid, const Matrix4x4<FloatType>& gridToDF, bool squaredSum = false) const {
+			const int dimZ = (int)grid.getDimZ();
+			std::vector<std::pair<FloatType, size_t>> slices(dimZ);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int z = 0; z < dimZ; z++) {
+				slices[z] = evalDistOfSlice(grid, gridToDF, z, squaredSum);
+			}
+			return sumSlices(slices.data(), dimZ);
+		}
+
+		//! evaluates evalDistOfSetVoxels for many candidate transforms (e.g., in a pose search) in parallel over the transforms
+		std::vector<std::pair<FloatType, size_t>> evalDistOfSetVoxels(const BinaryGrid3& grid, const std::vector<Matrix4x4<FloatType>>& gridToDF, bool squaredSum = false) const {
+			const int numTransforms = (int)gridToDF.size();
+			std::vector<std::pair<FloatType, size_t>> result(numTransforms);
+			if (numTransforms == 1) {
+				result[0] = evalDistOfSetVoxels(grid, gridToDF[0], squaredSum);
+				return result;
+			}
+#ifdef MLIB_OPENMP
+#pragma omp parallel
+#endif
+			{
+				std::vector<std::pair<FloatType, size_t>> slices(grid.getDimZ());
+#ifdef MLIB_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+				for (int i = 0; i < numTransforms; i++) {
+					for (size_t z = 0; z < grid.getDimZ(); z++) {
+						slices[z] = evalDistOfSlice(grid, gridToDF[i], z, squaredSum);
+					}
+					result[i] = sumSlices(slices.data(), slices.size());
+				}
+			}
+			return result;
+		}
+
 		size_t getNumZeroVoxels() const {
 			return m_numZeroVoxels;
 		}
@@ -183,14 +262,16 @@ namespace ml {
 			return upsample(vec3ul(this->getDimX() * 2, this->getDimY() * 2, this->getDimZ() * 2));
 		}
 
+		//! updateValues clamps the distances to [-truncation, truncation]
 		void setTruncation(float truncation, bool updateValues = true) {
 			m_truncation = truncation;
 			if (updateValues) {
-				for (unsigned int z = 0; z < m_dimZ; z++) {
-					for (unsigned int y = 0; y < m_dimY; y++) {
-						for (unsigned int x = 0; x < m_dimX; x++) {
+				for (size_t z = 0; z < this->getDimZ(); z++) {
+					for (size_t y = 0; y < this->getDimY(); y++) {
+						for (size_t x = 0; x < this->getDimX(); x++) {
 							float v = (*this)(x, y, z);
 							if (v > truncation) (*this)(x, y, z) = truncation;
+							else if (v < -truncation) (*this)(x, y, z) = -truncation;
 						} //x
 					} //y
 				} //z
@@ -199,147 +280,113 @@ namespace ml {
 
 	private:
 
-		void generateFromBinaryGridSimple(const BinaryGrid3& grid, FloatType trunc) {
-
-			FloatType kernel[3][3][3];
-			for (int k = -1; k <= 1; k++) {
-				for (int j = -1; j <= 1; j++) {
-					for (int i = -1; i <= 1; i++) {
-						FloatType d = vec3<FloatType>((FloatType)k, (FloatType)j, (FloatType)i).length();
-						kernel[k + 1][j + 1][i + 1] = d;
-					}
-				}
-			}
+		std::pair<FloatType, size_t> evalDistOfSlice(const BinaryGrid3& grid, const Matrix4x4<FloatType>& gridToDF, size_t z, bool squaredSum) const {
+			const vec3<FloatType> stepX(gridToDF(0, 0), gridToDF(1, 0), gridToDF(2, 0));
+			const vec3<FloatType> stepY(gridToDF(0, 1), gridToDF(1, 1), gridToDF(2, 1));
+			const FloatType dimX = (FloatType)this->getDimX(), dimY = (FloatType)this->getDimY(), dimZ = (FloatType)this->getDimZ();
+			const FloatType* data = this->getData();
 
-			//initialize with grid distances
-			m_numZeroVoxels = 0;
-			for (size_t z = 0; z < grid.getDimZ(); z++) {
-				for (size_t y = 0; y < grid.getDimY(); y++) {
-					for (size_t x = 0; x < grid.getDimX(); x++) {
-						if (grid.isVoxelSet(x, y, z)) {
-							(*this)(x, y, z) = (FloatType)0;
-							m_numZeroVoxels++;
-						}
-						else {
-							(*this)(x, y, z) = std::numeric_limits<FloatType>::infinity();
+			//shifted by half a voxel, so that truncating to an index rounds to the nearest voxel
+			vec3<FloatType> rowStart = gridToDF.transformAffine(vec3<FloatType>((FloatType)0, (FloatType)0, (FloatType)z)) + (FloatType)0.5;
+			FloatType dist = (FloatType)0;
+			size_t numComparisons = 0;
+			for (size_t y = 0; y < grid.getDimY(); y++, rowStart += stepY) {
+				grid.forEachSetVoxelInRow(y, z, [&](size_t x) {
+					const vec3<FloatType> p = rowStart + stepX * (FloatType)x;
+					if (p.x >= (FloatType)0 && p.x < dimX && p.y >= (FloatType)0 && p.y < dimY && p.z >= (FloatType)0 && p.z < dimZ) {
+						const FloatType d = std::abs(data[((size_t)p.z * this->getDimY() + (size_t)p.y) * this->getDimX() + (size_t)p.x]);
+						if (d < m_truncation) {
+							dist += squaredSum ? d*d : d;
+							numComparisons++;
 						}
 					}
-				}
+				});
 			}
+			return std::make_pair(dist, numComparisons);
+		}
 
-			bool found = true;
-			while (found) {
-				found = false;
-				for (size_t z = 0; z < this->getDimZ(); z++) {
-					for (size_t y = 0; y < this->getDimY(); y++) {
-						for (size_t x = 0; x < this->getDimX(); x++) {
-
-							FloatType dMin = (*this)(x, y, z);
-							for (int k = -1; k <= 1; k++) {
-								for (int j = -1; j <= 1; j++) {
-									for (int i = -1; i <= 1; i++) {
-										vec3ul n(x + i, y + j, z + k);
-										if (this->isValidCoordinate(n.x, n.y, n.z)) {
-											FloatType dCurr = (*this)(n.x, n.y, n.z) + kernel[i + 1][j + 1][k + 1];
-											if (dCurr < dMin && dCurr <= trunc) {
-												dMin = dCurr;
-												found = true;
-											}
-										}
-									}
-								}
-							}
-							(*this)(x, y, z) = dMin;
-						}
-					}
-				}
+		static std::pair<FloatType, size_t> sumSlices(const std::pair<FloatType, size_t>* slices, size_t numSlices) {
+			std::pair<FloatType, size_t> result((FloatType)0, 0);
+			for (size_t i = 0; i < numSlices; i++) {
+				result.first += slices[i].first;
+				result.second += slices[i].second;
 			}
-
+			return result;
 		}
 
-		void generateFromBinaryGridQueue(const BinaryGrid3& grid) {
-
-			BinaryGrid3 visited(grid.getDimensions());
-
-			//initialize with grid distances
-			m_numZeroVoxels = 0;
-			for (size_t z = 0; z < grid.getDimZ(); z++) {
-				for (size_t y = 0; y < grid.getDimY(); y++) {
-					for (size_t x = 0; x < grid.getDimX(); x++) {
-						if (grid.isVoxelSet(x, y, z)) {
-							(*this)(x, y, z) = (FloatType)0;
-							visited.setVoxel(x, y, z);
-							m_numZeroVoxels++;
-						}
-						else {
-							(*this)(x, y, z) = std::numeric_limits<FloatType>::infinity();
-						}
+		//! squared distance of every voxel to the closest voxel with isVoxelSet == target
+		void squaredDistanceTransform(const BinaryGrid3& grid, bool target, FloatType* result) const {
+			const size_t dimX = grid.getDimX(), dimY = grid.getDimY(), dimZ = grid.getDimZ();
+			const FloatType inf = std::numeric_limits<FloatType>::infinity();
+
+			const int numZ = (int)dimZ;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int z = 0; z < numZ; z++) {
+				for (size_t y = 0; y < dimY; y++) {
+					for (size_t x = 0; x < dimX; x++) {
+						result[(z * dimY + y) * dimX + x] = grid.isVoxelSet(x, y, z) == target ? (FloatType)0 : inf;
 					}
 				}
 			}
 
-			//initialize priority queue
-			struct Voxel {
-				Voxel(size_t _x, size_t _y, size_t _z, FloatType _d) : x(_x), y(_y), z(_z), dist(_d) {}
-
-				bool operator<(const Voxel& other) const {
-					return dist < other.dist;	//need to have the smallest one at 'top'; so it's inverted
-				}
-
-				size_t x, y, z;
-				FloatType dist;
-			};
-			std::priority_queue<Voxel> queue;
-			for (size_t z = 0; z < this->getDimZ(); z++) {
-				for (size_t y = 0; y < this->getDimY(); y++) {
-					for (size_t x = 0; x < this->getDimX(); x++) {
-						if (!grid.isVoxelSet(x, y, z)) {
-							FloatType d;
-							if (isNeighborSet(grid, x, y, z, d)) {
-								queue.push(Voxel(x, y, z, d));
-							}
-						}
+			//one pass per axis; every pass transforms independent lines
+			const size_t dims[3] = { dimX, dimY, dimZ };
+			const size_t strides[3] = { 1, dimX, dimX * dimY };
+			for (int axis = 0; axis < 3; axis++) {
+				const size_t length = dims[axis], stride = strides[axis];
+				const int numLines = (int)(this->getNumElements() / length);
+				const size_t dimA = dims[axis == 0 ? 1 : 0];
+				const size_t strideA = strides[axis == 0 ? 1 : 0], strideB = strides[axis == 2 ? 1 : 2];
+#ifdef MLIB_OPENMP
+#pragma omp parallel
+#endif
+				{
+					std::vector<double> f(length), d(length), z(length + 1);
+					std::vector<int> v(length);
+#ifdef MLIB_OPENMP
+#pragma omp for
+#endif
+					for (int line = 0; line < numLines; line++) {
+						FloatType* base = result + (line % dimA) * strideA + (line / dimA) * strideB;
+						for (size_t i = 0; i < length; i++) f[i] = (double)base[i * stride];
+						distanceTransform1D(f.data(), length, d.data(), v.data(), z.data());
+						for (size_t i = 0; i < length; i++) base[i * stride] = (FloatType)d[i];
 					}
 				}
 			}
+		}
 
-			while (!queue.empty()) {
-				//first, check if the current voxel needs to be updated (and update if necessary)
-				Voxel top = queue.top();
-				queue.pop();
-
-				if (!visited.isVoxelSet(top.x, top.y, top.z)) {
-
-					visited.setVoxel(top.x, top.y, top.z);
-
-					if (checkDistToNeighborAndUpdate(top.x, top.y, top.z)) {
-
-						//second, check if neighbors need to be inserted into the queue
-						for (size_t k = 0; k < 3; k++) {
-							for (size_t j = 0; j < 3; j++) {
-								for (size_t i = 0; i < 3; i++) {
-									if (k == 1 && j == 1 && i == 1) continue;	//don't consider itself
-									vec3ul n(top.x - 1 + i, top.y - 1 + j, top.z - 1 + k);
-									if (this->isValidCoordinate(n.x, n.y, n.z) && !visited.isVoxelSet(n)) {
-										FloatType d = (vec3<FloatType>((FloatType)top.x, (FloatType)top.y, (FloatType)top.z) -
-											vec3<FloatType>((FloatType)n.x, (FloatType)n.y, (FloatType)n.z)).length();
-										FloatType dToN = (*this)(top.x, top.y, top.z) + d;
-										if (dToN < (*this)(n.x, n.y, n.z)) {
-											queue.push(Voxel(n.x, n.y, n.z, dToN));
-										}
-									}
-								}
-							}
-						}
-
-					}
+		//! d[q] = min_p (q - p)^2 + f[p] by the lower envelope of parabolas; v and z are scratch memory (n and n + 1 entries)
+		static void distanceTransform1D(const double* f, size_t n, double* d, int* v, double* z) {
+			const double inf = std::numeric_limits<double>::infinity();
+			int k = -1;
+			for (int q = 0; q < (int)n; q++) {
+				if (f[q] == inf) continue;
+				double s = -inf;
+				while (k >= 0) {
+					s = ((f[q] + (double)q * q) - (f[v[k]] + (double)v[k] * v[k])) / (2.0 * (q - v[k]));
+					if (s > z[k]) break;
+					k--;
 				}
+				if (k < 0) s = -inf;
+				k++;
+				v[k] = q;
+				z[k] = s;
+				z[k + 1] = inf;
+			}
+			if (k < 0) {
+				for (size_t q = 0; q < n; q++) d[q] = inf;
+				return;
+			}
+			k = 0;
+			for (int q = 0; q < (int)n; q++) {
+				while (z[k + 1] < (double)q) k++;
+				d[q] = (double)(q - v[k]) * (q - v[k]) + f[v[k]];
 			}
-
 		}
 
-
-
 		//! bools checks if there is a neighbor with a smaller distance (+ the dist to the current voxel); if then it updates the distances and returns true
 		bool checkDistToNeighborAndUpdate(size_t x, size_t y, size_t z, bool respectTruncation = false) {
 			bool foundBetter = false;
@@ -367,27 +414,6 @@ namespace ml {
 
 		}
 
-		//! checks if a neighbor of (x,y,z) in the grid is set
-		bool isNeighborSet(const BinaryGrid3& grid, size_t x, size_t y, size_t z, FloatType& d) const {
-			for (size_t k = 0; k < 3; k++) {
-				for (size_t j = 0; j < 3; j++) {
-					for (size_t i = 0; i < 3; i++) {
-						if (k == 1 && j == 1 && i == 1) continue;	//don't consider itself
-						vec3ul v(x - 1 + i, y - 1 + j, z - 1 + k);
-						if (grid.isValidCoordinate(v)) {
-							if (grid.isVoxelSet(v)) {
-								d = (vec3<FloatType>((FloatType)x, (FloatType)y, (FloatType)z) -
-									vec3<FloatType>((FloatType)v.x, (FloatType)v.y, (FloatType)v.z)).length();
-								//TODO avoid the costly sqrt computation and just check for 1, sqrt(2), or, sqrt(3)
-								return true;
-							}
-						}
-					}
-				}
-			}
-			return false;
-		}
-
 		size_t m_numZeroVoxels;
 		FloatType m_truncation;
 	};
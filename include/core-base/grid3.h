@@ -5,7 +5,114 @@
 namespace ml
 {
 
-	template <class T> class Grid3
+	//! Grid3 memory layouts: map voxel coordinates to offsets into the grid storage. getCellIndices is the neighborhood
+	//! kernel of a layout: the offsets of the 2x2x2 voxels of a cell, computed with less arithmetic than eight getIndex calls.
+	//! BinaryGrid3 keeps its linear layout: its word-parallel operations need x-rows packed into words, and a 32-bit word
+	//! already covers a 32-voxel run.
+
+	//! x fastest, then y, then z (getData() is a dense dimX*dimY*dimZ array)
+	class Grid3LayoutLinear
+	{
+	public:
+		static const bool isLinear = true;
+
+		Grid3LayoutLinear() {
+			setDimensions(0, 0, 0);
+		}
+		void setDimensions(size_t dimX, size_t dimY, size_t dimZ) {
+			m_dimX = dimX;
+			m_dimXY = dimX * dimY;
+			m_dimZ = dimZ;
+		}
+		size_t getStorageSize() const {
+			return m_dimXY * m_dimZ;
+		}
+		size_t getIndex(size_t x, size_t y, size_t z) const {
+			return m_dimXY * z + m_dimX * y + x;
+		}
+		//! x[1], y[1], z[1] are x[0], y[0], z[0] or one more; corner c of the cell is (x[c & 1], y[(c >> 1) & 1], z[c >> 2])
+		void getCellIndices(const size_t x[2], const size_t y[2], const size_t z[2], size_t indices[8]) const {
+			const size_t base = getIndex(x[0], y[0], z[0]);
+			const size_t dx = x[1] - x[0], dy = (y[1] - y[0]) * m_dimX, dz = (z[1] - z[0]) * m_dimXY;
+			indices[0] = base;				indices[1] = base + dx;
+			indices[2] = base + dy;			indices[3] = base + dy + dx;
+			indices[4] = base + dz;			indices[5] = base + dz + dx;
+			indices[6] = base + dz + dy;	indices[7] = base + dz + dy + dx;
+		}
+		//! visits all coordinates in storage order
+		template<class Func>
+		void forEachCoordinate(Func f) const {
+			const size_t dimY = m_dimX ? m_dimXY / m_dimX : 0;
+			for (size_t z = 0; z < m_dimZ; z++)
+				for (size_t y = 0; y < dimY; y++)
+					for (size_t x = 0; x < m_dimX; x++)
+						f(x, y, z);
+		}
+	private:
+		size_t m_dimX, m_dimXY, m_dimZ;
+	};
+
+	//! bricks of 8^3 voxels, stored brick after brick; inside a brick voxels are in Z-order (Morton order), so stepping
+	//! in y or z mostly stays within the same brick (2 KB for floats). The dimensions are padded to multiples of 8 in storage.
+	class Grid3LayoutTiled
+	{
+	public:
+		static const bool isLinear = false;
+		static const size_t TILE_DIM = 8;
+		static const size_t TILE_SIZE = TILE_DIM * TILE_DIM * TILE_DIM;
+
+		Grid3LayoutTiled() {
+			setDimensions(0, 0, 0);
+		}
+		void setDimensions(size_t dimX, size_t dimY, size_t dimZ) {
+			m_dimX = dimX;
+			m_dimY = dimY;
+			m_dimZ = dimZ;
+			m_tilesX = (dimX + TILE_DIM - 1) / TILE_DIM;
+			m_tilesY = (dimY + TILE_DIM - 1) / TILE_DIM;
+			m_tilesZ = (dimZ + TILE_DIM - 1) / TILE_DIM;
+		}
+		size_t getStorageSize() const {
+			return m_tilesX * m_tilesY * m_tilesZ * TILE_SIZE;
+		}
+		size_t getIndex(size_t x, size_t y, size_t z) const {
+			return getTileOffset(x, y, z) + (spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2));
+		}
+		//! see Grid3LayoutLinear; a cell inside a brick needs one brick offset and the Morton bits of six coordinates
+		void getCellIndices(const size_t x[2], const size_t y[2], const size_t z[2], size_t indices[8]) const {
+			if ((x[0] ^ x[1]) >= TILE_DIM || (y[0] ^ y[1]) >= TILE_DIM || (z[0] ^ z[1]) >= TILE_DIM) {
+				for (int c = 0; c < 8; c++) indices[c] = getIndex(x[c & 1], y[(c >> 1) & 1], z[c >> 2]);
+				return;
+			}
+			const size_t tile = getTileOffset(x[0], y[0], z[0]);
+			const size_t mx[2] = { spreadBits(x[0]), spreadBits(x[1]) };
+			const size_t my[2] = { spreadBits(y[0]) << 1, spreadBits(y[1]) << 1 };
+			const size_t mz[2] = { tile + (spreadBits(z[0]) << 2), tile + (spreadBits(z[1]) << 2) };
+			for (int c = 0; c < 8; c++) indices[c] = mz[c >> 2] + (my[(c >> 1) & 1] | mx[c & 1]);
+		}
+		template<class Func>
+		void forEachCoordinate(Func f) const {
+			for (size_t tz = 0; tz < m_dimZ; tz += TILE_DIM)
+				for (size_t ty = 0; ty < m_dimY; ty += TILE_DIM)
+					for (size_t tx = 0; tx < m_dimX; tx += TILE_DIM)
+						for (size_t z = tz; z < std::min(tz + TILE_DIM, m_dimZ); z++)
+							for (size_t y = ty; y < std::min(ty + TILE_DIM, m_dimY); y++)
+								for (size_t x = tx; x < std::min(tx + TILE_DIM, m_dimX); x++)
+									f(x, y, z);
+		}
+	private:
+		size_t getTileOffset(size_t x, size_t y, size_t z) const {
+			return (((z / TILE_DIM) * m_tilesY + y / TILE_DIM) * m_tilesX + x / TILE_DIM) * TILE_SIZE;
+		}
+		//! moves the three lowest bits of v to bits 0, 3 and 6
+		static size_t spreadBits(size_t v) {
+			return (v & 1) | ((v & 2) << 2) | ((v & 4) << 4);
+		}
+		size_t m_dimX, m_dimY, m_dimZ;
+		size_t m_tilesX, m_tilesY, m_tilesZ;
+	};
+
+	template <class T, class Layout = Grid3LayoutLinear> class Grid3
 	{
 	public:
 		Grid3();
@@ -14,10 +121,28 @@ namespace ml
 		Grid3(const vec3ul& dim) : Grid3(dim.x, dim.y, dim.z) {}
 		Grid3(const vec3ul& dim, const T& value) : Grid3(dim.x, dim.y, dim.z, value) {}
 
-		Grid3(const Grid3<T> &grid);
-		Grid3(Grid3<T> &&grid);
+		Grid3(const Grid3 &grid);
+		Grid3(Grid3 &&grid);
 		Grid3(size_t dimX, size_t dimY, size_t dimZ, const std::function< T(size_t x, size_t y, size_t z) > &fillFunction);
 
+		//! copies a grid with another memory layout
+		template<class OtherLayout>
+		explicit Grid3(const Grid3<T, OtherLayout>& grid) {
+			m_dimX = m_dimY = m_dimZ = 0;
+			m_data = nullptr;
+			allocate(grid.getDimX(), grid.getDimY(), grid.getDimZ());
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int z = 0; z < (int)m_dimZ; z++) {
+				for (size_t y = 0; y < m_dimY; y++) {
+					for (size_t x = 0; x < m_dimX; x++) {
+						(*this)(x, y, z) = grid(x, y, z);
+					}
+				}
+			}
+		}
+
 		~Grid3();
 
 		//! adl swap
@@ -26,10 +151,11 @@ namespace ml
 			std::swap(a.m_dimY, b.m_dimY);
 			std::swap(a.m_dimZ, b.m_dimZ);
 			std::swap(a.m_data, b.m_data);
+			std::swap(a.m_layout, b.m_layout);
 		}
 
-		Grid3<T>& operator=(const Grid3<T>& grid);
-		Grid3<T>& operator=(Grid3<T>&& grid);
+		Grid3& operator=(const Grid3& grid);
+		Grid3& operator=(Grid3&& grid);
 
 		void allocate(size_t dimX, size_t dimY, size_t dimZ);
 		void allocate(size_t dimX, size_t dimY, size_t dimZ, const T &value);
@@ -41,12 +167,12 @@ namespace ml
 		//
 		inline T& operator() (size_t x, size_t y, size_t z)	{
 			MLIB_ASSERT(x < getDimX() && y < getDimY() && z < getDimZ());
-			return m_data[getDimX()*getDimY()*z + getDimX()*y + x];
+			return m_data[m_layout.getIndex(x, y, z)];
 		}
 
 		inline const T& operator() (size_t x, size_t y, size_t z) const	{
 			MLIB_ASSERT(x < getDimX() && y < getDimY() && z < getDimZ());
-			return m_data[getDimX()*getDimY()*z + getDimX()*y + x];
+			return m_data[m_layout.getIndex(x, y, z)];
 		}
 
 		inline T& operator() (const vec3ul& coord)	{
@@ -75,9 +201,27 @@ namespace ml
 			return m_dimX * m_dimY * m_dimZ;
 		}
 
+		//! number of stored elements (larger than getNumElements if the layout pads the grid)
+		size_t getStorageSize() const {
+			return m_layout.getStorageSize();
+		}
+
+		//! offset of the voxel in getData()
+		size_t getIndex(size_t x, size_t y, size_t z) const {
+			return m_layout.getIndex(x, y, z);
+		}
+		//! offsets of the 2x2x2 voxels of a cell (see Grid3LayoutLinear::getCellIndices)
+		void getCellIndices(const size_t x[2], const size_t y[2], const size_t z[2], size_t indices[8]) const {
+			m_layout.getCellIndices(x, y, z, indices);
+		}
+		const Layout& getLayout() const {
+			return m_layout;
+		}
+
 		inline bool isSquare() const	{
 			return (m_dimX == m_dimY && m_dimY == m_dimZ);
 		}
+		//! the storage in the order of the layout (x fastest, then y, then z, for the default layout)
 		inline T* getData()	{
 			return m_data;
 		}
@@ -85,36 +229,36 @@ namespace ml
 			return m_data;
 		}
 
-		inline Grid3<T>& operator += (const Grid3<T>& right)
+		inline Grid3& operator += (const Grid3& right)
 		{
 			MLIB_ASSERT(getDimensions() == right.getDimensions());
-			const size_t numElements = getNumElements();
+			const size_t numElements = getStorageSize();
 			for (size_t i = 0; i < numElements; i++) {
 				m_data[i] += right.m_data[i];
 			}
 			return *this;
 		}
-		inline Grid3<T>& operator += (T value)
+		inline Grid3& operator += (T value)
 		{
-			const size_t numElements = getNumElements();
+			const size_t numElements = getStorageSize();
 			for (size_t i = 0; i < numElements; i++) {
 				m_data[i] += value;
 			}
 			return *this;
 		}
-		inline Grid3<T>& operator *= (T value)
+		inline Grid3& operator *= (T value)
 		{
-			const size_t numElements = getNumElements();
+			const size_t numElements = getStorageSize();
 			for (size_t i = 0; i < numElements; i++) {
 				m_data[i] *= value;
 			}
 			return *this;
 		}
 
-		inline Grid3<T> operator * (T value)
+		inline Grid3 operator * (T value)
 		{
-			Grid3<T> result(m_dimX, m_dimY, m_dimZ);
-			const size_t numElements = getNumElements();
+			Grid3 result(m_dimX, m_dimY, m_dimZ);
+			const size_t numElements = getStorageSize();
 			for (size_t i = 0; i < numElements; i++) {
 				result.m_data[i] = m_data[i] * value;
 			}
@@ -128,6 +272,16 @@ namespace ml
 
 		void fill(const std::function<T(size_t x, size_t y, size_t z)> &fillFunction);
 
+		//! calls f(x, y, z, value) for all voxels in storage order (brick by brick for the tiled layout)
+		template<class Func>
+		void forEachVoxel(Func f) {
+			m_layout.forEachCoordinate([&](size_t x, size_t y, size_t z) { f(x, y, z, m_data[m_layout.getIndex(x, y, z)]); });
+		}
+		template<class Func>
+		void forEachVoxel(Func f) const {
+			m_layout.forEachCoordinate([&](size_t x, size_t y, size_t z) { f(x, y, z, (const T&)m_data[m_layout.getIndex(x, y, z)]); });
+		}
+
 		//
 		// Query
 		//
@@ -195,7 +349,7 @@ namespace ml
 
 		struct iterator
 		{
-			iterator(Grid3<T> *_grid)
+			iterator(Grid3 *_grid)
 			{
 				x = 0;
 				y = 0;
@@ -253,12 +407,12 @@ namespace ml
 			size_t x, y, z;
 
 		private:
-			Grid3<T> *grid;
+			Grid3 *grid;
 		};
 
 		struct constIterator
 		{
-			constIterator(const Grid3<T> *_grid)
+			constIterator(const Grid3 *_grid)
 			{
 				x = 0;
 				y = 0;
@@ -316,7 +470,7 @@ namespace ml
 			size_t x, y, z;
 
 		private:
-			const Grid3<T> *grid;
+			const Grid3 *grid;
 		};
 
 
@@ -343,11 +497,20 @@ namespace ml
 	protected:
 		T* m_data;
 		size_t m_dimX, m_dimY, m_dimZ;
+		Layout m_layout;
 	};
 
-	template <class T> inline bool operator == (const Grid3<T> &a, const Grid3<T> &b)
+	template <class T, class Layout> inline bool operator == (const Grid3<T, Layout> &a, const Grid3<T, Layout> &b)
 	{
 		if (a.getDimensions() != b.getDimensions()) return false;
+		if (!Layout::isLinear) {
+			//the padding of the storage is not compared
+			for (size_t z = 0; z < a.getDimZ(); z++)
+				for (size_t y = 0; y < a.getDimY(); y++)
+					for (size_t x = 0; x < a.getDimX(); x++)
+						if (a(x, y, z) != b(x, y, z))	return false;
+			return true;
+		}
 		const size_t totalEntries = a.getNumElements();
 		for (size_t i = 0; i < totalEntries; i++) {
 			if (a.getData()[i] != b.getData()[i])	return false;
@@ -355,54 +518,55 @@ namespace ml
 		return true;
 	}
 
-	template <class T> inline bool operator != (const Grid3<T> &a, const Grid3<T> &b)
+	template <class T, class Layout> inline bool operator != (const Grid3<T, Layout> &a, const Grid3<T, Layout> &b)
 	{
 		return !(a == b);
 	}
 
 	//! writes to a stream
-	template <class T>
-	inline std::ostream& operator<<(std::ostream& s, const Grid3<T>& g)
+	template <class T, class Layout>
+	inline std::ostream& operator<<(std::ostream& s, const Grid3<T, Layout>& g)
 	{
 		s << g.toString();
 		return s;
 	}
 
-	//! serialization (output)
-	template<class BinaryDataBuffer, class BinaryDataCompressor, class T>
-	inline BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& operator<<(BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& s, const Grid3<T>& g) {
+	//! serialization (output); always in linear order, independent of the layout
+	template<class BinaryDataBuffer, class BinaryDataCompressor, class T, class Layout>
+	inline BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& operator<<(BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& s, const Grid3<T, Layout>& g) {
 		
 		s << (UINT64)g.getDimX() << (UINT64)g.getDimY() << (UINT64)g.getDimZ();		
 
-		if (std::is_pod<T>::value) {
+		if (std::is_pod<T>::value && Layout::isLinear) {
 			s.writeData((const BYTE*)g.getData(), sizeof(T)*g.getNumElements());
 		}
 		else {
 			const size_t numElements = g.getNumElements();
 			s.reserve(sizeof(T) * numElements);
-			for (size_t i = 0; i < numElements; i++) {
-				s << g.getData()[i];
-			}
+			for (size_t z = 0; z < g.getDimZ(); z++)
+				for (size_t y = 0; y < g.getDimY(); y++)
+					for (size_t x = 0; x < g.getDimX(); x++)
+						s << g(x, y, z);
 		}
 		return s;
 	}
 
 	//! serialization (input)
-	template<class BinaryDataBuffer, class BinaryDataCompressor, class T>
-	inline BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& operator>>(BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& s, Grid3<T>& g) {
+	template<class BinaryDataBuffer, class BinaryDataCompressor, class T, class Layout>
+	inline BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& operator>>(BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& s, Grid3<T, Layout>& g) {
 		
 		UINT64 dimX, dimY, dimZ;
 		s >> dimX >> dimY >> dimZ;
 		g.allocate(dimX, dimY, dimZ);
 
-		if (std::is_pod<T>::value) {
+		if (std::is_pod<T>::value && Layout::isLinear) {
 			s.readData((BYTE*)g.getData(), sizeof(T)*g.getNumElements());
 		}
 		else { 
-			const size_t numElements = g.getNumElements();
-			for (size_t i = 0; i < numElements; i++) {
-				s >> g.getData()[i];
-			}
+			for (size_t z = 0; z < g.getDimZ(); z++)
+				for (size_t y = 0; y < g.getDimY(); y++)
+					for (size_t x = 0; x < g.getDimX(); x++)
+						s >> g(x, y, z);
 		}
 
 		return s;
@@ -414,6 +578,9 @@ namespace ml
 	typedef Grid3<unsigned int> Grid3ui;
 	typedef Grid3<unsigned char> Grid3uc;
 
+	typedef Grid3<float, Grid3LayoutTiled> TiledGrid3f;
+	typedef Grid3<double, Grid3LayoutTiled> TiledGrid3d;
+
 }  // namespace ml
 
 #include "grid3.cpp"
@@ -0,0 +1,184 @@
+#ifndef CORE_BASE_GRID3SAMPLER_H_
+#define CORE_BASE_GRID3SAMPLER_H_
+
+namespace ml {
+
+	//! continuous sampling of scalar grids (e.g., Grid3f, DistanceField3f) with analytic gradients.
+	//! Positions are in voxel coordinates (voxel (x,y,z) is located at (x,y,z)); positions outside the grid are clamped to
+	//! it, so the value is extended constantly and the gradient across the border is zero.
+	template<class FloatType>
+	class Grid3Sampler {
+	public:
+		//! trilinear interpolation of the 8 surrounding voxels
+		template<class Layout>
+		static FloatType trilinear(const Grid3<FloatType, Layout>& grid, const vec3<FloatType>& p) {
+			return trilinear(grid, p, nullptr);
+		}
+		template<class Layout>
+		static FloatType trilinear(const Grid3<FloatType, Layout>& grid, const vec3<FloatType>& p, vec3<FloatType>& gradient) {
+			return trilinear(grid, p, &gradient);
+		}
+
+		//! Catmull-Rom (interpolating) cubic of the 4^3 surrounding voxels; the gradient is continuous and linear fields are reproduced exactly
+		template<class Layout>
+		static FloatType tricubic(const Grid3<FloatType, Layout>& grid, const vec3<FloatType>& p) {
+			return tricubic(grid, p, nullptr);
+		}
+		template<class Layout>
+		static FloatType tricubic(const Grid3<FloatType, Layout>& grid, const vec3<FloatType>& p, vec3<FloatType>& gradient) {
+			return tricubic(grid, p, &gradient);
+		}
+
+		//! samples many points in parallel; pointToVoxel maps the points to voxel coordinates, the gradients are in voxel units
+		template<class Layout>
+		static void trilinear(const Grid3<FloatType, Layout>& grid, const std::vector<vec3<FloatType>>& points, std::vector<FloatType>& values,
+			std::vector<vec3<FloatType>>* gradients = nullptr, const Matrix4x4<FloatType>& pointToVoxel = Matrix4x4<FloatType>::identity()) {
+			sampleBatch(points, values, gradients, pointToVoxel, [&](const vec3<FloatType>& p, vec3<FloatType>* g) { return trilinear(grid, p, g); });
+		}
+		template<class Layout>
+		static void tricubic(const Grid3<FloatType, Layout>& grid, const std::vector<vec3<FloatType>>& points, std::vector<FloatType>& values,
+			std::vector<vec3<FloatType>>* gradients = nullptr, const Matrix4x4<FloatType>& pointToVoxel = Matrix4x4<FloatType>::identity()) {
+			sampleBatch(points, values, gradients, pointToVoxel, [&](const vec3<FloatType>& p, vec3<FloatType>* g) { return tricubic(grid, p, g); });
+		}
+
+	private:
+		template<class Layout>
+		static FloatType trilinear(const Grid3<FloatType, Layout>& grid, const vec3<FloatType>& p, vec3<FloatType>* gradient) {
+			size_t i0[3], i1[3];
+			FloatType t[3];
+			bool inside[3];
+			const vec3ul dim = grid.getDimensions();
+			for (int a = 0; a < 3; a++) {
+				inside[a] = locate(p[a], (size_t)dim[a], i0[a], t[a]);
+				i1[a] = std::min(i0[a] + 1, (size_t)dim[a] - 1);
+			}
+
+			//the layout computes the offsets of the whole cell at once
+			const size_t cx[2] = { i0[0], i1[0] }, cy[2] = { i0[1], i1[1] }, cz[2] = { i0[2], i1[2] };
+			size_t cell[8];
+			grid.getCellIndices(cx, cy, cz, cell);
+			const FloatType* data = grid.getData();
+
+			//interpolate along x, then y, then z; the derivatives follow from the same differences
+			FloatType vx[2][2], dx[2][2];
+			for (int z = 0; z < 2; z++) {
+				for (int y = 0; y < 2; y++) {
+					const FloatType v0 = data[cell[4 * z + 2 * y]], v1 = data[cell[4 * z + 2 * y + 1]];
+					vx[z][y] = v0 + (v1 - v0) * t[0];
+					dx[z][y] = v1 - v0;
+				}
+			}
+			const FloatType vy0 = vx[0][0] + (vx[0][1] - vx[0][0]) * t[1];
+			const FloatType vy1 = vx[1][0] + (vx[1][1] - vx[1][0]) * t[1];
+			if (gradient) {
+				const FloatType dxy0 = dx[0][0] + (dx[0][1] - dx[0][0]) * t[1];
+				const FloatType dxy1 = dx[1][0] + (dx[1][1] - dx[1][0]) * t[1];
+				gradient->x = inside[0] ? dxy0 + (dxy1 - dxy0) * t[2] : 0;
+				gradient->y = inside[1] ? (vx[0][1] - vx[0][0]) + ((vx[1][1] - vx[1][0]) - (vx[0][1] - vx[0][0])) * t[2] : 0;
+				gradient->z = inside[2] ? vy1 - vy0 : 0;
+			}
+			return vy0 + (vy1 - vy0) * t[2];
+		}
+
+		template<class Layout>
+		static FloatType tricubic(const Grid3<FloatType, Layout>& grid, const vec3<FloatType>& p, vec3<FloatType>* gradient) {
+			size_t index[3][4];
+			FloatType w[3][4], dw[3][4];
+			bool inside[3];
+			const vec3ul dim = grid.getDimensions();
+			for (int a = 0; a < 3; a++) {
+				size_t i;
+				FloatType t;
+				inside[a] = locate(p[a], (size_t)dim[a], i, t);
+				for (int k = 0; k < 4; k++) {
+					index[a][k] = (size_t)math::clamp((ptrdiff_t)i + k - 1, (ptrdiff_t)0, (ptrdiff_t)dim[a] - 1);
+				}
+				catmullRomWeights(t, w[a], dw[a]);
+				//missing neighbors are extrapolated linearly (v[-1] = 2 v[0] - v[1]), which keeps linear fields exact up to the border
+				if (i == 0)						foldWeights(w[a], dw[a], 0, 1, 2);
+				if (i + 2 >= (size_t)dim[a])	foldWeights(w[a], dw[a], 3, 2, 1);
+			}
+
+			FloatType value = 0;
+			vec3<FloatType> g = vec3<FloatType>::origin;
+			for (int z = 0; z < 4; z++) {
+				FloatType vz = 0, gxz = 0, gyz = 0;
+				for (int y = 0; y < 4; y++) {
+					FloatType vy = 0, gxy = 0;
+					for (int x = 0; x < 4; x++) {
+						const FloatType v = grid(index[0][x], index[1][y], index[2][z]);
+						vy += w[0][x] * v;
+						gxy += dw[0][x] * v;
+					}
+					vz += w[1][y] * vy;
+					gxz += w[1][y] * gxy;
+					gyz += dw[1][y] * vy;
+				}
+				value += w[2][z] * vz;
+				g.x += w[2][z] * gxz;
+				g.y += w[2][z] * gyz;
+				g.z += dw[2][z] * vz;
+			}
+			if (gradient) {
+				*gradient = vec3<FloatType>(inside[0] ? g.x : 0, inside[1] ? g.y : 0, inside[2] ? g.z : 0);
+			}
+			return value;
+		}
+
+		//! cell (i, i + 1) and position t within it for the coordinate c; returns false if c was clamped
+		static bool locate(FloatType c, size_t dim, size_t& i, FloatType& t) {
+			const FloatType maxCoord = (FloatType)(dim - 1);
+			if (!(c > 0)) {
+				i = 0;
+				t = 0;
+				return dim > 1 && c == 0;
+			}
+			if (c >= maxCoord) {
+				i = dim > 1 ? dim - 2 : 0;
+				t = dim > 1 ? (FloatType)1 : (FloatType)0;
+				return c == maxCoord;
+			}
+			i = (size_t)c;
+			t = c - (FloatType)i;
+			return true;
+		}
+
+		static void catmullRomWeights(FloatType t, FloatType w[4], FloatType dw[4]) {
+			const FloatType t2 = t * t, t3 = t2 * t;
+			w[0] = (-t3 + 2 * t2 - t) * (FloatType)0.5;
+			w[1] = (3 * t3 - 5 * t2 + 2) * (FloatType)0.5;
+			w[2] = (-3 * t3 + 4 * t2 + t) * (FloatType)0.5;
+			w[3] = (t3 - t2) * (FloatType)0.5;
+			dw[0] = (-3 * t2 + 4 * t - 1) * (FloatType)0.5;
+			dw[1] = (9 * t2 - 10 * t) * (FloatType)0.5;
+			dw[2] = (-9 * t2 + 8 * t + 1) * (FloatType)0.5;
+			dw[3] = (3 * t2 - 2 * t) * (FloatType)0.5;
+		}
+
+		static void foldWeights(FloatType w[4], FloatType dw[4], int ghost, int border, int inner) {
+			w[border] += 2 * w[ghost];	w[inner] -= w[ghost];	w[ghost] = 0;
+			dw[border] += 2 * dw[ghost];	dw[inner] -= dw[ghost];	dw[ghost] = 0;
+		}
+
+		template<class Sample>
+		static void sampleBatch(const std::vector<vec3<FloatType>>& points, std::vector<FloatType>& values, std::vector<vec3<FloatType>>* gradients,
+			const Matrix4x4<FloatType>& pointToVoxel, Sample sample) {
+			const int numPoints = (int)points.size();
+			values.resize(numPoints);
+			if (gradients) gradients->resize(numPoints);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(static, 1024)
+#endif
+			for (int i = 0; i < numPoints; i++) {
+				const vec3<FloatType> p = pointToVoxel.transformAffine(points[i]);
+				values[i] = sample(p, gradients ? &(*gradients)[i] : nullptr);
+			}
+		}
+	};
+
+	typedef Grid3Sampler<float> Grid3Samplerf;
+	typedef Grid3Sampler<double> Grid3Samplerd;
+
+}  // namespace ml
+
+#endif  // CORE_BASE_GRID3SAMPLER_H_
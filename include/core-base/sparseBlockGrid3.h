@@ -0,0 +1,451 @@
+#ifndef CORE_BASE_SPARSEBLOCKGRID3_H_
+#define CORE_BASE_SPARSEBLOCKGRID3_H_
+
+namespace ml {
+
+//! sparse voxel volume for large scenes (e.g., TSDF or occupancy at fine resolutions): voxels are allocated in blocks of
+//! 8^3, and a hash map indexes the allocated blocks by their block coordinates (voxel coordinates / 8). Every block keeps
+//! an active mask; inactive voxels have the background value. Blocks are heap-allocated, so pointers to blocks (and the
+//! accessors) stay valid until the block is removed (prune, clear).
+template<class T>
+class SparseBlockGrid3 {
+public:
+	static const int BLOCK_LOG2 = 3;
+	static const int BLOCK_DIM = 1 << BLOCK_LOG2;
+	static const int BLOCK_SIZE = BLOCK_DIM * BLOCK_DIM * BLOCK_DIM;
+
+	struct Block {
+		T values[BLOCK_SIZE];
+		UINT64 activeMask[BLOCK_SIZE / 64];
+
+		bool isActive(UINT i) const {
+			return ((activeMask[i >> 6] >> (i & 63)) & 1) != 0;
+		}
+		void setActive(UINT i) {
+			activeMask[i >> 6] |= (UINT64)1 << (i & 63);
+		}
+		void setInactive(UINT i) {
+			activeMask[i >> 6] &= ~((UINT64)1 << (i & 63));
+		}
+		bool hasActiveVoxels() const {
+			for (int w = 0; w < BLOCK_SIZE / 64; w++) {
+				if (activeMask[w] != 0) return true;
+			}
+			return false;
+		}
+		UINT getNumActiveVoxels() const {
+			UINT count = 0;
+			for (int w = 0; w < BLOCK_SIZE / 64; w++) {
+				for (UINT64 m = activeMask[w]; m != 0; m &= m - 1) count++;
+			}
+			return count;
+		}
+		//! coordinate of a voxel inside the block
+		static vec3i localCoord(UINT i) {
+			return vec3i((int)(i & (BLOCK_DIM - 1)), (int)((i >> BLOCK_LOG2) & (BLOCK_DIM - 1)), (int)(i >> (2 * BLOCK_LOG2)));
+		}
+	};
+
+	SparseBlockGrid3(const T& background = T()) {
+		m_background = background;
+	}
+	SparseBlockGrid3(const SparseBlockGrid3& other) {
+		*this = other;
+	}
+	SparseBlockGrid3(SparseBlockGrid3&& other) {
+		*this = std::move(other);
+	}
+	//! voxels that differ from the background become active; the grid origin maps to offset
+	SparseBlockGrid3(const Grid3<T>& grid, const T& background, const vec3i& offset = vec3i(0, 0, 0)) {
+		m_background = background;
+		fromGrid3(grid, offset);
+	}
+
+	SparseBlockGrid3& operator=(const SparseBlockGrid3& other) {
+		if (this == &other) return *this;
+		clear();
+		m_background = other.m_background;
+		m_blockCoords = other.m_blockCoords;
+		m_blockIndex = other.m_blockIndex;
+		m_blocks.resize(other.m_blocks.size());
+		for (size_t b = 0; b < m_blocks.size(); b++) m_blocks[b].reset(new Block(*other.m_blocks[b]));
+		return *this;
+	}
+	SparseBlockGrid3& operator=(SparseBlockGrid3&& other) {
+		m_background = other.m_background;
+		m_blocks = std::move(other.m_blocks);
+		m_blockCoords = std::move(other.m_blockCoords);
+		m_blockIndex = std::move(other.m_blockIndex);
+		return *this;
+	}
+
+	void clear() {
+		m_blocks.clear();
+		m_blockCoords.clear();
+		m_blockIndex.clear();
+	}
+
+	const T& getBackground() const {
+		return m_background;
+	}
+	size_t getNumBlocks() const {
+		return m_blocks.size();
+	}
+	size_t getNumActiveVoxels() const {
+		size_t count = 0;
+		for (const auto& b : m_blocks) count += b->getNumActiveVoxels();
+		return count;
+	}
+	//! bytes of the allocated blocks
+	size_t getMemoryUsage() const {
+		return m_blocks.size() * (sizeof(Block) + sizeof(vec3i));
+	}
+
+	static vec3i toBlockCoord(const vec3i& c) {
+		return vec3i(c.x >> BLOCK_LOG2, c.y >> BLOCK_LOG2, c.z >> BLOCK_LOG2);
+	}
+	static UINT toLocalIndex(const vec3i& c) {
+		return (UINT)(c.x & (BLOCK_DIM - 1)) | ((UINT)(c.y & (BLOCK_DIM - 1)) << BLOCK_LOG2) | ((UINT)(c.z & (BLOCK_DIM - 1)) << (2 * BLOCK_LOG2));
+	}
+
+	//! block-level access; b in [0, getNumBlocks())
+	const vec3i& getBlockCoord(size_t b) const {
+		return m_blockCoords[b];
+	}
+	Block& getBlock(size_t b) {
+		return *m_blocks[b];
+	}
+	const Block& getBlock(size_t b) const {
+		return *m_blocks[b];
+	}
+	//! nullptr if the block is not allocated
+	Block* findBlock(const vec3i& blockCoord) {
+		auto it = m_blockIndex.find(blockCoord);
+		return it == m_blockIndex.end() ? nullptr : m_blocks[it->second].get();
+	}
+	const Block* findBlock(const vec3i& blockCoord) const {
+		auto it = m_blockIndex.find(blockCoord);
+		return it == m_blockIndex.end() ? nullptr : m_blocks[it->second].get();
+	}
+	//! index of the block for getBlock/getBlockCoord; (size_t)-1 if the block is not allocated
+	size_t getBlockIndex(const vec3i& blockCoord) const {
+		auto it = m_blockIndex.find(blockCoord);
+		return it == m_blockIndex.end() ? (size_t)-1 : it->second;
+	}
+	//! allocates the block (all voxels inactive) if it does not exist yet
+	Block& touchBlock(const vec3i& blockCoord) {
+		auto it = m_blockIndex.find(blockCoord);
+		if (it != m_blockIndex.end()) return *m_blocks[it->second];
+		Block* block = new Block;
+		for (int i = 0; i < BLOCK_SIZE; i++) block->values[i] = m_background;
+		for (int w = 0; w < BLOCK_SIZE / 64; w++) block->activeMask[w] = 0;
+		m_blockIndex[blockCoord] = m_blocks.size();
+		m_blocks.push_back(std::unique_ptr<Block>(block));
+		m_blockCoords.push_back(blockCoord);
+		return *block;
+	}
+
+	const T& getValue(const vec3i& c) const {
+		const Block* block = findBlock(toBlockCoord(c));
+		return block ? block->values[toLocalIndex(c)] : m_background;
+	}
+	bool isActive(const vec3i& c) const {
+		const Block* block = findBlock(toBlockCoord(c));
+		return block && block->isActive(toLocalIndex(c));
+	}
+	//! sets and activates the voxel
+	void setValue(const vec3i& c, const T& value) {
+		Block& block = touchBlock(toBlockCoord(c));
+		const UINT i = toLocalIndex(c);
+		block.values[i] = value;
+		block.setActive(i);
+	}
+	//! resets the voxel to the background (the block stays allocated; see prune)
+	void setInactive(const vec3i& c) {
+		Block* block = findBlock(toBlockCoord(c));
+		if (!block) return;
+		const UINT i = toLocalIndex(c);
+		block->values[i] = m_background;
+		block->setInactive(i);
+	}
+
+	//! removes the blocks without active voxels
+	void prune() {
+		size_t numKept = 0;
+		for (size_t b = 0; b < m_blocks.size(); b++) {
+			if (!m_blocks[b]->hasActiveVoxels()) continue;
+			m_blocks[numKept] = std::move(m_blocks[b]);
+			m_blockCoords[numKept] = m_blockCoords[b];
+			numKept++;
+		}
+		m_blocks.resize(numKept);
+		m_blockCoords.resize(numKept);
+		m_blockIndex.clear();
+		for (size_t b = 0; b < numKept; b++) m_blockIndex[m_blockCoords[b]] = b;
+	}
+
+	//! voxel access that caches the last block, for coherent access patterns (e.g., along rays or inside a block)
+	class Accessor {
+	public:
+		Accessor(SparseBlockGrid3& grid) : m_grid(grid) {
+			m_block = nullptr;
+		}
+		const T& getValue(const vec3i& c) {
+			Block* block = lookup(c, false);
+			return block ? block->values[toLocalIndex(c)] : m_grid.m_background;
+		}
+		bool isActive(const vec3i& c) {
+			Block* block = lookup(c, false);
+			return block && block->isActive(toLocalIndex(c));
+		}
+		void setValue(const vec3i& c, const T& value) {
+			Block* block = lookup(c, true);
+			const UINT i = toLocalIndex(c);
+			block->values[i] = value;
+			block->setActive(i);
+		}
+		//! activates the voxel and returns a reference to its value
+		T& operator()(const vec3i& c) {
+			Block* block = lookup(c, true);
+			const UINT i = toLocalIndex(c);
+			block->setActive(i);
+			return block->values[i];
+		}
+	private:
+		//! misses are not cached, since the block may be allocated through the grid or another accessor later on
+		Block* lookup(const vec3i& c, bool allocate) {
+			const vec3i blockCoord = toBlockCoord(c);
+			if (m_block && blockCoord == m_blockCoord) return m_block;
+			Block* block = allocate ? &m_grid.touchBlock(blockCoord) : m_grid.findBlock(blockCoord);
+			if (block) {
+				m_block = block;
+				m_blockCoord = blockCoord;
+			}
+			return block;
+		}
+		SparseBlockGrid3& m_grid;
+		Block* m_block;			//nullptr: nothing cached yet
+		vec3i m_blockCoord;
+	};
+
+	class ConstAccessor {
+	public:
+		ConstAccessor(const SparseBlockGrid3& grid) : m_grid(grid) {
+			m_block = nullptr;
+		}
+		const T& getValue(const vec3i& c) {
+			const Block* block = lookup(c);
+			return block ? block->values[toLocalIndex(c)] : m_grid.m_background;
+		}
+		bool isActive(const vec3i& c) {
+			const Block* block = lookup(c);
+			return block && block->isActive(toLocalIndex(c));
+		}
+	private:
+		//! misses are not cached (see Accessor::lookup)
+		const Block* lookup(const vec3i& c) {
+			const vec3i blockCoord = toBlockCoord(c);
+			if (m_block && blockCoord == m_blockCoord) return m_block;
+			const Block* block = m_grid.findBlock(blockCoord);
+			if (block) {
+				m_block = block;
+				m_blockCoord = blockCoord;
+			}
+			return block;
+		}
+		const SparseBlockGrid3& m_grid;
+		const Block* m_block;	//nullptr: nothing cached yet
+		vec3i m_blockCoord;
+	};
+
+	Accessor getAccessor() {
+		return Accessor(*this);
+	}
+	ConstAccessor getAccessor() const {
+		return ConstAccessor(*this);
+	}
+
+	//! calls f(const vec3i& blockCoord, Block& block) for every block
+	template<class Func>
+	void forEachBlock(Func f) {
+		for (size_t b = 0; b < m_blocks.size(); b++) f(m_blockCoords[b], *m_blocks[b]);
+	}
+	template<class Func>
+	void forEachBlock(Func f) const {
+		for (size_t b = 0; b < m_blocks.size(); b++) f(m_blockCoords[b], (const Block&)*m_blocks[b]);
+	}
+	//! calls f(const vec3i& blockCoord, Block& block) for every block in parallel (f must not allocate blocks)
+	template<class Func>
+	void applyParallel(Func f) {
+		const int numBlocks = (int)m_blocks.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+		for (int b = 0; b < numBlocks; b++) f(m_blockCoords[b], *m_blocks[b]);
+	}
+	//! calls f(const vec3i& coord, T& value) for every active voxel in parallel (over the blocks)
+	template<class Func>
+	void applyActiveParallel(Func f) {
+		applyParallel([&](const vec3i& blockCoord, Block& block) {
+			const vec3i origin = blockCoord * BLOCK_DIM;
+			for (UINT i = 0; i < (UINT)BLOCK_SIZE; i++) {
+				if (block.isActive(i)) f(origin + Block::localCoord(i), block.values[i]);
+			}
+		});
+	}
+	//! calls f(const vec3i& coord, const T& value) for every active voxel (serially, block by block)
+	template<class Func>
+	void forEachActiveVoxel(Func f) const {
+		forEachBlock([&](const vec3i& blockCoord, const Block& block) {
+			const vec3i origin = blockCoord * BLOCK_DIM;
+			for (UINT i = 0; i < (UINT)BLOCK_SIZE; i++) {
+				if (block.isActive(i)) f(origin + Block::localCoord(i), block.values[i]);
+			}
+		});
+	}
+
+	//! bounds of the active voxels (inclusive); returns false if there are none
+	bool getActiveBounds(vec3i& minCoord, vec3i& maxCoord) const {
+		bool found = false;
+		minCoord = vec3i(std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
+		maxCoord = vec3i(std::numeric_limits<int>::min(), std::numeric_limits<int>::min(), std::numeric_limits<int>::min());
+		forEachActiveVoxel([&](const vec3i& c, const T&) {
+			minCoord = math::min(minCoord, c);
+			maxCoord = math::max(maxCoord, c);
+			found = true;
+		});
+		return found;
+	}
+
+	//! voxels that differ from the background become active; the grid origin maps to offset
+	void fromGrid3(const Grid3<T>& grid, const vec3i& offset = vec3i(0, 0, 0)) {
+		clear();
+		fromDense(vec3i((int)grid.getDimX(), (int)grid.getDimY(), (int)grid.getDimZ()), offset,
+			[&](size_t x, size_t y, size_t z) { return grid(x, y, z) != m_background; },
+			[&](size_t x, size_t y, size_t z) { return grid(x, y, z); });
+	}
+	//! set voxels become active with the given value
+	void fromBinaryGrid(const BinaryGrid3& grid, const T& value, const vec3i& offset = vec3i(0, 0, 0)) {
+		clear();
+		fromDense(vec3i((int)grid.getDimX(), (int)grid.getDimY(), (int)grid.getDimZ()), offset,
+			[&](size_t x, size_t y, size_t z) { return grid.isVoxelSet(x, y, z); },
+			[&](size_t, size_t, size_t) { return value; });
+	}
+
+	//! dense grid over the bounds of the active voxels (background elsewhere); offset receives the coordinate of its origin
+	Grid3<T> toGrid3(vec3i& offset) const {
+		vec3i minCoord, maxCoord;
+		if (!getActiveBounds(minCoord, maxCoord)) {
+			offset = vec3i(0, 0, 0);
+			return Grid3<T>();
+		}
+		offset = minCoord;
+		const vec3i dim = maxCoord - minCoord + 1;
+		Grid3<T> grid(dim.x, dim.y, dim.z);
+		grid.setValues(m_background);
+		toDense(offset, dim, [&](const vec3i& c, const T& value) { grid(c.x, c.y, c.z) = value; });
+		return grid;
+	}
+	//! active voxels become set voxels; offset receives the coordinate of the grid origin
+	BinaryGrid3 toBinaryGrid(vec3i& offset) const {
+		vec3i minCoord, maxCoord;
+		if (!getActiveBounds(minCoord, maxCoord)) {
+			offset = vec3i(0, 0, 0);
+			return BinaryGrid3();
+		}
+		offset = minCoord;
+		const vec3i dim = maxCoord - minCoord + 1;
+		BinaryGrid3 grid(dim.x, dim.y, dim.z);
+		//filled serially: neighboring blocks may share words of the bit grid
+		forEachActiveVoxel([&](const vec3i& c, const T&) { grid.setVoxel(c.x - offset.x, c.y - offset.y, c.z - offset.z); });
+		return grid;
+	}
+
+private:
+	//! allocates the blocks that contain active voxels (found in parallel), then fills them in parallel
+	template<class IsActive, class GetValue>
+	void fromDense(const vec3i& dim, const vec3i& offset, IsActive isActive, GetValue getValue) {
+		if (dim.x <= 0 || dim.y <= 0 || dim.z <= 0) return;
+		const vec3i firstBlock = toBlockCoord(offset);
+		const vec3i lastBlock = toBlockCoord(offset + dim - 1);
+		const vec3i numBlocks = lastBlock - firstBlock + 1;
+		const int totalBlocks = numBlocks.x * numBlocks.y * numBlocks.z;
+		auto blockCoordOf = [&](int b) { return firstBlock + vec3i(b % numBlocks.x, (b / numBlocks.x) % numBlocks.y, b / (numBlocks.x * numBlocks.y)); };
+
+		std::vector<BYTE> occupied(totalBlocks, 0);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+		for (int b = 0; b < totalBlocks; b++) {
+			forEachDenseVoxel(blockCoordOf(b), offset, dim, [&](size_t x, size_t y, size_t z, UINT) {
+				if (isActive(x, y, z)) occupied[b] = 1;
+				return occupied[b] == 0;
+			});
+		}
+
+		std::vector<int> blocks;
+		for (int b = 0; b < totalBlocks; b++) {
+			if (!occupied[b]) continue;
+			touchBlock(blockCoordOf(b));
+			blocks.push_back(b);
+		}
+
+		const int numOccupied = (int)blocks.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+		for (int j = 0; j < numOccupied; j++) {
+			const vec3i blockCoord = blockCoordOf(blocks[j]);
+			Block& block = *findBlock(blockCoord);
+			forEachDenseVoxel(blockCoord, offset, dim, [&](size_t x, size_t y, size_t z, UINT i) {
+				if (isActive(x, y, z)) {
+					block.values[i] = getValue(x, y, z);
+					block.setActive(i);
+				}
+				return true;
+			});
+		}
+	}
+
+	//! calls f(x, y, z, localIndex) for the voxels of the block that lie inside the dense grid; stops when f returns false
+	template<class Func>
+	static void forEachDenseVoxel(const vec3i& blockCoord, const vec3i& offset, const vec3i& dim, Func f) {
+		const vec3i origin = blockCoord * BLOCK_DIM - offset;
+		for (UINT i = 0; i < (UINT)BLOCK_SIZE; i++) {
+			const vec3i g = origin + Block::localCoord(i);
+			if (g.x < 0 || g.y < 0 || g.z < 0 || g.x >= dim.x || g.y >= dim.y || g.z >= dim.z) continue;
+			if (!f((size_t)g.x, (size_t)g.y, (size_t)g.z, i)) return;
+		}
+	}
+
+	//! calls f(c - offset, value) for the active voxels inside [offset, offset + dim), in parallel over the blocks
+	template<class Func>
+	void toDense(const vec3i& offset, const vec3i& dim, Func f) const {
+		const int numBlocks = (int)m_blocks.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+		for (int b = 0; b < numBlocks; b++) {
+			const Block& block = *m_blocks[b];
+			const vec3i origin = m_blockCoords[b] * BLOCK_DIM - offset;
+			for (UINT i = 0; i < (UINT)BLOCK_SIZE; i++) {
+				if (!block.isActive(i)) continue;
+				const vec3i g = origin + Block::localCoord(i);
+				if (g.x < 0 || g.y < 0 || g.z < 0 || g.x >= dim.x || g.y >= dim.y || g.z >= dim.z) continue;
+				f(g, block.values[i]);
+			}
+		}
+	}
+
+	T m_background;
+	std::vector< std::unique_ptr<Block> > m_blocks;
+	std::vector<vec3i> m_blockCoords;
+	std::unordered_map<vec3i, size_t, std::hash<vec3i>> m_blockIndex;
+};
+
+typedef SparseBlockGrid3<float> SparseBlockGrid3f;
+typedef SparseBlockGrid3<double> SparseBlockGrid3d;
+
+}  // namespace ml
+
+#endif  // CORE_BASE_SPARSEBLOCKGRID3_H_
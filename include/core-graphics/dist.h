@@ -27,6 +27,71 @@ T distSq(const vec3<T> &ptA, const vec3<T> &ptB)
     return vec3<T>::distSq(ptA, ptB);
 }
 
+//
+// closest point to pt on the segment (a, b)
+//
+template <class T>
+vec3<T> closestPointOnSegment(const vec3<T> &pt, const vec3<T> &a, const vec3<T> &b)
+{
+    const vec3<T> ab = b - a;
+    const T l2 = ab.lengthSq();
+    if (l2 == (T)0) return a;
+    return a + ab * math::clamp(((pt - a) | ab) / l2, (T)0, (T)1);
+}
+
+//
+// closest point to pt on the triangle (a, b, c), found by the Voronoi region of pt (Ericson, Real-Time Collision Detection, 5.1.5)
+//
+template <class T>
+vec3<T> closestPointOnTriangle(const vec3<T> &pt, const vec3<T> &a, const vec3<T> &b, const vec3<T> &c)
+{
+    const vec3<T> ab = b - a, ac = c - a, ap = pt - a;
+
+    //a (nearly) zero-area triangle has no interior region, and the barycentric denominator below vanishes: use its longest edge
+    const T abSq = ab.lengthSq(), acSq = ac.lengthSq(), bcSq = vec3<T>::distSq(b, c);
+    const T maxEdgeSq = std::max(abSq, std::max(acSq, bcSq));
+    if ((ab ^ ac).lengthSq() <= std::numeric_limits<T>::epsilon() * maxEdgeSq * maxEdgeSq) {
+        if (maxEdgeSq == abSq) return closestPointOnSegment(pt, a, b);
+        if (maxEdgeSq == acSq) return closestPointOnSegment(pt, a, c);
+        return closestPointOnSegment(pt, b, c);
+    }
+
+    const T d1 = ab | ap, d2 = ac | ap;
+    if (d1 <= (T)0 && d2 <= (T)0) return a;
+
+    const vec3<T> bp = pt - b;
+    const T d3 = ab | bp, d4 = ac | bp;
+    if (d3 >= (T)0 && d4 <= d3) return b;
+
+    const T vc = d1 * d4 - d3 * d2;
+    if (vc <= (T)0 && d1 >= (T)0 && d3 <= (T)0) return a + ab * (d1 / (d1 - d3));
+
+    const vec3<T> cp = pt - c;
+    const T d5 = ab | cp, d6 = ac | cp;
+    if (d6 >= (T)0 && d5 <= d6) return c;
+
+    const T vb = d5 * d2 - d1 * d6;
+    if (vb <= (T)0 && d2 >= (T)0 && d6 <= (T)0) return a + ac * (d2 / (d2 - d6));
+
+    const T va = d3 * d6 - d5 * d4;
+    if (va <= (T)0 && (d4 - d3) >= (T)0 && (d5 - d6) >= (T)0) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    const T denom = (T)1 / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+template <class T>
+T distSq(const Triangle<T> &tri, const vec3<T> &pt)
+{
+    return vec3<T>::distSq(closestPointOnTriangle(pt, tri.vertices[0], tri.vertices[1], tri.vertices[2]), pt);
+}
+
+template <class T>
+T distSq(const vec3<T> &pt, const Triangle<T> &tri)
+{
+    return distSq(tri, pt);
+}
+
 template <class T>
 T distSq(const LineSegment2<T> &seg, const vec2<T> &p)
 {
@@ -0,0 +1,106 @@
+#ifndef CORE_MATH_ALIASTABLE_H_
+#define CORE_MATH_ALIASTABLE_H_
+
+namespace ml {
+
+	//! Walker/Vose alias table: O(n) construction, O(1) sampling of a discrete distribution given by non-negative weights
+	template<class FloatType>
+	class AliasTable
+	{
+	public:
+		AliasTable() {
+			m_totalWeight = 0;
+		}
+		AliasTable(const std::vector<FloatType>& weights) {
+			build(weights);
+		}
+
+		void build(const std::vector<FloatType>& weights) {
+			const size_t n = weights.size();
+			if (n > std::numeric_limits<UINT>::max()) throw MLIB_EXCEPTION("too many weights for an alias table");
+			m_probability.resize(n);
+			m_alias.resize(n);
+
+			double sum = 0.0;
+			for (size_t i = 0; i < n; i++) {
+				if (weights[i] < (FloatType)0) throw MLIB_EXCEPTION("negative weight");
+				sum += (double)weights[i];
+			}
+			m_totalWeight = (FloatType)sum;
+			if (n == 0 || sum <= 0.0) {
+				m_probability.clear();
+				m_alias.clear();
+				return;
+			}
+
+			//scale the weights so that the mean is 1 and split them into under- and overfull buckets
+			std::vector<double> scaled(n);
+			std::vector<UINT> small, large;
+			small.reserve(n);
+			large.reserve(n);
+			const double scale = (double)n / sum;
+			for (size_t i = 0; i < n; i++) {
+				scaled[i] = (double)weights[i] * scale;
+				if (scaled[i] < 1.0)	small.push_back((UINT)i);
+				else					large.push_back((UINT)i);
+			}
+
+			while (!small.empty() && !large.empty()) {
+				const UINT s = small.back();	small.pop_back();
+				const UINT l = large.back();
+				m_probability[s] = (FloatType)scaled[s];
+				m_alias[s] = l;
+				scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+				if (scaled[l] < 1.0) {
+					large.pop_back();
+					small.push_back(l);
+				}
+			}
+			//the remaining buckets are full (up to round-off)
+			for (UINT l : large) {
+				m_probability[l] = (FloatType)1;
+				m_alias[l] = l;
+			}
+			for (UINT s : small) {
+				m_probability[s] = (FloatType)1;
+				m_alias[s] = s;
+			}
+		}
+
+		//! draws an index given two uniform numbers in [0, 1)
+		UINT sample(double u0, double u1) const {
+			UINT bucket = (UINT)(u0 * (double)m_probability.size());
+			if (bucket >= m_probability.size()) bucket = (UINT)m_probability.size() - 1;
+			return u1 < (double)m_probability[bucket] ? bucket : m_alias[bucket];
+		}
+
+		//! draws an index using a single uniform number in [0, 1) (the fractional bucket position is reused)
+		UINT sample(double u) const {
+			const double x = u * (double)m_probability.size();
+			UINT bucket = (UINT)x;
+			if (bucket >= m_probability.size()) bucket = (UINT)m_probability.size() - 1;
+			return (x - (double)bucket) < (double)m_probability[bucket] ? bucket : m_alias[bucket];
+		}
+
+		size_t size() const {
+			return m_probability.size();
+		}
+		bool empty() const {
+			return m_probability.empty();
+		}
+		FloatType getTotalWeight() const {
+			return m_totalWeight;
+		}
+
+	private:
+		std::vector<FloatType>	m_probability;
+		std::vector<UINT>		m_alias;
+		FloatType				m_totalWeight;
+	};
+
+	typedef AliasTable<float> AliasTablef;
+	typedef AliasTable<double> AliasTabled;
+
+}  // namespace ml
+
+#endif  // CORE_MATH_ALIASTABLE_H_
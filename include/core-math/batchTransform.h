@@ -0,0 +1,183 @@
+#ifndef CORE_MATH_BATCHTRANSFORM_H_
+#define CORE_MATH_BATCHTRANSFORM_H_
+
+namespace ml {
+
+//
+// Bulk transforms of 3D points and normals (used by TriMesh, TriMeshSoA, MeshData and PointCloud).
+// Inputs are addressed with a pointer and a byte stride, so the kernels work on tightly packed vec3 arrays as well as
+// on vec3 members inside larger vertex structs. Elements are processed in fixed-size blocks that are de-interleaved
+// into local x/y/z arrays, which lets the compiler vectorize the arithmetic; blocks are distributed over threads.
+// Source and destination may alias (in-place transforms).
+//
+
+//! number of elements per block (and per OpenMP work item)
+#define MLIB_BATCH_TRANSFORM_BLOCK 256
+
+template<class FloatType>
+struct BatchTransformBlock {
+	FloatType x[MLIB_BATCH_TRANSFORM_BLOCK];
+	FloatType y[MLIB_BATCH_TRANSFORM_BLOCK];
+	FloatType z[MLIB_BATCH_TRANSFORM_BLOCK];
+
+	void load(const FloatType* src, size_t stride, size_t n) {
+		const char* ptr = (const char*)src;
+		for (size_t i = 0; i < n; i++) {
+			const FloatType* p = (const FloatType*)(ptr + i*stride);
+			x[i] = p[0];	y[i] = p[1];	z[i] = p[2];
+		}
+	}
+	void store(FloatType* dst, size_t stride, size_t n) const {
+		char* ptr = (char*)dst;
+		for (size_t i = 0; i < n; i++) {
+			FloatType* p = (FloatType*)(ptr + i*stride);
+			p[0] = x[i];	p[1] = y[i];	p[2] = z[i];
+		}
+	}
+
+	//! m is row-major (see Matrix4x4)
+	void transformPointsAffine(const FloatType* m, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			const FloatType px = x[i], py = y[i], pz = z[i];
+			x[i] = m[0] * px + m[1] * py + m[2] * pz + m[3];
+			y[i] = m[4] * px + m[5] * py + m[6] * pz + m[7];
+			z[i] = m[8] * px + m[9] * py + m[10] * pz + m[11];
+		}
+	}
+	//! same as Matrix4x4 * vec3 (implicit w=1 and subsequent de-homogenization)
+	void transformPointsProjective(const FloatType* m, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			const FloatType px = x[i], py = y[i], pz = z[i];
+			const FloatType invW = (FloatType)1 / (m[12] * px + m[13] * py + m[14] * pz + m[15]);
+			x[i] = (m[0] * px + m[1] * py + m[2] * pz + m[3]) * invW;
+			y[i] = (m[4] * px + m[5] * py + m[6] * pz + m[7]) * invW;
+			z[i] = (m[8] * px + m[9] * py + m[10] * pz + m[11]) * invW;
+		}
+	}
+	//! m is the normal matrix (inverse transpose); zero-length normals stay zero
+	void transformNormals(const FloatType* m, size_t n, bool normalize) {
+		for (size_t i = 0; i < n; i++) {
+			const FloatType nx = x[i], ny = y[i], nz = z[i];
+			x[i] = m[0] * nx + m[1] * ny + m[2] * nz;
+			y[i] = m[4] * nx + m[5] * ny + m[6] * nz;
+			z[i] = m[8] * nx + m[9] * ny + m[10] * nz;
+		}
+		if (normalize) {
+			for (size_t i = 0; i < n; i++) {
+				const FloatType lSq = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+				const FloatType s = lSq > (FloatType)0 ? (FloatType)1 / std::sqrt(lSq) : (FloatType)1;
+				x[i] *= s;	y[i] *= s;	z[i] *= s;
+			}
+		}
+	}
+};
+
+template<class FloatType>
+inline bool isAffineTransform(const Matrix4x4<FloatType>& m) {
+	return m(3, 0) == (FloatType)0 && m(3, 1) == (FloatType)0 && m(3, 2) == (FloatType)0 && m(3, 3) == (FloatType)1;
+}
+
+//! points and/or normals in one pass; either pointer may be null
+template<class FloatType>
+void transformPointsAndNormals(const Matrix4x4<FloatType>& m,
+	FloatType* points, size_t pointStride,
+	FloatType* normals, size_t normalStride,
+	size_t count, bool normalize = true)
+{
+	if (count == 0) return;
+	const bool affine = isAffineTransform(m);
+	const Matrix4x4<FloatType> normalMatrix = normals ? m.getInverse().getTranspose() : Matrix4x4<FloatType>::identity();
+	const FloatType* pm = m.getData();
+	const FloatType* nm = normalMatrix.getData();
+
+	const int numBlocks = (int)((count + MLIB_BATCH_TRANSFORM_BLOCK - 1) / MLIB_BATCH_TRANSFORM_BLOCK);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for if(numBlocks > 4)
+#endif
+	for (int b = 0; b < numBlocks; b++) {
+		const size_t begin = (size_t)b * MLIB_BATCH_TRANSFORM_BLOCK;
+		const size_t n = std::min((size_t)MLIB_BATCH_TRANSFORM_BLOCK, count - begin);
+		BatchTransformBlock<FloatType> block;
+		if (points) {
+			FloatType* p = (FloatType*)((char*)points + begin*pointStride);
+			block.load(p, pointStride, n);
+			if (affine) block.transformPointsAffine(pm, n);
+			else		block.transformPointsProjective(pm, n);
+			block.store(p, pointStride, n);
+		}
+		if (normals) {
+			FloatType* p = (FloatType*)((char*)normals + begin*normalStride);
+			block.load(p, normalStride, n);
+			block.transformNormals(nm, n, normalize);
+			block.store(p, normalStride, n);
+		}
+	}
+}
+
+//! dst[i] = m * src[i] (same semantics as Matrix4x4 * vec3; affine matrices take a faster path)
+template<class FloatType>
+void transformPoints(const Matrix4x4<FloatType>& m,
+	const FloatType* src, size_t srcStride,
+	FloatType* dst, size_t dstStride,
+	size_t count)
+{
+	if (count == 0) return;
+	const bool affine = isAffineTransform(m);
+	const FloatType* pm = m.getData();
+
+	const int numBlocks = (int)((count + MLIB_BATCH_TRANSFORM_BLOCK - 1) / MLIB_BATCH_TRANSFORM_BLOCK);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for if(numBlocks > 4)
+#endif
+	for (int b = 0; b < numBlocks; b++) {
+		const size_t begin = (size_t)b * MLIB_BATCH_TRANSFORM_BLOCK;
+		const size_t n = std::min((size_t)MLIB_BATCH_TRANSFORM_BLOCK, count - begin);
+		BatchTransformBlock<FloatType> block;
+		block.load((const FloatType*)((const char*)src + begin*srcStride), srcStride, n);
+		if (affine) block.transformPointsAffine(pm, n);
+		else		block.transformPointsProjective(pm, n);
+		block.store((FloatType*)((char*)dst + begin*dstStride), dstStride, n);
+	}
+}
+
+//! m is the point transform; normals are transformed by its inverse transpose and re-normalized (if non-zero)
+template<class FloatType>
+void transformNormals(const Matrix4x4<FloatType>& m,
+	const FloatType* src, size_t srcStride,
+	FloatType* dst, size_t dstStride,
+	size_t count, bool normalize = true)
+{
+	if (count == 0) return;
+	const Matrix4x4<FloatType> normalMatrix = m.getInverse().getTranspose();
+	const FloatType* nm = normalMatrix.getData();
+
+	const int numBlocks = (int)((count + MLIB_BATCH_TRANSFORM_BLOCK - 1) / MLIB_BATCH_TRANSFORM_BLOCK);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for if(numBlocks > 4)
+#endif
+	for (int b = 0; b < numBlocks; b++) {
+		const size_t begin = (size_t)b * MLIB_BATCH_TRANSFORM_BLOCK;
+		const size_t n = std::min((size_t)MLIB_BATCH_TRANSFORM_BLOCK, count - begin);
+		BatchTransformBlock<FloatType> block;
+		block.load((const FloatType*)((const char*)src + begin*srcStride), srcStride, n);
+		block.transformNormals(nm, n, normalize);
+		block.store((FloatType*)((char*)dst + begin*dstStride), dstStride, n);
+	}
+}
+
+//! in-place convenience versions for tightly packed arrays
+template<class FloatType>
+void transformPoints(const Matrix4x4<FloatType>& m, std::vector<vec3<FloatType>>& points) {
+	if (points.empty()) return;
+	transformPoints(m, (const FloatType*)points.data(), sizeof(vec3<FloatType>), (FloatType*)points.data(), sizeof(vec3<FloatType>), points.size());
+}
+
+template<class FloatType>
+void transformNormals(const Matrix4x4<FloatType>& m, std::vector<vec3<FloatType>>& normals, bool normalize = true) {
+	if (normals.empty()) return;
+	transformNormals(m, (const FloatType*)normals.data(), sizeof(vec3<FloatType>), (FloatType*)normals.data(), sizeof(vec3<FloatType>), normals.size(), normalize);
+}
+
+}  // namespace ml
+
+#endif  // CORE_MATH_BATCHTRANSFORM_H_
@@ -0,0 +1,72 @@
+#ifndef CORE_MATH_COUNTERRNG_H_
+#define CORE_MATH_COUNTERRNG_H_
+
+namespace ml {
+
+	//! counter-based random number generator: the n-th number of a stream is a pure function of (seed, stream, n)
+	//! there is no shared state, so parallel loops can use one stream per work item (e.g., per sample index) and
+	//! produce the same results for any number of threads; based on the SplitMix64 finalizer
+	class CounterRNG
+	{
+	public:
+		CounterRNG(UINT64 seed = 0, UINT64 stream = 0) {
+			setStream(seed, stream);
+		}
+
+		void setStream(UINT64 seed, UINT64 stream) {
+			m_key = mix(seed + mix(stream + 0x632BE59BD9B4E019ull));
+			m_counter = 0;
+		}
+
+		UINT64 getCounter() const {
+			return m_counter;
+		}
+		void setCounter(UINT64 counter) {
+			m_counter = counter;
+		}
+
+		//! random access into a stream (without advancing any generator)
+		static UINT64 hash(UINT64 seed, UINT64 stream, UINT64 counter) {
+			CounterRNG rng(seed, stream);
+			rng.setCounter(counter);
+			return rng.rand64();
+		}
+
+		UINT64 rand64() {
+			return mix(m_key + (++m_counter) * 0x9E3779B97F4A7C15ull);
+		}
+		UINT rand32() {
+			return (UINT)(rand64() >> 32);
+		}
+
+		//! uniform in [0, 1)
+		double uniform() {
+			return (double)(rand64() >> 11) * (1.0 / 9007199254740992.0);
+		}
+		//! uniform in [0, 1)
+		float uniformf() {
+			return (float)(rand32() >> 8) * (1.0f / 16777216.0f);
+		}
+		//! uniform in [_min, _max)
+		double uniform(double _min, double _max) {
+			return _min + (_max - _min) * uniform();
+		}
+		//! uniform integer in [0, n)
+		UINT uniformIndex(UINT n) {
+			return (UINT)(((UINT64)rand32() * (UINT64)n) >> 32);
+		}
+
+	private:
+		static UINT64 mix(UINT64 z) {
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		UINT64 m_key;
+		UINT64 m_counter;
+	};
+
+}  // namespace ml
+
+#endif  // CORE_MATH_COUNTERRNG_H_
@@ -0,0 +1,543 @@
+#ifndef CORE_MESH_GRIDMESHER_H_
+#define CORE_MESH_GRIDMESHER_H_
+
+namespace ml {
+
+	//! surface extraction from voxel grids:
+	//! marchingCubes extracts the iso-surface of a scalar grid (Grid3, DistanceField3, SparseBlockGrid3) as an indexed mesh
+	//! in which every grid edge crossing yields exactly one (shared) vertex; greedyMesh turns the boundary faces of a
+	//! BinaryGrid3 into as few quads as possible (instead of a cube per voxel, as TriMesh(const BinaryGrid3&) does).
+	//! Voxel (x,y,z) is located at (x,y,z) before voxelToWorld is applied.
+	template<class FloatType>
+	class GridMesher {
+	public:
+		typedef typename TriMesh<FloatType>::Vertex Vertex;
+
+		//! generates the case tables, which marchingCubes otherwise does on first use; call it before meshing from several
+		//! threads, since compilers before Visual Studio 2015 do not initialize function-local statics thread-safely
+		static void initTables() {
+			getCubeTables();
+		}
+
+		//! voxels with values below isoValue are inside; triangles face outwards (towards larger values), normals are
+		//! the normalized value gradients. Cells with non-finite values (e.g., beyond the truncation of a distance field) are skipped.
+		//! colors (optional) must have the dimensions of grid and are interpolated along the edges.
+		static TriMesh<FloatType> marchingCubes(const Grid3<FloatType>& grid, FloatType isoValue = 0, const Matrix4x4<FloatType>& voxelToWorld = Matrix4x4<FloatType>::identity(), bool withNormals = true, const Grid3<vec4<FloatType>>* colors = nullptr) {
+			const int dimX = (int)grid.getDimX(), dimY = (int)grid.getDimY(), dimZ = (int)grid.getDimZ();
+			if (colors && (colors->getDimX() != grid.getDimX() || colors->getDimY() != grid.getDimY() || colors->getDimZ() != grid.getDimZ())) {
+				throw MLIB_EXCEPTION("color grid dimensions do not match");
+			}
+			if (dimX < 2 || dimY < 2 || dimZ < 2) return TriMesh<FloatType>();
+
+			const CubeTables& tables = getCubeTables();
+			const VertexTransform transform(voxelToWorld);
+			const FloatType* data = grid.getData();
+			const size_t sliceSize = (size_t)dimX * dimY;
+
+			auto value = [&](int x, int y, int z) { return data[sliceSize * z + (size_t)dimX * y + x]; };
+			auto gradient = [&](int x, int y, int z) {
+				return finiteDifferenceGradient(vec3i(x, y, z), [&](const vec3i& c, FloatType& v) {
+					if (c.x < 0 || c.y < 0 || c.z < 0 || c.x >= dimX || c.y >= dimY || c.z >= dimZ) return false;
+					v = value(c.x, c.y, c.z);
+					return std::isfinite(v) != 0;
+				});
+			};
+
+			//! visits the crossing edges starting at the points of plane z (x-, y- and z-edge per point, row by row);
+			//! vertex ids are assigned in this order, starting at firstId
+			auto scanPlane = [&](int z, UINT firstId, std::vector<UINT>* ids, std::vector<Vertex>* vertices) {
+				UINT id = firstId;
+				for (int y = 0; y < dimY; y++) {
+					for (int x = 0; x < dimX; x++) {
+						const FloatType v0 = value(x, y, z);
+						for (int axis = 0; axis < 3; axis++) {
+							const vec3i c1(x + (axis == 0), y + (axis == 1), z + (axis == 2));
+							UINT edgeId = INVALID_ID;
+							if (c1.x < dimX && c1.y < dimY && c1.z < dimZ) {
+								const FloatType v1 = value(c1.x, c1.y, c1.z);
+								if (isCrossing(v0, v1, isoValue)) {
+									edgeId = id++;
+									if (vertices) {
+										const FloatType t = (isoValue - v0) / (v1 - v0);
+										vec4<FloatType> color = vec4<FloatType>::origin;
+										if (colors) color = (*colors)(x, y, z) * ((FloatType)1 - t) + (*colors)(c1.x, c1.y, c1.z) * t;
+										vec3<FloatType> normal = vec3<FloatType>::origin;
+										if (withNormals) normal = gradient(x, y, z) * ((FloatType)1 - t) + gradient(c1.x, c1.y, c1.z) * t;
+										(*vertices)[edgeId] = transform.makeVertex(vec3<FloatType>((FloatType)x, (FloatType)y, (FloatType)z), axis, t, normal, color);
+									}
+								}
+							}
+							if (ids) (*ids)[((size_t)dimX * y + x) * 3 + axis] = edgeId;
+						}
+					}
+				}
+				return id - firstId;
+			};
+
+			//slabs of cell layers are processed in parallel; a slab owns the vertices of the planes [z0, z1), the last slab
+			//also owns the last plane. The number of slabs only depends on the grid size, so the output is deterministic.
+			const int numCellLayers = dimZ - 1;
+			const int numSlabs = std::min(64, std::max(1, numCellLayers / 4));
+			std::vector<UINT> slabVertexCount(numSlabs, 0);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+			for (int s = 0; s < numSlabs; s++) {
+				const int z0 = numCellLayers * s / numSlabs, z1 = numCellLayers * (s + 1) / numSlabs;
+				const int lastPlane = (s == numSlabs - 1) ? z1 : z1 - 1;
+				for (int z = z0; z <= lastPlane; z++) slabVertexCount[s] += scanPlane(z, 0, nullptr, nullptr);
+			}
+			std::vector<UINT> slabFirstVertex(numSlabs + 1, 0);
+			for (int s = 0; s < numSlabs; s++) slabFirstVertex[s + 1] = slabFirstVertex[s] + slabVertexCount[s];
+
+			std::vector<Vertex> vertices(slabFirstVertex[numSlabs]);
+			std::vector< std::vector<vec3ui> > slabTriangles(numSlabs);
+			std::vector<BYTE> slabSkippedCells(numSlabs, 0);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+			for (int s = 0; s < numSlabs; s++) {
+				const int z0 = numCellLayers * s / numSlabs, z1 = numCellLayers * (s + 1) / numSlabs;
+				std::vector<UINT> lower(sliceSize * 3), upper(sliceSize * 3);
+				UINT nextId = slabFirstVertex[s];
+				nextId += scanPlane(z0, nextId, &lower, &vertices);
+				for (int z = z0; z < z1; z++) {
+					//the first plane of the next slab is only indexed (with that slab's ids), not emitted
+					if (z + 1 < z1 || s == numSlabs - 1) nextId += scanPlane(z + 1, nextId, &upper, &vertices);
+					else scanPlane(z + 1, slabFirstVertex[s + 1], &upper, nullptr);
+
+					const std::vector<UINT>* planes[2] = { &lower, &upper };
+					for (int y = 0; y + 1 < dimY; y++) {
+						for (int x = 0; x + 1 < dimX; x++) {
+							FloatType corners[8];
+							bool finite = true;
+							for (int c = 0; c < 8; c++) {
+								corners[c] = value(x + (c & 1), y + ((c >> 1) & 1), z + (c >> 2));
+								finite &= std::isfinite(corners[c]) != 0;
+							}
+							if (!finite) {
+								slabSkippedCells[s] = 1;
+								continue;
+							}
+							tables.triangulate(corners, isoValue, transform.flipped, slabTriangles[s], [&](int edge) {
+								const vec3i& b = tables.edgeBase[edge];
+								return (*planes[b.z])[((size_t)dimX * (y + b.y) + x + b.x) * 3 + tables.edgeAxis[edge]];
+							});
+						}
+					}
+					std::swap(lower, upper);
+				}
+			}
+
+			bool anySkipped = false;
+			for (int s = 0; s < numSlabs; s++) anySkipped |= slabSkippedCells[s] != 0;
+			return makeMesh(vertices, slabTriangles, anySkipped, withNormals, colors != nullptr);
+		}
+
+		//! iso-surface of the cells whose eight corners are active; see above
+		static TriMesh<FloatType> marchingCubes(const SparseBlockGrid3<FloatType>& grid, FloatType isoValue = 0, const Matrix4x4<FloatType>& voxelToWorld = Matrix4x4<FloatType>::identity(), bool withNormals = true) {
+			typedef SparseBlockGrid3<FloatType> Grid;
+			const int numBlocks = (int)grid.getNumBlocks();
+			if (numBlocks == 0) return TriMesh<FloatType>();
+
+			const CubeTables& tables = getCubeTables();
+			const VertexTransform transform(voxelToWorld);
+
+			//every block owns the edges starting at its voxels
+			std::vector< std::vector<UINT> > blockEdgeIds(numBlocks);
+			std::vector< std::vector<Vertex> > blockVertices(numBlocks);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+			for (int b = 0; b < numBlocks; b++) {
+				typename Grid::ConstAccessor accessor = grid.getAccessor();
+				auto lookup = [&](const vec3i& c, FloatType& v) {
+					if (!accessor.isActive(c)) return false;
+					v = accessor.getValue(c);
+					return std::isfinite(v) != 0;
+				};
+				const typename Grid::Block& block = grid.getBlock(b);
+				const vec3i origin = grid.getBlockCoord(b) * Grid::BLOCK_DIM;
+				std::vector<UINT>& ids = blockEdgeIds[b];
+				ids.assign(Grid::BLOCK_SIZE * 3, INVALID_ID);
+				for (UINT i = 0; i < (UINT)Grid::BLOCK_SIZE; i++) {
+					const FloatType v0 = block.values[i];
+					if (!block.isActive(i) || !std::isfinite(v0)) continue;
+					const vec3i c0 = origin + Grid::Block::localCoord(i);
+					for (int axis = 0; axis < 3; axis++) {
+						vec3i c1 = c0;
+						c1[axis]++;
+						FloatType v1;
+						if (!lookup(c1, v1) || !isCrossing(v0, v1, isoValue)) continue;
+						const FloatType t = (isoValue - v0) / (v1 - v0);
+						vec3<FloatType> normal = vec3<FloatType>::origin;
+						if (withNormals) normal = finiteDifferenceGradient(c0, lookup) * ((FloatType)1 - t) + finiteDifferenceGradient(c1, lookup) * t;
+						ids[i * 3 + axis] = (UINT)blockVertices[b].size();
+						blockVertices[b].push_back(transform.makeVertex(vec3<FloatType>(c0), axis, t, normal, vec4<FloatType>::origin));
+					}
+				}
+			}
+
+			std::vector<UINT> blockFirstVertex(numBlocks + 1, 0);
+			for (int b = 0; b < numBlocks; b++) blockFirstVertex[b + 1] = blockFirstVertex[b] + (UINT)blockVertices[b].size();
+			std::vector<Vertex> vertices(blockFirstVertex[numBlocks]);
+
+			std::vector< std::vector<vec3ui> > blockTriangles(numBlocks);
+			std::vector<BYTE> blockSkippedCells(numBlocks, 0);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+			for (int b = 0; b < numBlocks; b++) {
+				std::copy(blockVertices[b].begin(), blockVertices[b].end(), vertices.begin() + blockFirstVertex[b]);
+				typename Grid::ConstAccessor accessor = grid.getAccessor();
+				const vec3i blockCoord = grid.getBlockCoord(b);
+				const vec3i origin = blockCoord * Grid::BLOCK_DIM;
+
+				//edges of the cells at the upper block faces start in the neighboring blocks
+				vec3i cachedCoord = blockCoord;
+				size_t cachedBlock = b;
+				auto edgeVertex = [&](const vec3i& c, int axis) {
+					const vec3i coord = Grid::toBlockCoord(c);
+					if (coord != cachedCoord) {
+						cachedCoord = coord;
+						cachedBlock = grid.getBlockIndex(coord);
+					}
+					return blockFirstVertex[cachedBlock] + blockEdgeIds[cachedBlock][Grid::toLocalIndex(c) * 3 + axis];
+				};
+
+				for (UINT i = 0; i < (UINT)Grid::BLOCK_SIZE; i++) {
+					if (!grid.getBlock(b).isActive(i)) continue;
+					const vec3i c0 = origin + Grid::Block::localCoord(i);
+					FloatType corners[8];
+					bool valid = true, finite = true;
+					for (int c = 0; c < 8 && valid; c++) {
+						const vec3i cc = c0 + vec3i(c & 1, (c >> 1) & 1, c >> 2);
+						valid = accessor.isActive(cc);
+						if (valid) {
+							corners[c] = accessor.getValue(cc);
+							finite &= std::isfinite(corners[c]) != 0;
+						}
+					}
+					if (!valid) continue;
+					if (!finite) {
+						blockSkippedCells[b] = 1;
+						continue;
+					}
+					tables.triangulate(corners, isoValue, transform.flipped, blockTriangles[b], [&](int edge) {
+						return edgeVertex(c0 + tables.edgeBase[edge], tables.edgeAxis[edge]);
+					});
+				}
+			}
+
+			bool anySkipped = false;
+			for (int b = 0; b < numBlocks; b++) anySkipped |= blockSkippedCells[b] != 0;
+			return makeMesh(vertices, blockTriangles, anySkipped, withNormals, false);
+		}
+
+		//! merges coplanar boundary faces of the set voxels into maximal rectangles (two triangles each); the surface is the
+		//! same as that of TriMesh(const BinaryGrid3&), voxels span [x-0.5, x+0.5]
+		static TriMesh<FloatType> greedyMesh(const BinaryGrid3& grid, const Matrix4x4<FloatType>& voxelToWorld = Matrix4x4<FloatType>::identity(), bool withNormals = false, const vec4<FloatType>& color = vec4<FloatType>(0.5, 0.5, 0.5, 0.5)) {
+			const int dims[3] = { (int)grid.getDimX(), (int)grid.getDimY(), (int)grid.getDimZ() };
+			const VertexTransform transform(voxelToWorld);
+
+			//one task per slice and face direction
+			std::vector<vec3i> tasks;	//axis, side, slice
+			for (int axis = 0; axis < 3; axis++) {
+				for (int side = 0; side < 2; side++) {
+					for (int slice = 0; slice < dims[axis]; slice++) tasks.push_back(vec3i(axis, side, slice));
+				}
+			}
+			const int numTasks = (int)tasks.size();
+			std::vector< std::vector<Vertex> > taskVertices(numTasks);
+
+#ifdef MLIB_OPENMP
+#pragma omp parallel
+#endif
+			{
+				std::vector<BYTE> mask;
+#ifdef MLIB_OPENMP
+#pragma omp for schedule(dynamic, 4)
+#endif
+				for (int task = 0; task < numTasks; task++) {
+					const int axis = tasks[task].x, side = tasks[task].y, slice = tasks[task].z;
+					const int u = (axis + 1) % 3, v = (axis + 2) % 3;
+					const int dimU = dims[u], dimV = dims[v];
+					auto isSet = [&](int a, int cu, int cv) {
+						if (a < 0 || a >= dims[axis]) return false;
+						size_t c[3];
+						c[axis] = a; c[u] = cu; c[v] = cv;
+						return grid.isVoxelSet(c[0], c[1], c[2]);
+					};
+
+					mask.resize((size_t)dimU * dimV);
+					const int neighbor = side ? slice + 1 : slice - 1;
+					for (int cv = 0; cv < dimV; cv++) {
+						for (int cu = 0; cu < dimU; cu++) {
+							mask[(size_t)cv * dimU + cu] = isSet(slice, cu, cv) && !isSet(neighbor, cu, cv);
+						}
+					}
+
+					vec3<FloatType> normal = vec3<FloatType>::origin;
+					normal[axis] = side ? (FloatType)1 : (FloatType)-1;
+					normal = transform.transformNormal(normal);
+					const FloatType plane = (FloatType)slice + (side ? (FloatType)0.5 : (FloatType)-0.5);
+
+					for (int cv = 0; cv < dimV; cv++) {
+						for (int cu = 0; cu < dimU; cu++) {
+							if (!mask[(size_t)cv * dimU + cu]) continue;
+							int width = 1, height = 1;
+							while (cu + width < dimU && mask[(size_t)cv * dimU + cu + width]) width++;
+							for (bool grow = true; grow && cv + height < dimV; ) {
+								for (int k = 0; k < width && grow; k++) grow = mask[(size_t)(cv + height) * dimU + cu + k] != 0;
+								if (grow) height++;
+							}
+							for (int h = 0; h < height; h++) {
+								std::fill(mask.begin() + (size_t)(cv + h) * dimU + cu, mask.begin() + (size_t)(cv + h) * dimU + cu + width, 0);
+							}
+
+							//(u, v, axis) is right-handed, so the corners are counter-clockwise seen from +axis
+							const FloatType u0 = (FloatType)cu - (FloatType)0.5, u1 = u0 + (FloatType)width;
+							const FloatType v0 = (FloatType)cv - (FloatType)0.5, v1 = v0 + (FloatType)height;
+							const FloatType quad[4][2] = { { u0, v0 }, { u1, v0 }, { u1, v1 }, { u0, v1 } };
+							const bool reverse = (side == 0) != transform.flipped;
+							for (int k = 0; k < 4; k++) {
+								const int q = reverse ? 3 - k : k;
+								vec3<FloatType> p;
+								p[axis] = plane; p[u] = quad[q][0]; p[v] = quad[q][1];
+								taskVertices[task].push_back(Vertex(transform.voxelToWorld * p, normal, color, vec2<FloatType>::origin));
+							}
+						}
+					}
+				}
+			}
+
+			std::vector<size_t> taskFirstVertex(numTasks + 1, 0);
+			for (int task = 0; task < numTasks; task++) taskFirstVertex[task + 1] = taskFirstVertex[task] + taskVertices[task].size();
+			std::vector<Vertex> vertices(taskFirstVertex[numTasks]);
+			std::vector<vec3ui> indices(taskFirstVertex[numTasks] / 2);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int task = 0; task < numTasks; task++) {
+				const size_t first = taskFirstVertex[task];
+				std::copy(taskVertices[task].begin(), taskVertices[task].end(), vertices.begin() + first);
+				for (size_t q = first; q < first + taskVertices[task].size(); q += 4) {
+					indices[q / 2 + 0] = vec3ui((UINT)q, (UINT)q + 1, (UINT)q + 2);
+					indices[q / 2 + 1] = vec3ui((UINT)q, (UINT)q + 2, (UINT)q + 3);
+				}
+			}
+			return TriMesh<FloatType>(vertices, indices, false, withNormals, false, true);
+		}
+
+	private:
+		static const UINT INVALID_ID = (UINT)-1;
+
+		static bool isCrossing(FloatType v0, FloatType v1, FloatType isoValue) {
+			return std::isfinite(v0) && std::isfinite(v1) && ((v0 < isoValue) != (v1 < isoValue));
+		}
+
+		//! central differences; one-sided where a neighbor is missing (lookup returns false)
+		template<class Lookup>
+		static vec3<FloatType> finiteDifferenceGradient(const vec3i& c, Lookup lookup) {
+			vec3<FloatType> g;
+			FloatType center = 0;
+			lookup(c, center);
+			for (int axis = 0; axis < 3; axis++) {
+				vec3i lo = c, hi = c;
+				lo[axis]--; hi[axis]++;
+				FloatType vLo, vHi;
+				const bool hasLo = lookup(lo, vLo), hasHi = lookup(hi, vHi);
+				if (hasLo && hasHi)	g[axis] = (vHi - vLo) * (FloatType)0.5;
+				else if (hasHi)		g[axis] = vHi - center;
+				else if (hasLo)		g[axis] = center - vLo;
+				else				g[axis] = 0;
+			}
+			return g;
+		}
+
+		struct VertexTransform {
+			VertexTransform(const Matrix4x4<FloatType>& _voxelToWorld) : voxelToWorld(_voxelToWorld) {
+				normalMatrix = voxelToWorld.getMatrix3x3().getInverse().getTranspose();
+				flipped = voxelToWorld.getMatrix3x3().det() < 0;
+			}
+			vec3<FloatType> transformNormal(const vec3<FloatType>& n) const {
+				const vec3<FloatType> result = normalMatrix * n;
+				const FloatType length = result.length();
+				return length > 0 ? result / length : result;
+			}
+			//! vertex on the edge from p0 along axis
+			Vertex makeVertex(const vec3<FloatType>& p0, int axis, FloatType t, const vec3<FloatType>& gradient, const vec4<FloatType>& color) const {
+				vec3<FloatType> p = p0;
+				p[axis] += t;
+				return Vertex(voxelToWorld * p, transformNormal(gradient), color, vec2<FloatType>::origin);
+			}
+			Matrix4x4<FloatType> voxelToWorld;
+			Matrix3x3<FloatType> normalMatrix;
+			bool flipped;		//the transformation mirrors, so triangles must be reversed
+		};
+
+		//! marching cubes case table, generated instead of hard-coded: corner c of a cell is at (c&1, (c>>1)&1, c>>2),
+		//! edge 4*axis + k starts at the corner given by k in the two other axes (lower axis first)
+		struct CubeTables {
+			static const int MAX_CASE_INDICES = 30;
+
+			CubeTables() {
+				int edgeCorners[12][2];
+				for (int axis = 0; axis < 3; axis++) {
+					const int lo = axis == 0 ? 1 : 0, hi = axis == 2 ? 1 : 2;
+					for (int k = 0; k < 4; k++) {
+						const int e = axis * 4 + k;
+						const int c0 = ((k & 1) << lo) | ((k >> 1) << hi);
+						edgeCorners[e][0] = c0;
+						edgeCorners[e][1] = c0 | (1 << axis);
+						edgeAxis[e] = axis;
+						edgeBase[e] = vec3i(c0 & 1, (c0 >> 1) & 1, c0 >> 2);
+					}
+				}
+				auto edgeBetween = [&](int c0, int c1) {
+					for (int e = 0; e < 12; e++) {
+						if ((edgeCorners[e][0] == c0 && edgeCorners[e][1] == c1) || (edgeCorners[e][0] == c1 && edgeCorners[e][1] == c0)) return e;
+					}
+					return -1;
+				};
+
+				//the faces of the cell with their corners counter-clockwise seen from outside
+				int faces[6][4];
+				for (int axis = 0; axis < 3; axis++) {
+					const int u = (axis + 1) % 3, v = (axis + 2) % 3;
+					for (int side = 0; side < 2; side++) {
+						const int base = side << axis;
+						const int cycle[4] = { base, base | (1 << u), base | (1 << u) | (1 << v), base | (1 << v) };
+						for (int i = 0; i < 4; i++) faces[axis * 2 + side][i] = side ? cycle[i] : cycle[3 - i];
+					}
+				}
+
+				auto shareFace = [&](int e0, int e1) {
+					for (int f = 0; f < 6; f++) {
+						bool has0 = false, has1 = false;
+						for (int i = 0; i < 4; i++) {
+							const int e = edgeBetween(faces[f][i], faces[f][(i + 1) % 4]);
+							has0 |= e == e0;
+							has1 |= e == e1;
+						}
+						if (has0 && has1) return true;
+					}
+					return false;
+				};
+
+				//on every face, the contour runs from each edge where the boundary leaves the inside to the previous edge
+				//where it enters (cutting off the inside corner in the ambiguous case, consistently for both cells sharing
+				//the face). The segments close into loops that run clockwise seen from outside.
+				for (int config = 0; config < 256; config++) {
+					auto inside = [&](int c) { return ((config >> c) & 1) != 0; };
+					int next[12];
+					for (int e = 0; e < 12; e++) next[e] = -1;
+					for (int f = 0; f < 6; f++) {
+						for (int i = 0; i < 4; i++) {
+							if (!inside(faces[f][i]) || inside(faces[f][(i + 1) % 4])) continue;
+							for (int j = 1; j < 4; j++) {
+								const int a = faces[f][(i + 4 - j) % 4], b = faces[f][(i + 5 - j) % 4];
+								if (inside(a) != inside(b)) {
+									next[edgeBetween(faces[f][i], faces[f][(i + 1) % 4])] = edgeBetween(a, b);
+									break;
+								}
+							}
+						}
+					}
+
+					//loops are triangulated by clipping ears (reversing the orientation), avoiding diagonals along a cell face:
+					//those would coincide with a contour segment of the neighboring cell
+					numIndices[config] = 0;
+					bool visited[12] = { false };
+					for (int e = 0; e < 12; e++) {
+						if (next[e] < 0 || visited[e]) continue;
+						std::vector<int> loop;
+						for (int k = e; !visited[k]; k = next[k]) {
+							visited[k] = true;
+							loop.push_back(k);
+						}
+						while (loop.size() >= 3) {
+							const int n = (int)loop.size();
+							int ear = 0;
+							for (int k = 0; k < n && n > 3; k++) {
+								if (!shareFace(loop[(k + n - 1) % n], loop[(k + 1) % n])) {
+									ear = k;
+									break;
+								}
+							}
+							MLIB_ASSERT(numIndices[config] + 3 <= MAX_CASE_INDICES);
+							indices[config][numIndices[config]++] = (signed char)loop[(ear + 1) % n];
+							indices[config][numIndices[config]++] = (signed char)loop[ear];
+							indices[config][numIndices[config]++] = (signed char)loop[(ear + n - 1) % n];
+							loop.erase(loop.begin() + ear);
+							if (n == 3) break;
+						}
+					}
+				}
+			}
+
+			//! appends the triangles of the cell; edgeVertex(edge) returns the vertex id of a crossing edge
+			template<class EdgeVertex>
+			void triangulate(const FloatType corners[8], FloatType isoValue, bool flipped, std::vector<vec3ui>& triangles, EdgeVertex edgeVertex) const {
+				int config = 0;
+				for (int c = 0; c < 8; c++) {
+					if (corners[c] < isoValue) config |= 1 << c;
+				}
+				for (int k = 0; k < numIndices[config]; k += 3) {
+					const UINT i0 = edgeVertex(indices[config][k]);
+					const UINT i1 = edgeVertex(indices[config][k + 1]);
+					const UINT i2 = edgeVertex(indices[config][k + 2]);
+					if (flipped)	triangles.push_back(vec3ui(i0, i2, i1));
+					else			triangles.push_back(vec3ui(i0, i1, i2));
+				}
+			}
+
+			int edgeAxis[12];
+			vec3i edgeBase[12];
+			signed char indices[256][MAX_CASE_INDICES];
+			int numIndices[256];
+		};
+
+		//! the tables are generated once, on first use
+		static const CubeTables& getCubeTables() {
+			static const CubeTables tables;
+			return tables;
+		}
+
+		//! concatenates the triangle lists; vertices that no triangle references (next to skipped cells) are removed
+		static TriMesh<FloatType> makeMesh(std::vector<Vertex>& vertices, const std::vector< std::vector<vec3ui> >& triangleLists, bool removeUnreferenced, bool hasNormals, bool hasColors) {
+			std::vector<size_t> firstTriangle(triangleLists.size() + 1, 0);
+			for (size_t l = 0; l < triangleLists.size(); l++) firstTriangle[l + 1] = firstTriangle[l] + triangleLists[l].size();
+			std::vector<vec3ui> triangles(firstTriangle.back());
+			for (size_t l = 0; l < triangleLists.size(); l++) {
+				std::copy(triangleLists[l].begin(), triangleLists[l].end(), triangles.begin() + firstTriangle[l]);
+			}
+
+			if (removeUnreferenced) {
+				std::vector<UINT> remap(vertices.size(), INVALID_ID);
+				for (const vec3ui& t : triangles) {
+					remap[t.x] = remap[t.y] = remap[t.z] = 0;
+				}
+				UINT numUsed = 0;
+				for (size_t v = 0; v < vertices.size(); v++) {
+					if (remap[v] == INVALID_ID) continue;
+					remap[v] = numUsed;
+					vertices[numUsed++] = vertices[v];
+				}
+				vertices.resize(numUsed);
+				for (vec3ui& t : triangles) {
+					t = vec3ui(remap[t.x], remap[t.y], remap[t.z]);
+				}
+			}
+			return TriMesh<FloatType>(vertices, triangles, false, hasNormals, false, hasColors);
+		}
+	};
+
+	template<class FloatType> const UINT GridMesher<FloatType>::INVALID_ID;
+
+	typedef GridMesher<float> GridMesherf;
+	typedef GridMesher<double> GridMesherd;
+
+}  // namespace ml
+
+#endif  // CORE_MESH_GRIDMESHER_H_
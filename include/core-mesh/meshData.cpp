@@ -565,6 +565,16 @@ unsigned int MeshData<FloatType>::removeFacesInFrontOfPlane( const Plane<FloatTy
 }
 
 
+template <class FloatType>
+void MeshData<FloatType>::merge( MeshData<FloatType>&& other )
+{
+	if (isEmpty()) {
+		*this = std::move(other);
+		return;
+	}
+	merge(static_cast<const MeshData<FloatType>&>(other));
+}
+
 template <class FloatType>
 void MeshData<FloatType>::merge( const MeshData<FloatType>& other )
 {
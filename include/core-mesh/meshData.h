@@ -352,10 +352,22 @@ public:
 		}
 
 		void append(const Indices& other) {
+			const unsigned int* ptrBefore = m_Indices.size() > 0 ? &m_Indices[0] : nullptr;
+			size_t offset = m_Indices.size();
+			const size_t facesBefore = m_Faces.size();
 			m_Indices.insert(m_Indices.end(), other.m_Indices.begin(), other.m_Indices.end());
 			m_Faces.insert(m_Faces.end(), other.m_Faces.begin(), other.m_Faces.end());
-			recomputeFacePtr();
-
+			if (m_Indices.size() > 0 && ptrBefore != &m_Indices[0]) {
+				recomputeFacePtr();
+			} else {
+				//storage did not move: only the appended faces need to point into it (keeps repeated merges linear)
+				for (size_t i = facesBefore; i < m_Faces.size(); i++) {
+					if (m_Faces[i].size()) {
+						m_Faces[i].setPtr(&m_Indices[offset]);
+						offset += m_Faces[i].size();
+					}
+				}
+			}
 		}
 
 
@@ -483,14 +495,8 @@ public:
 	}
 
 	void applyTransform(const Matrix4x4<FloatType>& t) {
-		for (size_t i = 0; i < m_Vertices.size(); i++) {
-			m_Vertices[i] = t*m_Vertices[i];
-		}
-		Matrix4x4<FloatType> invTrans = t.getInverse().getTranspose();
-		for (size_t i = 0; i < m_Normals.size(); i++) {
-			m_Normals[i] = invTrans.transformNormalAffine(m_Normals[i]);
-			m_Normals[i].normalizeIfNonzero();
-		}
+		transformPoints(t, m_Vertices);
+		transformNormals(t, m_Normals);
 	}
 
 	BoundingBox3<FloatType> computeBoundingBox() const {
@@ -543,6 +549,8 @@ public:
 
 	//! merges two meshes (assumes the same memory layout/type)
 	void merge(const MeshData<FloatType>& other);
+	//! same as above; takes over the data if this mesh is empty
+	void merge(MeshData<FloatType>&& other);
 	unsigned int removeDuplicateVertices();
 	unsigned int removeDuplicateFaces();
 	unsigned int mergeCloseVertices(FloatType thresh, bool approx = false);
@@ -754,13 +762,23 @@ public:
 	}
 
 
-	//! computes per vertex normals (recomputes if not present yet)
-	void computeVertexNormals() {
+	//! computes per vertex normals (recomputes if not present yet); triangle meshes take the parallel path of MeshNormals
+	void computeVertexNormals(typename MeshNormals<FloatType>::WeightingType weighting = MeshNormals<FloatType>::WEIGHT_UNIFORM) {
 
 		if (m_FaceIndicesVertices.size() == 0) throw MLIB_EXCEPTION("must be an indexed face set");
 		m_Normals.clear();
 		m_FaceIndicesNormals.clear();
 
+		if (isTriMesh()) {
+			std::vector<vec3ui> faces(m_FaceIndicesVertices.size());
+			for (size_t i = 0; i < faces.size(); i++) {
+				const auto& face = m_FaceIndicesVertices[i];
+				faces[i] = vec3ui(face[0], face[1], face[2]);
+			}
+			MeshNormals<FloatType>::compute(m_Vertices, m_Normals, faces, weighting);
+			return;
+		}
+
 		m_Normals.resize(m_Vertices.size(), vec3<FloatType>(0,0,0));
 		for (const auto& face : m_FaceIndicesVertices) {
 
@@ -770,10 +788,20 @@ public:
 				n += (m_Vertices[face[i]] - m_Vertices[first]) ^ (m_Vertices[face[i+1]] - m_Vertices[first]);
 			}
 
-			n.normalize();
+			if (weighting != MeshNormals<FloatType>::WEIGHT_AREA) n.normalize();
 
-			for (auto idx : face) {
-				m_Normals[idx] += n;
+			if (weighting == MeshNormals<FloatType>::WEIGHT_ANGLE) {
+				//every corner is weighted by its angle between the two adjacent edges of the polygon
+				const unsigned int numCorners = face.size();
+				for (unsigned int i = 0; i < numCorners; i++) {
+					const unsigned int prev = face[(i + numCorners - 1) % numCorners], next = face[(i + 1) % numCorners];
+					m_Normals[face[i]] += n * MeshNormals<FloatType>::cornerAngle(m_Vertices[face[i]], m_Vertices[prev], m_Vertices[next]);
+				}
+			}
+			else {
+				for (auto idx : face) {
+					m_Normals[idx] += n;
+				}
 			}
 		}
 		for (auto& n : m_Normals) {
@@ -0,0 +1,222 @@
+#ifndef CORE_MESH_MESHNORMALS_H_
+#define CORE_MESH_MESHNORMALS_H_
+
+namespace ml {
+
+//! parallel per-vertex normal computation for indexed triangle sets (used by TriMesh and MeshData)
+//! instead of scattering face normals into the vertices (which races when parallelized), every vertex
+//! gathers the normals of its incident faces through a vertex-to-face adjacency in CSR layout
+template<class FloatType>
+class MeshNormals {
+public:
+	enum WeightingType {
+		WEIGHT_UNIFORM = 0,	//every incident face contributes its unit normal
+		WEIGHT_AREA = 1,	//face normals are weighted by the face area
+		WEIGHT_ANGLE = 2	//face normals are weighted by the incident corner angle
+	};
+
+	//! vertex-to-face adjacency in compressed sparse row layout; can be kept around as long as the connectivity does not change
+	class VertexFaceAdjacency {
+	public:
+		VertexFaceAdjacency() {}
+		VertexFaceAdjacency(size_t numVertices, const vec3ui* faces, size_t numFaces) {
+			build(numVertices, faces, numFaces);
+		}
+
+		void build(size_t numVertices, const vec3ui* faces, size_t numFaces) {
+			m_offsets.clear();
+			m_offsets.resize(numVertices + 1, 0);
+			m_corners.resize(numFaces * 3);
+
+			//count the valence of every vertex
+			const int numFacesI = (int)numFaces;
+			UINT* counts = m_offsets.data() + 1;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int f = 0; f < numFacesI; f++) {
+				for (unsigned int c = 0; c < 3; c++) {
+					const unsigned int v = faces[f][c];
+#ifdef MLIB_OPENMP
+#pragma omp atomic
+#endif
+					counts[v]++;
+				}
+			}
+			for (size_t i = 0; i < numVertices; i++) {
+				m_offsets[i + 1] += m_offsets[i];
+			}
+
+			//filling in face order keeps every vertex list sorted, which makes the (parallel) gather deterministic
+			std::vector<UINT> cursor(m_offsets.begin(), m_offsets.end() - 1);
+			for (size_t f = 0; f < numFaces; f++) {
+				for (unsigned int c = 0; c < 3; c++) {
+					m_corners[cursor[faces[f][c]]++] = (UINT)(3 * f + c);
+				}
+			}
+		}
+
+		size_t getNumVertices() const {
+			return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+		}
+		size_t getNumCorners() const {
+			return m_corners.size();
+		}
+
+		//! number of faces incident to vertex v
+		UINT getValence(size_t v) const {
+			return m_offsets[v + 1] - m_offsets[v];
+		}
+		//! corners are encoded as 3*faceIndex + cornerIndex
+		const UINT* getCorners(size_t v) const {
+			return m_corners.data() + m_offsets[v];
+		}
+
+		const std::vector<UINT>& getOffsets() const { return m_offsets; }
+		const std::vector<UINT>& getCorners() const { return m_corners; }
+	private:
+		std::vector<UINT> m_offsets;	//numVertices + 1 entries
+		std::vector<UINT> m_corners;	//3*numFaces entries
+	};
+
+	//! interleaved (AoS) data; strides are in bytes, so positions and normals may live inside a larger vertex struct
+	static void compute(size_t numVertices,
+		const FloatType* positions, size_t positionStride,
+		FloatType* normals, size_t normalStride,
+		const vec3ui* faces, size_t numFaces,
+		WeightingType weighting = WEIGHT_AREA, const VertexFaceAdjacency* adjacency = nullptr)
+	{
+		StridedPositions p(positions, positionStride);
+		StridedNormals n(normals, normalStride);
+		computeInternal(numVertices, p, n, faces, numFaces, weighting, adjacency);
+	}
+
+	//! structure-of-arrays data
+	static void computeSoA(size_t numVertices,
+		const FloatType* px, const FloatType* py, const FloatType* pz,
+		FloatType* nx, FloatType* ny, FloatType* nz,
+		const vec3ui* faces, size_t numFaces,
+		WeightingType weighting = WEIGHT_AREA, const VertexFaceAdjacency* adjacency = nullptr)
+	{
+		SoAPositions p(px, py, pz);
+		SoANormals n(nx, ny, nz);
+		computeInternal(numVertices, p, n, faces, numFaces, weighting, adjacency);
+	}
+
+	//! convenience wrapper for tightly packed position/normal arrays
+	static void compute(const std::vector<vec3<FloatType>>& positions, std::vector<vec3<FloatType>>& normals, const std::vector<vec3ui>& faces, WeightingType weighting = WEIGHT_AREA) {
+		normals.resize(positions.size());
+		if (positions.empty()) return;
+		compute(positions.size(),
+			(const FloatType*)positions.data(), sizeof(vec3<FloatType>),
+			(FloatType*)normals.data(), sizeof(vec3<FloatType>),
+			faces.data(), faces.size(), weighting);
+	}
+
+	//! interior angle at p between the edges to a and b (in radians)
+	static FloatType cornerAngle(const vec3<FloatType>& p, const vec3<FloatType>& a, const vec3<FloatType>& b) {
+		const vec3<FloatType> e0 = a - p;
+		const vec3<FloatType> e1 = b - p;
+		return std::atan2((e0 ^ e1).length(), e0 | e1);
+	}
+
+private:
+	struct StridedPositions {
+		StridedPositions(const FloatType* p, size_t s) : ptr((const char*)p), stride(s) {}
+		vec3<FloatType> operator()(size_t i) const {
+			const FloatType* p = (const FloatType*)(ptr + i*stride);
+			return vec3<FloatType>(p[0], p[1], p[2]);
+		}
+		const char* ptr;
+		size_t stride;
+	};
+	struct StridedNormals {
+		StridedNormals(FloatType* p, size_t s) : ptr((char*)p), stride(s) {}
+		void set(size_t i, const vec3<FloatType>& n) const {
+			FloatType* p = (FloatType*)(ptr + i*stride);
+			p[0] = n.x;	p[1] = n.y;	p[2] = n.z;
+		}
+		char* ptr;
+		size_t stride;
+	};
+	struct SoAPositions {
+		SoAPositions(const FloatType* _x, const FloatType* _y, const FloatType* _z) : x(_x), y(_y), z(_z) {}
+		vec3<FloatType> operator()(size_t i) const {
+			return vec3<FloatType>(x[i], y[i], z[i]);
+		}
+		const FloatType *x, *y, *z;
+	};
+	struct SoANormals {
+		SoANormals(FloatType* _x, FloatType* _y, FloatType* _z) : x(_x), y(_y), z(_z) {}
+		void set(size_t i, const vec3<FloatType>& n) const {
+			x[i] = n.x;	y[i] = n.y;	z[i] = n.z;
+		}
+		FloatType *x, *y, *z;
+	};
+
+	template<class Positions, class Normals>
+	static void computeInternal(size_t numVertices, const Positions& positions, const Normals& normals,
+		const vec3ui* faces, size_t numFaces, WeightingType weighting, const VertexFaceAdjacency* adjacency)
+	{
+		VertexFaceAdjacency localAdjacency;
+		if (adjacency == nullptr) {
+			localAdjacency.build(numVertices, faces, numFaces);
+			adjacency = &localAdjacency;
+		}
+		else if (adjacency->getNumVertices() != numVertices || adjacency->getNumCorners() != 3 * numFaces) {
+			throw MLIB_EXCEPTION("vertex-face adjacency does not match the mesh");
+		}
+
+		//pass 1: weighted face normals (and corner angles); independent per face
+		std::vector<vec3<FloatType>> faceNormals(numFaces);
+		std::vector<FloatType> cornerAngles(weighting == WEIGHT_ANGLE ? 3 * numFaces : 0);
+		const int numFacesI = (int)numFaces;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int f = 0; f < numFacesI; f++) {
+			const vec3<FloatType> p0 = positions(faces[f].x);
+			const vec3<FloatType> p1 = positions(faces[f].y);
+			const vec3<FloatType> p2 = positions(faces[f].z);
+			vec3<FloatType> n = (p1 - p0) ^ (p2 - p0);
+			if (weighting != WEIGHT_AREA) n.normalizeIfNonzero();
+			faceNormals[f] = n;
+
+			if (weighting == WEIGHT_ANGLE) {
+				cornerAngles[3 * f + 0] = cornerAngle(p0, p1, p2);
+				cornerAngles[3 * f + 1] = cornerAngle(p1, p2, p0);
+				cornerAngles[3 * f + 2] = cornerAngle(p2, p0, p1);
+			}
+		}
+
+		//pass 2: every vertex gathers from its incident faces; no write conflicts
+		const int numVerticesI = (int)numVertices;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int v = 0; v < numVerticesI; v++) {
+			const UINT* corners = adjacency->getCorners(v);
+			const UINT valence = adjacency->getValence(v);
+			vec3<FloatType> n(0, 0, 0);
+			if (weighting == WEIGHT_ANGLE) {
+				for (UINT i = 0; i < valence; i++) {
+					n += faceNormals[corners[i] / 3] * cornerAngles[corners[i]];
+				}
+			}
+			else {
+				for (UINT i = 0; i < valence; i++) {
+					n += faceNormals[corners[i] / 3];
+				}
+			}
+			n.normalizeIfNonzero();
+			normals.set(v, n);
+		}
+	}
+};
+
+typedef MeshNormals<float> MeshNormalsf;
+typedef MeshNormals<double> MeshNormalsd;
+
+}  // namespace ml
+
+#endif  // CORE_MESH_MESHNORMALS_H_
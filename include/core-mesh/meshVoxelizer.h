@@ -0,0 +1,218 @@
+#ifndef CORE_MESH_MESHVOXELIZER_H_
+#define CORE_MESH_MESHVOXELIZER_H_
+
+namespace ml {
+
+	//! conversion of triangle meshes into voxel grids (the counterpart of GridMesher):
+	//! voxelizeSurface sets every voxel whose box touches a triangle, voxelizeSolid additionally fills the interior of closed
+	//! meshes (scanline parity), computeDistanceField evaluates exact distances to the surface within a narrow band.
+	//! Voxel (x,y,z) spans [x-0.5, x+0.5] after worldToVoxel is applied, distances are measured in voxels. The grids must be
+	//! allocated by the caller; voxels are only set, never cleared.
+	template<class FloatType>
+	class MeshVoxelizer {
+	public:
+		//! conservative surface voxelization: triangle/box overlap test for the voxels of each triangle's bounding box; parallel over the triangles
+		static void voxelizeSurface(const TriMesh<FloatType>& mesh, BinaryGrid3& grid, const Matrix4x4<FloatType>& worldToVoxel = Matrix4x4<FloatType>::identity()) {
+			if (mesh.getIndices().empty()) return;
+			std::vector<vec3<FloatType>> positions;
+			transformPositions(mesh, worldToVoxel, positions);
+			voxelizeSurface(positions, mesh.getIndices(), grid);
+		}
+
+		//! surface voxels plus all voxels whose centers are inside the mesh; the mesh must be closed (but may be oriented arbitrarily)
+		static void voxelizeSolid(const TriMesh<FloatType>& mesh, BinaryGrid3& grid, const Matrix4x4<FloatType>& worldToVoxel = Matrix4x4<FloatType>::identity()) {
+			if (mesh.getIndices().empty()) return;
+			std::vector<vec3<FloatType>> positions;
+			transformPositions(mesh, worldToVoxel, positions);
+			voxelizeSurface(positions, mesh.getIndices(), grid);
+			voxelizeInterior(positions, mesh.getIndices(), grid);
+		}
+
+		//! exact distance to the closest surface point (BVH query) for all voxels within band of the surface, infinity beyond;
+		//! signedDistance: voxels whose centers are inside the (closed) mesh are negative (-infinity beyond the band)
+		static void computeDistanceField(const TriMesh<FloatType>& mesh, Grid3<FloatType>& grid, FloatType band, const Matrix4x4<FloatType>& worldToVoxel = Matrix4x4<FloatType>::identity(), bool signedDistance = true) {
+			const FloatType inf = std::numeric_limits<FloatType>::infinity();
+			if (mesh.getIndices().empty()) {
+				grid.setValues(inf);
+				return;
+			}
+			TriMesh<FloatType> voxelMesh = mesh;
+			voxelMesh.transform(worldToVoxel);
+			std::vector<vec3<FloatType>> positions(voxelMesh.getVertices().size());
+			for (size_t i = 0; i < positions.size(); i++) positions[i] = voxelMesh.getVertices()[i].position;
+			const std::vector<vec3ui>& indices = voxelMesh.getIndices();
+
+			//every voxel within band of a surface point is within L1 distance sqrt(3) * (band + sqrt(3) / 2) of a surface voxel
+			const vec3ul dim = grid.getDimensions();
+			BinaryGrid3 bandVoxels(dim);
+			voxelizeSurface(positions, indices, bandVoxels);
+			bandVoxels.dilate((unsigned int)std::ceil(std::sqrt((FloatType)3) * band + (FloatType)1.5));
+
+			BinaryGrid3 inside(dim);
+			if (signedDistance) voxelizeInterior(positions, indices, inside);
+
+			TriMeshAcceleratorBVH<FloatType> bvh(voxelMesh);
+			const int dimZ = (int)dim.z;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+			for (int z = 0; z < dimZ; z++) {
+				for (size_t y = 0; y < dim.y; y++) {
+					for (size_t x = 0; x < dim.x; x++) {
+						grid(x, y, z) = inside.isVoxelSet(x, y, z) ? -inf : inf;
+					}
+					bandVoxels.forEachSetVoxelInRow(y, z, [&](size_t x) {
+						const vec3<FloatType> p((FloatType)x, (FloatType)y, (FloatType)z);
+						vec3<FloatType> closest;
+						if (bvh.closestPoint(p, closest, band)) {
+							const FloatType d = (p - closest).length();
+							grid(x, y, z) = inside.isVoxelSet(x, y, z) ? -d : d;
+						}
+					});
+				}
+			}
+		}
+
+		//! as above; the truncation of the distance field is set to band
+		static void computeDistanceField(const TriMesh<FloatType>& mesh, DistanceField3<FloatType>& df, FloatType band, const Matrix4x4<FloatType>& worldToVoxel = Matrix4x4<FloatType>::identity(), bool signedDistance = true) {
+			computeDistanceField(mesh, static_cast<Grid3<FloatType>&>(df), band, worldToVoxel, signedDistance);
+			df.setTruncation(band, false);
+		}
+
+	private:
+		static void transformPositions(const TriMesh<FloatType>& mesh, const Matrix4x4<FloatType>& worldToVoxel, std::vector<vec3<FloatType>>& positions) {
+			const std::vector<typename TriMesh<FloatType>::Vertex>& vertices = mesh.getVertices();
+			const int numVertices = (int)vertices.size();
+			positions.resize(numVertices);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < numVertices; i++) {
+				positions[i] = worldToVoxel.transformAffine(vertices[i].position);
+			}
+		}
+
+		static void voxelizeSurface(const std::vector<vec3<FloatType>>& positions, const std::vector<vec3ui>& indices, BinaryGrid3& grid) {
+			const vec3i maxVoxel = vec3i(grid.getDimensions()) - 1;
+			const int numTriangles = (int)indices.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+			for (int t = 0; t < numTriangles; t++) {
+				const vec3<FloatType>& p0 = positions[indices[t].x];
+				const vec3<FloatType>& p1 = positions[indices[t].y];
+				const vec3<FloatType>& p2 = positions[indices[t].z];
+
+				//voxels whose boxes overlap the bounding box of the triangle
+				const vec3<FloatType> bbMin = math::min(math::min(p0, p1), p2), bbMax = math::max(math::max(p0, p1), p2);
+				vec3i lo, hi;
+				for (int a = 0; a < 3; a++) {
+					lo[a] = std::max((int)std::ceil(bbMin[a] - (FloatType)0.5), 0);
+					hi[a] = std::min((int)std::floor(bbMax[a] + (FloatType)0.5), maxVoxel[a]);
+				}
+				if (lo.x > hi.x || lo.y > hi.y || lo.z > hi.z) continue;
+
+				//a triangle within a single voxel needs no test (this also covers degenerate triangles)
+				if (lo == hi) {
+					grid.setVoxelAtomic(lo.x, lo.y, lo.z);
+					continue;
+				}
+				if (((p1 - p0) ^ (p2 - p0)).lengthSq() == (FloatType)0) continue;
+
+				const vec3<FloatType> halfVoxel((FloatType)0.5, (FloatType)0.5, (FloatType)0.5);
+				for (int z = lo.z; z <= hi.z; z++) {
+					for (int y = lo.y; y <= hi.y; y++) {
+						for (int x = lo.x; x <= hi.x; x++) {
+							const vec3<FloatType> c((FloatType)x, (FloatType)y, (FloatType)z);
+							if (intersection::intersectTriangleAABB(c - halfVoxel, c + halfVoxel, p0, p1, p2)) {
+								grid.setVoxelAtomic(x, y, z);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		//! sets the voxels whose centers are inside: rays along x through the voxel centers, filled between pairs of crossings.
+		//! Crossings are found with exact edge functions and a consistent tie-breaking rule, so that rays through shared edges and
+		//! vertices cross a closed surface an even number of times. Parallel over the slices.
+		static void voxelizeInterior(const std::vector<vec3<FloatType>>& positions, const std::vector<vec3ui>& indices, BinaryGrid3& grid) {
+			const int dimY = (int)grid.getDimY(), dimZ = (int)grid.getDimZ();
+			const FloatType dimX = (FloatType)grid.getDimX();
+
+			std::vector< std::vector<UINT> > sliceTriangles(dimZ);
+			for (size_t t = 0; t < indices.size(); t++) {
+				const FloatType z0 = positions[indices[t].x].z, z1 = positions[indices[t].y].z, z2 = positions[indices[t].z].z;
+				const int lo = std::max((int)std::ceil(std::min(std::min(z0, z1), z2)), 0);
+				const int hi = std::min((int)std::floor(std::max(std::max(z0, z1), z2)), dimZ - 1);
+				for (int z = lo; z <= hi; z++) sliceTriangles[z].push_back((UINT)t);
+			}
+
+#ifdef MLIB_OPENMP
+#pragma omp parallel
+#endif
+			{
+				std::vector< std::pair<int, FloatType> > crossings;	//(y, x)
+#ifdef MLIB_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+				for (int z = 0; z < dimZ; z++) {
+					crossings.clear();
+					for (UINT t : sliceTriangles[z]) {
+						const vec3<FloatType>* p[3] = { &positions[indices[t].x], &positions[indices[t].y], &positions[indices[t].z] };
+
+						//counter-clockwise in the (y, z) plane
+						const double area = edgeFunction(p[0]->y, p[0]->z, p[1]->y, p[1]->z, p[2]->y, p[2]->z);
+						if (area == 0.0) continue;
+						if (area < 0.0) std::swap(p[1], p[2]);
+
+						const int lo = std::max((int)std::ceil(std::min(std::min(p[0]->y, p[1]->y), p[2]->y)), 0);
+						const int hi = std::min((int)std::floor(std::max(std::max(p[0]->y, p[1]->y), p[2]->y)), dimY - 1);
+						for (int y = lo; y <= hi; y++) {
+							double w[3];
+							bool covered = true;
+							for (int e = 0; e < 3 && covered; e++) {
+								const vec3<FloatType>& a = *p[(e + 1) % 3];
+								const vec3<FloatType>& b = *p[(e + 2) % 3];
+								w[e] = edgeFunction(a.y, a.z, b.y, b.z, (FloatType)y, (FloatType)z);
+								covered = w[e] > 0.0 || (w[e] == 0.0 && ownsEdge(a, b));
+							}
+							if (!covered) continue;
+							const double x = (w[0] * p[0]->x + w[1] * p[1]->x + w[2] * p[2]->x) / (w[0] + w[1] + w[2]);
+							crossings.push_back(std::make_pair(y, (FloatType)x));
+						}
+					}
+
+					std::sort(crossings.begin(), crossings.end());
+					for (size_t i = 0; i + 1 < crossings.size(); ) {
+						if (crossings[i].first != crossings[i + 1].first) {
+							i++;	//odd number of crossings in this row (open mesh); skip its last crossing
+							continue;
+						}
+						const FloatType x0 = math::clamp(std::ceil(crossings[i].second), (FloatType)0, dimX);
+						const FloatType x1 = math::clamp(std::ceil(crossings[i + 1].second), (FloatType)0, dimX);
+						if (x0 < x1) grid.setVoxelsInRowAtomic((size_t)x0, (size_t)x1, crossings[i].first, z);
+						i += 2;
+					}
+				}
+			}
+		}
+
+		//! twice the signed area of (a, b, q) in a plane; evaluated relative to q, so that swapping a and b negates it exactly
+		static double edgeFunction(FloatType au, FloatType av, FloatType bu, FloatType bv, FloatType qu, FloatType qv) {
+			return ((double)au - qu) * ((double)bv - qv) - ((double)av - qv) * ((double)bu - qu);
+		}
+
+		//! whether a point on the edge from a to b belongs to the triangle left of it (as if the point were moved by (+1, +eps) in
+		//! the (y, z) plane); exactly one of two triangles sharing an edge (or a vertex) owns it
+		static bool ownsEdge(const vec3<FloatType>& a, const vec3<FloatType>& b) {
+			return b.z < a.z || (b.z == a.z && b.y > a.y);
+		}
+	};
+
+	typedef MeshVoxelizer<float> MeshVoxelizerf;
+	typedef MeshVoxelizer<double> MeshVoxelizerd;
+
+}  // namespace ml
+
+#endif  // CORE_MESH_MESHVOXELIZER_H_
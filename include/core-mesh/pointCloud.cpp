@@ -129,6 +129,192 @@ size_t PointCloud<FloatType>::sparsifyUniform(FloatType thresh, bool approx)
 }
 
 
+template <class FloatType>
+size_t PointCloud<FloatType>::downsampleVoxelGrid(FloatType voxelSize)
+{
+	if (voxelSize <= (FloatType)0)	throw MLIB_EXCEPTION("invalid voxel size " + std::to_string(voxelSize));
+	if (!isConsistent())			throw MLIB_EXCEPTION("inconsistent point cloud");
+	if (m_points.size() >= (size_t)std::numeric_limits<int>::max()) throw MLIB_EXCEPTION("too many points");
+	if (m_points.empty()) return 0;
+
+	//voxel keys (21 bits per dimension) relative to the voxel of the bounding box minimum
+	const BoundingBox3<FloatType> bb = computeBoundingBox();
+	const FloatType invVoxelSize = (FloatType)1 / voxelSize;
+	const vec3<FloatType> minVoxel(
+		(FloatType)std::floor(bb.getMinX() * invVoxelSize),
+		(FloatType)std::floor(bb.getMinY() * invVoxelSize),
+		(FloatType)std::floor(bb.getMinZ() * invVoxelSize));
+	const FloatType maxExtent = std::max(std::max(bb.getExtentX(), bb.getExtentY()), bb.getExtentZ());
+	if (maxExtent * invVoxelSize >= (FloatType)((1 << 21) - 2)) throw MLIB_EXCEPTION("voxel size too small for the extent of the point cloud");
+
+	const int numPoints = (int)m_points.size();
+	std::vector< std::pair<UINT64, UINT> > keys(numPoints);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+	for (int i = 0; i < numPoints; i++) {
+		const vec3<FloatType>& p = m_points[i];
+		const UINT64 x = (UINT64)std::max((FloatType)0, std::floor(p.x * invVoxelSize) - minVoxel.x);
+		const UINT64 y = (UINT64)std::max((FloatType)0, std::floor(p.y * invVoxelSize) - minVoxel.y);
+		const UINT64 z = (UINT64)std::max((FloatType)0, std::floor(p.z * invVoxelSize) - minVoxel.z);
+		keys[i] = std::make_pair((z << 42) | (y << 21) | x, (UINT)i);
+	}
+	//the point index makes all keys unique, hence the order within a voxel (and the summation order) is fixed
+	util::parallelSort(keys);
+
+	std::vector<UINT> voxelStart;
+	for (int i = 0; i < numPoints; i++) {
+		if (i == 0 || keys[i].first != keys[i - 1].first) voxelStart.push_back((UINT)i);
+	}
+	voxelStart.push_back((UINT)numPoints);
+
+	const int numVoxels = (int)voxelStart.size() - 1;
+	std::vector<vec3<FloatType>> newPoints(numVoxels);
+	std::vector<vec3<FloatType>> newNormals(hasNormals() ? numVoxels : 0);
+	std::vector<vec4<FloatType>> newColors(hasColors() ? numVoxels : 0);
+	std::vector<vec2<FloatType>> newTexCoords(hasTexCoords() ? numVoxels : 0);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+	for (int v = 0; v < numVoxels; v++) {
+		const UINT begin = voxelStart[v], end = voxelStart[v + 1];
+		const FloatType invCount = (FloatType)1 / (FloatType)(end - begin);
+
+		vec3d p(0.0, 0.0, 0.0);
+		for (UINT i = begin; i < end; i++) p += vec3d(m_points[keys[i].second]);
+		newPoints[v] = vec3<FloatType>(p / (double)(end - begin));
+
+		if (hasNormals()) {
+			vec3<FloatType> n((FloatType)0, (FloatType)0, (FloatType)0);
+			for (UINT i = begin; i < end; i++) n += m_normals[keys[i].second];
+			const FloatType length = n.length();
+			newNormals[v] = length > (FloatType)0 ? n / length : m_normals[keys[begin].second];
+		}
+		if (hasColors()) {
+			vec4<FloatType> c((FloatType)0, (FloatType)0, (FloatType)0, (FloatType)0);
+			for (UINT i = begin; i < end; i++) c += m_colors[keys[i].second];
+			newColors[v] = c * invCount;
+		}
+		if (hasTexCoords()) {
+			vec2<FloatType> t((FloatType)0, (FloatType)0);
+			for (UINT i = begin; i < end; i++) t += m_texCoords[keys[i].second];
+			newTexCoords[v] = t * invCount;
+		}
+	}
+
+	m_points.swap(newPoints);
+	m_normals.swap(newNormals);
+	m_colors.swap(newColors);
+	m_texCoords.swap(newTexCoords);
+	return m_points.size();
+}
+
+template <class FloatType>
+size_t PointCloud<FloatType>::downsampleFarthestPoint(size_t targetCount, size_t startIndex)
+{
+	if (!isConsistent())			throw MLIB_EXCEPTION("inconsistent point cloud");
+	if (m_points.size() >= (size_t)std::numeric_limits<int>::max()) throw MLIB_EXCEPTION("too many points");
+	if (targetCount >= m_points.size()) return m_points.size();
+	if (startIndex >= m_points.size())	throw MLIB_EXCEPTION("invalid start index " + std::to_string(startIndex));
+
+	const int numPoints = (int)m_points.size();
+	std::vector<FloatType> minDistSq(numPoints, std::numeric_limits<FloatType>::max());
+	std::vector<UINT> selected;
+	selected.reserve(targetCount);
+	UINT next = (UINT)startIndex;
+	while (selected.size() < targetCount) {
+		selected.push_back(next);
+		minDistSq[next] = (FloatType)-1;	//kept points are excluded from the search
+		const vec3<FloatType> s = m_points[next];
+
+		//update the distances to the kept set and find the farthest point; ties go to the smaller index, so the
+		//combined result does not depend on how the points are split among the threads
+		FloatType bestDistSq = (FloatType)-1;
+		UINT best = 0;
+#ifdef MLIB_OPENMP
+#pragma omp parallel
+#endif
+		{
+			FloatType localDistSq = (FloatType)-1;
+			UINT local = 0;
+#ifdef MLIB_OPENMP
+#pragma omp for nowait
+#endif
+			for (int i = 0; i < numPoints; i++) {
+				if (minDistSq[i] < (FloatType)0) continue;
+				const FloatType d = std::min(minDistSq[i], vec3<FloatType>::distSq(m_points[i], s));
+				minDistSq[i] = d;
+				if (d > localDistSq) {
+					localDistSq = d;
+					local = (UINT)i;
+				}
+			}
+#ifdef MLIB_OPENMP
+#pragma omp critical
+#endif
+			{
+				if (localDistSq > bestDistSq || (localDistSq == bestDistSq && local < best)) {
+					bestDistSq = localDistSq;
+					best = local;
+				}
+			}
+		}
+		//all remaining points coincide with kept ones
+		if (bestDistSq <= (FloatType)0) break;
+		next = best;
+	}
+
+	selectPoints(selected);
+	return m_points.size();
+}
+
+template <class FloatType>
+size_t PointCloud<FloatType>::compact(const std::vector<BYTE>& keep)
+{
+	if (keep.size() != m_points.size())	throw MLIB_EXCEPTION("mask does not match the points");
+	if (!isConsistent())				throw MLIB_EXCEPTION("inconsistent point cloud");
+
+	size_t cnt = 0;
+	for (size_t i = 0; i < m_points.size(); i++) {
+		if (!keep[i]) continue;
+		if (cnt != i) {
+			m_points[cnt] = m_points[i];
+			if (hasNormals())	m_normals[cnt] = m_normals[i];
+			if (hasColors())	m_colors[cnt] = m_colors[i];
+			if (hasTexCoords())	m_texCoords[cnt] = m_texCoords[i];
+		}
+		cnt++;
+	}
+	m_points.resize(cnt);
+	if (hasNormals())	m_normals.resize(cnt);
+	if (hasColors())	m_colors.resize(cnt);
+	if (hasTexCoords())	m_texCoords.resize(cnt);
+	return cnt;
+}
+
+template <class FloatType>
+void PointCloud<FloatType>::selectPoints(const std::vector<UINT>& indices)
+{
+	const int n = (int)indices.size();
+	std::vector<vec3<FloatType>> newPoints(n);
+	std::vector<vec3<FloatType>> newNormals(hasNormals() ? n : 0);
+	std::vector<vec4<FloatType>> newColors(hasColors() ? n : 0);
+	std::vector<vec2<FloatType>> newTexCoords(hasTexCoords() ? n : 0);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+	for (int i = 0; i < n; i++) {
+		const UINT j = indices[i];
+		newPoints[i] = m_points[j];
+		if (hasNormals())	newNormals[i] = m_normals[j];
+		if (hasColors())	newColors[i] = m_colors[j];
+		if (hasTexCoords())	newTexCoords[i] = m_texCoords[j];
+	}
+	m_points.swap(newPoints);
+	m_normals.swap(newNormals);
+	m_colors.swap(newColors);
+	m_texCoords.swap(newTexCoords);
+}
 
 
 
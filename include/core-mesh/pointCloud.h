@@ -103,14 +103,25 @@ public:
 	
 
 	void applyTransform(const Matrix4x4<FloatType>& t) {
-		for (size_t i = 0; i < m_points.size(); i++) {
-			m_points[i] = t*m_points[i];
-		}
-		Matrix4x4<FloatType> invTrans = t.getInverse().getTranspose();
-		for (size_t i = 0; i < m_normals.size(); i++) {
-			m_normals[i] = invTrans.transformNormalAffine(m_normals[i]);
-			m_normals[i].normalizeIfNonzero();
-		}
+		transformPoints(t, m_points);
+		transformNormals(t, m_normals);
+	}
+
+	//! PCA normals from the k nearest neighbors (see PointCloudNormals); radius > 0 additionally limits the neighborhood
+	void computeNormals(UINT k = 16, FloatType radius = 0) {
+		PointCloudNormals<FloatType>::compute(m_points, m_normals, k, radius);
+	}
+	//! PCA normals from all neighbors within the radius
+	void computeNormalsInRadius(FloatType radius) {
+		PointCloudNormals<FloatType>::computeInRadius(m_points, m_normals, radius);
+	}
+	//! flips the normals towards the viewpoint (e.g., the camera position of a depth frame)
+	void orientNormals(const vec3<FloatType>& viewpoint) {
+		PointCloudNormals<FloatType>::orientTowardsViewpoint(m_points, m_normals, viewpoint);
+	}
+	//! consistent orientation without a viewpoint (MST propagation over the kNN graph)
+	void orientNormalsMST(UINT k = 8) {
+		PointCloudNormals<FloatType>::orientMST(m_points, m_normals, k);
 	}
 
     //! Computes the bounding box of the mesh (not cached!)
@@ -159,12 +170,42 @@ public:
 	}
 
 
+	//! replaces the points of every voxel (cube of edge length voxelSize) by their average; normals are re-normalized
+	//! the result is ordered by voxel and does not depend on the number of threads; returns the new number of points
+	size_t downsampleVoxelGrid(FloatType voxelSize);
+
+	//! farthest point sampling: starting with startIndex, repeatedly keeps the point farthest from all kept points until
+	//! targetCount points are kept (or no point is left that differs from all kept points, so duplicates are never kept twice);
+	//! costs O(n * targetCount), so very large clouds should be voxel-grid downsampled first
+	size_t downsampleFarthestPoint(size_t targetCount, size_t startIndex = 0);
+
+
+	//! removes all points whose mask entry is 0 (from all attribute arrays in a single pass); returns the new number of points
+	size_t compact(const std::vector<BYTE>& keep);
+
+	//! statistical outlier removal (see PointCloudFilter::statisticalOutlierMask)
+	size_t removeStatisticalOutliers(UINT k = 16, FloatType stdDevMultiplier = 1) {
+		std::vector<BYTE> keep;
+		PointCloudFilter<FloatType>::statisticalOutlierMask(m_points, keep, k, stdDevMultiplier);
+		return compact(keep);
+	}
+	//! radius outlier removal (see PointCloudFilter::radiusOutlierMask)
+	size_t removeRadiusOutliers(FloatType radius, UINT minNeighbors = 2) {
+		std::vector<BYTE> keep;
+		PointCloudFilter<FloatType>::radiusOutlierMask(m_points, keep, radius, minNeighbors);
+		return compact(keep);
+	}
+
+
 	std::vector<vec3<FloatType>> m_points;
 	std::vector<vec3<FloatType>> m_normals;
 	std::vector<vec4<FloatType>> m_colors;
 	std::vector<vec2<FloatType>> m_texCoords;
 private:
 
+	//! keeps only the given points (in the given order)
+	void selectPoints(const std::vector<UINT>& indices);
+
 	inline vec3i toVirtualVoxelPos(const vec3<FloatType>& v, FloatType voxelSize) {
 		return vec3i(v / voxelSize + (FloatType)0.5*vec3<FloatType>(math::sign(v)));
 	}
@@ -0,0 +1,107 @@
+#ifndef CORE_MESH_POINTCLOUDFILTER_H_
+#define CORE_MESH_POINTCLOUDFILTER_H_
+
+namespace ml {
+
+//! parallel outlier detection for unorganized point clouds (e.g., flying pixels of depth frames)
+//! the filters write a keep-mask (1 = inlier, 0 = outlier) and return the number of inliers; PointCloud::compact removes
+//! the outliers from all attribute arrays in a single pass. The results do not depend on the number of threads.
+template<class FloatType>
+class PointCloudFilter {
+public:
+	//! statistical outlier removal: a point is an outlier if the mean distance to its k nearest neighbors (k-d tree)
+	//! exceeds the mean of this value over the whole cloud by more than stdDevMultiplier standard deviations
+	static size_t statisticalOutlierMask(const std::vector<vec3<FloatType>>& points, std::vector<BYTE>& keep, UINT k = 16, FloatType stdDevMultiplier = 1)
+	{
+		keep.assign(points.size(), 1);
+		if (points.size() < 2) return points.size();
+		if (k == 0) throw MLIB_EXCEPTION("at least 1 neighbor is required");
+		k = std::min(k, (UINT)points.size() - 1);
+
+		//k + 1 neighbors, since every point finds itself; queried in chunks to bound the memory of the neighbor lists
+		const UINT kSelf = k + 1;
+		NearestNeighborSearchKdTree<FloatType> tree;
+		tree.init((const FloatType*)points.data(), (UINT)points.size(), 3, kSelf);
+		std::vector<FloatType> meanDist(points.size());
+		const size_t chunkSize = 1 << 16;
+		std::vector<UINT> indices(chunkSize * kSelf);
+		std::vector<FloatType> dists(chunkSize * kSelf);
+		for (size_t first = 0; first < points.size(); first += chunkSize) {
+			const size_t count = std::min(chunkSize, points.size() - first);
+			tree.kNearestBatch((const FloatType*)&points[first], count, kSelf, indices.data(), dists.data());
+			const int countI = (int)count;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int q = 0; q < countI; q++) {
+				//skip the point itself (which is not necessarily the first entry if there are duplicates)
+				const UINT self = (UINT)(first + q);
+				FloatType sum = (FloatType)0;
+				UINT n = 0;
+				for (UINT j = 0; j < kSelf && n < k; j++) {
+					if (indices[(size_t)q * kSelf + j] == self) continue;
+					sum += dists[(size_t)q * kSelf + j];
+					n++;
+				}
+				meanDist[self] = sum / (FloatType)n;
+			}
+		}
+
+		//serial (fixed order) reduction
+		double sum = 0.0, sumSq = 0.0;
+		for (FloatType d : meanDist) {
+			sum += (double)d;
+			sumSq += (double)d * (double)d;
+		}
+		const double mean = sum / (double)points.size();
+		const double variance = std::max(0.0, sumSq / (double)points.size() - mean * mean);
+		const FloatType thresh = (FloatType)(mean + (double)stdDevMultiplier * std::sqrt(variance));
+
+		return createMask(meanDist, thresh, keep);
+	}
+
+	//! radius outlier removal: a point is an outlier if there are fewer than minNeighbors other points within the radius
+	static size_t radiusOutlierMask(const std::vector<vec3<FloatType>>& points, std::vector<BYTE>& keep, FloatType radius, UINT minNeighbors = 2)
+	{
+		keep.assign(points.size(), 1);
+		if (points.empty()) return 0;
+		if (radius <= (FloatType)0) throw MLIB_EXCEPTION("invalid radius");
+
+		UniformPointGrid<FloatType> grid(points, radius);
+		const int numPoints = (int)points.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+		for (int i = 0; i < numPoints; i++) {
+			UINT count = 0;
+			grid.forEachInRadius(points[i], radius, [&](UINT j, FloatType) { if (j != (UINT)i) count++; });
+			keep[i] = count >= minNeighbors ? 1 : 0;
+		}
+
+		size_t numInliers = 0;
+		for (BYTE b : keep) numInliers += b;
+		return numInliers;
+	}
+
+private:
+	static size_t createMask(const std::vector<FloatType>& values, FloatType thresh, std::vector<BYTE>& keep)
+	{
+		const int n = (int)values.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int i = 0; i < n; i++) {
+			keep[i] = values[i] <= thresh ? 1 : 0;
+		}
+		size_t numInliers = 0;
+		for (BYTE b : keep) numInliers += b;
+		return numInliers;
+	}
+};
+
+typedef PointCloudFilter<float> PointCloudFilterf;
+typedef PointCloudFilter<double> PointCloudFilterd;
+
+}  // namespace ml
+
+#endif  // CORE_MESH_POINTCLOUDFILTER_H_
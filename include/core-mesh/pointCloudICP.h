@@ -0,0 +1,310 @@
+#ifndef CORE_MESH_POINTCLOUDICP_H_
+#define CORE_MESH_POINTCLOUDICP_H_
+
+namespace ml {
+
+//! rigid registration by iterative closest points (point-to-point or point-to-plane) without external dependencies
+//! Correspondences are the nearest target points (k-d tree batch queries) of the transformed source points; every
+//! iteration linearizes the rotation and solves the 6x6 normal equations (Cholesky), which are reduced in parallel over
+//! fixed blocks of points, so the result does not depend on the number of threads. Optionally, the source is aligned
+//! coarse-to-fine on voxel-grid subsamples, and residuals are down-weighted by a Huber or Tukey M-estimator.
+template<class FloatType>
+class PointCloudICP {
+public:
+	enum Metric {
+		METRIC_POINT_TO_POINT,
+		METRIC_POINT_TO_PLANE
+	};
+	enum Weighting {
+		WEIGHT_NONE,
+		WEIGHT_HUBER,
+		WEIGHT_TUKEY
+	};
+
+	struct Params {
+		Params() {
+			metric = METRIC_POINT_TO_PLANE;
+			weighting = WEIGHT_HUBER;
+			maxIterations = 30;
+			maxCorrespondenceDist = 0;
+			robustScale = 0;
+			voxelSize = 0;
+			numLevels = 1;
+			minRotation = (FloatType)1e-6;
+			minTranslation = (FloatType)1e-6;
+		}
+		Metric		metric;
+		Weighting	weighting;
+		UINT		maxIterations;			//per level
+		FloatType	maxCorrespondenceDist;	//on the finest level (doubled per coarser level); 0: unlimited
+		FloatType	robustScale;			//scale of the M-estimator; 0: estimated from the median absolute residual
+		FloatType	voxelSize;				//subsampling of the source on the finest level; 0: all points
+		UINT		numLevels;				//level l (0 = finest) uses voxelSize * 2^l; requires voxelSize > 0 if > 1
+		FloatType	minRotation;			//convergence: update smaller than this (radians) ...
+		FloatType	minTranslation;			//... and this
+	};
+
+	struct Result {
+		Matrix4x4<FloatType> transform;		//maps the source onto the target
+		FloatType rmse;						//of the correspondences of the last iteration
+		UINT numCorrespondences;
+		UINT numIterations;					//over all levels
+		bool converged;						//on the finest level
+	};
+
+	PointCloudICP() {}
+
+	//! point-to-plane needs target normals; if there are none, they are estimated (see PointCloudNormals)
+	void setTarget(const std::vector<vec3<FloatType>>& points, const std::vector<vec3<FloatType>>& normals = std::vector<vec3<FloatType>>()) {
+		if (points.empty()) throw MLIB_EXCEPTION("empty target");
+		if (!normals.empty() && normals.size() != points.size()) throw MLIB_EXCEPTION("normals do not match the points");
+		m_targetPoints = points;
+		m_targetNormals = normals;
+		m_tree.init((const FloatType*)m_targetPoints.data(), (UINT)m_targetPoints.size(), 3, 1);
+	}
+	void setTarget(const PointCloud<FloatType>& pc) {
+		setTarget(pc.m_points, pc.m_normals);
+	}
+	void setTarget(const TriMesh<FloatType>& mesh) {
+		std::vector<vec3<FloatType>> points, normals;
+		getVertices(mesh, points, normals);
+		setTarget(points, normals);
+	}
+
+	Result align(const std::vector<vec3<FloatType>>& source, const Matrix4x4<FloatType>& initial = Matrix4x4<FloatType>::identity(), const Params& params = Params()) {
+		if (m_targetPoints.empty()) throw MLIB_EXCEPTION("no target");
+		if (params.numLevels > 1 && params.voxelSize <= (FloatType)0) throw MLIB_EXCEPTION("coarse-to-fine alignment requires a voxel size");
+		if (params.metric == METRIC_POINT_TO_PLANE && m_targetNormals.empty()) {
+			PointCloudNormals<FloatType>::compute(m_targetPoints, m_targetNormals);
+		}
+
+		Result result;
+		result.numIterations = 0;
+		result.numCorrespondences = 0;
+		result.rmse = (FloatType)0;
+		result.converged = false;
+		Matrix4x4<double> transform(initial);
+		for (int level = (int)std::max(params.numLevels, 1u) - 1; level >= 0; level--) {
+			const FloatType scale = (FloatType)(1 << level);
+			PointCloud<FloatType> levelSource;
+			levelSource.m_points = source;
+			if (params.voxelSize > (FloatType)0) levelSource.downsampleVoxelGrid(params.voxelSize * scale);
+			const FloatType maxDist = params.maxCorrespondenceDist * scale;
+
+			result.converged = false;
+			for (UINT iter = 0; iter < params.maxIterations; iter++) {
+				result.numIterations++;
+				double delta[6];
+				if (!iterate(levelSource.m_points, transform, maxDist, params, delta, result)) break;
+
+				//rotation (Rodrigues) and translation of the update
+				const vec3d omega(delta[0], delta[1], delta[2]), t(delta[3], delta[4], delta[5]);
+				transform = rigidTransform(omega, t) * transform;
+				if (omega.length() < params.minRotation && t.length() < params.minTranslation) {
+					result.converged = true;
+					break;
+				}
+			}
+		}
+		result.transform = Matrix4x4<FloatType>(transform);
+		return result;
+	}
+	Result align(const PointCloud<FloatType>& source, const Matrix4x4<FloatType>& initial = Matrix4x4<FloatType>::identity(), const Params& params = Params()) {
+		return align(source.m_points, initial, params);
+	}
+	Result align(const TriMesh<FloatType>& source, const Matrix4x4<FloatType>& initial = Matrix4x4<FloatType>::identity(), const Params& params = Params()) {
+		std::vector<vec3<FloatType>> points, normals;
+		getVertices(source, points, normals);
+		return align(points, initial, params);
+	}
+
+private:
+	static const int s_blockSize = 4096;
+
+	static void getVertices(const TriMesh<FloatType>& mesh, std::vector<vec3<FloatType>>& points, std::vector<vec3<FloatType>>& normals) {
+		const auto& vertices = mesh.getVertices();
+		points.resize(vertices.size());
+		normals.resize(mesh.hasNormals() ? vertices.size() : 0);
+		for (size_t i = 0; i < vertices.size(); i++) {
+			points[i] = vertices[i].position;
+			if (mesh.hasNormals()) normals[i] = vertices[i].normal;
+		}
+	}
+
+	//! one Gauss-Newton step; returns false if there are too few correspondences or the system is singular
+	bool iterate(const std::vector<vec3<FloatType>>& source, const Matrix4x4<double>& transform, FloatType maxDist, const Params& params, double delta[6], Result& result) {
+		const int n = (int)source.size();
+		m_transformed.resize(n);
+		const Matrix4x4<FloatType> transformF(transform);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int i = 0; i < n; i++) {
+			m_transformed[i] = transformF * source[i];
+		}
+		m_indices.resize(n);
+		if (maxDist > (FloatType)0)	m_tree.kNearestBatchInRadius((const FloatType*)m_transformed.data(), n, 1, maxDist, m_indices.data(), nullptr);
+		else						m_tree.kNearestBatch((const FloatType*)m_transformed.data(), n, 1, m_indices.data(), nullptr);
+
+		//residuals (point-to-plane: signed distance along the target normal)
+		m_residuals.resize(n);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int i = 0; i < n; i++) {
+			const UINT j = m_indices[i];
+			if (j == (UINT)-1) {
+				m_residuals[i] = std::numeric_limits<FloatType>::max();
+				continue;
+			}
+			const vec3<FloatType> d = m_targetPoints[j] - m_transformed[i];
+			m_residuals[i] = params.metric == METRIC_POINT_TO_PLANE ? (m_targetNormals[j] | d) : d.length();
+		}
+
+		const FloatType sigma = params.weighting == WEIGHT_NONE ? (FloatType)0 : (params.robustScale > (FloatType)0 ? params.robustScale : estimateScale());
+		const FloatType k = params.weighting == WEIGHT_HUBER ? (FloatType)1.345 * sigma : (FloatType)4.685 * sigma;
+
+		//normal equations, reduced per block (in parallel) and over the blocks (serially)
+		const int numBlocks = (n + s_blockSize - 1) / s_blockSize;
+		m_blockSums.assign((size_t)numBlocks * 29, 0.0);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int b = 0; b < numBlocks; b++) {
+			double* sum = &m_blockSums[(size_t)b * 29];	//21 entries of the upper triangle, 6 of the right-hand side, squared residuals, count
+			const int end = std::min(n, (b + 1) * s_blockSize);
+			for (int i = b * s_blockSize; i < end; i++) {
+				const FloatType r = m_residuals[i];
+				if (r == std::numeric_limits<FloatType>::max()) continue;
+				const double w = weight(std::abs(r), k, params.weighting);
+				const vec3d p(m_transformed[i]), q(m_targetPoints[m_indices[i]]);
+				if (params.metric == METRIC_POINT_TO_PLANE) {
+					const vec3d normal(m_targetNormals[m_indices[i]]);
+					const vec3d c = p ^ normal;
+					const double J[6] = { c.x, c.y, c.z, normal.x, normal.y, normal.z };
+					accumulate(sum, J, (double)r, w);
+				}
+				else {
+					//rows of [-[p]x | I] with the residual q - p
+					const vec3d d = q - p;
+					const double J0[6] = { 0.0, p.z, -p.y, 1.0, 0.0, 0.0 };
+					const double J1[6] = { -p.z, 0.0, p.x, 0.0, 1.0, 0.0 };
+					const double J2[6] = { p.y, -p.x, 0.0, 0.0, 0.0, 1.0 };
+					accumulate(sum, J0, d.x, w);
+					accumulate(sum, J1, d.y, w);
+					accumulate(sum, J2, d.z, w);
+				}
+				sum[27] += (double)r * (double)r;
+				sum[28] += 1.0;
+			}
+		}
+		double total[29];
+		for (int e = 0; e < 29; e++) total[e] = 0.0;
+		for (int b = 0; b < numBlocks; b++) {
+			for (int e = 0; e < 29; e++) total[e] += m_blockSums[(size_t)b * 29 + e];
+		}
+
+		result.numCorrespondences = (UINT)total[28];
+		result.rmse = total[28] > 0.0 ? (FloatType)std::sqrt(total[27] / total[28]) : (FloatType)0;
+		if (total[28] < 6.0) return false;
+		return solve6x6(total, total + 21, delta);
+	}
+
+	//! accumulates w * J^T J (upper triangle, row by row) and w * J^T r
+	static void accumulate(double* sum, const double J[6], double r, double w) {
+		int e = 0;
+		for (int row = 0; row < 6; row++) {
+			const double wj = w * J[row];
+			for (int col = row; col < 6; col++) sum[e++] += wj * J[col];
+			sum[21 + row] += wj * r;
+		}
+	}
+
+	static double weight(FloatType r, FloatType k, Weighting weighting) {
+		if (weighting == WEIGHT_HUBER) return r <= k ? 1.0 : (double)(k / r);
+		if (weighting == WEIGHT_TUKEY) {
+			if (r >= k) return 0.0;
+			const double u = (double)(r / k);
+			return (1.0 - u * u) * (1.0 - u * u);
+		}
+		return 1.0;
+	}
+
+	//! 1.4826 * median absolute residual (of the valid correspondences)
+	FloatType estimateScale() {
+		m_scratch.clear();
+		for (FloatType r : m_residuals) {
+			if (r != std::numeric_limits<FloatType>::max()) m_scratch.push_back(std::abs(r));
+		}
+		if (m_scratch.empty()) return (FloatType)1;
+		std::nth_element(m_scratch.begin(), m_scratch.begin() + m_scratch.size() / 2, m_scratch.end());
+		return std::max((FloatType)1.4826 * m_scratch[m_scratch.size() / 2], std::numeric_limits<FloatType>::epsilon());
+	}
+
+	//! Cholesky decomposition of the symmetric matrix (upper triangle, row by row)
+	static bool solve6x6(const double upper[21], const double rhs[6], double x[6]) {
+		double A[6][6], L[6][6];
+		int e = 0;
+		for (int row = 0; row < 6; row++) {
+			for (int col = row; col < 6; col++) A[row][col] = A[col][row] = upper[e++];
+		}
+		for (int i = 0; i < 6; i++) {
+			for (int j = 0; j <= i; j++) {
+				double s = A[i][j];
+				for (int k = 0; k < j; k++) s -= L[i][k] * L[j][k];
+				if (i == j) {
+					if (s <= 1e-12 * std::max(A[i][i], 1e-300)) return false;
+					L[i][i] = std::sqrt(s);
+				}
+				else {
+					L[i][j] = s / L[j][j];
+				}
+			}
+		}
+		double y[6];
+		for (int i = 0; i < 6; i++) {
+			double s = rhs[i];
+			for (int k = 0; k < i; k++) s -= L[i][k] * y[k];
+			y[i] = s / L[i][i];
+		}
+		for (int i = 5; i >= 0; i--) {
+			double s = y[i];
+			for (int k = i + 1; k < 6; k++) s -= L[k][i] * x[k];
+			x[i] = s / L[i][i];
+		}
+		return true;
+	}
+
+	static Matrix4x4<double> rigidTransform(const vec3d& omega, const vec3d& t) {
+		const double angle = omega.length();
+		Matrix3x3<double> R;
+		R.setIdentity();
+		if (angle > 0.0) {
+			const vec3d a = omega / angle;
+			const double c = std::cos(angle), s = std::sin(angle), C = 1.0 - c;
+			R = Matrix3x3<double>(
+				c + a.x * a.x * C,			a.x * a.y * C - a.z * s,	a.x * a.z * C + a.y * s,
+				a.y * a.x * C + a.z * s,	c + a.y * a.y * C,			a.y * a.z * C - a.x * s,
+				a.z * a.x * C - a.y * s,	a.z * a.y * C + a.x * s,	c + a.z * a.z * C);
+		}
+		return Matrix4x4<double>(R, t);
+	}
+
+	std::vector<vec3<FloatType>> m_targetPoints;
+	std::vector<vec3<FloatType>> m_targetNormals;
+	NearestNeighborSearchKdTree<FloatType> m_tree;
+
+	//scratch data of the iterations
+	std::vector<vec3<FloatType>> m_transformed;
+	std::vector<UINT> m_indices;
+	std::vector<FloatType> m_residuals;
+	std::vector<FloatType> m_scratch;
+	std::vector<double> m_blockSums;
+};
+
+typedef PointCloudICP<float> PointCloudICPf;
+typedef PointCloudICP<double> PointCloudICPd;
+
+}  // namespace ml
+
+#endif  // CORE_MESH_POINTCLOUDICP_H_
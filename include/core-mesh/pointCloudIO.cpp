@@ -66,16 +66,13 @@ namespace ml {
 						//byteOffset += vertexProperties[j].byteSize;
 					}
 					else if (vertexProperties[j].name == "nx") {
-						pc.m_normals[i].x = ((float*)&data[i*size + byteOffset])[0];
-						byteOffset += vertexProperties[j].byteSize;
+						pc.m_normals[i].x = readNextDecimalValue();
 					}
 					else if (vertexProperties[j].name == "ny") {
-						pc.m_normals[i].y = ((float*)&data[i*size + byteOffset])[0];
-						byteOffset += vertexProperties[j].byteSize;
+						pc.m_normals[i].y = readNextDecimalValue();
 					}
 					else if (vertexProperties[j].name == "nz") {
-						pc.m_normals[i].z = ((float*)&data[i*size + byteOffset])[0];
-						byteOffset += vertexProperties[j].byteSize;
+						pc.m_normals[i].z = readNextDecimalValue();
 					}
 					else if (vertexProperties[j].name == "red") {
 						pc.m_colors[i].x = ((unsigned char*)&data[i*size + byteOffset])[0];	pc.m_colors[i].x/=255.0f;
@@ -120,6 +117,143 @@ namespace ml {
 		file.close();
 	}
 
+	template <class FloatType>
+	void PointCloudIO<FloatType>::loadFromPCD( const std::string& filename, PointCloud<FloatType>& pc )
+	{
+		std::ifstream file(filename, std::ios::binary);
+		if (!file.is_open())	throw MLIB_EXCEPTION("Could not open file " + filename);
+
+		struct Field {
+			std::string name;
+			UINT size;
+			char type;
+			UINT count;
+			UINT offset;
+		};
+		std::vector<Field> fields;
+		std::vector<UINT> sizes, counts;
+		std::vector<char> types;
+		size_t numPoints = 0;
+		std::string data;
+
+		std::string line;
+		while (data.empty() && file.good()) {
+			util::safeGetline(file, line);
+			std::stringstream ss(line);
+			std::string key;
+			ss >> key;
+			if (key.empty() || key[0] == '#') continue;
+			if (key == "FIELDS") {
+				std::string name;
+				while (ss >> name) {
+					Field f;
+					f.name = name;
+					f.size = 4;
+					f.type = 'F';
+					f.count = 1;
+					fields.push_back(f);
+				}
+			}
+			else if (key == "SIZE")		{ UINT v; while (ss >> v) sizes.push_back(v); }
+			else if (key == "TYPE")		{ char v; while (ss >> v) types.push_back(v); }
+			else if (key == "COUNT")	{ UINT v; while (ss >> v) counts.push_back(v); }
+			else if (key == "POINTS")	{ ss >> numPoints; }
+			else if (key == "DATA")		{ ss >> data; }
+		}
+		if (data.empty()) throw MLIB_EXCEPTION("no data found in " + filename);
+		if (data != "ascii" && data != "binary") throw MLIB_EXCEPTION("unsupported PCD data format " + data);
+
+		UINT stride = 0;
+		int x = -1, nx = -1, rgb = -1;
+		for (size_t i = 0; i < fields.size(); i++) {
+			Field& f = fields[i];
+			if (i < sizes.size())	f.size = sizes[i];
+			if (i < types.size())	f.type = types[i];
+			if (i < counts.size())	f.count = counts[i];
+			f.offset = stride;
+			stride += f.size * f.count;
+			if (f.name == "x")									x = (int)i;
+			else if (f.name == "normal_x")						nx = (int)i;
+			else if (f.name == "rgb" || f.name == "rgba")		rgb = (int)i;
+		}
+		if (x < 0 || (size_t)x + 2 >= fields.size()) throw MLIB_EXCEPTION("no positions found in " + filename);
+		if (nx >= 0 && (size_t)nx + 2 >= fields.size()) nx = -1;
+
+		pc.m_points.resize(numPoints);
+		if (nx >= 0)	pc.m_normals.resize(numPoints);
+		if (rgb >= 0)	pc.m_colors.resize(numPoints);
+
+		auto decode = [](const BYTE* src, const Field& f) {
+			if (f.type == 'F') {
+				if (f.size == 8)	{ double v;	memcpy(&v, src, 8);	return v; }
+				float v;	memcpy(&v, src, 4);	return (double)v;
+			}
+			if (f.size == 1)	return f.type == 'U' ? (double)src[0] : (double)(signed char)src[0];
+			if (f.size == 2)	{ unsigned short v;	memcpy(&v, src, 2);	return f.type == 'U' ? (double)v : (double)(short)v; }
+			if (f.size == 4)	{ unsigned int v;	memcpy(&v, src, 4);	return f.type == 'U' ? (double)v : (double)(int)v; }
+			UINT64 v;	memcpy(&v, src, 8);	return f.type == 'U' ? (double)v : (double)(long long)v;
+		};
+		auto unpackColor = [&](unsigned int c, size_t i) {
+			const FloatType alpha = fields[rgb].name == "rgba" ? (FloatType)(c >> 24) : (FloatType)255;
+			pc.m_colors[i] = vec4<FloatType>((FloatType)((c >> 16) & 0xff), (FloatType)((c >> 8) & 0xff), (FloatType)(c & 0xff), alpha) / (FloatType)255;
+		};
+
+		if (data == "binary") {
+			std::vector<BYTE> buffer(numPoints * stride);
+			file.read((char*)buffer.data(), buffer.size());
+			if (!file) throw MLIB_EXCEPTION("unexpected end of file " + filename);
+
+			const int n = (int)numPoints;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < n; i++) {
+				const BYTE* point = &buffer[(size_t)i * stride];
+				for (int d = 0; d < 3; d++) {
+					pc.m_points[i][d] = (FloatType)decode(point + fields[x + d].offset, fields[x + d]);
+					if (nx >= 0) pc.m_normals[i][d] = (FloatType)decode(point + fields[nx + d].offset, fields[nx + d]);
+				}
+				if (rgb >= 0) {
+					unsigned int c;
+					memcpy(&c, point + fields[rgb].offset, 4);
+					unpackColor(c, i);
+				}
+			}
+		} else {
+			//one value per field element
+			std::vector<UINT> element(fields.size());
+			UINT numElements = 0;
+			for (size_t f = 0; f < fields.size(); f++) {
+				element[f] = numElements;
+				numElements += fields[f].count;
+			}
+			std::vector<std::string> values(numElements);
+			for (size_t i = 0; i < numPoints; i++) {
+				util::safeGetline(file, line);
+				std::stringstream ss(line);
+				for (UINT e = 0; e < numElements; e++) {
+					if (!(ss >> values[e])) throw MLIB_EXCEPTION("invalid line in " + filename);
+				}
+				for (int d = 0; d < 3; d++) {
+					pc.m_points[i][d] = (FloatType)std::atof(values[element[x + d]].c_str());
+					if (nx >= 0) pc.m_normals[i][d] = (FloatType)std::atof(values[element[nx + d]].c_str());
+				}
+				if (rgb >= 0) {
+					unsigned int c;
+					if (fields[rgb].type == 'F') {
+						const float f = std::strtof(values[element[rgb]].c_str(), nullptr);
+						memcpy(&c, &f, 4);
+					} else {
+						c = (unsigned int)std::strtoul(values[element[rgb]].c_str(), nullptr, 10);
+					}
+					unpackColor(c, i);
+				}
+			}
+		}
+
+		file.close();
+	}
+
 } // namespace ml
 
 #endif
\ No newline at end of file
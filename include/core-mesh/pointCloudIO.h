@@ -23,6 +23,8 @@ public:
 
 		if (extension == "ply") {
 			loadFromPLY(filename, pointCloud);
+		} else if (extension == "pcd") {
+			loadFromPCD(filename, pointCloud);
 		} else {
 			throw MLIB_EXCEPTION("unknown file extension" + filename);
 		}
@@ -44,6 +46,8 @@ public:
 		std::string extension = util::getFileExtension(filename);
 		if (extension == "ply") {
 			saveToPLY(filename, pointCloud);
+		} else if (extension == "pcd") {
+			saveToPCD(filename, pointCloud);
 		} else {
 			throw MLIB_EXCEPTION("unknown file extension" + filename);
 		}
@@ -56,6 +60,9 @@ public:
 
 	static void loadFromPLY(const std::string& filename, PointCloud<FloatType>& pc);
 
+	//! ascii and binary PCD files (binary_compressed is not supported); reads x y z, normal_x normal_y normal_z and rgb/rgba
+	static void loadFromPCD(const std::string& filename, PointCloud<FloatType>& pc);
+
 
 	/************************************************************************/
 	/* Write Functions													    */
@@ -63,45 +70,53 @@ public:
 
 	// PCD is the file format used by PCL
 	// example: http://pointclouds.org/documentation/tutorials/pcd_file_format.php
-	static void saveToPCD(const std::string& filename, const PointCloud<FloatType>& pc) {
-		if (!std::is_same<FloatType, float>::value) throw MLIB_EXCEPTION("only implemented for float, not for double");
-
+	// fields: x y z [normal_x normal_y normal_z] [rgba (packed as 0xAARRGGBB)]
+	static void saveToPCD(const std::string& filename, const PointCloud<FloatType>& pc, bool binary = true) {
 		std::ofstream file(filename, std::ios::binary);
 		if (!file.is_open()) throw MLIB_EXCEPTION("Could not open file for writing " + filename);
-		file << "VERSION .7" << std::endl;
-		file << "FIELDS x y z" << std::endl;
-		file << "SIZE 4 4 4" << std::endl;
-		file << "TYPE F F F" << std::endl;
-		file << "COUNT 1 1 1" << std::endl;
-		file << "WIDTH " << pc.m_points.size() << std::endl;
-		file << "HEIGHT 1" << std::endl;
-		file << "VIEWPOINT 0 0 0 1 0 0 0" << std::endl;
-		file << "POINTS " << pc.m_points.size() << std::endl;
-		file << "DATA ascii" << std::endl;
-		for (auto &p : pc.m_points)
-		{
-			file << p.x << " " << p.y << " " << p.z << std::endl;
+		const char floatSize = sizeof(FloatType) == 4 ? '4' : '8';
+		const std::string fs = std::string(" ") + floatSize;
+		file << "VERSION .7\n";
+		file << "FIELDS x y z" << (pc.hasNormals() ? " normal_x normal_y normal_z" : "") << (pc.hasColors() ? " rgba" : "") << "\n";
+		file << "SIZE" << fs << fs << fs << (pc.hasNormals() ? fs + fs + fs : "") << (pc.hasColors() ? " 4" : "") << "\n";
+		file << "TYPE F F F" << (pc.hasNormals() ? " F F F" : "") << (pc.hasColors() ? " U" : "") << "\n";
+		file << "COUNT 1 1 1" << (pc.hasNormals() ? " 1 1 1" : "") << (pc.hasColors() ? " 1" : "") << "\n";
+		file << "WIDTH " << pc.m_points.size() << "\n";
+		file << "HEIGHT 1\n";
+		file << "VIEWPOINT 0 0 0 1 0 0 0\n";
+		file << "POINTS " << pc.m_points.size() << "\n";
+		file << "DATA " << (binary ? "binary" : "ascii") << "\n";
+
+		if (binary) {
+			writeChunked(file, pc, true);
+		} else {
+			file << std::setprecision(std::numeric_limits<FloatType>::digits10 + 2);
+			for (size_t i = 0; i < pc.m_points.size(); i++) {
+				const vec3<FloatType>& p = pc.m_points[i];
+				file << p.x << " " << p.y << " " << p.z;
+				if (pc.hasNormals())	file << " " << pc.m_normals[i].x << " " << pc.m_normals[i].y << " " << pc.m_normals[i].z;
+				if (pc.hasColors())		file << " " << packColorPCD(pc.m_colors[i]);
+				file << "\n";
+			}
 		}
 		file.close();
 	}
 
 	static void saveToPLY(const std::string& filename, const PointCloud<FloatType>& pc) {
-
-		if (!std::is_same<FloatType, float>::value) throw MLIB_EXCEPTION("only implemented for float, not for double");
-
 		std::ofstream file(filename, std::ios::binary);
 		if (!file.is_open()) throw MLIB_EXCEPTION("Could not open file for writing " + filename);
+		const std::string type = sizeof(FloatType) == 4 ? "float" : "double";
 		file << "ply\n";
 		file << "format binary_little_endian 1.0\n";
 		file << "comment MLIB generated\n";
 		file << "element vertex " << pc.m_points.size() << "\n";
-		file << "property float x\n";
-		file << "property float y\n";
-		file << "property float z\n";
+		file << "property " << type << " x\n";
+		file << "property " << type << " y\n";
+		file << "property " << type << " z\n";
 		if (pc.m_normals.size() > 0) {
-			file << "property float nx\n";
-			file << "property float ny\n";
-			file << "property float nz\n";
+			file << "property " << type << " nx\n";
+			file << "property " << type << " ny\n";
+			file << "property " << type << " nz\n";
 		}
 		if (pc.m_colors.size() > 0) {
 			file << "property uchar red\n";
@@ -111,34 +126,60 @@ public:
 		}
 		file << "end_header\n";
 
-		if (pc.m_colors.size() > 0 || pc.m_normals.size() > 0) {
-			size_t vertexByteSize = sizeof(float)*3;
-			if (pc.m_normals.size() > 0)	vertexByteSize += sizeof(float)*3;
-			if (pc.m_colors.size() > 0)		vertexByteSize += sizeof(unsigned char)*4;
-			BYTE* data = new BYTE[vertexByteSize*pc.m_points.size()];
-			size_t byteOffset = 0;
-			for (size_t i = 0; i < pc.m_points.size(); i++) {
-				memcpy(&data[byteOffset], &pc.m_points[i], sizeof(float)*3);
-				byteOffset += sizeof(float)*3;
-				if (pc.m_normals.size() > 0) {
-					memcpy(&data[byteOffset], &pc.m_normals[i], sizeof(float)*3);
-					byteOffset += sizeof(float)*3;
+		writeChunked(file, pc, false);
+		file.close();
+	}
+
+private:
+	static vec4uc toColor8(const vec4<FloatType>& c) {
+		vec4uc result;
+		for (int k = 0; k < 4; k++) result[k] = (unsigned char)math::clamp(c[k] * (FloatType)255 + (FloatType)0.5, (FloatType)0, (FloatType)255);
+		return result;
+	}
+	static unsigned int packColorPCD(const vec4<FloatType>& c) {
+		const vec4uc c8 = toColor8(c);
+		return ((unsigned int)c8.w << 24) | ((unsigned int)c8.x << 16) | ((unsigned int)c8.y << 8) | (unsigned int)c8.z;
+	}
+
+	//! interleaves the attributes of chunks of points into a staging buffer (in parallel) and writes every chunk at once
+	static void writeChunked(std::ofstream& file, const PointCloud<FloatType>& pc, bool pcdColors) {
+		const size_t vec3Size = sizeof(FloatType) * 3;
+		size_t stride = vec3Size;
+		if (pc.hasNormals())	stride += vec3Size;
+		if (pc.hasColors())		stride += 4;
+
+		const size_t chunkSize = (size_t)1 << 20;
+		std::vector<BYTE> buffer(std::min(chunkSize, pc.m_points.size()) * stride);
+		for (size_t first = 0; first < pc.m_points.size(); first += chunkSize) {
+			const int count = (int)std::min(chunkSize, pc.m_points.size() - first);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < count; i++) {
+				const size_t v = first + i;
+				BYTE* dst = &buffer[(size_t)i * stride];
+				memcpy(dst, &pc.m_points[v], vec3Size);
+				dst += vec3Size;
+				if (pc.hasNormals()) {
+					memcpy(dst, &pc.m_normals[v], vec3Size);
+					dst += vec3Size;
 				}
-				if (pc.m_colors.size() > 0) {
-					vec4uc c(pc.m_colors[i]*255);
-					memcpy(&data[byteOffset], &c, sizeof(unsigned char)*4);
-					byteOffset += sizeof(unsigned char)*4;
+				if (pc.hasColors()) {
+					if (pcdColors) {
+						const unsigned int c = packColorPCD(pc.m_colors[v]);
+						memcpy(dst, &c, 4);
+					} else {
+						const vec4uc c = toColor8(pc.m_colors[v]);
+						memcpy(dst, &c, 4);
+					}
 				}
 			}
-			file.write((const char*)data, byteOffset);
-			SAFE_DELETE_ARRAY(data);
-		} else {
-			file.write((const char*)&pc.m_points[0], sizeof(float)*3*pc.m_points.size());
+			file.write((const char*)buffer.data(), (size_t)count * stride);
 		}
-
-		file.close();
 	}
 
+public:
+
 
 /*
 	static void saveToFile(const std::string &filename, const std::vector<vec3<FloatType>> &points) {
@@ -283,6 +324,171 @@ private:
 typedef PointCloudIO<float> PointCloudIOf;
 typedef PointCloudIO<double> PointCloudIOd;
 
+
+//! reads the vertices of a PLY file in chunks (for point clouds that do not fit into memory)
+template <class FloatType>
+class PointCloudStreamReaderPLY {
+public:
+	PointCloudStreamReaderPLY() {
+		m_numRead = 0;
+		m_stride = 0;
+	}
+	PointCloudStreamReaderPLY(const std::string& filename) {
+		open(filename);
+	}
+
+	void open(const std::string& filename) {
+		m_file.close();
+		m_file.clear();
+		m_file.open(filename, std::ios::binary);
+		if (!m_file.is_open())	throw MLIB_EXCEPTION("Could not open file " + filename);
+
+		m_header = PlyHeader();
+		m_header.m_bBinary = false;
+		m_header.read(m_file);
+		if (m_header.m_numVertices == (unsigned int)-1) throw MLIB_EXCEPTION("no vertices found");
+		m_dataStart = m_file.tellg();
+		m_numRead = 0;
+
+		m_stride = 0;
+		m_properties.clear();
+		for (const PlyHeader::PlyPropertyHeader& p : m_header.m_properties["vertex"]) {
+			Property prop;
+			prop.offset = m_stride;
+			prop.type = getType(p.nameType);
+			if (prop.type == TYPE_UNKNOWN) throw MLIB_EXCEPTION("unknown data type " + p.nameType);
+			prop.target = getTarget(p.name);
+			prop.scale = 1.0;
+			if (prop.target >= 6) {
+				if (p.byteSize == 1)		prop.scale = 1.0 / 255.0;
+				else if (p.byteSize == 2)	prop.scale = 1.0 / 65535.0;
+			}
+			m_properties.push_back(prop);
+			m_stride += p.byteSize;
+		}
+	}
+
+	size_t getNumPoints() const {
+		return m_header.m_numVertices;
+	}
+	bool hasNormals() const {
+		return m_header.m_bHasNormals;
+	}
+	bool hasColors() const {
+		return m_header.m_bHasColors;
+	}
+
+	//! restarts at the first point
+	void rewind() {
+		m_file.clear();
+		m_file.seekg(m_dataStart);
+		m_numRead = 0;
+	}
+
+	//! reads (up to) the next maxCount points into pc (replacing its content); returns the number of points read (0 at the end)
+	size_t read(PointCloud<FloatType>& pc, size_t maxCount) {
+		const size_t count = std::min(maxCount, getNumPoints() - m_numRead);
+		pc.m_points.resize(count);
+		if (hasNormals())	pc.m_normals.resize(count);
+		else				pc.m_normals.clear();
+		if (hasColors())	pc.m_colors.assign(count, vec4<FloatType>((FloatType)0, (FloatType)0, (FloatType)0, (FloatType)1));
+		else				pc.m_colors.clear();
+		pc.m_texCoords.clear();
+		if (count == 0) return 0;
+
+		if (m_header.m_bBinary) {
+			m_buffer.resize(count * m_stride);
+			m_file.read((char*)m_buffer.data(), m_buffer.size());
+			if (!m_file) throw MLIB_EXCEPTION("unexpected end of file");
+
+			const int countI = (int)count;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < countI; i++) {
+				const BYTE* vertex = &m_buffer[(size_t)i * m_stride];
+				for (const Property& p : m_properties) {
+					if (p.target >= 0) assign(pc, i, p.target, decode(vertex + p.offset, p.type) * p.scale);
+				}
+			}
+		}
+		else {
+			std::string line;
+			for (size_t i = 0; i < count; i++) {
+				util::safeGetline(m_file, line);
+				std::stringstream ss(line);
+				for (const Property& p : m_properties) {
+					double value = 0.0;
+					ss >> value;
+					if (p.target >= 0) assign(pc, i, p.target, value * p.scale);
+				}
+			}
+		}
+		m_numRead += count;
+		return count;
+	}
+
+private:
+	enum DataType {
+		TYPE_FLOAT, TYPE_DOUBLE, TYPE_UCHAR, TYPE_CHAR, TYPE_USHORT, TYPE_SHORT, TYPE_UINT, TYPE_INT, TYPE_UNKNOWN
+	};
+
+	struct Property {
+		UINT offset;
+		DataType type;
+		int target;			//0-2 position, 3-5 normal, 6-9 color, -1 ignored
+		double scale;
+	};
+
+	static int getTarget(const std::string& name) {
+		static const char* names[] = { "x", "y", "z", "nx", "ny", "nz", "red", "green", "blue", "alpha" };
+		for (int i = 0; i < 10; i++) {
+			if (name == names[i]) return i;
+		}
+		return -1;
+	}
+
+	static DataType getType(const std::string& name) {
+		static const char* names[] = { "float", "double", "uchar", "char", "ushort", "short", "uint", "int" };
+		for (int i = 0; i < TYPE_UNKNOWN; i++) {
+			if (name == names[i]) return (DataType)i;
+		}
+		return TYPE_UNKNOWN;
+	}
+
+	//! types are validated in open(), so this never throws (it runs inside the parallel loop of read)
+	static double decode(const BYTE* data, DataType type) {
+		switch (type) {
+		case TYPE_FLOAT:	{ float v;			memcpy(&v, data, sizeof(v));	return v; }
+		case TYPE_DOUBLE:	{ double v;			memcpy(&v, data, sizeof(v));	return v; }
+		case TYPE_UCHAR:	{ return (double)data[0]; }
+		case TYPE_CHAR:		{ return (double)(signed char)data[0]; }
+		case TYPE_USHORT:	{ unsigned short v;	memcpy(&v, data, sizeof(v));	return v; }
+		case TYPE_SHORT:	{ short v;			memcpy(&v, data, sizeof(v));	return v; }
+		case TYPE_UINT:		{ unsigned int v;	memcpy(&v, data, sizeof(v));	return v; }
+		case TYPE_INT:		{ int v;			memcpy(&v, data, sizeof(v));	return v; }
+		default:			return 0.0;
+		}
+	}
+
+	static void assign(PointCloud<FloatType>& pc, size_t i, int target, double value) {
+		if (target < 3)			pc.m_points[i][target] = (FloatType)value;
+		else if (target < 6)	pc.m_normals[i][target - 3] = (FloatType)value;
+		else					pc.m_colors[i][target - 6] = (FloatType)value;
+	}
+
+	std::ifstream			m_file;
+	PlyHeader				m_header;
+	std::streampos			m_dataStart;
+	size_t					m_numRead;
+	UINT					m_stride;
+	std::vector<Property>	m_properties;
+	std::vector<BYTE>		m_buffer;
+};
+
+typedef PointCloudStreamReaderPLY<float> PointCloudStreamReaderPLYf;
+typedef PointCloudStreamReaderPLY<double> PointCloudStreamReaderPLYd;
+
 } //namespace ml
 
 
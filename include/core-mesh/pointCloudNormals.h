@@ -0,0 +1,292 @@
+#ifndef CORE_MESH_POINTCLOUDNORMALS_H_
+#define CORE_MESH_POINTCLOUDNORMALS_H_
+
+namespace ml {
+
+//! parallel normal estimation for unorganized point clouds (used by PointCloud::computeNormals)
+//! every normal is the eigenvector of the smallest eigenvalue of the covariance of the point's neighborhood (kNN through
+//! a k-d tree, or all points within a radius through a uniform grid); the 3x3 eigenproblem is solved in closed form.
+//! PCA normals are only defined up to sign; orientTowardsViewpoint and orientMST make them consistent.
+template<class FloatType>
+class PointCloudNormals {
+public:
+	//! k nearest neighbors (including the point itself); if radius > 0, only neighbors within the radius are used.
+	//! points with fewer than 3 neighbors get a zero normal. curvature (optional) receives the surface variation
+	//! lambda_min / (lambda_0 + lambda_1 + lambda_2) of every neighborhood
+	static void compute(const std::vector<vec3<FloatType>>& points, std::vector<vec3<FloatType>>& normals, UINT k = 16, FloatType radius = 0, std::vector<FloatType>* curvature = nullptr)
+	{
+		normals.resize(points.size());
+		if (curvature) curvature->resize(points.size());
+		if (points.empty()) return;
+		if (k < 3) throw MLIB_EXCEPTION("at least 3 neighbors are required");
+
+		//k nearest neighbors, queried in chunks to bound the memory of the neighbor lists
+		NearestNeighborSearchKdTree<FloatType> tree;
+		tree.init((const FloatType*)points.data(), (UINT)points.size(), 3, k);
+		const size_t chunkSize = 1 << 16;
+		std::vector<UINT> indices(chunkSize * k);
+		std::vector<FloatType> dists(chunkSize * k);
+		for (size_t first = 0; first < points.size(); first += chunkSize) {
+			const size_t count = std::min(chunkSize, points.size() - first);
+			tree.kNearestBatch((const FloatType*)&points[first], count, k, indices.data(), dists.data());
+			const int countI = (int)count;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int q = 0; q < countI; q++) {
+				Covariance c;
+				for (UINT j = 0; j < k; j++) {
+					const UINT n = indices[(size_t)q * k + j];
+					if (n == (UINT)-1 || (radius > (FloatType)0 && dists[(size_t)q * k + j] > radius)) break;
+					c.add(points[n]);
+				}
+				fitNormal(c, normals[first + q], curvature ? &(*curvature)[first + q] : nullptr);
+			}
+		}
+	}
+
+	//! uses all points within the radius (through a uniform grid); better suited than kNN for non-uniform densities
+	static void computeInRadius(const std::vector<vec3<FloatType>>& points, std::vector<vec3<FloatType>>& normals, FloatType radius, std::vector<FloatType>* curvature = nullptr)
+	{
+		normals.resize(points.size());
+		if (curvature) curvature->resize(points.size());
+		if (points.empty()) return;
+		if (radius <= (FloatType)0) throw MLIB_EXCEPTION("invalid radius");
+
+		UniformPointGrid<FloatType> grid(points, radius);
+		const int numPoints = (int)points.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+		for (int i = 0; i < numPoints; i++) {
+			Covariance c;
+			grid.forEachInRadius(points[i], radius, [&](UINT j, FloatType) { c.add(points[j]); });
+			fitNormal(c, normals[i], curvature ? &(*curvature)[i] : nullptr);
+		}
+	}
+
+	//! flips every normal that points away from the viewpoint (e.g., the sensor position)
+	static void orientTowardsViewpoint(const std::vector<vec3<FloatType>>& points, std::vector<vec3<FloatType>>& normals, const vec3<FloatType>& viewpoint)
+	{
+		const int numPoints = (int)std::min(points.size(), normals.size());
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int i = 0; i < numPoints; i++) {
+			if ((normals[i] | (viewpoint - points[i])) < (FloatType)0) normals[i] = -normals[i];
+		}
+	}
+
+	//! consistent orientation by propagation along a minimum spanning tree of the kNN graph (Hoppe et al. 1992); edges
+	//! between nearly parallel normals are cheap. Every connected component starts at its highest point (largest z),
+	//! whose normal is oriented towards +z. The propagation is serial (but deterministic).
+	static void orientMST(const std::vector<vec3<FloatType>>& points, std::vector<vec3<FloatType>>& normals, UINT k = 8)
+	{
+		if (normals.size() != points.size()) throw MLIB_EXCEPTION("normals do not match the points");
+		const size_t numPoints = points.size();
+		if (numPoints == 0) return;
+		k = std::min(k + 1, (UINT)numPoints);
+
+		//symmetric kNN graph in CSR layout
+		NearestNeighborSearchKdTree<FloatType> tree;
+		tree.init((const FloatType*)points.data(), (UINT)numPoints, 3, k);
+		std::vector<UINT> knn(numPoints * k);
+		tree.kNearestBatch((const FloatType*)points.data(), numPoints, k, knn.data(), nullptr);
+
+		std::vector<UINT> offsets(numPoints + 1, 0);
+		for (size_t i = 0; i < numPoints; i++) {
+			for (UINT j = 0; j < k; j++) {
+				const UINT n = knn[i * k + j];
+				if (n == (UINT)-1 || n == i) continue;
+				offsets[i + 1]++;
+				offsets[n + 1]++;
+			}
+		}
+		for (size_t i = 0; i < numPoints; i++) offsets[i + 1] += offsets[i];
+		std::vector<UINT> adjacency(offsets.back());
+		std::vector<UINT> cursor(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < numPoints; i++) {
+			for (UINT j = 0; j < k; j++) {
+				const UINT n = knn[i * k + j];
+				if (n == (UINT)-1 || n == i) continue;
+				adjacency[cursor[i]++] = n;
+				adjacency[cursor[n]++] = (UINT)i;
+			}
+		}
+
+		//seeds in order of decreasing height
+		std::vector<UINT> seeds(numPoints);
+		for (size_t i = 0; i < numPoints; i++) seeds[i] = (UINT)i;
+		std::sort(seeds.begin(), seeds.end(), [&](UINT a, UINT b) { return points[a].z > points[b].z || (points[a].z == points[b].z && a < b); });
+
+		//Prim's algorithm; an edge (weight, target, source) is popped in order of increasing weight (ties by index)
+		typedef std::pair<FloatType, std::pair<UINT, UINT> > Edge;
+		std::priority_queue<Edge, std::vector<Edge>, std::greater<Edge> > queue;
+		std::vector<bool> visited(numPoints, false);
+		for (UINT seed : seeds) {
+			if (visited[seed]) continue;
+			if (normals[seed].z < (FloatType)0) normals[seed] = -normals[seed];
+			visited[seed] = true;
+			pushEdges(seed, normals, offsets, adjacency, visited, queue);
+			while (!queue.empty()) {
+				const Edge e = queue.top();
+				queue.pop();
+				const UINT target = e.second.first;
+				if (visited[target]) continue;
+				visited[target] = true;
+				if ((normals[target] | normals[e.second.second]) < (FloatType)0) normals[target] = -normals[target];
+				pushEdges(target, normals, offsets, adjacency, visited, queue);
+			}
+		}
+	}
+
+	//! eigenvalues (ascending) and unit eigenvectors of a symmetric 3x3 matrix, in closed form (trigonometric solution
+	//! of the characteristic polynomial; eigenvectors from cross products of the rows of A - lambda*I)
+	static void eigenSymmetric3x3(const Matrix3x3<FloatType>& m, vec3<FloatType>& eigenValues, vec3<FloatType> eigenVectors[3])
+	{
+		const double a[6] = { m(0, 0), m(0, 1), m(0, 2), m(1, 1), m(1, 2), m(2, 2) };
+		double lambda[3];
+		vec3d v[3];
+		solveSymmetric3x3(a, lambda, v);
+		eigenValues = vec3<FloatType>((FloatType)lambda[0], (FloatType)lambda[1], (FloatType)lambda[2]);
+		for (unsigned int i = 0; i < 3; i++) eigenVectors[i] = vec3<FloatType>(v[i]);
+	}
+
+private:
+	//! running sums for the neighborhood covariance
+	struct Covariance {
+		Covariance() : n(0), sum(0, 0, 0) {
+			for (unsigned int i = 0; i < 6; i++) sumSq[i] = 0.0;
+		}
+		void add(const vec3<FloatType>& p) {
+			//accumulate relative to the first point to limit cancellation
+			if (n == 0) origin = vec3d(p);
+			const vec3d d = vec3d(p) - origin;
+			sum += d;
+			sumSq[0] += d.x * d.x;	sumSq[1] += d.x * d.y;	sumSq[2] += d.x * d.z;
+			sumSq[3] += d.y * d.y;	sumSq[4] += d.y * d.z;	sumSq[5] += d.z * d.z;
+			n++;
+		}
+		UINT n;
+		vec3d origin;
+		vec3d sum;
+		double sumSq[6];
+	};
+
+	//! a = (a00, a01, a02, a11, a12, a22)
+	static void solveSymmetric3x3(const double a[6], double lambda[3], vec3d v[3])
+	{
+		//scaling does not change the eigenvectors but avoids over-/underflow
+		double scale = 0.0;
+		for (unsigned int i = 0; i < 6; i++) scale = std::max(scale, std::abs(a[i]));
+		if (scale == 0.0) {
+			lambda[0] = lambda[1] = lambda[2] = 0.0;
+			v[0] = vec3d(1, 0, 0);	v[1] = vec3d(0, 1, 0);	v[2] = vec3d(0, 0, 1);
+			return;
+		}
+		const double a00 = a[0] / scale, a01 = a[1] / scale, a02 = a[2] / scale;
+		const double a11 = a[3] / scale, a12 = a[4] / scale, a22 = a[5] / scale;
+
+		const double p1 = a01 * a01 + a02 * a02 + a12 * a12;
+		const double q = (a00 + a11 + a22) / 3.0;
+		const double b00 = a00 - q, b11 = a11 - q, b22 = a22 - q;
+		const double p = std::sqrt((b00 * b00 + b11 * b11 + b22 * b22 + 2.0 * p1) / 6.0);
+		if (p < 1e-12) {
+			lambda[0] = lambda[1] = lambda[2] = q;
+		}
+		else {
+			const double detB = b00 * (b11 * b22 - a12 * a12) - a01 * (a01 * b22 - a12 * a02) + a02 * (a01 * a12 - b11 * a02);
+			const double r = math::clamp(detB / (2.0 * p * p * p), -1.0, 1.0);
+			const double phi = std::acos(r) / 3.0;
+			lambda[2] = q + 2.0 * p * std::cos(phi);
+			lambda[0] = q + 2.0 * p * std::cos(phi + 2.0 * math::PI / 3.0);
+			lambda[1] = 3.0 * q - lambda[0] - lambda[2];
+		}
+
+		const double tol = 1e-10;
+		const bool found0 = eigenVector(a00, a01, a02, a11, a12, a22, lambda[0], tol, v[0]);
+		const bool found2 = eigenVector(a00, a01, a02, a11, a12, a22, lambda[2], tol, v[2]);
+		if (found0 && found2) {
+			v[1] = (v[2] ^ v[0]).getNormalized();
+		}
+		else if (found2) {
+			//double smallest eigenvalue: any orthonormal basis of the plane orthogonal to v[2]
+			v[0] = orthogonal(v[2]);
+			v[1] = v[2] ^ v[0];
+		}
+		else if (found0) {
+			v[2] = orthogonal(v[0]);
+			v[1] = v[2] ^ v[0];
+		}
+		else {
+			v[0] = vec3d(1, 0, 0);	v[1] = vec3d(0, 1, 0);	v[2] = vec3d(0, 0, 1);
+		}
+		for (unsigned int i = 0; i < 3; i++) lambda[i] *= scale;
+	}
+
+	static void fitNormal(const Covariance& c, vec3<FloatType>& normal, FloatType* curvature)
+	{
+		normal = vec3<FloatType>(0, 0, 0);
+		if (curvature) *curvature = 0;
+		if (c.n < 3) return;
+
+		const double invN = 1.0 / (double)c.n;
+		const vec3d mean = c.sum * invN;
+		const double cov[6] = {
+			c.sumSq[0] * invN - mean.x * mean.x, c.sumSq[1] * invN - mean.x * mean.y, c.sumSq[2] * invN - mean.x * mean.z,
+			c.sumSq[3] * invN - mean.y * mean.y, c.sumSq[4] * invN - mean.y * mean.z, c.sumSq[5] * invN - mean.z * mean.z };
+
+		double lambda[3];
+		vec3d v[3];
+		solveSymmetric3x3(cov, lambda, v);
+		normal = vec3<FloatType>(v[0]);
+		if (curvature) {
+			const double sum = lambda[0] + lambda[1] + lambda[2];
+			*curvature = sum > 0.0 ? (FloatType)(std::max(lambda[0], 0.0) / sum) : (FloatType)0;
+		}
+	}
+
+	//! null vector of A - lambda*I from the largest cross product of two of its rows; false if the null space is not 1D
+	static bool eigenVector(double a00, double a01, double a02, double a11, double a12, double a22, double lambda, double tol, vec3d& result)
+	{
+		const vec3d r0(a00 - lambda, a01, a02);
+		const vec3d r1(a01, a11 - lambda, a12);
+		const vec3d r2(a02, a12, a22 - lambda);
+		const vec3d c[3] = { r0 ^ r1, r0 ^ r2, r1 ^ r2 };
+		unsigned int best = 0;
+		double bestLengthSq = c[0].lengthSq();
+		for (unsigned int i = 1; i < 3; i++) {
+			if (c[i].lengthSq() > bestLengthSq) {
+				best = i;
+				bestLengthSq = c[i].lengthSq();
+			}
+		}
+		if (bestLengthSq <= tol * tol) return false;
+		result = c[best] / std::sqrt(bestLengthSq);
+		return true;
+	}
+
+	static vec3d orthogonal(const vec3d& v)
+	{
+		const vec3d axis = std::abs(v.x) < 0.9 ? vec3d(1, 0, 0) : vec3d(0, 1, 0);
+		return (v ^ axis).getNormalized();
+	}
+
+	template<class Queue>
+	static void pushEdges(UINT source, const std::vector<vec3<FloatType>>& normals, const std::vector<UINT>& offsets, const std::vector<UINT>& adjacency, const std::vector<bool>& visited, Queue& queue)
+	{
+		for (UINT a = offsets[source]; a < offsets[source + 1]; a++) {
+			const UINT target = adjacency[a];
+			if (visited[target]) continue;
+			const FloatType weight = (FloatType)1 - std::abs(normals[source] | normals[target]);
+			queue.push(std::make_pair(weight, std::make_pair(target, source)));
+		}
+	}
+};
+
+typedef PointCloudNormals<float> PointCloudNormalsf;
+typedef PointCloudNormals<double> PointCloudNormalsd;
+
+}  // namespace ml
+
+#endif  // CORE_MESH_POINTCLOUDNORMALS_H_
@@ -0,0 +1,841 @@
+#ifndef CORE_MESH_POINTCLOUDOCTREE_H_
+#define CORE_MESH_POINTCLOUDOCTREE_H_
+
+namespace ml {
+
+//! node of an out-of-core point cloud octree; stored as is in the node table of the file (see PointCloudOctreeBuilder)
+struct PointCloudOctreeNode {
+	UINT64	offset;			//byte offset of the points of the node in the file
+	UINT	numPoints;
+	UINT	level;			//0 is the root
+	UINT	coord[3];		//cell of the node on its level
+	int		children[8];	//-1 if empty; child c covers the octant (c & 1, (c >> 1) & 1, (c >> 2) & 1)
+
+	bool isLeaf() const {
+		for (UINT c = 0; c < 8; c++) {
+			if (children[c] >= 0) return false;
+		}
+		return true;
+	}
+};
+
+//! file layout: header, the points of all nodes (positions, then normals, then RGBA8 colors), node table (root first)
+struct PointCloudOctreeHeader {
+	char	magic[8];
+	UINT	floatSize;
+	UINT	attributes;			//1: normals, 2: colors
+	UINT	lodResolution;
+	UINT	maxPointsPerNode;
+	UINT64	numInputPoints;
+	UINT64	numNodes;
+	UINT64	nodeTableOffset;
+	double	rootMin[3];			//the root node is the cube [rootMin, rootMin + rootSize]
+	double	rootSize;
+
+	static const char* getMagic() {
+		return "MLOCTREE";
+	}
+	bool hasNormals() const {
+		return (attributes & 1) != 0;
+	}
+	bool hasColors() const {
+		return (attributes & 2) != 0;
+	}
+	//! bytes per point in the file
+	size_t getPointSize() const {
+		return floatSize * (hasNormals() ? 6 : 3) + (hasColors() ? 4 : 0);
+	}
+};
+
+//! builds a level-of-detail octree file from PLY files that do not fit into memory
+//! Every node is a stand-alone representation of its subtree: leaves hold all of their points (at most maxPointsPerNode)
+//! and inner nodes keep one point per cell of a lodResolution^3 grid, subsampled from the points of their children.
+//! The input is streamed three times: bounding box; point counts on a 128^3 grid, from which subtrees that fit into the
+//! memory budget (chunks) are determined; distribution of the points to temporary chunk files. Chunks that are still too
+//! large (cells of the counting grid with too many points) are split by streaming their files into their octants. Every
+//! chunk is then built in memory and written to the output, and finally the nodes above the chunks are built from the
+//! chunk roots.
+template<class FloatType>
+class PointCloudOctreeBuilder {
+public:
+	struct Params {
+		Params() {
+			maxPointsPerNode = 20000;
+			lodResolution = 64;
+			memoryBudget = (size_t)1 << 30;
+		}
+		UINT	maxPointsPerNode;	//leaves hold at most this many points (unless the maximum depth is reached)
+		UINT	lodResolution;		//power of two
+		size_t	memoryBudget;		//bytes; bounds the number of points that are processed in memory at once
+	};
+
+	//! builds the octree file from one or several PLY files (which must have the same attributes)
+	static void build(const std::vector<std::string>& plyFiles, const std::string& outFile, const Params& params = Params()) {
+		PointCloudOctreeBuilder builder(params);
+		builder.run(plyFiles, outFile);
+	}
+	static void build(const std::string& plyFile, const std::string& outFile, const Params& params = Params()) {
+		build(std::vector<std::string>(1, plyFile), outFile, params);
+	}
+
+private:
+	static const UINT s_maxLevel = 21;			//quantized coordinates have 21 bits per dimension
+	static const UINT s_countLevel = 7;			//level of the counting grid
+	static const size_t s_readChunkSize = (size_t)1 << 20;
+
+	struct Chunk {
+		UINT level;
+		vec3ui coord;
+		UINT64 numPoints;
+		std::string filename;
+	};
+
+	PointCloudOctreeBuilder(const Params& params) : m_params(params) {
+		if (!math::isPower2(m_params.lodResolution)) throw MLIB_EXCEPTION("lodResolution must be a power of two");
+		if (m_params.maxPointsPerNode == 0) throw MLIB_EXCEPTION("invalid maxPointsPerNode");
+		m_lodBits = 0;
+		while ((1u << m_lodBits) < m_params.lodResolution) m_lodBits++;
+		m_hasNormals = m_hasColors = false;
+		m_numInputPoints = 0;
+	}
+
+	void run(const std::vector<std::string>& plyFiles, const std::string& outFile) {
+		computeBounds(plyFiles);
+		countPoints(plyFiles);
+		selectChunks(0, vec3ui(0, 0, 0), outFile);
+		distributePoints(plyFiles);
+		splitChunks();
+
+		m_out.open(outFile, std::ios::binary);
+		if (!m_out.is_open()) throw MLIB_EXCEPTION("Could not open file for writing " + outFile);
+		PointCloudOctreeHeader header;
+		memset(&header, 0, sizeof(header));
+		m_out.write((const char*)&header, sizeof(header));
+
+		//subtrees of the chunks (in memory), then the nodes above them
+		m_chunkRoots.resize(m_chunks.size());
+		m_chunkSamples.resize(m_chunks.size());
+		for (size_t c = 0; c < m_chunks.size(); c++) {
+			if (m_chunks[c].numPoints == 0) continue;	//split into other chunks
+			PointCloud<FloatType> pc;
+			loadChunk(m_chunks[c], pc);
+			std::remove(m_chunks[c].filename.c_str());
+
+			std::vector<UINT> indices(pc.m_points.size());
+			for (size_t i = 0; i < indices.size(); i++) indices[i] = (UINT)i;
+			std::vector<UINT> sample;
+			m_chunkRoots[c] = buildSubtree(pc, indices.data(), indices.size(), m_chunks[c].level, sample);
+			gather(pc, sample, m_chunkSamples[c]);
+		}
+		PointCloud<FloatType> rootSample;
+		const int root = buildUpper(0, vec3ui(0, 0, 0), rootSample);
+
+		//node table in breadth-first order (root first)
+		std::vector<int> order(1, root), newIndex(m_nodes.size(), -1);
+		newIndex[root] = 0;
+		for (size_t i = 0; i < order.size(); i++) {
+			for (UINT c = 0; c < 8; c++) {
+				const int child = m_nodes[order[i]].children[c];
+				if (child < 0) continue;
+				newIndex[child] = (int)order.size();
+				order.push_back(child);
+			}
+		}
+		std::vector<PointCloudOctreeNode> table(order.size());
+		for (size_t i = 0; i < order.size(); i++) {
+			table[i] = m_nodes[order[i]];
+			for (UINT c = 0; c < 8; c++) {
+				if (table[i].children[c] >= 0) table[i].children[c] = newIndex[table[i].children[c]];
+			}
+		}
+
+		memcpy(header.magic, PointCloudOctreeHeader::getMagic(), 8);
+		header.floatSize = sizeof(FloatType);
+		header.attributes = (m_hasNormals ? 1 : 0) | (m_hasColors ? 2 : 0);
+		header.lodResolution = m_params.lodResolution;
+		header.maxPointsPerNode = m_params.maxPointsPerNode;
+		header.numInputPoints = m_numInputPoints;
+		header.numNodes = table.size();
+		header.nodeTableOffset = (UINT64)m_out.tellp();
+		for (UINT d = 0; d < 3; d++) header.rootMin[d] = m_rootMin[d];
+		header.rootSize = m_rootSize;
+		m_out.write((const char*)table.data(), sizeof(PointCloudOctreeNode) * table.size());
+		m_out.seekp(0);
+		m_out.write((const char*)&header, sizeof(header));
+		m_out.close();
+	}
+
+	//! pass 1: bounding cube and attributes
+	void computeBounds(const std::vector<std::string>& plyFiles) {
+		BoundingBox3<double> bb;
+		PointCloud<FloatType> pc;
+		for (size_t f = 0; f < plyFiles.size(); f++) {
+			PointCloudStreamReaderPLY<FloatType> reader(plyFiles[f]);
+			if (f == 0) {
+				m_hasNormals = reader.hasNormals();
+				m_hasColors = reader.hasColors();
+			}
+			else if (m_hasNormals != reader.hasNormals() || m_hasColors != reader.hasColors()) {
+				throw MLIB_EXCEPTION("the attributes of " + plyFiles[f] + " do not match");
+			}
+			while (reader.read(pc, s_readChunkSize) > 0) {
+				for (const vec3<FloatType>& p : pc.m_points) bb.include(vec3d(p));
+			}
+			m_numInputPoints += reader.getNumPoints();
+		}
+		if (m_numInputPoints == 0) throw MLIB_EXCEPTION("no points found");
+
+		m_rootMin = bb.getMin();
+		m_rootSize = std::max(bb.getMaxExtent(), 1e-6) * (1.0 + 1e-6);
+		m_pointSize = sizeof(FloatType) * (m_hasNormals ? 6 : 3) + (m_hasColors ? 4 : 0);
+	}
+
+	//! pass 2: point counts on the counting grid and all coarser levels
+	void countPoints(const std::vector<std::string>& plyFiles) {
+		m_counts.resize(s_countLevel + 1);
+		for (UINT l = 0; l <= s_countLevel; l++) m_counts[l].assign((size_t)1 << (3 * l), 0);
+
+		PointCloud<FloatType> pc;
+		std::vector<UINT> cells;
+		for (const std::string& filename : plyFiles) {
+			PointCloudStreamReaderPLY<FloatType> reader(filename);
+			while (reader.read(pc, s_readChunkSize) > 0) {
+				computeCells(pc, cells);
+				for (UINT c : cells) m_counts[s_countLevel][c]++;
+			}
+		}
+		for (UINT l = s_countLevel; l > 0; l--) {
+			const UINT dim = 1 << l;
+			for (UINT z = 0; z < dim; z++) {
+				for (UINT y = 0; y < dim; y++) {
+					for (UINT x = 0; x < dim; x++) {
+						m_counts[l - 1][cellIndex(l - 1, vec3ui(x / 2, y / 2, z / 2))] += m_counts[l][cellIndex(l, vec3ui(x, y, z))];
+					}
+				}
+			}
+		}
+	}
+
+	//! the largest subtrees that fit into the memory budget become chunks
+	void selectChunks(UINT level, const vec3ui& coord, const std::string& outFile) {
+		if (level == 0) {
+			m_chunkOfCell.assign(m_counts[s_countLevel].size(), -1);
+		}
+		const UINT64 count = m_counts[level][cellIndex(level, coord)];
+		if (count == 0) return;
+
+		if (count > getChunkCapacity() && level < s_countLevel) {
+			for (UINT c = 0; c < 8; c++) {
+				selectChunks(level + 1, childCoord(coord, c), outFile);
+			}
+			return;
+		}
+
+		addChunk(level, coord, count, outFile);
+		const UINT shift = s_countLevel - level;
+		for (UINT z = coord.z << shift; z < (coord.z + 1) << shift; z++) {
+			for (UINT y = coord.y << shift; y < (coord.y + 1) << shift; y++) {
+				for (UINT x = coord.x << shift; x < (coord.x + 1) << shift; x++) {
+					m_chunkOfCell[cellIndex(s_countLevel, vec3ui(x, y, z))] = (int)m_chunks.size() - 1;
+				}
+			}
+		}
+	}
+
+	//! number of points that can be built in memory at once
+	UINT64 getChunkCapacity() const {
+		return std::max((UINT64)m_params.maxPointsPerNode, (UINT64)(m_params.memoryBudget / (m_pointSize + 64)));
+	}
+
+	//! registers a chunk and creates its (empty) file
+	void addChunk(UINT level, const vec3ui& coord, UINT64 numPoints, const std::string& outFile) {
+		Chunk chunk;
+		chunk.level = level;
+		chunk.coord = coord;
+		chunk.numPoints = numPoints;
+		chunk.filename = outFile + ".chunk" + std::to_string(m_chunks.size()) + ".tmp";
+		m_chunkIndex[nodeKey(level, coord)] = (UINT)m_chunks.size();
+		m_chunks.push_back(chunk);
+		std::ofstream truncate(chunk.filename, std::ios::binary | std::ios::trunc);
+	}
+
+	//! splits the chunks that exceed the capacity into their octants (repeatedly, the new chunks are appended);
+	//! the files are streamed, so that at most a read block and the output buffers are in memory
+	void splitChunks() {
+		const UINT64 capacity = getChunkCapacity();
+		const size_t blockSize = (size_t)std::min((UINT64)s_readChunkSize, capacity);
+		const size_t maxBuffer = (size_t)1 << 20;
+		for (size_t c = 0; c < m_chunks.size(); c++) {
+			if (m_chunks[c].numPoints <= capacity) continue;
+			const Chunk chunk = m_chunks[c];
+			if (chunk.level == s_maxLevel) throw MLIB_EXCEPTION("too many coincident points for the memory budget");
+
+			std::ifstream file(chunk.filename, std::ios::binary);
+			if (!file.is_open()) throw MLIB_EXCEPTION("Could not open file " + chunk.filename);
+			Chunk children[8];
+			std::vector<BYTE> buffers[8];
+			for (UINT o = 0; o < 8; o++) {
+				children[o].level = chunk.level + 1;
+				children[o].coord = childCoord(chunk.coord, o);
+				children[o].numPoints = 0;
+				children[o].filename = chunk.filename + "." + std::to_string(o);
+				std::ofstream truncate(children[o].filename, std::ios::binary | std::ios::trunc);
+			}
+
+			const UINT shift = s_maxLevel - chunk.level - 1;
+			std::vector<BYTE> block;
+			for (UINT64 read = 0; read < chunk.numPoints; ) {
+				const size_t n = (size_t)std::min((UINT64)blockSize, chunk.numPoints - read);
+				block.resize(n * m_pointSize);
+				file.read((char*)block.data(), block.size());
+				if (!file) throw MLIB_EXCEPTION("unexpected end of file " + chunk.filename);
+				for (size_t i = 0; i < n; i++) {
+					const BYTE* src = &block[i * m_pointSize];
+					vec3<FloatType> p;
+					memcpy((void*)&p, src, sizeof(FloatType) * 3);
+					const vec3ui q = quantize(p);
+					const UINT o = ((q.x >> shift) & 1) | (((q.y >> shift) & 1) << 1) | (((q.z >> shift) & 1) << 2);
+					buffers[o].insert(buffers[o].end(), src, src + m_pointSize);
+					children[o].numPoints++;
+					if (buffers[o].size() >= maxBuffer) flush(children[o], buffers[o]);
+				}
+				read += n;
+			}
+			file.close();
+			std::remove(chunk.filename.c_str());
+
+			//the chunk is replaced by its non-empty octants
+			m_chunks[c].numPoints = 0;
+			m_chunkIndex.erase(nodeKey(chunk.level, chunk.coord));
+			m_splitNodes.insert(nodeKey(chunk.level, chunk.coord));
+			for (UINT o = 0; o < 8; o++) {
+				flush(children[o], buffers[o]);
+				if (children[o].numPoints == 0) {
+					std::remove(children[o].filename.c_str());
+					continue;
+				}
+				m_chunkIndex[nodeKey(children[o].level, children[o].coord)] = (UINT)m_chunks.size();
+				m_chunks.push_back(children[o]);
+			}
+		}
+	}
+
+	//! pass 3: appends every point to the file of its chunk (buffered)
+	void distributePoints(const std::vector<std::string>& plyFiles) {
+		std::vector< std::vector<BYTE> > buffers(m_chunks.size());
+		size_t bufferedBytes = 0;
+		const size_t maxBuffer = (size_t)1 << 20;
+		const size_t maxBufferedBytes = std::max(maxBuffer, m_params.memoryBudget / 4);
+
+		PointCloud<FloatType> pc;
+		std::vector<UINT> cells;
+		for (const std::string& filename : plyFiles) {
+			PointCloudStreamReaderPLY<FloatType> reader(filename);
+			while (reader.read(pc, s_readChunkSize) > 0) {
+				computeCells(pc, cells);
+				for (size_t i = 0; i < pc.m_points.size(); i++) {
+					const UINT c = (UINT)m_chunkOfCell[cells[i]];
+					std::vector<BYTE>& buffer = buffers[c];
+					const size_t offset = buffer.size();
+					buffer.resize(offset + m_pointSize);
+					encodePoint(pc, i, &buffer[offset]);
+					bufferedBytes += m_pointSize;
+					if (buffer.size() >= maxBuffer) {
+						bufferedBytes -= buffer.size();
+						flush(m_chunks[c], buffer);
+					}
+				}
+				if (bufferedBytes >= maxBufferedBytes) {
+					for (size_t c = 0; c < m_chunks.size(); c++) flush(m_chunks[c], buffers[c]);
+					bufferedBytes = 0;
+				}
+			}
+		}
+		for (size_t c = 0; c < m_chunks.size(); c++) flush(m_chunks[c], buffers[c]);
+	}
+
+	void flush(const Chunk& chunk, std::vector<BYTE>& buffer) {
+		if (buffer.empty()) return;
+		std::ofstream file(chunk.filename, std::ios::binary | std::ios::app);
+		if (!file.is_open()) throw MLIB_EXCEPTION("Could not open file for writing " + chunk.filename);
+		file.write((const char*)buffer.data(), buffer.size());
+		buffer.clear();
+		buffer.shrink_to_fit();
+	}
+
+	void loadChunk(const Chunk& chunk, PointCloud<FloatType>& pc) {
+		std::ifstream file(chunk.filename, std::ios::binary);
+		if (!file.is_open()) throw MLIB_EXCEPTION("Could not open file " + chunk.filename);
+		const size_t n = (size_t)chunk.numPoints;
+		std::vector<BYTE> data(n * m_pointSize);
+		file.read((char*)data.data(), data.size());
+		if (!file) throw MLIB_EXCEPTION("unexpected end of file " + chunk.filename);
+
+		pc.m_points.resize(n);
+		if (m_hasNormals)	pc.m_normals.resize(n);
+		if (m_hasColors)	pc.m_colors.resize(n);
+		const int numPoints = (int)n;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int i = 0; i < numPoints; i++) {
+			const BYTE* src = &data[(size_t)i * m_pointSize];
+			memcpy((void*)&pc.m_points[i], src, sizeof(FloatType) * 3);
+			src += sizeof(FloatType) * 3;
+			if (m_hasNormals) {
+				memcpy((void*)&pc.m_normals[i], src, sizeof(FloatType) * 3);
+				src += sizeof(FloatType) * 3;
+			}
+			if (m_hasColors) {
+				pc.m_colors[i] = vec4<FloatType>((FloatType)src[0], (FloatType)src[1], (FloatType)src[2], (FloatType)src[3]) / (FloatType)255;
+			}
+		}
+	}
+
+	void encodePoint(const PointCloud<FloatType>& pc, size_t i, BYTE* dst) const {
+		memcpy(dst, &pc.m_points[i], sizeof(FloatType) * 3);
+		dst += sizeof(FloatType) * 3;
+		if (m_hasNormals) {
+			memcpy(dst, &pc.m_normals[i], sizeof(FloatType) * 3);
+			dst += sizeof(FloatType) * 3;
+		}
+		if (m_hasColors) {
+			for (UINT k = 0; k < 4; k++) dst[k] = (BYTE)math::clamp(pc.m_colors[i][k] * (FloatType)255 + (FloatType)0.5, (FloatType)0, (FloatType)255);
+		}
+	}
+
+	//! quantized position (s_maxLevel bits per dimension)
+	vec3ui quantize(const vec3<FloatType>& p) const {
+		const double scale = (double)(1 << s_maxLevel) / m_rootSize;
+		vec3ui q;
+		for (UINT d = 0; d < 3; d++) {
+			const double v = ((double)p[d] - m_rootMin[d]) * scale;
+			q[d] = (UINT)math::clamp(v, 0.0, (double)((1 << s_maxLevel) - 1));
+		}
+		return q;
+	}
+
+	void computeCells(const PointCloud<FloatType>& pc, std::vector<UINT>& cells) const {
+		cells.resize(pc.m_points.size());
+		const int numPoints = (int)pc.m_points.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int i = 0; i < numPoints; i++) {
+			const vec3ui q = quantize(pc.m_points[i]);
+			const UINT shift = s_maxLevel - s_countLevel;
+			cells[i] = cellIndex(s_countLevel, vec3ui(q.x >> shift, q.y >> shift, q.z >> shift));
+		}
+	}
+
+	static size_t cellIndex(UINT level, const vec3ui& c) {
+		return (size_t)c.x + ((size_t)c.y << level) + ((size_t)c.z << (2 * level));
+	}
+	static vec3ui childCoord(const vec3ui& coord, UINT c) {
+		return vec3ui(2 * coord.x + (c & 1), 2 * coord.y + ((c >> 1) & 1), 2 * coord.z + ((c >> 2) & 1));
+	}
+	//! unique over all levels: the cell index (3 * level bits) with a leading one bit
+	static UINT64 nodeKey(UINT level, const vec3ui& coord) {
+		return ((UINT64)1 << (3 * level)) | (UINT64)cellIndex(level, coord);
+	}
+
+	//! builds the subtree of the given points (in memory); sample receives the points of the root of the subtree
+	int buildSubtree(const PointCloud<FloatType>& pc, UINT* indices, size_t count, UINT level, std::vector<UINT>& sample) {
+		const vec3ui q = quantize(pc.m_points[indices[0]]);
+		const UINT shift = s_maxLevel - level;
+		const vec3ui coord(q.x >> shift, q.y >> shift, q.z >> shift);
+		int children[8];
+		for (UINT c = 0; c < 8; c++) children[c] = -1;
+
+		if (count <= m_params.maxPointsPerNode || level == s_maxLevel) {
+			sample.assign(indices, indices + count);
+			return writeNode(pc, sample, level, coord, children);
+		}
+
+		//counting sort by octant
+		std::vector<BYTE> octant(count);
+		UINT octantStart[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+		for (size_t i = 0; i < count; i++) {
+			const vec3ui p = quantize(pc.m_points[indices[i]]);
+			const UINT s = shift - 1;
+			octant[i] = (BYTE)(((p.x >> s) & 1) | (((p.y >> s) & 1) << 1) | (((p.z >> s) & 1) << 2));
+			octantStart[octant[i] + 1]++;
+		}
+		for (UINT c = 0; c < 8; c++) octantStart[c + 1] += octantStart[c];
+		{
+			std::vector<UINT> sorted(count);
+			UINT cursor[8];
+			for (UINT c = 0; c < 8; c++) cursor[c] = octantStart[c];
+			for (size_t i = 0; i < count; i++) sorted[cursor[octant[i]]++] = indices[i];
+			std::copy(sorted.begin(), sorted.end(), indices);
+		}
+		octant.clear();
+		octant.shrink_to_fit();
+
+		std::vector<UINT> candidates, childSample;
+		for (UINT c = 0; c < 8; c++) {
+			const size_t childCount = octantStart[c + 1] - octantStart[c];
+			if (childCount == 0) continue;
+			children[c] = buildSubtree(pc, indices + octantStart[c], childCount, level + 1, childSample);
+			candidates.insert(candidates.end(), childSample.begin(), childSample.end());
+		}
+		subsample(pc, candidates, level, sample);
+		return writeNode(pc, sample, level, coord, children);
+	}
+
+	//! builds the nodes above the chunks; sample receives the points of the node
+	int buildUpper(UINT level, const vec3ui& coord, PointCloud<FloatType>& sample) {
+		if (level <= s_countLevel && m_counts[level][cellIndex(level, coord)] == 0) return -1;
+		auto it = m_chunkIndex.find(nodeKey(level, coord));
+		if (it != m_chunkIndex.end()) {
+			sample = std::move(m_chunkSamples[it->second]);
+			return m_chunkRoots[it->second];
+		}
+		//below the counting grid, only the nodes of split chunks lead to further chunks
+		if (level >= s_countLevel && m_splitNodes.find(nodeKey(level, coord)) == m_splitNodes.end()) return -1;
+
+		int children[8];
+		PointCloud<FloatType> merged, childSample;
+		for (UINT c = 0; c < 8; c++) {
+			children[c] = buildUpper(level + 1, childCoord(coord, c), childSample);
+			if (children[c] < 0) continue;
+			merged.m_points.insert(merged.m_points.end(), childSample.m_points.begin(), childSample.m_points.end());
+			merged.m_normals.insert(merged.m_normals.end(), childSample.m_normals.begin(), childSample.m_normals.end());
+			merged.m_colors.insert(merged.m_colors.end(), childSample.m_colors.begin(), childSample.m_colors.end());
+		}
+		std::vector<UINT> candidates(merged.m_points.size()), indices;
+		for (size_t i = 0; i < candidates.size(); i++) candidates[i] = (UINT)i;
+		subsample(merged, candidates, level, indices);
+		const int node = writeNode(merged, indices, level, coord, children);
+		gather(merged, indices, sample);
+		return node;
+	}
+
+	//! keeps the first candidate of every cell of the lodResolution^3 grid of the node
+	void subsample(const PointCloud<FloatType>& pc, const std::vector<UINT>& candidates, UINT level, std::vector<UINT>& sample) const {
+		const UINT localBits = std::min(m_lodBits, s_maxLevel - level);
+		const UINT shift = s_maxLevel - level - localBits;
+		const UINT mask = (1u << localBits) - 1;
+		std::vector< std::pair<UINT64, UINT> > keys(candidates.size());
+		const int numCandidates = (int)candidates.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int i = 0; i < numCandidates; i++) {
+			const vec3ui q = quantize(pc.m_points[candidates[i]]);
+			const UINT64 key = (UINT64)((q.x >> shift) & mask) | ((UINT64)((q.y >> shift) & mask) << 21) | ((UINT64)((q.z >> shift) & mask) << 42);
+			keys[i] = std::make_pair(key, (UINT)i);
+		}
+		util::parallelSort(keys);
+
+		sample.clear();
+		for (size_t i = 0; i < keys.size(); i++) {
+			if (i == 0 || keys[i].first != keys[i - 1].first) sample.push_back(candidates[keys[i].second]);
+		}
+	}
+
+	void gather(const PointCloud<FloatType>& pc, const std::vector<UINT>& indices, PointCloud<FloatType>& result) const {
+		result.clear();
+		for (UINT i : indices) {
+			result.m_points.push_back(pc.m_points[i]);
+			if (m_hasNormals)	result.m_normals.push_back(pc.m_normals[i]);
+			if (m_hasColors)	result.m_colors.push_back(pc.m_colors[i]);
+		}
+	}
+
+	int writeNode(const PointCloud<FloatType>& pc, const std::vector<UINT>& indices, UINT level, const vec3ui& coord, const int children[8]) {
+		PointCloudOctreeNode node;
+		node.offset = (UINT64)m_out.tellp();
+		node.numPoints = (UINT)indices.size();
+		node.level = level;
+		for (UINT d = 0; d < 3; d++) node.coord[d] = coord[d];
+		for (UINT c = 0; c < 8; c++) node.children[c] = children[c];
+
+		const size_t n = indices.size();
+		std::vector<BYTE> data(n * m_pointSize);
+		BYTE* dst = data.data();
+		for (UINT i : indices) {
+			memcpy(dst, &pc.m_points[i], sizeof(FloatType) * 3);
+			dst += sizeof(FloatType) * 3;
+		}
+		if (m_hasNormals) {
+			for (UINT i : indices) {
+				memcpy(dst, &pc.m_normals[i], sizeof(FloatType) * 3);
+				dst += sizeof(FloatType) * 3;
+			}
+		}
+		if (m_hasColors) {
+			for (UINT i : indices) {
+				for (UINT k = 0; k < 4; k++) *dst++ = (BYTE)math::clamp(pc.m_colors[i][k] * (FloatType)255 + (FloatType)0.5, (FloatType)0, (FloatType)255);
+			}
+		}
+		m_out.write((const char*)data.data(), data.size());
+		m_nodes.push_back(node);
+		return (int)m_nodes.size() - 1;
+	}
+
+	Params m_params;
+	UINT m_lodBits;
+	bool m_hasNormals;
+	bool m_hasColors;
+	size_t m_pointSize;
+	UINT64 m_numInputPoints;
+	vec3d m_rootMin;
+	double m_rootSize;
+
+	std::vector< std::vector<UINT64> > m_counts;			//point counts per level (up to the counting grid)
+	std::vector<int> m_chunkOfCell;							//counting grid cell -> chunk
+	std::vector<Chunk> m_chunks;
+	std::unordered_map<UINT64, UINT> m_chunkIndex;			//node key -> chunk
+	std::unordered_set<UINT64> m_splitNodes;				//node keys of chunks that were split
+	std::vector<int> m_chunkRoots;
+	std::vector< PointCloud<FloatType> > m_chunkSamples;
+
+	std::ofstream m_out;
+	std::vector<PointCloudOctreeNode> m_nodes;
+};
+
+
+//! read access to an octree file written by PointCloudOctreeBuilder; only the nodes that are needed by a query are
+//! loaded, and loaded nodes are kept in an LRU cache of bounded size. loadNode and query may be called concurrently.
+template<class FloatType>
+class PointCloudOctree {
+public:
+	PointCloudOctree() {
+		m_cacheBudget = 0;
+		m_cacheSize = 0;
+	}
+	PointCloudOctree(const std::string& filename, size_t cacheBudget = (size_t)512 << 20) {
+		open(filename, cacheBudget);
+	}
+
+	void open(const std::string& filename, size_t cacheBudget = (size_t)512 << 20) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::ifstream file(filename, std::ios::binary);
+		if (!file.is_open()) throw MLIB_EXCEPTION("Could not open file " + filename);
+		file.read((char*)&m_header, sizeof(m_header));
+		if (!file || memcmp(m_header.magic, PointCloudOctreeHeader::getMagic(), 8) != 0) throw MLIB_EXCEPTION("invalid octree file " + filename);
+		if (m_header.floatSize != sizeof(FloatType)) throw MLIB_EXCEPTION("octree file " + filename + " has a different float type");
+
+		m_nodes.resize((size_t)m_header.numNodes);
+		file.seekg((std::streamoff)m_header.nodeTableOffset);
+		file.read((char*)m_nodes.data(), sizeof(PointCloudOctreeNode) * m_nodes.size());
+		if (!file) throw MLIB_EXCEPTION("unexpected end of file " + filename);
+
+		m_filename = filename;
+		m_cache.clear();
+		m_lru.clear();
+		m_cacheSize = 0;
+		m_cacheBudget = cacheBudget;
+	}
+
+	size_t getNumNodes() const {
+		return m_nodes.size();
+	}
+	const PointCloudOctreeNode& getNode(UINT node) const {
+		return m_nodes[node];
+	}
+	const PointCloudOctreeHeader& getHeader() const {
+		return m_header;
+	}
+	bool hasNormals() const {
+		return m_header.hasNormals();
+	}
+	bool hasColors() const {
+		return m_header.hasColors();
+	}
+
+	BoundingBox3<FloatType> getNodeBoundingBox(UINT node) const {
+		const PointCloudOctreeNode& n = m_nodes[node];
+		const double size = m_header.rootSize / (double)(1u << n.level);
+		vec3<FloatType> minB, maxB;
+		for (UINT d = 0; d < 3; d++) {
+			minB[d] = (FloatType)(m_header.rootMin[d] + size * n.coord[d]);
+			maxB[d] = (FloatType)(m_header.rootMin[d] + size * (n.coord[d] + 1));
+		}
+		return BoundingBox3<FloatType>(minB, maxB);
+	}
+	//! grid spacing of the subsampled points of an inner node; 0 for leaves (which hold all of their points)
+	FloatType getNodeSpacing(UINT node) const {
+		if (m_nodes[node].isLeaf()) return (FloatType)0;
+		return (FloatType)(m_header.rootSize / (double)(1u << m_nodes[node].level) / (double)m_header.lodResolution);
+	}
+
+	//! bytes of the points that are currently cached; never more than the budget
+	size_t getCacheSize() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_cacheSize;
+	}
+	void setCacheBudget(size_t bytes) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_cacheBudget = bytes;
+		evict(0);
+	}
+
+	//! nodes that intersect the box and are leaves or have a spacing of at most minSpacing (minSpacing = 0: full detail);
+	//! no node is an ancestor of another, so the selected nodes represent every point at most once
+	void findNodes(const BoundingBox3<FloatType>& box, FloatType minSpacing, std::vector<UINT>& nodes) const {
+		nodes.clear();
+		if (m_nodes.empty()) return;
+		findNodes(0, minSpacing, [&](const BoundingBox3<FloatType>& bb) { return box.intersects(bb); }, nodes);
+	}
+	//! same for the view frustum of a view-projection matrix (clip space -w <= x, y, z <= w)
+	void findNodes(const Matrix4x4<FloatType>& viewProjection, FloatType minSpacing, std::vector<UINT>& nodes) const {
+		nodes.clear();
+		if (m_nodes.empty()) return;
+		vec4<FloatType> planes[6];
+		getFrustumPlanes(viewProjection, planes);
+		findNodes(0, minSpacing, [&](const BoundingBox3<FloatType>& bb) { return intersectsFrustum(planes, bb); }, nodes);
+	}
+
+	//! points of a node (through the LRU cache); a node that is larger than the whole budget is returned without caching it.
+	//! The file is read without holding the lock (every load opens its own stream), so concurrent loads do not serialize on IO
+	std::shared_ptr< const PointCloud<FloatType> > loadNode(UINT node) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			std::shared_ptr< const PointCloud<FloatType> > cached = findCached(node);
+			if (cached) return cached;
+		}
+
+		const PointCloudOctreeNode& n = m_nodes[node];
+		const size_t bytes = (size_t)n.numPoints * m_header.getPointSize();
+		std::vector<BYTE> data(bytes);
+		std::ifstream file(m_filename, std::ios::binary);
+		file.seekg((std::streamoff)n.offset);
+		file.read((char*)data.data(), bytes);
+		if (!file) throw MLIB_EXCEPTION("unexpected end of file " + m_filename);
+
+		std::shared_ptr< PointCloud<FloatType> > pc = std::make_shared< PointCloud<FloatType> >();
+		const BYTE* src = data.data();
+		pc->m_points.resize(n.numPoints);
+		memcpy((void*)pc->m_points.data(), src, sizeof(FloatType) * 3 * n.numPoints);
+		src += sizeof(FloatType) * 3 * n.numPoints;
+		if (hasNormals()) {
+			pc->m_normals.resize(n.numPoints);
+			memcpy((void*)pc->m_normals.data(), src, sizeof(FloatType) * 3 * n.numPoints);
+			src += sizeof(FloatType) * 3 * n.numPoints;
+		}
+		if (hasColors()) {
+			pc->m_colors.resize(n.numPoints);
+			for (UINT i = 0; i < n.numPoints; i++, src += 4) {
+				pc->m_colors[i] = vec4<FloatType>((FloatType)src[0], (FloatType)src[1], (FloatType)src[2], (FloatType)src[3]) / (FloatType)255;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		//another thread may have loaded the same node in the meantime
+		std::shared_ptr< const PointCloud<FloatType> > cached = findCached(node);
+		if (cached) return cached;
+		if (bytes > m_cacheBudget) return pc;
+		evict(bytes);
+		m_lru.push_front(node);
+		m_cache[node] = std::make_pair(std::shared_ptr< const PointCloud<FloatType> >(pc), m_lru.begin());
+		m_cacheSize += bytes;
+		return pc;
+	}
+
+	//! all points inside the box, at the level of detail given by minSpacing (see findNodes)
+	void query(const BoundingBox3<FloatType>& box, FloatType minSpacing, PointCloud<FloatType>& result) {
+		std::vector<UINT> nodes;
+		findNodes(box, minSpacing, nodes);
+		collect(nodes, [&](const vec3<FloatType>& p) { return box.intersects(p); }, result);
+	}
+	//! all points inside the view frustum, at the level of detail given by minSpacing (see findNodes)
+	void query(const Matrix4x4<FloatType>& viewProjection, FloatType minSpacing, PointCloud<FloatType>& result) {
+		std::vector<UINT> nodes;
+		findNodes(viewProjection, minSpacing, nodes);
+		vec4<FloatType> planes[6];
+		getFrustumPlanes(viewProjection, planes);
+		collect(nodes, [&](const vec3<FloatType>& p) {
+			for (UINT i = 0; i < 6; i++) {
+				if (planes[i].x * p.x + planes[i].y * p.y + planes[i].z * p.z + planes[i].w < (FloatType)0) return false;
+			}
+			return true;
+		}, result);
+	}
+
+private:
+	template<class BoxTest>
+	void findNodes(UINT node, FloatType minSpacing, BoxTest test, std::vector<UINT>& nodes) const {
+		if (!test(getNodeBoundingBox(node))) return;
+		const PointCloudOctreeNode& n = m_nodes[node];
+		if (n.isLeaf() || getNodeSpacing(node) <= minSpacing) {
+			nodes.push_back(node);
+			return;
+		}
+		for (UINT c = 0; c < 8; c++) {
+			if (n.children[c] >= 0) findNodes((UINT)n.children[c], minSpacing, test, nodes);
+		}
+	}
+
+	template<class PointTest>
+	void collect(const std::vector<UINT>& nodes, PointTest test, PointCloud<FloatType>& result) {
+		result.clear();
+		for (UINT node : nodes) {
+			std::shared_ptr< const PointCloud<FloatType> > pc = loadNode(node);
+			for (size_t i = 0; i < pc->m_points.size(); i++) {
+				if (!test(pc->m_points[i])) continue;
+				result.m_points.push_back(pc->m_points[i]);
+				if (pc->hasNormals())	result.m_normals.push_back(pc->m_normals[i]);
+				if (pc->hasColors())	result.m_colors.push_back(pc->m_colors[i]);
+			}
+		}
+	}
+
+	//! planes (a, b, c, d) with ax + by + cz + d >= 0 inside (Gribb and Hartmann)
+	static void getFrustumPlanes(const Matrix4x4<FloatType>& m, vec4<FloatType> planes[6]) {
+		for (UINT i = 0; i < 3; i++) {
+			planes[2 * i + 0] = vec4<FloatType>(m(3, 0) + m(i, 0), m(3, 1) + m(i, 1), m(3, 2) + m(i, 2), m(3, 3) + m(i, 3));
+			planes[2 * i + 1] = vec4<FloatType>(m(3, 0) - m(i, 0), m(3, 1) - m(i, 1), m(3, 2) - m(i, 2), m(3, 3) - m(i, 3));
+		}
+	}
+
+	//! conservative: false only if the box is completely outside of one of the planes
+	static bool intersectsFrustum(const vec4<FloatType> planes[6], const BoundingBox3<FloatType>& bb) {
+		for (UINT i = 0; i < 6; i++) {
+			const vec4<FloatType>& p = planes[i];
+			const FloatType x = p.x >= (FloatType)0 ? bb.getMaxX() : bb.getMinX();
+			const FloatType y = p.y >= (FloatType)0 ? bb.getMaxY() : bb.getMinY();
+			const FloatType z = p.z >= (FloatType)0 ? bb.getMaxZ() : bb.getMinZ();
+			if (p.x * x + p.y * y + p.z * z + p.w < (FloatType)0) return false;
+		}
+		return true;
+	}
+
+	//! cached points of the node (marked as most recently used) or nullptr; the caller holds the lock
+	std::shared_ptr< const PointCloud<FloatType> > findCached(UINT node) {
+		auto it = m_cache.find(node);
+		if (it == m_cache.end()) return nullptr;
+		m_lru.splice(m_lru.begin(), m_lru, it->second.second);
+		return it->second.first;
+	}
+
+	//! drops the least recently used nodes until the given number of bytes fits into the budget
+	void evict(size_t bytes) {
+		while (!m_lru.empty() && m_cacheSize + bytes > m_cacheBudget) {
+			const UINT node = m_lru.back();
+			m_lru.pop_back();
+			m_cacheSize -= (size_t)m_nodes[node].numPoints * m_header.getPointSize();
+			m_cache.erase(node);
+		}
+	}
+
+	std::string m_filename;
+	PointCloudOctreeHeader m_header;
+	std::vector<PointCloudOctreeNode> m_nodes;
+
+	mutable std::mutex m_mutex;
+	size_t m_cacheBudget;
+	size_t m_cacheSize;
+	std::list<UINT> m_lru;		//most recently used first
+	std::unordered_map< UINT, std::pair< std::shared_ptr< const PointCloud<FloatType> >, std::list<UINT>::iterator > > m_cache;
+};
+
+typedef PointCloudOctreeBuilder<float> PointCloudOctreeBuilderf;
+typedef PointCloudOctreeBuilder<double> PointCloudOctreeBuilderd;
+typedef PointCloudOctree<float> PointCloudOctreef;
+typedef PointCloudOctree<double> PointCloudOctreed;
+
+}  // namespace ml
+
+#endif  // CORE_MESH_POINTCLOUDOCTREE_H_
@@ -94,23 +94,24 @@ namespace ml {
 
 
 	template<class FloatType>
-	void TriMesh<FloatType>::computeNormals() {
-		for (size_t i = 0; i < m_vertices.size(); i++) {
-			m_vertices[i].normal = vec3<FloatType>::origin;
+	void TriMesh<FloatType>::computeNormals(typename MeshNormals<FloatType>::WeightingType weighting) {
+		if (!m_vertices.empty()) {
+			MeshNormals<FloatType>::compute(m_vertices.size(),
+				(const FloatType*)&m_vertices[0].position, sizeof(Vertex),
+				(FloatType*)&m_vertices[0].normal, sizeof(Vertex),
+				m_indices.data(), m_indices.size(), weighting);
 		}
+		m_bHasNormals = true;
+	}
 
-		for (size_t i = 0; i < m_indices.size(); i++) {
-			vec3<FloatType> faceNormal =
-				(m_vertices[m_indices[i].y].position - m_vertices[m_indices[i].x].position) ^ (m_vertices[m_indices[i].z].position - m_vertices[m_indices[i].x].position);
-
-			m_vertices[m_indices[i].x].normal += faceNormal;
-			m_vertices[m_indices[i].y].normal += faceNormal;
-			m_vertices[m_indices[i].z].normal += faceNormal;
-		}
-		for (size_t i = 0; i < m_vertices.size(); i++) {
-			m_vertices[i].normal.normalize();
+	template<class FloatType>
+	void TriMesh<FloatType>::computeNormals(const typename MeshNormals<FloatType>::VertexFaceAdjacency& adjacency, typename MeshNormals<FloatType>::WeightingType weighting) {
+		if (!m_vertices.empty()) {
+			MeshNormals<FloatType>::compute(m_vertices.size(),
+				(const FloatType*)&m_vertices[0].position, sizeof(Vertex),
+				(FloatType*)&m_vertices[0].normal, sizeof(Vertex),
+				m_indices.data(), m_indices.size(), weighting, &adjacency);
 		}
-
 		m_bHasNormals = true;
 	}
 
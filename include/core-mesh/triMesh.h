@@ -316,7 +316,7 @@ namespace ml {
 
 		//! move operator
 		void operator=(TriMesh&& t) {
-			std::swap(*this, t);
+			swap(*this, t);
 		}
 
 		//! adl swap
@@ -340,12 +340,11 @@ namespace ml {
 		}
 
 		void transform(const Matrix4x4<FloatType>& m) {
-			Matrix4x4<FloatType> invTrans = m.getInverse().getTranspose();
-			for (Vertex& v : m_vertices) {
-				v.position = m * v.position;
-				v.normal = invTrans.transformNormalAffine(v.normal);
-				v.normal.normalizeIfNonzero();
-			}
+			if (m_vertices.empty()) return;
+			transformPointsAndNormals(m,
+				(FloatType*)&m_vertices[0].position, sizeof(Vertex),
+				(FloatType*)&m_vertices[0].normal, sizeof(Vertex),
+				m_vertices.size());
 		}
 
 		void scale(FloatType s) { scale(vec3<FloatType>(s, s, s)); }
@@ -370,8 +369,11 @@ namespace ml {
 			return bb;
 		}
 
-		//! Computes the vertex normals of the mesh
-		void computeNormals();
+		//! Computes the vertex normals of the mesh (in parallel; area-weighted by default)
+		void computeNormals(typename MeshNormals<FloatType>::WeightingType weighting = MeshNormals<FloatType>::WEIGHT_AREA);
+
+		//! Computes the vertex normals with a precomputed vertex-face adjacency (the connectivity must match the mesh)
+		void computeNormals(const typename MeshNormals<FloatType>::VertexFaceAdjacency& adjacency, typename MeshNormals<FloatType>::WeightingType weighting = MeshNormals<FloatType>::WEIGHT_AREA);
 
         //! Creates a flat Loop-subdivision of the mesh
         TriMesh<FloatType> flatLoopSubdivision(float minEdgeLength) const;
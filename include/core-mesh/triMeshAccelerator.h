@@ -64,8 +64,9 @@ public:
 		for (size_t i = 0; i < triMeshPairs.size(); i++) {
 			m_VerticesCopy[i] = triMeshPairs[i].first->getVertices();
 			//apply the transform locally
-			for (auto& v : m_VerticesCopy[i]) {
-				v.position = triMeshPairs[i].second * v.position;
+			if (!m_VerticesCopy[i].empty()) {
+				FloatType* positions = (FloatType*)&m_VerticesCopy[i][0].position;
+				transformPoints(triMeshPairs[i].second, positions, sizeof(typename TriMesh<FloatType>::Vertex), positions, sizeof(typename TriMesh<FloatType>::Vertex), m_VerticesCopy[i].size());
 			}
 			vertices[i] = &m_VerticesCopy[i];
 			indices[i] = &triMeshPairs[i].first->getIndices();
@@ -75,6 +76,40 @@ public:
 		buildInternal();	//construct the acceleration structure
 	}
 
+	//! constructs the acceleration structure from a structure-of-arrays mesh; only the positions are read (and copied), so the
+	//! triangles carry no normals, colors or texture coordinates: look them up in the mesh through the triangle index instead
+	void build(const TriMeshSoA<FloatType>& mesh, const Matrix4x4<FloatType>& transform = Matrix4x4<FloatType>::identity()) {
+		std::vector< std::pair<const TriMeshSoA<FloatType>*, Matrix4x4<FloatType>> > meshes;
+		meshes.push_back(std::make_pair(&mesh, transform));
+		build(meshes);
+	}
+
+	//! constructs the acceleration structure; always generates an internal copy
+	void build(const std::vector<std::pair<const TriMeshSoA<FloatType>*, Matrix4x4<FloatType>>>& triMeshPairs) {
+		destroy();
+
+		std::vector<const std::vector<typename TriMesh<FloatType>::Vertex>*> vertices(triMeshPairs.size());
+		std::vector<const std::vector<vec3ui>*> indices(triMeshPairs.size());
+
+		m_VerticesCopy.resize(triMeshPairs.size());
+		for (size_t i = 0; i < triMeshPairs.size(); i++) {
+			const TriMeshSoA<FloatType>& mesh = *triMeshPairs[i].first;
+			const std::vector<vec3<FloatType>>& positions = mesh.getPositions();
+			std::vector<typename TriMesh<FloatType>::Vertex>& copy = m_VerticesCopy[i];
+			copy.resize(positions.size());
+
+			//the triangles point to vertices, so the transformed positions are written into the position fields of the copy
+			if (!positions.empty()) {
+				transformPoints(triMeshPairs[i].second, (const FloatType*)&positions[0], sizeof(vec3<FloatType>), (FloatType*)&copy[0].position, sizeof(typename TriMesh<FloatType>::Vertex), positions.size());
+			}
+			vertices[i] = &copy;
+			indices[i] = &mesh.getIndices();
+		}
+		createTrianglePointers(vertices, indices);
+
+		buildInternal();	//construct the acceleration structure
+	}
+
 	size_t triangleCount() const
 	{
 		return m_Triangles.size();
@@ -132,6 +132,43 @@ struct TriangleBVHNode {
 		return nullptr;
 	}
 
+	//! closest point on the triangles to p, if it is closer than sqrt(distSq) (which is updated); children are visited nearest first
+	const typename TriMesh<FloatType>::Triangle* closestPoint(const vec3<FloatType>& p, FloatType& distSq, vec3<FloatType>& closest) const {
+		if (isLeaf()) {
+			const vec3<FloatType> c = closestPointOnTriangle(p, leafTri->getV0().position, leafTri->getV1().position, leafTri->getV2().position);
+			const FloatType d = vec3<FloatType>::distSq(p, c);
+			if (d >= distSq) return nullptr;
+			distSq = d;
+			closest = c;
+			return leafTri;
+		}
+		const TriangleBVHNode* nearChild = lChild;
+		const TriangleBVHNode* farChild = rChild;
+		FloatType nearDistSq = lChild->boundingBoxDistSq(p), farDistSq = rChild->boundingBoxDistSq(p);
+		if (farDistSq < nearDistSq) {
+			std::swap(nearChild, farChild);
+			std::swap(nearDistSq, farDistSq);
+		}
+		const typename TriMesh<FloatType>::Triangle* result = nullptr;
+		if (nearDistSq < distSq) result = nearChild->closestPoint(p, distSq, closest);
+		if (farDistSq < distSq) {
+			const typename TriMesh<FloatType>::Triangle* t = farChild->closestPoint(p, distSq, closest);
+			if (t) result = t;
+		}
+		return result;
+	}
+
+	//! squared distance from p to the bounding box (0 inside)
+	FloatType boundingBoxDistSq(const vec3<FloatType>& p) const {
+		const vec3<FloatType> bbMin = boundingBox.getMin(), bbMax = boundingBox.getMax();
+		FloatType d = 0;
+		for (unsigned int i = 0; i < 3; i++) {
+			const FloatType outside = std::max(std::max(bbMin[i] - p[i], p[i] - bbMax[i]), (FloatType)0);
+			d += outside * outside;
+		}
+		return d;
+	}
+
     // collisions with other Triangles
 	bool intersects(const typename TriMesh<FloatType>::Triangle* tri) const {
 		if (boundingBox.intersects(tri->getV0().position, tri->getV1().position, tri->getV2().position)) {
@@ -279,17 +316,28 @@ public:
 		std::cout << "Info: NumNodes " << m_Root->getNumNodesRec() << std::endl;
 		std::cout << "Info: NumLeaves " << m_Root->getNumLeaves() << std::endl;
 	}
+
+	//! closest surface point to p within maxDist (e.g., for distance fields); returns nullptr if there is none
+	const typename TriMesh<FloatType>::Triangle* closestPoint(const vec3<FloatType>& p, vec3<FloatType>& closest, FloatType maxDist = std::numeric_limits<FloatType>::infinity()) const {
+		if (!m_Root) return nullptr;
+		FloatType distSq = maxDist * maxDist;
+		if (m_Root->boundingBoxDistSq(p) >= distSq) return nullptr;
+		return m_Root->closestPoint(p, distSq, closest);
+	}
 private:
 	//! defined by the interface
 	bool collisionInternal(const TriMeshAcceleratorBVH<FloatType>& other) const {
+		if (!m_Root || !other.m_Root) return false;
 		return m_Root->intersects(*other.m_Root);
 	}
 
     bool collisionTransformInternal(const TriMeshAcceleratorBVH<FloatType>& other, const Matrix4x4<FloatType>& transform) const {
+        if (!m_Root || !other.m_Root) return false;
         return m_Root->intersects(*other.m_Root, transform);
     }
 
     bool collisionTransformBBoxOnlyInternal(const TriMeshAcceleratorBVH<FloatType>& other, const Matrix4x4<FloatType>& transform) const {
+        if (!m_Root || !other.m_Root) return false;
         return m_Root->collisionBBoxOnly(*other.m_Root, transform);
     }
 
@@ -297,6 +345,7 @@ private:
 	const typename TriMesh<FloatType>::Triangle* intersectInternal(const Ray<FloatType>& r, FloatType& t, FloatType& u, FloatType& v, FloatType tmin = (FloatType)0, FloatType tmax = std::numeric_limits<FloatType>::max(), bool onlyFrontFaces = false) const {
 		u = v = std::numeric_limits<FloatType>::max();	
 		t = tmax;	//TODO MATTHIAS: probably we don't have to track tmax since t must always be smaller than the prev
+		if (!m_Root) return nullptr;	//empty mesh
 		return m_Root->intersect(r, t, u, v, tmin, tmax, onlyFrontFaces);
 	}
 
@@ -319,8 +368,10 @@ private:
 			TriangleBVHNode<FloatType> *node;
 		};
 
+		if (tris.empty()) return;
 		std::vector<NodeEntry> currLevel(1);
 		m_Root = new TriangleBVHNode<FloatType>;
+		if (tris.size() == 1) m_Root->leafTri = tris[0];
 		currLevel[0].node = m_Root;
 		currLevel[0].begin = 0;
 		currLevel[0].end = tris.size();
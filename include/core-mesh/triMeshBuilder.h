@@ -0,0 +1,146 @@
+#ifndef CORE_MESH_TRIMESHBUILDER_H_
+#define CORE_MESH_TRIMESHBUILDER_H_
+
+namespace ml {
+
+	//! accumulates many (transformed) meshes into one TriMesh with a single copy per vertex
+	//! append() only records the pieces (by reference, or by taking ownership of moved meshes); finalize() allocates
+	//! the output once and copies, transforms and re-indexes all pieces in parallel
+	template<class FloatType>
+	class TriMeshBuilder
+	{
+	public:
+		TriMeshBuilder() {
+			clear();
+		}
+
+		void clear() {
+			m_pieces.clear();
+			m_ownedMeshes.clear();
+			m_numVertices = 0;
+			m_numTriangles = 0;
+		}
+
+		void reserve(size_t numMeshes) {
+			m_pieces.reserve(numMeshes);
+		}
+
+		//! the mesh is referenced, not copied: it must stay alive (and unchanged) until finalize() is called
+		void append(const TriMesh<FloatType>& mesh) {
+			addPiece(&mesh, nullptr);
+		}
+		void append(const TriMesh<FloatType>& mesh, const Matrix4x4<FloatType>& transform) {
+			addPiece(&mesh, &transform);
+		}
+
+		//! takes ownership of the mesh data (no copy)
+		void append(TriMesh<FloatType>&& mesh) {
+			m_ownedMeshes.push_back(std::move(mesh));
+			addPiece(&m_ownedMeshes.back(), nullptr);
+		}
+		void append(TriMesh<FloatType>&& mesh, const Matrix4x4<FloatType>& transform) {
+			m_ownedMeshes.push_back(std::move(mesh));
+			addPiece(&m_ownedMeshes.back(), &transform);
+		}
+
+		size_t getNumMeshes() const {
+			return m_pieces.size();
+		}
+		size_t getNumVertices() const {
+			return m_numVertices;
+		}
+		size_t getNumTriangles() const {
+			return m_numTriangles;
+		}
+
+		//! an attribute is kept if all appended meshes have it; normals are transformed along with the positions
+		TriMesh<FloatType> finalize() {
+			TriMesh<FloatType> result;
+			if (m_pieces.empty()) return result;
+
+			bool hasNormals = true, hasColors = true, hasTexCoords = true;
+			for (const Piece& p : m_pieces) {
+				hasNormals &= p.mesh->hasNormals();
+				hasColors &= p.mesh->hasColors();
+				hasTexCoords &= p.mesh->hasTexCoords();
+			}
+
+			//a single moved-in mesh can be handed out directly
+			if (m_pieces.size() == 1 && !m_pieces[0].hasTransform && !m_ownedMeshes.empty()) {
+				swap(result, m_ownedMeshes.back());
+				clear();
+				return result;
+			}
+
+			std::vector<typename TriMesh<FloatType>::Vertex>& vertices = result.getVertices();
+			std::vector<vec3ui>& indices = result.getIndices();
+			vertices.resize(m_numVertices);
+			indices.resize(m_numTriangles);
+
+			//pieces write to disjoint ranges of the output
+			const int numPieces = (int)m_pieces.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+			for (int i = 0; i < numPieces; i++) {
+				const Piece& p = m_pieces[i];
+				const std::vector<typename TriMesh<FloatType>::Vertex>& srcVertices = p.mesh->getVertices();
+				const std::vector<vec3ui>& srcIndices = p.mesh->getIndices();
+				if (!srcVertices.empty()) {
+					typename TriMesh<FloatType>::Vertex* dst = &vertices[p.vertexOffset];
+					std::copy(srcVertices.begin(), srcVertices.end(), dst);
+					if (p.hasTransform) {
+						transformPointsAndNormals(p.transform,
+							(FloatType*)&dst[0].position, sizeof(typename TriMesh<FloatType>::Vertex),
+							hasNormals ? (FloatType*)&dst[0].normal : nullptr, sizeof(typename TriMesh<FloatType>::Vertex),
+							srcVertices.size());
+					}
+				}
+				const vec3ui base((unsigned int)p.vertexOffset);
+				vec3ui* dstIndices = indices.data() + p.triangleOffset;
+				for (size_t t = 0; t < srcIndices.size(); t++) {
+					dstIndices[t] = srcIndices[t] + base;
+				}
+			}
+
+			result.m_bHasNormals = hasNormals;
+			result.m_bHasColors = hasColors;
+			result.m_bHasTexCoords = hasTexCoords;
+			clear();
+			return result;
+		}
+
+	private:
+		struct Piece {
+			const TriMesh<FloatType>* mesh;
+			Matrix4x4<FloatType> transform;
+			bool hasTransform;
+			size_t vertexOffset;
+			size_t triangleOffset;
+		};
+
+		void addPiece(const TriMesh<FloatType>* mesh, const Matrix4x4<FloatType>* transform) {
+			Piece p;
+			p.mesh = mesh;
+			p.hasTransform = transform != nullptr;
+			if (transform) p.transform = *transform;
+			p.vertexOffset = m_numVertices;
+			p.triangleOffset = m_numTriangles;
+			m_numVertices += mesh->getVertices().size();
+			m_numTriangles += mesh->getIndices().size();
+			if (m_numVertices > std::numeric_limits<unsigned int>::max()) throw MLIB_EXCEPTION("too many vertices for 32-bit indices");
+			m_pieces.push_back(p);
+		}
+
+		std::vector<Piece>				m_pieces;
+		std::deque<TriMesh<FloatType>>	m_ownedMeshes;	//deque: stable addresses when growing
+		size_t m_numVertices;
+		size_t m_numTriangles;
+	};
+
+	typedef TriMeshBuilder<float> TriMeshBuilderf;
+	typedef TriMeshBuilder<double> TriMeshBuilderd;
+
+}  // namespace ml
+
+#endif  // CORE_MESH_TRIMESHBUILDER_H_
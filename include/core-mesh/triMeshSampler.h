@@ -36,7 +36,75 @@ public:
 
     static std::vector<Sample> sample(const std::vector< std::pair<const TriMesh<T>*, mat4f> > &meshes, float sampleDensity, UINT maxSampleCount, const std::function<bool(const vec3f&)> &normalPredicate);
 
+    enum SampleMode
+    {
+        MODE_RANDOM = 0,        // independent, area-weighted samples
+        MODE_POISSON_DISK = 1   // no two samples are closer than minDistance (Euclidean); dart throwing over random candidates
+    };
+
+    //
+    // World-space vertices, normals and areas of all acceptable triangles, computed once, plus an alias table over the areas.
+    // It can be reused for any number of sample sets (e.g., different seeds) of the same scene.
+    //
+    class SurfaceDistribution
+    {
+    public:
+        SurfaceDistribution() : m_totalArea(0.0) {}
+        SurfaceDistribution(const std::vector<MeshData> &meshes, const std::function<bool(const vec3f&)> &normalPredicate = nullptr)
+        {
+            build(meshes, normalPredicate);
+        }
+
+        //! the predicate (if any) is called concurrently from several threads
+        void build(const std::vector<MeshData> &meshes, const std::function<bool(const vec3f&)> &normalPredicate = nullptr);
+
+        double getTotalArea() const { return m_totalArea; }
+        size_t getNumTriangles() const { return m_triangles.size(); }
+
+        //! maps a triangle (picked by u0) and two further uniform numbers to a surface sample
+        Sample sample(double u0, double u1, double u2) const;
+
+    private:
+        struct Triangle
+        {
+            vec3ui vertices;      // indices into m_positions
+            vec3f normal;
+            UINT meshIndex;
+            UINT triangleIndex;
+        };
+        std::vector<vec3f> m_positions;
+        std::vector<Triangle> m_triangles;
+        AliasTable<double> m_aliasTable;
+        double m_totalArea;
+    };
+
+    //
+    // Parallel sampling: every sample (or Poisson-disk candidate) i draws from its own counter-based random stream (seed, i),
+    // so the result only depends on the seed, not on the number of threads. A minDistance of 0 selects a distance that yields
+    // roughly the requested number of samples in Poisson-disk mode.
+    //
+
+    static std::vector<Sample> sampleParallelByDensity(const std::vector<MeshData> &meshes, float sampleDensity, UINT maxSampleCount, UINT64 seed = 0, SampleMode mode = MODE_RANDOM, float minDistance = 0.0f)
+    {
+        return sampleParallelByDensity(SurfaceDistribution(meshes), sampleDensity, maxSampleCount, seed, mode, minDistance);
+    }
+
+    static std::vector<Sample> sampleParallelByDensity(const std::vector<MeshData> &meshes, float sampleDensity, UINT maxSampleCount, const std::function<bool(const vec3f&)> &normalPredicate, UINT64 seed = 0, SampleMode mode = MODE_RANDOM, float minDistance = 0.0f)
+    {
+        return sampleParallelByDensity(SurfaceDistribution(meshes, normalPredicate), sampleDensity, maxSampleCount, seed, mode, minDistance);
+    }
+
+    static std::vector<Sample> sampleParallelByDensity(const SurfaceDistribution &distribution, float sampleDensity, UINT maxSampleCount, UINT64 seed = 0, SampleMode mode = MODE_RANDOM, float minDistance = 0.0f)
+    {
+        const UINT sampleCount = (UINT)std::min((double)maxSampleCount, distribution.getTotalArea() * sampleDensity);
+        return sampleParallelByCount(distribution, sampleCount, seed, mode, minDistance);
+    }
+
+    static std::vector<Sample> sampleParallelByCount(const SurfaceDistribution &distribution, UINT sampleCount, UINT64 seed = 0, SampleMode mode = MODE_RANDOM, float minDistance = 0.0f);
+
 private:
+    static std::vector<Sample> poissonDiskSelect(const std::vector<Sample> &candidates, UINT sampleCount, float minDistance);
+
     static double directionalSurfaceArea(const MeshData &mesh, const std::function<bool(const vec3f&)> &normalPredicate);
 
     static double triangleArea(const MeshData &mesh, UINT triangleIndex)
@@ -199,6 +267,191 @@ vec2f TriMeshSampler<T>::stratifiedSample2D(double s, UINT depth)
     return basePoint + stratifiedSample2D((s - baseValue) * 4.0, depth + 1) * 0.5f;
 }
 
+template<class T>
+void TriMeshSampler<T>::SurfaceDistribution::build(const std::vector<MeshData> &meshes, const std::function<bool(const vec3f&)> &normalPredicate)
+{
+    m_positions.clear();
+    m_triangles.clear();
+    m_totalArea = 0.0;
+
+    // world-space vertices; every vertex is transformed once
+    std::vector<size_t> vertexOffsets(meshes.size() + 1, 0);
+    std::vector<size_t> triangleOffsets(meshes.size() + 1, 0);
+    for (size_t m = 0; m < meshes.size(); m++)
+    {
+        vertexOffsets[m + 1] = vertexOffsets[m] + meshes[m].first->getVertices().size();
+        triangleOffsets[m + 1] = triangleOffsets[m] + meshes[m].first->getIndices().size();
+    }
+    if (vertexOffsets.back() > std::numeric_limits<UINT>::max() || triangleOffsets.back() > std::numeric_limits<UINT>::max())
+        throw MLIB_EXCEPTION("too many vertices/triangles to sample");
+
+    m_positions.resize(vertexOffsets.back());
+    std::vector<Triangle> triangles(triangleOffsets.back());
+    std::vector<double> areas(triangleOffsets.back());
+    std::vector<char> accepted(triangleOffsets.back());
+
+    for (size_t m = 0; m < meshes.size(); m++)
+    {
+        const mat4f &transform = meshes[m].second;
+        const auto &vertices = meshes[m].first->getVertices();
+        const auto &indices = meshes[m].first->getIndices();
+        vec3f *positions = m_positions.data() + vertexOffsets[m];
+
+        const int numVertices = (int)vertices.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+        for (int i = 0; i < numVertices; i++)
+        {
+            positions[i] = transform.transformAffine(vec3f(vertices[i].position));
+        }
+
+        const vec3ui base((UINT)vertexOffsets[m]);
+        const int numTriangles = (int)indices.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+        for (int t = 0; t < numTriangles; t++)
+        {
+            const size_t idx = triangleOffsets[m] + t;
+            Triangle &tri = triangles[idx];
+            tri.vertices = indices[t] + base;
+            tri.meshIndex = (UINT)m;
+            tri.triangleIndex = (UINT)t;
+
+            const vec3f &v0 = m_positions[tri.vertices.x];
+            const vec3f &v1 = m_positions[tri.vertices.y];
+            const vec3f &v2 = m_positions[tri.vertices.z];
+            tri.normal = math::triangleNormal(v0, v1, v2);
+            areas[idx] = math::triangleArea(vec3d(v0), vec3d(v1), vec3d(v2));
+            accepted[idx] = (areas[idx] > 0.0 && (!normalPredicate || normalPredicate(tri.normal))) ? 1 : 0;
+        }
+    }
+
+    // keep the acceptable triangles (in order, so the distribution does not depend on the thread count)
+    std::vector<double> weights;
+    m_triangles.reserve(triangles.size());
+    weights.reserve(triangles.size());
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        if (accepted[i])
+        {
+            m_triangles.push_back(triangles[i]);
+            weights.push_back(areas[i]);
+            m_totalArea += areas[i];
+        }
+    }
+    m_aliasTable.build(weights);
+}
+
+template<class T>
+typename TriMeshSampler<T>::Sample TriMeshSampler<T>::SurfaceDistribution::sample(double u0, double u1, double u2) const
+{
+    const Triangle &tri = m_triangles[m_aliasTable.sample(u0)];
+
+    // uniform on the triangle by folding the unit square (same uv convention as sampleTriangle)
+    vec2f uv((float)u1, (float)u2);
+    if (uv.x + uv.y > 1.0f)
+    {
+        uv = vec2f(1.0f - uv.y, 1.0f - uv.x);
+    }
+
+    const vec3f &v0 = m_positions[tri.vertices.x];
+    const vec3f &v1 = m_positions[tri.vertices.y];
+    const vec3f &v2 = m_positions[tri.vertices.z];
+
+    Sample result;
+    result.pos = v0 + (v1 - v0) * uv.x + (v2 - v0) * uv.y;
+    result.normal = tri.normal;
+    result.meshIndex = tri.meshIndex;
+    result.triangleIndex = tri.triangleIndex;
+    result.uv = uv;
+    return result;
+}
+
+template<class T>
+std::vector<typename TriMeshSampler<T>::Sample> TriMeshSampler<T>::sampleParallelByCount(const SurfaceDistribution &distribution, UINT sampleCount, UINT64 seed, SampleMode mode, float minDistance)
+{
+    if (sampleCount == 0 || distribution.getNumTriangles() == 0)
+    {
+        return std::vector<Sample>();
+    }
+
+    // Poisson-disk mode over-samples and then thins out the candidates
+    const size_t candidateCount = mode == MODE_POISSON_DISK ? std::min((size_t)sampleCount * 8, (size_t)std::numeric_limits<int>::max()) : sampleCount;
+    std::vector<Sample> samples(candidateCount);
+
+    const int count = (int)candidateCount;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+    for (int i = 0; i < count; i++)
+    {
+        CounterRNG rng(seed, (UINT64)i);
+        const double u0 = rng.uniform();
+        const double u1 = rng.uniform();
+        const double u2 = rng.uniform();
+        samples[i] = distribution.sample(u0, u1, u2);
+    }
+
+    if (mode == MODE_POISSON_DISK)
+    {
+        if (minDistance <= 0.0f)
+        {
+            // dart throwing with 8x candidates covers about 40% of the surface with disks of radius minDistance/2
+            minDistance = (float)std::sqrt(0.5 * distribution.getTotalArea() / (double)sampleCount);
+        }
+        return poissonDiskSelect(samples, sampleCount, minDistance);
+    }
+    return samples;
+}
+
+template<class T>
+std::vector<typename TriMeshSampler<T>::Sample> TriMeshSampler<T>::poissonDiskSelect(const std::vector<Sample> &candidates, UINT sampleCount, float minDistance)
+{
+    // candidates are visited in (random) index order; a hash grid with cell size minDistance limits the tests to 27 cells
+    const float invCellSize = 1.0f / minDistance;
+    const float minDistSq = minDistance * minDistance;
+    std::unordered_map<vec3i, std::vector<UINT>, std::hash<vec3i>> grid;
+    grid.reserve(sampleCount);
+
+    std::vector<Sample> result;
+    result.reserve(sampleCount);
+    for (size_t i = 0; i < candidates.size() && result.size() < sampleCount; i++)
+    {
+        const vec3f &p = candidates[i].pos;
+        const vec3i cell((int)std::floor(p.x * invCellSize), (int)std::floor(p.y * invCellSize), (int)std::floor(p.z * invCellSize));
+
+        bool valid = true;
+        for (int z = -1; z <= 1 && valid; z++)
+        {
+            for (int y = -1; y <= 1 && valid; y++)
+            {
+                for (int x = -1; x <= 1 && valid; x++)
+                {
+                    auto it = grid.find(cell + vec3i(x, y, z));
+                    if (it == grid.end()) continue;
+                    for (UINT s : it->second)
+                    {
+                        if (vec3f::distSq(result[s].pos, p) < minDistSq)
+                        {
+                            valid = false;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (valid)
+        {
+            grid[cell].push_back((UINT)result.size());
+            result.push_back(candidates[i]);
+        }
+    }
+    return result;
+}
+
 } // ml
 
 // below is code for my pre-C++-11 MeshSampler
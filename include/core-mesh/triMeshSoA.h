@@ -0,0 +1,278 @@
+#ifndef CORE_MESH_TRIMESHSOA_H_
+#define CORE_MESH_TRIMESHSOA_H_
+
+namespace ml {
+
+	//! triangle mesh with one array per vertex attribute (structure of arrays)
+	//! purely geometric kernels (transform, bounding box, normals, accelerator builds) only stream the 12-24 byte positions
+	//! instead of the interleaved TriMesh::Vertex; attributes that are not present are not stored at all
+	template<class FloatType>
+	class TriMeshSoA
+	{
+	public:
+		TriMeshSoA() {
+			m_bHasNormals = false;
+			m_bHasTexCoords = false;
+			m_bHasColors = false;
+		}
+
+		explicit TriMeshSoA(const TriMesh<FloatType>& mesh) {
+			fromTriMesh(mesh);
+		}
+
+		TriMeshSoA(const std::vector<vec3<FloatType>>& positions, const std::vector<vec3ui>& indices) : m_positions(positions), m_indices(indices) {
+			m_bHasNormals = false;
+			m_bHasTexCoords = false;
+			m_bHasColors = false;
+		}
+
+		TriMeshSoA(std::vector<vec3<FloatType>>&& positions, std::vector<vec3ui>&& indices) : m_positions(std::move(positions)), m_indices(std::move(indices)) {
+			m_bHasNormals = false;
+			m_bHasTexCoords = false;
+			m_bHasColors = false;
+		}
+
+		TriMeshSoA(const TriMeshSoA& other) = default;
+		TriMeshSoA& operator=(const TriMeshSoA& other) = default;
+
+		TriMeshSoA(TriMeshSoA&& other) {
+			m_bHasNormals = m_bHasTexCoords = m_bHasColors = false;
+			swap(*this, other);
+		}
+		void operator=(TriMeshSoA&& other) {
+			swap(*this, other);
+		}
+
+		//! adl swap
+		friend void swap(TriMeshSoA& a, TriMeshSoA& b) {
+			std::swap(a.m_positions, b.m_positions);
+			std::swap(a.m_normals, b.m_normals);
+			std::swap(a.m_colors, b.m_colors);
+			std::swap(a.m_texCoords, b.m_texCoords);
+			std::swap(a.m_indices, b.m_indices);
+			std::swap(a.m_bHasNormals, b.m_bHasNormals);
+			std::swap(a.m_bHasTexCoords, b.m_bHasTexCoords);
+			std::swap(a.m_bHasColors, b.m_bHasColors);
+		}
+
+		//! splits the interleaved vertices of a TriMesh; attributes are only copied if the mesh flags them as present
+		void fromTriMesh(const TriMesh<FloatType>& mesh) {
+			const std::vector<typename TriMesh<FloatType>::Vertex>& vertices = mesh.getVertices();
+			m_bHasNormals = mesh.hasNormals();
+			m_bHasColors = mesh.hasColors();
+			m_bHasTexCoords = mesh.hasTexCoords();
+
+			m_positions.resize(vertices.size());
+			m_normals.resize(m_bHasNormals ? vertices.size() : 0);
+			m_colors.resize(m_bHasColors ? vertices.size() : 0);
+			m_texCoords.resize(m_bHasTexCoords ? vertices.size() : 0);
+			m_indices = mesh.getIndices();
+
+			const int numVertices = (int)vertices.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < numVertices; i++) {
+				m_positions[i] = vertices[i].position;
+				if (m_bHasNormals)		m_normals[i] = vertices[i].normal;
+				if (m_bHasColors)		m_colors[i] = vertices[i].color;
+				if (m_bHasTexCoords)	m_texCoords[i] = vertices[i].texCoord;
+			}
+		}
+
+		//! interleaves the attributes again (e.g., for rendering with D3D11TriMesh)
+		TriMesh<FloatType> toTriMesh() const {
+			std::vector<typename TriMesh<FloatType>::Vertex> vertices(m_positions.size());
+			const int numVertices = (int)m_positions.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < numVertices; i++) {
+				vertices[i].position = m_positions[i];
+				if (m_bHasNormals)		vertices[i].normal = m_normals[i];
+				if (m_bHasColors)		vertices[i].color = m_colors[i];
+				if (m_bHasTexCoords)	vertices[i].texCoord = m_texCoords[i];
+			}
+			return TriMesh<FloatType>(vertices, m_indices, false, m_bHasNormals, m_bHasTexCoords, m_bHasColors);
+		}
+
+		void computeMeshData(MeshData<FloatType>& meshData) const {
+			meshData.clear();
+			meshData.m_Vertices = m_positions;
+			if (m_bHasNormals)		meshData.m_Normals = m_normals;
+			if (m_bHasColors)		meshData.m_Colors = m_colors;
+			if (m_bHasTexCoords)	meshData.m_TextureCoords = m_texCoords;
+			meshData.m_FaceIndicesVertices.resize(m_indices.size());
+			for (size_t i = 0; i < m_indices.size(); i++) {
+				meshData.m_FaceIndicesVertices[i][0] = m_indices[i].x;
+				meshData.m_FaceIndicesVertices[i][1] = m_indices[i].y;
+				meshData.m_FaceIndicesVertices[i][2] = m_indices[i].z;
+			}
+		}
+
+		MeshData<FloatType> computeMeshData() const {
+			MeshData<FloatType> meshData;
+			computeMeshData(meshData);
+			return meshData;
+		}
+
+		void clear() {
+			m_positions.clear();
+			m_normals.clear();
+			m_colors.clear();
+			m_texCoords.clear();
+			m_indices.clear();
+			m_bHasNormals = false;
+			m_bHasTexCoords = false;
+			m_bHasColors = false;
+		}
+		bool empty() const {
+			return m_positions.empty();
+		}
+
+		size_t getNumVertices() const {
+			return m_positions.size();
+		}
+		size_t getNumTriangles() const {
+			return m_indices.size();
+		}
+
+		void transform(const Matrix4x4<FloatType>& m) {
+			transformPoints(m, m_positions);
+			if (m_bHasNormals) transformNormals(m, m_normals);
+		}
+
+		void scale(FloatType s) { scale(vec3<FloatType>(s, s, s)); }
+
+		void scale(const vec3<FloatType>& v) {
+			const int numVertices = (int)m_positions.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < numVertices; i++) {
+				m_positions[i].x *= v.x;
+				m_positions[i].y *= v.y;
+				m_positions[i].z *= v.z;
+			}
+		}
+
+		//! Computes the bounding box of the mesh (not cached!)
+		BoundingBox3<FloatType> computeBoundingBox() const {
+			BoundingBox3<FloatType> bb;
+			const int numVertices = (int)m_positions.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel
+#endif
+			{
+				BoundingBox3<FloatType> localBB;
+#ifdef MLIB_OPENMP
+#pragma omp for nowait
+#endif
+				for (int i = 0; i < numVertices; i++) {
+					localBB.include(m_positions[i]);
+				}
+#ifdef MLIB_OPENMP
+#pragma omp critical
+#endif
+				bb.include(localBB);
+			}
+			return bb;
+		}
+
+		//! Computes the vertex normals of the mesh (see MeshNormals)
+		void computeNormals(typename MeshNormals<FloatType>::WeightingType weighting = MeshNormals<FloatType>::WEIGHT_AREA) {
+			MeshNormals<FloatType>::compute(m_positions, m_normals, m_indices, weighting);
+			m_bHasNormals = true;
+		}
+
+		//! overwrites/sets the mesh color
+		void setColor(const vec4<FloatType>& c) {
+			m_colors.clear();
+			m_colors.resize(m_positions.size(), c);
+			m_bHasColors = true;
+		}
+
+		const std::vector<vec3<FloatType>>& getPositions() const { return m_positions; }
+		const std::vector<vec3<FloatType>>& getNormals() const { return m_normals; }
+		const std::vector<vec4<FloatType>>& getColors() const { return m_colors; }
+		const std::vector<vec2<FloatType>>& getTexCoords() const { return m_texCoords; }
+		const std::vector<vec3ui>& getIndices() const { return m_indices; }
+
+		std::vector<vec3<FloatType>>& getPositions() { return m_positions; }
+		std::vector<vec3<FloatType>>& getNormals() { return m_normals; }
+		std::vector<vec4<FloatType>>& getColors() { return m_colors; }
+		std::vector<vec2<FloatType>>& getTexCoords() { return m_texCoords; }
+		std::vector<vec3ui>& getIndices() { return m_indices; }
+
+		//! the flags must be kept in sync with the attribute arrays (an attribute is either empty or has one entry per position)
+		bool hasNormals() const {
+			return m_bHasNormals;
+		}
+		bool hasColors() const {
+			return m_bHasColors;
+		}
+		bool hasTexCoords() const {
+			return m_bHasTexCoords;
+		}
+		void setHasNormals(bool b) {
+			m_bHasNormals = b;
+			m_normals.resize(b ? m_positions.size() : 0);
+		}
+		void setHasColors(bool b) {
+			m_bHasColors = b;
+			m_colors.resize(b ? m_positions.size() : 0);
+		}
+		void setHasTexCoords(bool b) {
+			m_bHasTexCoords = b;
+			m_texCoords.resize(b ? m_positions.size() : 0);
+		}
+
+		bool m_bHasNormals;
+		bool m_bHasTexCoords;
+		bool m_bHasColors;
+
+		std::vector<vec3<FloatType>>	m_positions;
+		std::vector<vec3<FloatType>>	m_normals;
+		std::vector<vec4<FloatType>>	m_colors;
+		std::vector<vec2<FloatType>>	m_texCoords;
+		std::vector<vec3ui>				m_indices;
+	};
+
+	typedef TriMeshSoA<float> TriMeshSoAf;
+	typedef TriMeshSoA<double> TriMeshSoAd;
+
+	template<class BinaryDataBuffer, class BinaryDataCompressor, class FloatType>
+	inline BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& operator<< (BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& s, const TriMeshSoA<FloatType> &m) {
+		s << m.m_bHasNormals << m.m_bHasTexCoords << m.m_bHasColors;
+		s.writePrimitive(m.m_positions);
+		s.writePrimitive(m.m_normals);
+		s.writePrimitive(m.m_colors);
+		s.writePrimitive(m.m_texCoords);
+		s.writePrimitive(m.m_indices);
+		return s;
+	}
+
+	template<class BinaryDataBuffer, class BinaryDataCompressor, class FloatType>
+	inline BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& operator>> (BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& s, TriMeshSoA<FloatType> &m) {
+		s >> m.m_bHasNormals >> m.m_bHasTexCoords >> m.m_bHasColors;
+		s.readPrimitive(m.m_positions);
+		s.readPrimitive(m.m_normals);
+		s.readPrimitive(m.m_colors);
+		s.readPrimitive(m.m_texCoords);
+		s.readPrimitive(m.m_indices);
+		return s;
+	}
+
+	template<class FloatType>
+	std::ostream& operator<<(std::ostream& os, const TriMeshSoA<FloatType>& triMesh) {
+		os << "TriMeshSoA:\n"
+			<< "\tVertices:  " << triMesh.m_positions.size() << "\n"
+			<< "\tIndices:   " << triMesh.m_indices.size() << "*3\n"
+			<< std::endl;
+
+		return os;
+	}
+
+}  // namespace ml
+
+#endif  // CORE_MESH_TRIMESHSOA_H_
@@ -80,6 +80,22 @@ public:
 		}
 	}
 
+	//! vectors of plain data types that are not PODs by the standard's definition (e.g., vec3f or TriMesh::Vertex) as raw memory
+	template <class T>
+	void writePrimitive(const std::vector<T>& v) {
+		const UINT64 size = v.size();
+		writeData(size);
+		if (size > 0) writeData((const BYTE*)v.data(), sizeof(T)*v.size());
+	}
+
+	template <class T>
+	void readPrimitive(std::vector<T>& v) {
+		UINT64 size;
+		readData(size);
+		v.resize(size);
+		if (size > 0) readData((BYTE*)v.data(), sizeof(T)*v.size());
+	}
+
 	//! clears the read offset: copies all data to the front of the data array and frees all unnecessary memory
 	void clearReadOffset() {
 		m_dataBuffer.clearReadOffset();
@@ -13,6 +13,9 @@ public:
 	{
 		initInternal(points, dimension, maxK);
 	}
+	//! result receives k indices sorted by distance; if there are fewer than k points, the remaining entries are (UINT)-1
+	//! (as in kNearestBatch). epsilon > 0 allows approximate neighbors (within (1 + epsilon) times the exact distances);
+	//! exact backends such as NearestNeighborSearchBruteForce ignore it
 	void kNearest(const FloatType *query, UINT k, FloatType epsilon, std::vector<UINT> &result) const
 	{
 		kNearestInternal(query, k, epsilon, result);
@@ -90,9 +93,19 @@ public:
 		return std::vector<FloatType>();
 	}
 
+	//! reentrant batched query: queries are stored contiguously (numQueries x dimension) and processed in parallel
+	//! outIdx and outDist (may be null) receive numQueries x k entries sorted by distance; distances are Euclidean (not squared)
+	//! if there are fewer than k points, the remaining entries are (UINT)-1 and std::numeric_limits<FloatType>::max()
+	void kNearestBatch(const FloatType *queries, size_t numQueries, UINT k, UINT *outIdx, FloatType *outDist, FloatType epsilon = 0.0f) const
+	{
+		if (numQueries == 0 || k == 0) return;
+		kNearestBatchInternal(queries, numQueries, k, epsilon, outIdx, outDist);
+	}
+
 private:
 	virtual void initInternal(const std::vector< const FloatType* > &points, UINT dimension, UINT maxK) = 0;
 	virtual void kNearestInternal(const FloatType *query, UINT k, FloatType epsilon, std::vector<UINT> &result) const = 0;
+	virtual void kNearestBatchInternal(const FloatType *queries, size_t numQueries, UINT k, FloatType epsilon, UINT *outIdx, FloatType *outDist) const = 0;
     virtual void fixedRadiusInternal(const FloatType *query, UINT k, FloatType radius, FloatType epsilon, std::vector<UINT> &result) const = 0;
     virtual void fixedRadiusInternalDist(const FloatType *query, UINT k, FloatType radius, FloatType epsilon, std::vector< std::pair<UINT, FloatType> > &result) const = 0;
 };
@@ -163,69 +176,262 @@ public:
 		return m_queue;
 	}
 
+	//! copies the entries to outIdx/outDist (may be null); empty entries become (UINT)-1; entries are assumed to hold squared distances
+	void writeResult(UINT *outIdx, FloatType *outDist) const
+	{
+		for (size_t i = 0; i < m_queue.size(); i++)
+		{
+			const bool valid = m_queue[i].index >= 0;
+			outIdx[i] = valid ? (UINT)m_queue[i].index : (UINT)-1;
+			if (outDist) outDist[i] = valid ? std::sqrt(m_queue[i].dist) : std::numeric_limits<FloatType>::max();
+		}
+	}
+
 private:
 	FloatType m_farthestDist;
 	std::vector<NeighborEntry> m_queue;
 };
 
+//! k-nearest neighbor selection with a bounded max-heap: O(log k) per accepted candidate
+//! ties are broken by index, which yields the same result as KNearestNeighborQueue
+template<class FloatType>
+class KNearestNeighborHeap
+{
+public:
+	struct Entry
+	{
+		FloatType dist;
+		UINT index;
+		bool operator<(const Entry &other) const
+		{
+			return dist < other.dist || (dist == other.dist && index < other.index);
+		}
+	};
+
+	KNearestNeighborHeap()
+	{
+		m_k = 0;
+	}
+
+	void init(UINT k)
+	{
+		m_k = k;
+		m_heap.clear();
+		m_heap.reserve(k);
+	}
+
+	//! squared distance a candidate has to beat
+	FloatType worst() const
+	{
+		return m_heap.size() < m_k ? std::numeric_limits<FloatType>::max() : m_heap.front().dist;
+	}
+
+	inline void insert(UINT index, FloatType dist)
+	{
+		Entry e;
+		e.dist = dist;
+		e.index = index;
+		if (m_heap.size() < m_k)
+		{
+			m_heap.push_back(e);
+			std::push_heap(m_heap.begin(), m_heap.end());
+		}
+		else if (m_k > 0 && e < m_heap.front())
+		{
+			std::pop_heap(m_heap.begin(), m_heap.end());
+			m_heap.back() = e;
+			std::push_heap(m_heap.begin(), m_heap.end());
+		}
+	}
+
+	//! writes k entries sorted by distance (see NearestNeighborSearch::kNearestBatch) and clears the heap
+	void writeResult(UINT *outIdx, FloatType *outDist)
+	{
+		std::sort_heap(m_heap.begin(), m_heap.end());
+		for (size_t i = 0; i < m_k; i++)
+		{
+			const bool valid = i < m_heap.size();
+			outIdx[i] = valid ? m_heap[i].index : (UINT)-1;
+			if (outDist) outDist[i] = valid ? std::sqrt(m_heap[i].dist) : std::numeric_limits<FloatType>::max();
+		}
+		m_heap.clear();
+	}
+
+private:
+	UINT m_k;
+	std::vector<Entry> m_heap;
+};
+
+//! points per block of the brute-force point storage, and queries that share one pass over the points
+#define MLIB_NNS_POINT_BLOCK 32
+#define MLIB_NNS_QUERY_BLOCK 8
+
+//! exact brute-force search; the method of choice for high-dimensional descriptors
+//! the points are stored in blocks of MLIB_NNS_POINT_BLOCK points, transposed within each block (dimension-major), so the
+//! distance kernel runs over contiguous point lanes and vectorizes without re-associating sums. Batched queries are
+//! processed MLIB_NNS_QUERY_BLOCK at a time, so every point block is loaded once per query block (a tiled, GEMM-like loop)
 template<class FloatType>
 class NearestNeighborSearchBruteForce : public NearestNeighborSearch<FloatType>
 {
 public:
-	NearestNeighborSearchBruteForce() {}
+	NearestNeighborSearchBruteForce()
+	{
+		m_dimension = 0;
+		m_numPoints = 0;
+	}
 
 	void initInternal(const std::vector< const FloatType* > &points, UINT dimension, UINT maxK)
 	{
+		if (points.size() >= (size_t)std::numeric_limits<int>::max()) throw MLIB_EXCEPTION("too many points");
 		m_dimension = dimension;
-		m_pointData.resize(points.size() * dimension);
-		int pointIndex = 0;
-		for (auto p : points)
+		m_numPoints = (UINT)points.size();
+
+		const int numBlocks = (int)((m_numPoints + MLIB_NNS_POINT_BLOCK - 1) / MLIB_NNS_POINT_BLOCK);
+		m_blocks.clear();
+		m_blocks.resize((size_t)numBlocks * m_dimension * MLIB_NNS_POINT_BLOCK, (FloatType)0);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int b = 0; b < numBlocks; b++)
+		{
+			FloatType* block = &m_blocks[(size_t)b * m_dimension * MLIB_NNS_POINT_BLOCK];
+			const UINT count = blockSize(b);
+			for (UINT i = 0; i < count; i++)
+			{
+				const FloatType* p = points[(size_t)b * MLIB_NNS_POINT_BLOCK + i];
+				for (UINT d = 0; d < m_dimension; d++)
+					block[d * MLIB_NNS_POINT_BLOCK + i] = p[d];
+			}
+		}
+	}
+
+	//! the search is exact, so epsilon is not used
+	void kNearestInternal(const FloatType *query, UINT k, FloatType, std::vector<UINT> &result) const
+	{
+		KNearestNeighborHeap<FloatType> heap;
+		heap.init(k);
+		searchQueryBlock(query, 1, &heap);
+
+		if (result.size() != k) result.resize(k);
+		if (k > 0) heap.writeResult(&result[0], nullptr);
+	}
+
+	void kNearestBatchInternal(const FloatType *queries, size_t numQueries, UINT k, FloatType, UINT *outIdx, FloatType *outDist) const
+	{
+		const int numQueryBlocks = (int)((numQueries + MLIB_NNS_QUERY_BLOCK - 1) / MLIB_NNS_QUERY_BLOCK);
+#ifdef MLIB_OPENMP
+#pragma omp parallel
+#endif
 		{
-			m_points.push_back(&m_pointData[0] + pointIndex);
-			for(UINT d = 0; d < m_dimension; d++)
-				m_pointData[pointIndex++] = p[d];
+			KNearestNeighborHeap<FloatType> heaps[MLIB_NNS_QUERY_BLOCK];
+#ifdef MLIB_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+			for (int qb = 0; qb < numQueryBlocks; qb++)
+			{
+				const size_t first = (size_t)qb * MLIB_NNS_QUERY_BLOCK;
+				const UINT count = (UINT)std::min((size_t)MLIB_NNS_QUERY_BLOCK, numQueries - first);
+				for (UINT q = 0; q < count; q++) heaps[q].init(k);
+				searchQueryBlock(queries + first * m_dimension, count, heaps);
+				for (UINT q = 0; q < count; q++)
+					heaps[q].writeResult(outIdx + (first + q) * k, outDist ? outDist + (first + q) * k : nullptr);
+			}
 		}
 	}
 
-	void kNearestInternal(const FloatType *query, UINT k, FloatType epsilon, std::vector<UINT> &result) const
+	void fixedRadiusInternal(const FloatType *query, UINT k, FloatType radius, FloatType, std::vector<UINT> &result) const
+	{
+		std::vector< std::pair<UINT, FloatType> > resultDist;
+		fixedRadiusInternalDist(query, k, radius, (FloatType)0, resultDist);
+		result.resize(resultDist.size());
+		for (size_t i = 0; i < resultDist.size(); i++)
+			result[i] = resultDist[i].first;
+	}
+
+	//! returns the (at most k; all if k == 0) closest points within the radius, sorted by distance
+	void fixedRadiusInternalDist(const FloatType *query, UINT k, FloatType radius, FloatType, std::vector< std::pair<UINT, FloatType> > &result) const
 	{
-		m_queue.init(k, std::numeric_limits<FloatType>::max());
-		
-		for(UINT pointIndex = 0; pointIndex < m_points.size(); pointIndex++)
+		result.clear();
+		const FloatType radiusSq = radius * radius;
+		FloatType dist[1][MLIB_NNS_POINT_BLOCK];
+		const int numBlocks = (int)((m_numPoints + MLIB_NNS_POINT_BLOCK - 1) / MLIB_NNS_POINT_BLOCK);
+		for (int b = 0; b < numBlocks; b++)
 		{
-			FloatType dist = 0.0f;
-			const FloatType* point = m_points[pointIndex];
-			for(UINT d = 0; d < m_dimension; d++)
+			computeTile(query, 1, &m_blocks[(size_t)b * m_dimension * MLIB_NNS_POINT_BLOCK], dist);
+			const UINT count = blockSize(b);
+			for (UINT i = 0; i < count; i++)
 			{
-				FloatType diff = point[d] - query[d];
-				dist += diff * diff;
+				if (dist[0][i] <= radiusSq) result.push_back(std::make_pair((UINT)b * MLIB_NNS_POINT_BLOCK + i, dist[0][i]));
 			}
-			m_queue.insert(typename KNearestNeighborQueue<FloatType>::NeighborEntry(pointIndex, dist));
 		}
 
-		if (result.size() != k) result.resize(k);
-		UINT resultIndex = 0;
-		for (const auto &e : m_queue.queue())
+		auto byDistance = [](const std::pair<UINT, FloatType> &a, const std::pair<UINT, FloatType> &b) { return a.second < b.second || (a.second == b.second && a.first < b.first); };
+		if (k > 0 && result.size() > k)
 		{
-			result[resultIndex++] = e.index;
+			std::partial_sort(result.begin(), result.begin() + k, result.end(), byDistance);
+			result.resize(k);
 		}
+		else
+		{
+			std::sort(result.begin(), result.end(), byDistance);
+		}
+		for (auto &e : result) e.second = std::sqrt(e.second);
 	}
 
-    void fixedRadiusInternal(const FloatType *query, UINT k, FloatType radius, FloatType epsilon, std::vector<UINT> &result) const
-    {
-        throw MLIB_EXCEPTION("fixedRadiusInternal not implemented");
-    }
+private:
+	UINT blockSize(int b) const
+	{
+		return std::min((UINT)MLIB_NNS_POINT_BLOCK, m_numPoints - (UINT)b * MLIB_NNS_POINT_BLOCK);
+	}
 
-    void fixedRadiusInternalDist(const FloatType *query, UINT k, FloatType radius, FloatType epsilon, std::vector< std::pair<UINT, FloatType> > &result) const
-    {
-        throw MLIB_EXCEPTION("fixedRadiusInternalDist not implemented");
-    }
+	//! squared distances of numQueries (<= MLIB_NNS_QUERY_BLOCK) queries to one point block
+	void computeTile(const FloatType *queries, UINT numQueries, const FloatType *block, FloatType dist[][MLIB_NNS_POINT_BLOCK]) const
+	{
+		for (UINT q = 0; q < numQueries; q++)
+		{
+			const FloatType* query = queries + (size_t)q * m_dimension;
+			FloatType* acc = dist[q];
+			for (UINT i = 0; i < MLIB_NNS_POINT_BLOCK; i++) acc[i] = (FloatType)0;
+			for (UINT d = 0; d < m_dimension; d++)
+			{
+				const FloatType qd = query[d];
+				const FloatType* lane = block + d * MLIB_NNS_POINT_BLOCK;
+				for (UINT i = 0; i < MLIB_NNS_POINT_BLOCK; i++)
+				{
+					const FloatType diff = lane[i] - qd;
+					acc[i] += diff * diff;
+				}
+			}
+		}
+	}
+
+	void searchQueryBlock(const FloatType *queries, UINT numQueries, KNearestNeighborHeap<FloatType> *heaps) const
+	{
+		FloatType dist[MLIB_NNS_QUERY_BLOCK][MLIB_NNS_POINT_BLOCK];
+		const int numBlocks = (int)((m_numPoints + MLIB_NNS_POINT_BLOCK - 1) / MLIB_NNS_POINT_BLOCK);
+		for (int b = 0; b < numBlocks; b++)
+		{
+			computeTile(queries, numQueries, &m_blocks[(size_t)b * m_dimension * MLIB_NNS_POINT_BLOCK], dist);
+			const UINT count = blockSize(b);
+			const UINT base = (UINT)b * MLIB_NNS_POINT_BLOCK;
+			for (UINT q = 0; q < numQueries; q++)
+			{
+				FloatType worst = heaps[q].worst();
+				for (UINT i = 0; i < count; i++)
+				{
+					if (dist[q][i] < worst)
+					{
+						heaps[q].insert(base + i, dist[q][i]);
+						worst = heaps[q].worst();
+					}
+				}
+			}
+		}
+	}
 
-private:
 	UINT m_dimension;
-	std::vector<FloatType> m_pointData;
-	std::vector< const FloatType* > m_points;
-	mutable KNearestNeighborQueue<FloatType> m_queue;
+	UINT m_numPoints;
+	std::vector<FloatType> m_blocks;	//numBlocks x dimension x MLIB_NNS_POINT_BLOCK (zero padded)
 };
 
 }  // namespace ml
@@ -0,0 +1,302 @@
+#ifndef CORE_UTIL_NEARESTNEIGHBORSEARCHKDTREE_H_
+#define CORE_UTIL_NEARESTNEIGHBORSEARCHKDTREE_H_
+
+namespace ml
+{
+
+//! k-d tree for low-dimensional data (typically 3-16 dimensions); header-only alternative to NearestNeighborSearchFLANN
+//! the tree is balanced (median splits along the dimension of largest spread) and stored implicitly: node i has the
+//! children 2i+1 and 2i+2, and the point range of every node follows from halving the range of its parent. The points
+//! are copied in leaf order, so every leaf bucket is one contiguous block of memory. Queries do not modify the tree and
+//! may be issued concurrently.
+template<class FloatType>
+class NearestNeighborSearchKdTree : public NearestNeighborSearch<FloatType>
+{
+public:
+	//! bucketSize is the maximum number of points per leaf
+	NearestNeighborSearchKdTree(UINT bucketSize = 12)
+	{
+		m_bucketSize = std::max(bucketSize, 1u);
+		m_dimension = 0;
+		m_numPoints = 0;
+		m_depth = 0;
+	}
+
+	UINT getNumPoints() const
+	{
+		return m_numPoints;
+	}
+	UINT getDimension() const
+	{
+		return m_dimension;
+	}
+	UINT getDepth() const
+	{
+		return m_depth;
+	}
+
+	//! batched kNN restricted to neighbors within maxDist (missing entries as in kNearestBatch); much faster than the
+	//! unbounded search for queries far away from the points (e.g., outliers during ICP)
+	void kNearestBatchInRadius(const FloatType *queries, size_t numQueries, UINT k, FloatType maxDist, UINT *outIdx, FloatType *outDist) const
+	{
+		if (numQueries == 0 || k == 0) return;
+		searchBatch(queries, numQueries, k, (FloatType)0, maxDist * maxDist, outIdx, outDist);
+	}
+
+private:
+	//! per-query scratch data
+	struct SearchState
+	{
+		const FloatType* query;
+		std::vector<FloatType> offsets;		//per-dimension offset of the query to the current cell
+		KNearestNeighborQueue<FloatType> queue;
+		std::vector< std::pair<UINT, FloatType> > radiusResult;
+		FloatType maxDistSq;
+		FloatType epsilonScale;				//(1 + epsilon)^2
+	};
+
+	void initInternal(const std::vector< const FloatType* > &points, UINT dimension, UINT)
+	{
+		if (points.size() >= (size_t)std::numeric_limits<int>::max()) throw MLIB_EXCEPTION("too many points for the k-d tree");
+		m_dimension = dimension;
+		m_numPoints = (UINT)points.size();
+
+		m_depth = 0;
+		while ((((size_t)m_numPoints + ((size_t)1 << m_depth) - 1) >> m_depth) > m_bucketSize) m_depth++;
+
+		const size_t numInternalNodes = ((size_t)1 << m_depth) - 1;
+		m_splitDim.resize(numInternalNodes);
+		m_splitValue.resize(numInternalNodes);
+		m_indices.resize(m_numPoints);
+		for (UINT i = 0; i < m_numPoints; i++) m_indices[i] = i;
+
+		//level by level: the nodes of one level partition disjoint ranges of m_indices
+		for (UINT level = 0; level < m_depth; level++) {
+			const int levelSize = 1 << level;
+			const UINT firstNode = (UINT)levelSize - 1;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic) if(levelSize > 1)
+#endif
+			for (int j = 0; j < levelSize; j++) {
+				UINT begin, end;
+				nodeRange(level, (UINT)j, begin, end);
+				splitNode(points, firstNode + (UINT)j, begin, end);
+			}
+		}
+
+		//copy the points in leaf order
+		m_points.resize((size_t)m_numPoints * m_dimension);
+		const int numPoints = (int)m_numPoints;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int i = 0; i < numPoints; i++) {
+			const FloatType* src = points[m_indices[i]];
+			FloatType* dst = &m_points[(size_t)i * m_dimension];
+			for (UINT d = 0; d < m_dimension; d++) dst[d] = src[d];
+		}
+	}
+
+	void kNearestInternal(const FloatType *query, UINT k, FloatType epsilon, std::vector<UINT> &result) const
+	{
+		result.resize(k);
+		if (k == 0) return;
+		SearchState state;
+		initState(state, query);
+		state.queue.init(k, std::numeric_limits<FloatType>::max());
+		state.epsilonScale = ((FloatType)1 + epsilon) * ((FloatType)1 + epsilon);
+		if (m_numPoints > 0) searchKNearest(0, 0, m_numPoints, 0, (FloatType)0, state);
+		state.queue.writeResult(&result[0], nullptr);
+	}
+
+	void kNearestBatchInternal(const FloatType *queries, size_t numQueries, UINT k, FloatType epsilon, UINT *outIdx, FloatType *outDist) const
+	{
+		searchBatch(queries, numQueries, k, epsilon, std::numeric_limits<FloatType>::max(), outIdx, outDist);
+	}
+
+	void searchBatch(const FloatType *queries, size_t numQueries, UINT k, FloatType epsilon, FloatType maxDistSq, UINT *outIdx, FloatType *outDist) const
+	{
+#ifdef MLIB_OPENMP
+#pragma omp parallel
+#endif
+		{
+			SearchState state;
+			state.queue.init(k, maxDistSq);
+			state.epsilonScale = ((FloatType)1 + epsilon) * ((FloatType)1 + epsilon);
+			const int n = (int)numQueries;
+#ifdef MLIB_OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+			for (int q = 0; q < n; q++) {
+				initState(state, queries + (size_t)q * m_dimension);
+				state.queue.clear(maxDistSq);
+				if (m_numPoints > 0) searchKNearest(0, 0, m_numPoints, 0, (FloatType)0, state);
+				state.queue.writeResult(outIdx + (size_t)q * k, outDist ? outDist + (size_t)q * k : nullptr);
+			}
+		}
+	}
+
+	void fixedRadiusInternal(const FloatType *query, UINT k, FloatType radius, FloatType epsilon, std::vector<UINT> &result) const
+	{
+		std::vector< std::pair<UINT, FloatType> > resultDist;
+		fixedRadiusInternalDist(query, k, radius, epsilon, resultDist);
+		result.resize(resultDist.size());
+		for (size_t i = 0; i < resultDist.size(); i++) {
+			result[i] = resultDist[i].first;
+		}
+	}
+
+	//! returns the (at most k; all if k == 0) closest points within the radius, sorted by distance; with epsilon > 0, cells
+	//! farther away than radius / (1 + epsilon) are skipped, so only the points within that distance are guaranteed
+	void fixedRadiusInternalDist(const FloatType *query, UINT k, FloatType radius, FloatType epsilon, std::vector< std::pair<UINT, FloatType> > &result) const
+	{
+		SearchState state;
+		initState(state, query);
+		state.maxDistSq = radius * radius;
+		state.epsilonScale = ((FloatType)1 + epsilon) * ((FloatType)1 + epsilon);
+		if (m_numPoints > 0) searchRadius(0, 0, m_numPoints, 0, (FloatType)0, state);
+
+		std::vector< std::pair<UINT, FloatType> > &r = state.radiusResult;
+		auto byDistance = [](const std::pair<UINT, FloatType> &a, const std::pair<UINT, FloatType> &b) { return a.second < b.second || (a.second == b.second && a.first < b.first); };
+		if (k > 0 && r.size() > k) {
+			std::partial_sort(r.begin(), r.begin() + k, r.end(), byDistance);
+			r.resize(k);
+		}
+		else {
+			std::sort(r.begin(), r.end(), byDistance);
+		}
+		for (auto &e : r) e.second = std::sqrt(e.second);
+		result.swap(r);
+	}
+
+	void initState(SearchState &state, const FloatType *query) const
+	{
+		state.query = query;
+		state.offsets.assign(m_dimension, (FloatType)0);
+	}
+
+	//! point range of the j-th node on the given level
+	void nodeRange(UINT level, UINT j, UINT &begin, UINT &end) const
+	{
+		begin = 0;
+		end = m_numPoints;
+		for (UINT l = 0; l < level; l++) {
+			const UINT mid = begin + (end - begin) / 2;
+			if ((j >> (level - 1 - l)) & 1)	begin = mid;
+			else							end = mid;
+		}
+	}
+
+	void splitNode(const std::vector< const FloatType* > &points, UINT node, UINT begin, UINT end)
+	{
+		m_splitDim[node] = 0;
+		m_splitValue[node] = (FloatType)0;
+		if (begin == end) return;
+
+		//split along the dimension of largest spread
+		std::vector<FloatType> minValue(points[m_indices[begin]], points[m_indices[begin]] + m_dimension);
+		std::vector<FloatType> maxValue(minValue);
+		for (UINT i = begin + 1; i < end; i++) {
+			const FloatType* p = points[m_indices[i]];
+			for (UINT d = 0; d < m_dimension; d++) {
+				if (p[d] < minValue[d]) minValue[d] = p[d];
+				if (p[d] > maxValue[d]) maxValue[d] = p[d];
+			}
+		}
+		UINT splitDim = 0;
+		for (UINT d = 1; d < m_dimension; d++) {
+			if (maxValue[d] - minValue[d] > maxValue[splitDim] - minValue[splitDim]) splitDim = d;
+		}
+
+		const UINT mid = begin + (end - begin) / 2;
+		UINT* indices = m_indices.data();
+		std::nth_element(indices + begin, indices + mid, indices + end, [&](UINT a, UINT b) {
+			return points[a][splitDim] < points[b][splitDim];
+		});
+		m_splitDim[node] = splitDim;
+		m_splitValue[node] = points[indices[mid]][splitDim];
+	}
+
+	FloatType distSq(const FloatType* a, const FloatType* b) const
+	{
+		FloatType dist = (FloatType)0;
+		for (UINT d = 0; d < m_dimension; d++) {
+			const FloatType diff = a[d] - b[d];
+			dist += diff * diff;
+		}
+		return dist;
+	}
+
+	//! rd is the squared distance from the query to the cell of the node (see Arya and Mount's incremental distance calculation)
+	void searchKNearest(UINT node, UINT begin, UINT end, UINT level, FloatType rd, SearchState &state) const
+	{
+		if (level == m_depth) {
+			for (UINT i = begin; i < end; i++) {
+				const FloatType dist = distSq(state.query, &m_points[(size_t)i * m_dimension]);
+				if (dist < state.queue.queue().back().dist) state.queue.insert((int)m_indices[i], dist);
+			}
+			return;
+		}
+
+		const UINT dim = m_splitDim[node];
+		const FloatType diff = state.query[dim] - m_splitValue[node];
+		const UINT mid = begin + (end - begin) / 2;
+		const bool leftFirst = diff < (FloatType)0;
+
+		if (leftFirst)	searchKNearest(2 * node + 1, begin, mid, level + 1, rd, state);
+		else			searchKNearest(2 * node + 2, mid, end, level + 1, rd, state);
+
+		const FloatType oldOffset = state.offsets[dim];
+		const FloatType farRd = rd - oldOffset * oldOffset + diff * diff;
+		if (farRd * state.epsilonScale < state.queue.queue().back().dist) {
+			state.offsets[dim] = diff;
+			if (leftFirst)	searchKNearest(2 * node + 2, mid, end, level + 1, farRd, state);
+			else			searchKNearest(2 * node + 1, begin, mid, level + 1, farRd, state);
+			state.offsets[dim] = oldOffset;
+		}
+	}
+
+	void searchRadius(UINT node, UINT begin, UINT end, UINT level, FloatType rd, SearchState &state) const
+	{
+		if (level == m_depth) {
+			for (UINT i = begin; i < end; i++) {
+				const FloatType dist = distSq(state.query, &m_points[(size_t)i * m_dimension]);
+				if (dist <= state.maxDistSq) state.radiusResult.push_back(std::make_pair(m_indices[i], dist));
+			}
+			return;
+		}
+
+		const UINT dim = m_splitDim[node];
+		const FloatType diff = state.query[dim] - m_splitValue[node];
+		const UINT mid = begin + (end - begin) / 2;
+		const bool leftFirst = diff < (FloatType)0;
+
+		if (leftFirst)	searchRadius(2 * node + 1, begin, mid, level + 1, rd, state);
+		else			searchRadius(2 * node + 2, mid, end, level + 1, rd, state);
+
+		const FloatType oldOffset = state.offsets[dim];
+		const FloatType farRd = rd - oldOffset * oldOffset + diff * diff;
+		if (farRd * state.epsilonScale <= state.maxDistSq) {
+			state.offsets[dim] = diff;
+			if (leftFirst)	searchRadius(2 * node + 2, mid, end, level + 1, farRd, state);
+			else			searchRadius(2 * node + 1, begin, mid, level + 1, farRd, state);
+			state.offsets[dim] = oldOffset;
+		}
+	}
+
+	UINT m_bucketSize;
+	UINT m_dimension;
+	UINT m_numPoints;
+	UINT m_depth;						//leaves are on this level
+	std::vector<UINT> m_splitDim;		//2^depth - 1 internal nodes
+	std::vector<FloatType> m_splitValue;
+	std::vector<UINT> m_indices;		//original index of every point in leaf order
+	std::vector<FloatType> m_points;	//points in leaf order
+};
+
+typedef NearestNeighborSearchKdTree<float> NearestNeighborSearchKdTreef;
+typedef NearestNeighborSearchKdTree<double> NearestNeighborSearchKdTreed;
+
+}  // namespace ml
+
+#endif  // CORE_UTIL_NEARESTNEIGHBORSEARCHKDTREE_H_
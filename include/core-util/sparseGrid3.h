@@ -1,8 +1,9 @@
-
 #ifndef CORE_UTIL_SPARSEGRID3D_H_
 #define CORE_UTIL_SPARSEGRID3D_H_
 
 #include <functional>
+#include <atomic>
+#include <thread>
 #include <core-math/vec3.h>
 
 namespace std {
@@ -10,12 +11,16 @@ namespace std {
 template <>
 struct hash<ml::vec3i> : public std::unary_function<ml::vec3i, size_t> {
 	size_t operator()(const ml::vec3i& v) const {
-		//TODO larger prime number (64 bit) to match size_t
-		const size_t p0 = 73856093;
-		const size_t p1 = 19349669;
-		const size_t p2 = 83492791;
-		const size_t res = ((size_t)v.x * p0)^((size_t)v.y * p1)^((size_t)v.z * p2);
-		return res;
+		//64-bit prime products, followed by a finalizer so that neighboring cells spread over all bits
+		UINT64 h = (UINT64)(UINT)v.x * 0x9E3779B97F4A7C15ull;
+		h ^= (UINT64)(UINT)v.y * 0xC2B2AE3D27D4EB4Full;
+		h ^= (UINT64)(UINT)v.z * 0x165667B19E3779F9ull;
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDull;
+		h ^= h >> 33;
+		h *= 0xC4CEB9FE1A85EC53ull;
+		h ^= h >> 33;
+		return (size_t)h;
 	}
 };
 
@@ -26,31 +31,114 @@ namespace ml {
 template<class T> class SparseGrid3;
 template<class T> std::ostream& operator<<(std::ostream& s, const SparseGrid3<T>& g);
 
+//! hash map from vec3i to T with open addressing: a Robin Hood probed index table maps keys to elements. As in
+//! std::unordered_map, the elements are pairs with a const key; they are constructed once in block-allocated storage and
+//! never assigned over. A dense array of element pointers gives the iteration order (a linear scan), and a dense array
+//! of their keys is what the probing compares. Unlike in std::unordered_map, inserting or erasing elements invalidates
+//! iterators; references to an element stay valid until it is erased.
 template<class T>
 class SparseGrid3 {
 public:
-	typedef typename std::unordered_map<vec3i, T, std::hash<vec3i>>::iterator iterator;
-	typedef typename std::unordered_map<vec3i, T, std::hash<vec3i>>::const_iterator const_iterator;
-	iterator begin() {return m_Data.begin();}
-	iterator end() {return m_Data.end();}
-	const_iterator begin() const {return m_Data.begin();}
-	const_iterator end() const {return m_Data.end();}
-	
-	SparseGrid3(float maxLoadFactor = 0.6, size_t reserveBuckets = 64) {
-		m_Data.reserve(reserveBuckets);
-		m_Data.max_load_factor(maxLoadFactor);
+	typedef std::pair<const vec3i, T> Entry;
+
+	//! forward iterator over the element pointers; E is Entry or const Entry
+	template<class E>
+	class EntryIterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef E value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef E* pointer;
+		typedef E& reference;
+
+		EntryIterator() : m_ptr(nullptr) {}
+		explicit EntryIterator(Entry* const* ptr) : m_ptr(ptr) {}
+		//! iterator to const_iterator
+		EntryIterator(const EntryIterator<Entry>& other) : m_ptr(other.base()) {}
+
+		reference operator*() const {return **m_ptr;}
+		pointer operator->() const {return *m_ptr;}
+		EntryIterator& operator++() {
+			m_ptr++;
+			return *this;
+		}
+		EntryIterator operator++(int) {
+			EntryIterator it = *this;
+			m_ptr++;
+			return it;
+		}
+		template<class F> bool operator==(const EntryIterator<F>& other) const {return m_ptr == other.base();}
+		template<class F> bool operator!=(const EntryIterator<F>& other) const {return m_ptr != other.base();}
+
+		Entry* const* base() const {return m_ptr;}
+	private:
+		Entry* const* m_ptr;
+	};
+	typedef EntryIterator<Entry> iterator;
+	typedef EntryIterator<const Entry> const_iterator;
+	iterator begin() {return iterator(m_entries.data());}
+	iterator end() {return iterator(m_entries.data() + m_entries.size());}
+	const_iterator begin() const {return const_iterator(m_entries.data());}
+	const_iterator end() const {return const_iterator(m_entries.data() + m_entries.size());}
+
+	SparseGrid3(float maxLoadFactor = 0.6, size_t reserveBuckets = 64) : m_blockSize(0), m_blockUsed(0) {
+		m_maxLoadFactor = math::clamp(maxLoadFactor, 0.1f, 0.95f);
+		rehash(reserveBuckets);
+	}
+	SparseGrid3(const SparseGrid3& other) : m_keys(other.m_keys), m_slots(other.m_slots), m_maxLoadFactor(other.m_maxLoadFactor), m_blockSize(0), m_blockUsed(0) {
+		m_entries.reserve(other.m_entries.size());
+		for (const Entry* e : other.m_entries) m_entries.push_back(newEntry(e->first, e->second));
+	}
+	SparseGrid3(SparseGrid3&& other) : m_entries(std::move(other.m_entries)), m_keys(std::move(other.m_keys)), m_slots(std::move(other.m_slots)), m_maxLoadFactor(other.m_maxLoadFactor),
+		m_blocks(std::move(other.m_blocks)), m_blockSize(other.m_blockSize), m_blockUsed(other.m_blockUsed), m_freeStorage(std::move(other.m_freeStorage)) {
+		other.m_entries.clear();
+		other.m_blockSize = other.m_blockUsed = 0;
+	}
+	~SparseGrid3() {
+		destroyEntries();
+	}
+
+	SparseGrid3& operator=(SparseGrid3 other) {
+		swap(other);
+		return *this;
+	}
+	void swap(SparseGrid3& other) {
+		m_entries.swap(other.m_entries);
+		m_keys.swap(other.m_keys);
+		m_slots.swap(other.m_slots);
+		std::swap(m_maxLoadFactor, other.m_maxLoadFactor);
+		m_blocks.swap(other.m_blocks);
+		std::swap(m_blockSize, other.m_blockSize);
+		std::swap(m_blockUsed, other.m_blockUsed);
+		m_freeStorage.swap(other.m_freeStorage);
 	}
 
   size_t size() const {
-    return m_Data.size();
+    return m_entries.size();
   }
 
 	void clear() {
-		m_Data.clear();
+		destroyEntries();
+		m_keys.clear();
+		m_blocks.clear();
+		m_blockSize = m_blockUsed = 0;
+		m_freeStorage.clear();
+		std::fill(m_slots.begin(), m_slots.end(), EMPTY_SLOT);
+	}
+
+	//! makes room for numElements without growing the index table
+	void reserve(size_t numElements) {
+		m_entries.reserve(numElements);
+		m_keys.reserve(numElements);
+		if (numElements > maxElements()) rehash((size_t)((double)numElements / m_maxLoadFactor) + 1);
+	}
+
+	float getMaxLoadFactor() const {
+		return m_maxLoadFactor;
 	}
 
 	bool exists(const vec3i& i) const {
-		return (m_Data.find(i) != m_Data.end());
+		return findEntry(i, hashKey(i)) != INVALID_ENTRY;
 	}
 
 	bool exists(int x, int y, int z) const {
@@ -58,12 +146,17 @@ public:
 	}
 
 	const T& operator()(const vec3i& i) const {
-		return m_Data.find(i)->second;
+		const UINT entry = findEntry(i, hashKey(i));
+		assert(entry != INVALID_ENTRY);
+		return m_entries[entry]->second;
 	}
 
 	//! if the element does not exist, it will be created with its default constructor
 	T& operator()(const vec3i& i) {
-		return m_Data[i];
+		const UINT64 h = hashKey(i);
+		UINT entry = findEntry(i, h);
+		if (entry == INVALID_ENTRY) entry = insertNew(i, T(), h);
+		return m_entries[entry]->second;
 	}
 
 	const T& operator()(int x, int y, int z) const {
@@ -80,6 +173,151 @@ public:
 		return (*this)(i);
 	}
 
+	//! returns nullptr if the element does not exist
+	const T* find(const vec3i& i) const {
+		const UINT entry = findEntry(i, hashKey(i));
+		return entry == INVALID_ENTRY ? nullptr : &m_entries[entry]->second;
+	}
+	T* find(const vec3i& i) {
+		const UINT entry = findEntry(i, hashKey(i));
+		return entry == INVALID_ENTRY ? nullptr : &m_entries[entry]->second;
+	}
+
+	//! inserts or overwrites the element
+	void insert(const vec3i& i, const T& value) {
+		const UINT64 h = hashKey(i);
+		const UINT entry = findEntry(i, h);
+		if (entry == INVALID_ENTRY) insertNew(i, value, h);
+		else m_entries[entry]->second = value;
+	}
+
+	//! inserts or overwrites many elements; the keys are hashed in parallel and the table grows at most once
+	void insert(const std::vector<vec3i>& keys, const std::vector<T>& values) {
+		if (keys.size() != values.size()) throw MLIB_EXCEPTION("number of keys and values does not match");
+		const int numKeys = (int)keys.size();
+		std::vector<UINT64> hashes(numKeys);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int k = 0; k < numKeys; k++) {
+			hashes[k] = hashKey(keys[k]);
+		}
+		reserve(m_entries.size() + keys.size());
+		for (int k = 0; k < numKeys; k++) {
+			const UINT entry = findEntry(keys[k], hashes[k]);
+			if (entry == INVALID_ENTRY) insertNew(keys[k], values[k], hashes[k]);
+			else m_entries[entry]->second = values[k];
+		}
+	}
+
+	//! returns false if the element does not exist; the last element is moved into the freed place
+	bool erase(const vec3i& i) {
+		const size_t slot = findSlot(i, hashKey(i));
+		if (slot == INVALID_SLOT) return false;
+		const UINT entry = (UINT)m_slots[slot];
+
+		//backward shift deletion: pull the following displaced slots one step closer to their home
+		const size_t mask = m_slots.size() - 1;
+		size_t pos = slot;
+		for (;;) {
+			const size_t next = (pos + 1) & mask;
+			const UINT64 s = m_slots[next];
+			if (s == EMPTY_SLOT || probeDistance(s, next) == 0) break;
+			m_slots[pos] = s;
+			pos = next;
+		}
+		m_slots[pos] = EMPTY_SLOT;
+
+		const UINT last = (UINT)m_entries.size() - 1;
+		Entry* erased = m_entries[entry];
+		if (entry != last) {
+			const size_t lastSlot = findSlotOfEntry(last);
+			m_slots[lastSlot] = (m_slots[lastSlot] & 0xFFFFFFFF00000000ull) | entry;
+			m_entries[entry] = m_entries[last];
+			m_keys[entry] = m_keys[last];
+		}
+		m_entries.pop_back();
+		m_keys.pop_back();
+		deleteEntry(erased);
+		return true;
+	}
+
+	//! insertion from several threads at once: while the inserter exists, insert may be called concurrently, and no other
+	//! member function of the grid may be called. New keys go to a lock-free (CAS) linear probing table of their own and
+	//! are added to the grid by finish. An existing key is left as it is; of several concurrent insertions of the same
+	//! key, one wins, so the order of the new elements and the winning values depend on the thread schedule.
+	//! maxNewElements bounds the number of distinct new keys; insertions of existing or duplicate keys do not count.
+	class ConcurrentInserter {
+	public:
+		ConcurrentInserter(SparseGrid3& grid, size_t maxNewElements) : m_grid(grid), m_keys(maxNewElements), m_values(maxNewElements) {
+			m_numSlots = 16;
+			while (m_numSlots < 2 * maxNewElements) m_numSlots *= 2;
+			m_slots.reset(new std::atomic<UINT64>[m_numSlots]);
+			for (size_t i = 0; i < m_numSlots; i++) m_slots[i].store(0, std::memory_order_relaxed);
+			m_count.store(0);
+			m_overflow.store(false);
+		}
+
+		//! returns true if the key was new and this call inserted it; thread-safe
+		bool insert(const vec3i& i, const T& value) {
+			const UINT64 h = hashKey(i);
+			if (m_grid.findEntry(i, h) != INVALID_ENTRY) return false;
+
+			//slots hold the hash tag in the upper and the staging index + 1 in the lower half (0: empty). An empty slot is
+			//claimed with PENDING_INDEX first, so only the winner of the CAS reserves a staging index; the key and the value
+			//are written before the index is published, so a thread that reads the published slot sees them
+			const size_t mask = m_numSlots - 1;
+			const UINT64 tag = (UINT64)(UINT)h << 32;
+			size_t pos = (size_t)(UINT)h & mask;
+			for (size_t probe = 0; probe < m_numSlots; probe++, pos = (pos + 1) & mask) {
+				UINT64 s = m_slots[pos].load(std::memory_order_acquire);
+				if (s == 0 && m_slots[pos].compare_exchange_strong(s, tag | PENDING_INDEX, std::memory_order_acq_rel, std::memory_order_acquire)) {
+					const size_t index = m_count.fetch_add(1);
+					if (index >= m_keys.size()) {
+						m_overflow.store(true);
+						m_slots[pos].store(tag | DROPPED_INDEX, std::memory_order_release);
+						return false;
+					}
+					m_keys[index] = i;
+					m_values[index] = value;
+					m_slots[pos].store(tag | (UINT64)(index + 1), std::memory_order_release);
+					return true;
+				}
+				if ((s & 0xFFFFFFFF00000000ull) != tag) continue;
+				while ((UINT)s == PENDING_INDEX) {
+					std::this_thread::yield();
+					s = m_slots[pos].load(std::memory_order_acquire);
+				}
+				if ((UINT)s != DROPPED_INDEX && m_keys[(size_t)(UINT)s - 1] == i) return false;
+			}
+			m_overflow.store(true);
+			return false;
+		}
+
+		//! adds the new elements to the grid once all insertions are done (called once, not thread-safe); returns their number
+		size_t finish() {
+			if (m_overflow.load()) throw MLIB_EXCEPTION("more than " + std::to_string(m_keys.size()) + " new elements");
+			const size_t numNew = m_count.load();
+			m_grid.reserve(m_grid.size() + numNew);
+			for (size_t k = 0; k < numNew; k++) {
+				m_grid.insertNew(m_keys[k], m_values[k], hashKey(m_keys[k]));
+			}
+			return numNew;
+		}
+
+	private:
+		static const UINT64 PENDING_INDEX = 0xFFFFFFFFull;
+		static const UINT64 DROPPED_INDEX = 0xFFFFFFFEull;
+
+		SparseGrid3& m_grid;
+		std::vector<vec3i> m_keys;
+		std::vector<T> m_values;
+		std::unique_ptr<std::atomic<UINT64>[]> m_slots;
+		size_t m_numSlots;
+		std::atomic<size_t> m_count;
+		std::atomic<bool> m_overflow;
+	};
+
 #ifdef _WIN32
 	template<class U>
 #endif
@@ -99,8 +337,8 @@ public:
 
 	void writeBinaryDump(const std::string& s) const {
 		std::ofstream fout(s, std::ios::binary);
-		size_t size = m_Data.size();
-		float maxLoadFactor = m_Data.max_load_factor();
+		size_t size = m_entries.size();
+		float maxLoadFactor = m_maxLoadFactor;
 		fout.write((const char*)&size, sizeof(size_t));
 		fout.write((const char*)&maxLoadFactor, sizeof(float));
 		for (auto iter = begin(); iter != end(); iter++) {
@@ -113,35 +351,155 @@ public:
 	}
 
 	void readBinaryDump(const std::string& s) {
-		m_Data.clear();
+		clear();
 		std::ifstream fin(s, std::ios::binary);
 		if (!fin.is_open()) throw MLIB_EXCEPTION("file not found " + s);
 		size_t size; float maxLoadFactor;
 		fin.read((char*)&size, sizeof(size_t));
 		fin.read((char*)&maxLoadFactor, sizeof(float));
+		setMaxLoadFactor(maxLoadFactor);
+		reserve(size);
 		for (size_t i = 0; i < size; i++) {
 			ml::vec3i first; T second;
 			fin.read((char*)&first, sizeof(ml::vec3i));
 			assert(fin.good());
 			fin.read((char*)&second, sizeof(T));
 			assert(fin.good());
-			m_Data[first] = second;
+			insert(first, second);
 		}
 		fin.close();
 	}
 
+	void setMaxLoadFactor(float maxLoadFactor) {
+		m_maxLoadFactor = math::clamp(maxLoadFactor, 0.1f, 0.95f);
+		if (m_entries.size() > maxElements()) rehash((size_t)((double)m_entries.size() / m_maxLoadFactor) + 1);
+	}
+
+protected:
+	//! a slot holds the low 32 bits of the key hash (which also give the home slot) in its upper half and the entry index in its lower half
+	static const UINT64 EMPTY_SLOT = ~0ull;
+	static const size_t INVALID_SLOT = (size_t)-1;
+	static const UINT INVALID_ENTRY = (UINT)-1;
+
+	static UINT64 hashKey(const vec3i& i) {
+		return (UINT64)std::hash<vec3i>()(i);
+	}
+	static UINT64 makeSlot(UINT64 h, UINT entry) {
+		return (h << 32) | entry;
+	}
+	size_t probeDistance(UINT64 s, size_t pos) const {
+		return (pos - (size_t)(s >> 32)) & (m_slots.size() - 1);
+	}
+	size_t maxElements() const {
+		return (size_t)((double)m_slots.size() * m_maxLoadFactor);
+	}
+
+	size_t findSlot(const vec3i& i, UINT64 h) const {
+		const size_t mask = m_slots.size() - 1;
+		const UINT hashTag = (UINT)h;
+		size_t pos = (size_t)hashTag & mask;
+		for (size_t dist = 0;; dist++, pos = (pos + 1) & mask) {
+			const UINT64 s = m_slots[pos];
+			if (s == EMPTY_SLOT || probeDistance(s, pos) < dist) return INVALID_SLOT;
+			if ((UINT)(s >> 32) == hashTag && m_keys[(UINT)s] == i) return pos;
+		}
+	}
+	UINT findEntry(const vec3i& i, UINT64 h) const {
+		const size_t slot = findSlot(i, h);
+		return slot == INVALID_SLOT ? INVALID_ENTRY : (UINT)m_slots[slot];
+	}
+	size_t findSlotOfEntry(UINT entry) const {
+		const size_t mask = m_slots.size() - 1;
+		size_t pos = (size_t)(UINT)hashKey(m_keys[entry]) & mask;
+		while ((UINT)m_slots[pos] != entry) pos = (pos + 1) & mask;
+		return pos;
+	}
 
+	//! the key must not exist yet
+	UINT insertNew(const vec3i& i, const T& value, UINT64 h) {
+		if (m_entries.size() + 1 > maxElements()) rehash(m_slots.size() * 2);
+		const UINT entry = (UINT)m_entries.size();
+		m_entries.push_back(newEntry(i, value));
+		m_keys.push_back(i);
+		insertSlot(makeSlot((UINT)h, entry));
+		return entry;
+	}
+	void insertSlot(UINT64 s) {
+		const size_t mask = m_slots.size() - 1;
+		size_t pos = (size_t)(s >> 32) & mask;
+		for (size_t dist = 0;; dist++, pos = (pos + 1) & mask) {
+			const UINT64 current = m_slots[pos];
+			if (current == EMPTY_SLOT) {
+				m_slots[pos] = s;
+				return;
+			}
+			//Robin Hood: the slot closer to its home gives way
+			const size_t currentDist = probeDistance(current, pos);
+			if (currentDist < dist) {
+				m_slots[pos] = s;
+				s = current;
+				dist = currentDist;
+			}
+		}
+	}
+	//! rebuilds the index table with a power of two >= numSlots slots
+	void rehash(size_t numSlots) {
+		size_t capacity = 16;
+		while (capacity < numSlots) capacity *= 2;
+		m_slots.assign(capacity, EMPTY_SLOT);
+		for (UINT e = 0; e < (UINT)m_entries.size(); e++) {
+			insertSlot(makeSlot((UINT)hashKey(m_keys[e]), e));
+		}
+	}
 
+	//! constructs an element in free or new block storage; the blocks grow with the number of elements
+	Entry* newEntry(const vec3i& i, const T& value) {
+		void* storage;
+		if (!m_freeStorage.empty()) {
+			storage = m_freeStorage.back();
+			m_freeStorage.pop_back();
+		}
+		else {
+			if (m_blockUsed == m_blockSize) {
+				m_blockSize = std::max((size_t)64, m_entries.size());
+				m_blocks.push_back(std::unique_ptr<EntryStorage[]>(new EntryStorage[m_blockSize]));
+				m_blockUsed = 0;
+			}
+			storage = &m_blocks.back()[m_blockUsed++];
+		}
+		return new (storage) Entry(i, value);
+	}
+	void deleteEntry(Entry* e) {
+		e->~Entry();
+		m_freeStorage.push_back(e);
+	}
+	void destroyEntries() {
+		for (Entry* e : m_entries) e->~Entry();
+		m_entries.clear();
+	}
 
+	typedef typename std::aligned_storage<sizeof(Entry), std::alignment_of<Entry>::value>::type EntryStorage;
 
+	std::vector<Entry*> m_entries;		//elements in iteration order
+	std::vector<vec3i> m_keys;			//m_keys[e] == m_entries[e]->first
+	std::vector<UINT64> m_slots;
+	float m_maxLoadFactor;
 
-protected:
-	std::unordered_map<vec3i, T, std::hash<vec3i>> m_Data;
+	std::vector<std::unique_ptr<EntryStorage[]>> m_blocks;
+	size_t m_blockSize;					//capacity and number of used elements of the last block
+	size_t m_blockUsed;
+	std::vector<void*> m_freeStorage;	//storage of erased elements
 };
 
+template<class T> const UINT64 SparseGrid3<T>::EMPTY_SLOT;
+template<class T> const size_t SparseGrid3<T>::INVALID_SLOT;
+template<class T> const UINT SparseGrid3<T>::INVALID_ENTRY;
+template<class T> const UINT64 SparseGrid3<T>::ConcurrentInserter::PENDING_INDEX;
+template<class T> const UINT64 SparseGrid3<T>::ConcurrentInserter::DROPPED_INDEX;
+
 template<class T>
 inline std::ostream& operator<<(std::ostream& s, const SparseGrid3<T>& g) {
-	for (auto iter = g.m_Data.begin(); iter != g.m_Data.end(); iter++) {
+	for (auto iter = g.begin(); iter != g.end(); iter++) {
 		s << "\t" << iter->first << "\t: " << iter->second << std::endl;
 	}
 	return s;
@@ -154,7 +512,8 @@ inline BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& operator>>(Bina
 	g.clear();
 	size_t size;	float maxLoadFactor;
 	s >> size >> maxLoadFactor;
-	g.m_Data.max_load_factor(maxLoadFactor);
+	g.setMaxLoadFactor(maxLoadFactor);
+	g.reserve(size);
 	for (size_t i = 0; i < size; i++) {
 		vec3i first;	T second;
 		s >> first >> second;
@@ -165,8 +524,8 @@ inline BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& operator>>(Bina
 //! write to binary stream overload
 template<class BinaryDataBuffer, class BinaryDataCompressor, class T>
 inline BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& operator<<(BinaryDataStream<BinaryDataBuffer, BinaryDataCompressor>& s, const SparseGrid3<T>& g) {
-	s << g.m_Data.size();
-	s << g.m_Data.max_load_factor();
+	s << g.size();
+	s << g.getMaxLoadFactor();
 	for (auto iter = g.begin(); iter != g.end(); iter++) {
 		s << iter->first << iter->second;
 	}
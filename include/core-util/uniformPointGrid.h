@@ -0,0 +1,303 @@
+#ifndef CORE_UTIL_UNIFORMPOINTGRID_H_
+#define CORE_UTIL_UNIFORMPOINTGRID_H_
+
+namespace ml
+{
+
+//! compacted uniform grid over 3D points for radius and kNN queries (e.g., SPH neighborhoods)
+//! the points are counting-sorted by cell: every cell (slot) owns a contiguous range [m_slotStart[s], m_slotStart[s+1])
+//! of the reordered point array. In dense mode the slots are the cells of the bounding box; in hashed mode the cell
+//! coordinates are hashed into a fixed number of slots, which supports unbounded extents (cells that collide in a slot
+//! are told apart by recomputing the cell of every point). The build is parallel (except for the O(n) scatter) and
+//! deterministic.
+template<class FloatType>
+class UniformPointGrid
+{
+public:
+	enum Mode {
+		MODE_AUTO = 0,		//dense unless the bounding box has too many (empty) cells
+		MODE_DENSE = 1,
+		MODE_HASHED = 2
+	};
+
+	UniformPointGrid() {
+		m_cellSize = (FloatType)1;
+		m_invCellSize = (FloatType)1;
+		m_hashed = false;
+	}
+	UniformPointGrid(const std::vector<vec3<FloatType>>& points, FloatType cellSize, Mode mode = MODE_AUTO) {
+		build(points, cellSize, mode);
+	}
+
+	void build(const std::vector<vec3<FloatType>>& points, FloatType cellSize, Mode mode = MODE_AUTO) {
+		build(points.empty() ? nullptr : points.data(), points.size(), cellSize, mode);
+	}
+
+	void build(const vec3<FloatType>* points, size_t numPoints, FloatType cellSize, Mode mode = MODE_AUTO) {
+		if (cellSize <= (FloatType)0) throw MLIB_EXCEPTION("invalid cell size");
+		if (numPoints >= (size_t)std::numeric_limits<int>::max()) throw MLIB_EXCEPTION("too many points for the grid");
+		m_cellSize = cellSize;
+		m_invCellSize = (FloatType)1 / cellSize;
+		const int n = (int)numPoints;
+
+		//cell range of the points (world-aligned cells, so hashed grids are independent of the data)
+		m_minCell = vec3i(std::numeric_limits<int>::max());
+		m_maxCell = vec3i(std::numeric_limits<int>::min());
+		for (int i = 0; i < n; i++) {
+			const vec3i c = toCell(points[i]);
+			m_minCell = vec3i(std::min(m_minCell.x, c.x), std::min(m_minCell.y, c.y), std::min(m_minCell.z, c.z));
+			m_maxCell = vec3i(std::max(m_maxCell.x, c.x), std::max(m_maxCell.y, c.y), std::max(m_maxCell.z, c.z));
+		}
+		if (n == 0) m_minCell = m_maxCell = vec3i(0, 0, 0);
+		const double numCells =
+			((double)m_maxCell.x - (double)m_minCell.x + 1.0) *
+			((double)m_maxCell.y - (double)m_minCell.y + 1.0) *
+			((double)m_maxCell.z - (double)m_minCell.z + 1.0);
+		const double maxDenseCells = std::max((double)(1 << 22), 8.0 * (double)numPoints);
+		if (mode == MODE_DENSE && numCells > (double)std::numeric_limits<UINT>::max() - 1) throw MLIB_EXCEPTION("too many cells for a dense grid");
+		m_hashed = mode == MODE_HASHED || (mode == MODE_AUTO && numCells > maxDenseCells);
+
+		size_t numSlots;
+		if (m_hashed) {
+			numSlots = 1024;
+			while (numSlots < 2 * numPoints) numSlots *= 2;
+		}
+		else {
+			m_dims = vec3ui(m_maxCell - m_minCell) + vec3ui(1, 1, 1);
+			numSlots = (size_t)m_dims.x * m_dims.y * m_dims.z;
+		}
+		m_slotMask = (UINT)(numSlots - 1);
+
+		//counting sort: slot of every point, slot sizes, prefix sum, scatter
+		std::vector<UINT> pointSlot(numPoints);
+		m_slotStart.clear();
+		m_slotStart.resize(numSlots + 1, 0);
+		UINT* counts = m_slotStart.data() + 1;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int i = 0; i < n; i++) {
+			const UINT s = slot(toCell(points[i]));
+			pointSlot[i] = s;
+#ifdef MLIB_OPENMP
+#pragma omp atomic
+#endif
+			counts[s]++;
+		}
+		for (size_t s = 0; s < numSlots; s++) {
+			m_slotStart[s + 1] += m_slotStart[s];
+		}
+
+		//filling in point order keeps every slot sorted by index, so the layout does not depend on the thread count
+		m_indices.resize(numPoints);
+		std::vector<UINT> cursor(m_slotStart.begin(), m_slotStart.end() - 1);
+		for (int i = 0; i < n; i++) {
+			m_indices[cursor[pointSlot[i]]++] = (UINT)i;
+		}
+
+		m_points.resize(numPoints);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int i = 0; i < n; i++) {
+			m_points[i] = points[m_indices[i]];
+		}
+	}
+
+	bool isHashed() const {
+		return m_hashed;
+	}
+	size_t getNumPoints() const {
+		return m_points.size();
+	}
+	FloatType getCellSize() const {
+		return m_cellSize;
+	}
+	//! points in grid order and their original indices
+	const std::vector<vec3<FloatType>>& getSortedPoints() const {
+		return m_points;
+	}
+	const std::vector<UINT>& getSortedIndices() const {
+		return m_indices;
+	}
+
+	//! calls callback(UINT index, FloatType distSq) for every point within the radius (in grid order)
+	template<class Callback>
+	void forEachInRadius(const vec3<FloatType>& query, FloatType radius, Callback callback) const {
+		MLIB_ASSERT(radius >= (FloatType)0);
+		if (m_points.empty()) return;
+		const FloatType radiusSq = radius * radius;
+		const vec3<FloatType> r(radius, radius, radius);
+		const vec3i lo = clampCell(toCell(query - r));
+		const vec3i hi = clampCell(toCell(query + r));
+		for (int z = lo.z; z <= hi.z; z++) {
+			for (int y = lo.y; y <= hi.y; y++) {
+				for (int x = lo.x; x <= hi.x; x++) {
+					visitCell(vec3i(x, y, z), [&](UINT i) {
+						const FloatType distSq = vec3<FloatType>::distSq(m_points[i], query);
+						if (distSq <= radiusSq) callback(m_indices[i], distSq);
+					});
+				}
+			}
+		}
+	}
+
+	//! (index, squared distance) of all points within the radius; unsorted
+	void radiusSearch(const vec3<FloatType>& query, FloatType radius, std::vector< std::pair<UINT, FloatType> >& result) const {
+		result.clear();
+		forEachInRadius(query, radius, [&](UINT index, FloatType distSq) { result.push_back(std::make_pair(index, distSq)); });
+	}
+
+	//! neighbors of query q are neighbors[offsets[q]] ... neighbors[offsets[q+1]-1] (in grid order)
+	void radiusSearchBatch(const vec3<FloatType>* queries, size_t numQueries, FloatType radius, std::vector<UINT>& offsets, std::vector<UINT>& neighbors) const {
+		const int n = (int)numQueries;
+		offsets.clear();
+		offsets.resize(numQueries + 1, 0);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+		for (int q = 0; q < n; q++) {
+			UINT count = 0;
+			forEachInRadius(queries[q], radius, [&](UINT, FloatType) { count++; });
+			offsets[q + 1] = count;
+		}
+		for (size_t q = 0; q < numQueries; q++) {
+			offsets[q + 1] += offsets[q];
+		}
+		neighbors.resize(offsets.back());
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+		for (int q = 0; q < n; q++) {
+			UINT* out = neighbors.data() + offsets[q];
+			forEachInRadius(queries[q], radius, [&](UINT index, FloatType) { *out++ = index; });
+		}
+	}
+
+	//! k nearest points by expanding rings of cells; writes k entries sorted by distance (Euclidean), missing ones are
+	//! (UINT)-1 and std::numeric_limits<FloatType>::max() (see NearestNeighborSearch::kNearestBatch); outDist may be null
+	void kNearest(const vec3<FloatType>& query, UINT k, UINT* outIdx, FloatType* outDist) const {
+		KNearestNeighborHeap<FloatType> heap;
+		kNearestInternal(query, k, heap, outIdx, outDist);
+	}
+
+	void kNearestBatch(const vec3<FloatType>* queries, size_t numQueries, UINT k, UINT* outIdx, FloatType* outDist) const {
+		const int n = (int)numQueries;
+#ifdef MLIB_OPENMP
+#pragma omp parallel
+#endif
+		{
+			KNearestNeighborHeap<FloatType> heap;
+#ifdef MLIB_OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+			for (int q = 0; q < n; q++) {
+				kNearestInternal(queries[q], k, heap, outIdx + (size_t)q * k, outDist ? outDist + (size_t)q * k : nullptr);
+			}
+		}
+	}
+
+private:
+	vec3i toCell(const vec3<FloatType>& p) const {
+		return vec3i((int)std::floor(p.x * m_invCellSize), (int)std::floor(p.y * m_invCellSize), (int)std::floor(p.z * m_invCellSize));
+	}
+
+	//! cells outside the range of the points are empty
+	vec3i clampCell(const vec3i& c) const {
+		return vec3i(math::clamp(c.x, m_minCell.x, m_maxCell.x), math::clamp(c.y, m_minCell.y, m_maxCell.y), math::clamp(c.z, m_minCell.z, m_maxCell.z));
+	}
+
+	UINT slot(const vec3i& c) const {
+		if (m_hashed) {
+			return (UINT)std::hash<vec3i>()(c) & m_slotMask;
+		}
+		const vec3i l = c - m_minCell;
+		return (UINT)l.x + m_dims.x * ((UINT)l.y + m_dims.y * (UINT)l.z);
+	}
+
+	//! calls f(i) for every point i (in grid order) of the cell; the cell must be inside [m_minCell, m_maxCell]
+	template<class Visitor>
+	void visitCell(const vec3i& c, Visitor f) const {
+		const UINT s = slot(c);
+		const UINT end = m_slotStart[s + 1];
+		if (m_hashed) {
+			for (UINT i = m_slotStart[s]; i < end; i++) {
+				if (toCell(m_points[i]) == c) f(i);
+			}
+		}
+		else {
+			for (UINT i = m_slotStart[s]; i < end; i++) f(i);
+		}
+	}
+
+	void kNearestInternal(const vec3<FloatType>& query, UINT k, KNearestNeighborHeap<FloatType>& heap, UINT* outIdx, FloatType* outDist) const {
+		heap.init(k);
+		if (k > 0 && !m_points.empty()) {
+			const vec3i center = toCell(query);
+			//rings beyond this one cannot contain points
+			const int maxRing = std::max(std::max(
+				std::max(std::abs(center.x - m_minCell.x), std::abs(m_maxCell.x - center.x)),
+				std::max(std::abs(center.y - m_minCell.y), std::abs(m_maxCell.y - center.y))),
+				std::max(std::abs(center.z - m_minCell.z), std::abs(m_maxCell.z - center.z)));
+
+			auto insert = [&](UINT i) {
+				heap.insert(m_indices[i], vec3<FloatType>::distSq(m_points[i], query));
+			};
+			//the first ring that can contain points
+			const int minRing = std::max(std::max(
+				std::max(m_minCell.x - center.x, center.x - m_maxCell.x),
+				std::max(m_minCell.y - center.y, center.y - m_maxCell.y)),
+				std::max(std::max(m_minCell.z - center.z, center.z - m_maxCell.z), 0));
+
+			double visitedCells = 0.0;
+			for (int ring = minRing; ring <= maxRing; ring++) {
+				//points outside of rings 0..ring-1 are at least (ring-1)*cellSize away; stop once the heap is full and closer
+				const FloatType bound = (FloatType)(ring - 1) * m_cellSize;
+				if (ring > 0 && bound > (FloatType)0 && heap.worst() <= bound * bound) break;
+
+				const vec3i lo(std::max(center.x - ring, m_minCell.x), std::max(center.y - ring, m_minCell.y), std::max(center.z - ring, m_minCell.z));
+				const vec3i hi(std::min(center.x + ring, m_maxCell.x), std::min(center.y + ring, m_maxCell.y), std::min(center.z + ring, m_maxCell.z));
+
+				//in very sparse grids (e.g., a far outlier) scanning all points is cheaper than visiting the empty cells
+				visitedCells += ((double)hi.x - lo.x + 1.0) * ((double)hi.y - lo.y + 1.0) * ((double)hi.z - lo.z + 1.0);
+				if (visitedCells > 2.0 * (double)m_points.size() + 1024.0) {
+					heap.init(k);
+					for (UINT i = 0; i < (UINT)m_points.size(); i++) insert(i);
+					break;
+				}
+
+				for (int z = lo.z; z <= hi.z; z++) {
+					for (int y = lo.y; y <= hi.y; y++) {
+						const bool innerYZ = std::abs(z - center.z) < ring && std::abs(y - center.y) < ring;
+						for (int x = lo.x; x <= hi.x; x++) {
+							//only the shell of the ring (the interior was visited before)
+							if (innerYZ && std::abs(x - center.x) < ring) {
+								x = center.x + ring - 1;
+								continue;
+							}
+							visitCell(vec3i(x, y, z), insert);
+						}
+					}
+				}
+			}
+		}
+		if (k > 0) heap.writeResult(outIdx, outDist);
+	}
+
+	FloatType m_cellSize;
+	FloatType m_invCellSize;
+	bool m_hashed;
+	vec3i m_minCell, m_maxCell;		//cell range of the points
+	vec3ui m_dims;
+	UINT m_slotMask;				//hashed mode: number of slots - 1
+	std::vector<UINT> m_slotStart;	//number of slots + 1
+	std::vector<UINT> m_indices;	//original index of every point in grid order
+	std::vector<vec3<FloatType>> m_points;
+};
+
+typedef UniformPointGrid<float> UniformPointGridf;
+typedef UniformPointGrid<double> UniformPointGridd;
+
+}  // namespace ml
+
+#endif  // CORE_UTIL_UNIFORMPOINTGRID_H_
@@ -255,6 +255,21 @@ namespace math
 		return (((i + (i >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
 	}
 
+	//! index of the lowest set bit (i must not be 0)
+	inline unsigned int lowestSetBit(unsigned int i) {
+		return numberOfSetBits((i & (~i + 1)) - 1);
+	}
+
+	//! index of the highest set bit (i must not be 0)
+	inline unsigned int highestSetBit(unsigned int i) {
+		i |= i >> 1;
+		i |= i >> 2;
+		i |= i >> 4;
+		i |= i >> 8;
+		i |= i >> 16;
+		return numberOfSetBits(i) - 1;
+	}
+
 	//! generates a random number (uniform distribution)
 	template<typename T>
 	inline T randomUniform(T _min, T _max) {
@@ -324,6 +339,47 @@ namespace util
         }
     }
 
+	//! sorts chunks in parallel and merges them pairwise; the chunking only depends on the size, so the result does not
+	//! depend on the number of threads (like std::sort, the order of equivalent elements is unspecified)
+	template<class T, class Compare>
+	void parallelSort(std::vector<T> &v, Compare comp) {
+		const size_t minChunkSize = 1 << 14;
+		size_t numChunks = 1;
+		while (numChunks < 64 && v.size() / (numChunks * 2) >= minChunkSize) numChunks *= 2;
+		if (numChunks == 1) {
+			std::sort(v.begin(), v.end(), comp);
+			return;
+		}
+		auto chunkBegin = [&](size_t c) { return v.size() * c / numChunks; };
+
+		const int numChunksI = (int)numChunks;
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+		for (int c = 0; c < numChunksI; c++) {
+			std::sort(v.begin() + chunkBegin(c), v.begin() + chunkBegin(c + 1), comp);
+		}
+
+		std::vector<T> tmp(v.size());
+		for (size_t width = 1; width < numChunks; width *= 2) {
+			const int numMerges = (int)(numChunks / (2 * width));
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int m = 0; m < numMerges; m++) {
+				const size_t begin = chunkBegin(2 * m * width);
+				const size_t mid = chunkBegin((2 * m + 1) * width);
+				const size_t end = chunkBegin((2 * m + 2) * width);
+				std::merge(v.begin() + begin, v.begin() + mid, v.begin() + mid, v.begin() + end, tmp.begin() + begin, comp);
+			}
+			v.swap(tmp);
+		}
+	}
+	template<class T>
+	void parallelSort(std::vector<T> &v) {
+		parallelSort(v, std::less<T>());
+	}
+
 	inline std::string getTimeString() {
 		auto t = std::time(nullptr);
 		auto tm = *std::localtime(&t);
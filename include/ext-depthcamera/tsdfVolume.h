@@ -0,0 +1,374 @@
+#ifndef EXT_DEPTHCAMERA_TSDFVOLUME_H_
+#define EXT_DEPTHCAMERA_TSDFVOLUME_H_
+
+namespace ml {
+
+	//! volumetric fusion of depth (and color) frames into a truncated signed distance field (Curless and Levoy; the sparse
+	//! block layout follows voxel hashing by Niessner et al.), on the CPU. Voxels are stored in a SparseBlockGrid3; voxel c is
+	//! located at c * voxelSize in world space. Each frame allocates the blocks along the truncation band of its depth rays,
+	//! then integrates these blocks in parallel. The surface can be raycast (predicted depth and normals, e.g., for tracking)
+	//! or extracted as a mesh, where only the blocks changed since the last extraction are meshed again.
+	class TSDFVolume {
+	public:
+		struct Voxel {
+			Voxel() : sdf(0.0f), weight(0.0f), color(0, 0, 0) {}
+			float sdf;		//signed distance in world units (positive in front of the surface), clamped to the truncation
+			float weight;	//0 if the voxel was never observed
+			vec3uc color;
+		};
+		typedef SparseBlockGrid3<Voxel> Grid;
+
+		//! truncation <= 0 selects 4 voxels
+		TSDFVolume(float voxelSize = 0.01f, float truncation = 0.0f, float maxWeight = 255.0f) {
+			m_voxelSize = voxelSize;
+			m_truncation = truncation > 0.0f ? truncation : 4.0f * voxelSize;
+			m_maxWeight = maxWeight;
+		}
+
+		void clear() {
+			m_grid.clear();
+			m_blockMeshes.clear();
+			m_dirtyBlocks.clear();
+		}
+
+		float getVoxelSize() const {
+			return m_voxelSize;
+		}
+		float getTruncation() const {
+			return m_truncation;
+		}
+		const Grid& getGrid() const {
+			return m_grid;
+		}
+
+		mat4f getVoxelToWorld() const {
+			return mat4f::scale(m_voxelSize);
+		}
+		mat4f getWorldToVoxel() const {
+			return mat4f::scale(1.0f / m_voxelSize);
+		}
+
+		//! integrates a depth map (invalid pixels must be outside [minDepth, maxDepth]) seen from cameraToWorld; color is optional
+		//! and is looked up through depthToColor (depth camera to color camera space) and the color intrinsics
+		void integrate(const DepthImage32& depth, const mat4f& depthIntrinsic, const mat4f& cameraToWorld,
+			const ColorImageR8G8B8* color = nullptr, const mat4f& colorIntrinsic = mat4f::identity(), const mat4f& depthToColor = mat4f::identity(),
+			float minDepth = 0.1f, float maxDepth = 5.0f) {
+
+			std::vector<vec3i> blocks;
+			allocateBlocks(depth, depthIntrinsic, cameraToWorld, minDepth, maxDepth, blocks);
+
+			const mat4f voxelToCamera = cameraToWorld.getInverse() * getVoxelToWorld();
+			const int numBlocks = (int)blocks.size();
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+			for (int b = 0; b < numBlocks; b++) {
+				integrateBlock(blocks[b], *m_grid.findBlock(blocks[b]), depth, depthIntrinsic, voxelToCamera, color, colorIntrinsic, depthToColor, minDepth, maxDepth);
+			}
+
+			//a block's cells also reach into the first voxels of its upper neighbors
+			for (const vec3i& b : blocks) {
+				for (int i = 0; i < 8; i++) {
+					m_dirtyBlocks.insert(b - vec3i(i & 1, (i >> 1) & 1, i >> 2));
+				}
+			}
+		}
+
+		//! integrates a frame of a sensor data file; frames without a valid camera pose are skipped
+		void integrate(const SensorData& sensorData, size_t frameIdx, float minDepth = 0.1f, float maxDepth = 5.0f) {
+			const SensorData::RGBDFrame& frame = sensorData.m_frames[frameIdx];
+			const mat4f& cameraToWorld = frame.getCameraToWorld();
+			if (cameraToWorld(0, 0) == -std::numeric_limits<float>::infinity()) return;
+
+			const DepthImage32 depth = sensorData.computeDepthImage(frame);
+			if (frame.getColorCompressed() == nullptr) {
+				integrate(depth, sensorData.m_calibrationDepth.m_intrinsic, cameraToWorld, nullptr, mat4f::identity(), mat4f::identity(), minDepth, maxDepth);
+			}
+			else {
+				const ColorImageR8G8B8 color = sensorData.computeColorImage(frame);
+				integrate(depth, sensorData.m_calibrationDepth.m_intrinsic, cameraToWorld, &color, sensorData.m_calibrationColor.m_intrinsic,
+					sensorData.m_calibrationDepth.m_extrinsic, minDepth, maxDepth);
+			}
+		}
+
+		//! trilinear distance at a voxel-space position; false if one of the eight voxels was not observed
+		bool sampleSDF(Grid::ConstAccessor& accessor, const vec3f& p, float& sdf) const {
+			const vec3i c((int)std::floor(p.x), (int)std::floor(p.y), (int)std::floor(p.z));
+			const vec3f t = p - vec3f(c);
+			float v[8];
+			for (int i = 0; i < 8; i++) {
+				const Voxel& voxel = accessor.getValue(c + vec3i(i & 1, (i >> 1) & 1, i >> 2));
+				if (voxel.weight == 0.0f) return false;
+				v[i] = voxel.sdf;
+			}
+			const float x0 = v[0] + (v[1] - v[0]) * t.x, x1 = v[2] + (v[3] - v[2]) * t.x;
+			const float x2 = v[4] + (v[5] - v[4]) * t.x, x3 = v[6] + (v[7] - v[6]) * t.x;
+			const float y0 = x0 + (x1 - x0) * t.y, y1 = x2 + (x3 - x2) * t.y;
+			sdf = y0 + (y1 - y0) * t.z;
+			return true;
+		}
+
+		//! renders the surface seen from cameraToWorld: camera-space depth and world-space normals (invalid where no surface was hit);
+		//! rays skip unallocated blocks and step by the distance elsewhere. Parallel over the rows.
+		void raycast(const mat4f& cameraToWorld, const mat4f& intrinsic, unsigned int width, unsigned int height,
+			DepthImage32& depth, PointImage* normals = nullptr, float minDepth = 0.1f, float maxDepth = 5.0f) const {
+
+			depth.allocate(width, height);
+			depth.setPixels(depth.getInvalidValue());
+			if (normals) {
+				normals->allocate(width, height);
+				normals->setPixels(normals->getInvalidValue());
+			}
+
+			const mat4f cameraToVoxel = getWorldToVoxel() * cameraToWorld;
+			const mat4f intrinsicInverse = intrinsic.getInverse();
+			const vec3f origin = cameraToVoxel.transformAffine(vec3f::origin);
+
+#ifdef MLIB_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+			for (int y = 0; y < (int)height; y++) {
+				Grid::ConstAccessor accessor = m_grid.getAccessor();
+				for (unsigned int x = 0; x < width; x++) {
+					//ray in voxel space, parameterized by camera depth
+					const vec3f dirCamera = intrinsicInverse.transformAffine(vec3f((float)x, (float)y, 1.0f));
+					const vec3f dir = cameraToVoxel.transformAffine(dirCamera) - origin;
+					const float voxelsPerDepth = dir.length();
+
+					float t = minDepth, prevT = t, prevSDF = 0.0f;
+					bool prevValid = false;
+					while (t < maxDepth) {
+						const vec3f p = origin + dir * t;
+						float sdf;
+						if (!sampleSDF(accessor, p, sdf)) {
+							prevValid = false;
+							const vec3i blockCoord = Grid::toBlockCoord(vec3i((int)std::floor(p.x), (int)std::floor(p.y), (int)std::floor(p.z)));
+							if (m_grid.findBlock(blockCoord) == nullptr)	t = distanceToBlockExit(p, dir, blockCoord, t) + 0.5f / voxelsPerDepth;
+							else											t += 0.5f / voxelsPerDepth;
+							continue;
+						}
+						if (prevValid && prevSDF > 0.0f && sdf <= 0.0f) {
+							const float tHit = prevT + (t - prevT) * prevSDF / (prevSDF - sdf);
+							depth(x, (unsigned int)y) = tHit * dirCamera.z;
+							if (normals) {
+								vec3f n;
+								if (sampleGradient(accessor, origin + dir * tHit, n)) (*normals)(x, (unsigned int)y) = n.getNormalized();
+							}
+							break;
+						}
+						if (prevValid && prevSDF < 0.0f && sdf >= 0.0f) break;	//seen from behind
+
+						prevValid = true;
+						prevSDF = sdf;
+						prevT = t;
+						t += std::max(sdf / m_voxelSize * 0.8f, 0.5f) / voxelsPerDepth;
+					}
+				}
+			}
+		}
+
+		//! mesh of the zero crossings; blocks that changed since the last call are meshed again (in parallel), all others are reused.
+		//! Each block meshes the cells that start at its voxels, so vertices on block borders are duplicated.
+		TriMeshf extractMesh() {
+			std::vector<vec3i> dirty;
+			for (const vec3i& b : m_dirtyBlocks) {
+				if (m_grid.findBlock(b)) {
+					dirty.push_back(b);
+					m_blockMeshes[b];
+				}
+				else {
+					m_blockMeshes.erase(b);
+				}
+			}
+			m_dirtyBlocks.clear();
+
+			const int numDirty = (int)dirty.size();
+			GridMesher<float>::initTables();
+#ifdef MLIB_OPENMP
+#pragma omp parallel
+#endif
+			{
+				Grid3f sdf(Grid::BLOCK_DIM + 1, Grid::BLOCK_DIM + 1, Grid::BLOCK_DIM + 1);
+				Grid3<vec4f> colors(sdf.getDimensions());
+#ifdef MLIB_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+				for (int i = 0; i < numDirty; i++) {
+					meshBlock(dirty[i], sdf, colors, m_blockMeshes.find(dirty[i])->second);
+				}
+			}
+
+			std::vector<TriMeshf::Vertex> vertices;
+			std::vector<vec3ui> triangles;
+			for (const auto& m : m_blockMeshes) {
+				const UINT firstVertex = (UINT)vertices.size();
+				vertices.insert(vertices.end(), m.second.getVertices().begin(), m.second.getVertices().end());
+				for (const vec3ui& t : m.second.getIndices()) triangles.push_back(t + firstVertex);
+			}
+			return TriMeshf(vertices, triangles, false, true, false, true);
+		}
+
+	private:
+		//! collects (and allocates) the blocks that the truncation band around the depth samples passes through
+		void allocateBlocks(const DepthImage32& depth, const mat4f& intrinsic, const mat4f& cameraToWorld, float minDepth, float maxDepth, std::vector<vec3i>& blocks) {
+			const mat4f cameraToVoxel = getWorldToVoxel() * cameraToWorld;
+			const mat4f intrinsicInverse = intrinsic.getInverse();
+			const vec3f origin = cameraToVoxel.transformAffine(vec3f::origin);
+			const float blockSize = (float)Grid::BLOCK_DIM;
+			const int height = (int)depth.getHeight();
+
+			blocks.clear();
+#ifdef MLIB_OPENMP
+#pragma omp parallel
+#endif
+			{
+				std::vector<vec3i> local;
+#ifdef MLIB_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+				for (int y = 0; y < height; y++) {
+					for (unsigned int x = 0; x < depth.getWidth(); x++) {
+						const float d = depth(x, (unsigned int)y);
+						if (!(d >= minDepth && d <= maxDepth)) continue;
+
+						//walk the blocks from depth d - truncation to d + truncation along the ray (Amanatides and Woo), in block units
+						const vec3f dirCamera = intrinsicInverse.transformAffine(vec3f((float)x, (float)y, 1.0f));
+						const vec3f dir = (cameraToVoxel.transformAffine(dirCamera) - origin) / blockSize;
+						const float t0 = std::max(d - m_truncation, minDepth), t1 = d + m_truncation;
+
+						const vec3f start = (origin / blockSize) + dir * t0;
+						vec3i block((int)std::floor(start.x), (int)std::floor(start.y), (int)std::floor(start.z));
+						vec3i step;
+						vec3f tNext, tDelta;
+						for (int a = 0; a < 3; a++) {
+							step[a] = dir[a] > 0.0f ? 1 : -1;
+							const float boundary = (float)block[a] + (dir[a] > 0.0f ? 1.0f : 0.0f);
+							tNext[a] = dir[a] != 0.0f ? t0 + (boundary - start[a]) / dir[a] : std::numeric_limits<float>::infinity();
+							tDelta[a] = dir[a] != 0.0f ? 1.0f / std::abs(dir[a]) : std::numeric_limits<float>::infinity();
+						}
+						while (true) {
+							if (local.empty() || local.back() != block) local.push_back(block);
+							const int a = tNext.x < tNext.y ? (tNext.x < tNext.z ? 0 : 2) : (tNext.y < tNext.z ? 1 : 2);
+							if (tNext[a] > t1) break;
+							block[a] += step[a];
+							tNext[a] += tDelta[a];
+						}
+					}
+				}
+				std::sort(local.begin(), local.end(), lessBlock);
+				local.erase(std::unique(local.begin(), local.end()), local.end());
+#ifdef MLIB_OPENMP
+#pragma omp critical
+#endif
+				blocks.insert(blocks.end(), local.begin(), local.end());
+			}
+			std::sort(blocks.begin(), blocks.end(), lessBlock);
+			blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+
+			for (const vec3i& b : blocks) m_grid.touchBlock(b);
+		}
+
+		void integrateBlock(const vec3i& blockCoord, Grid::Block& block, const DepthImage32& depth, const mat4f& depthIntrinsic, const mat4f& voxelToCamera,
+			const ColorImageR8G8B8* color, const mat4f& colorIntrinsic, const mat4f& depthToColor, float minDepth, float maxDepth) {
+
+			const vec3f stepX(voxelToCamera(0, 0), voxelToCamera(1, 0), voxelToCamera(2, 0));
+			const vec3f stepY(voxelToCamera(0, 1), voxelToCamera(1, 1), voxelToCamera(2, 1));
+			const vec3f stepZ(voxelToCamera(0, 2), voxelToCamera(1, 2), voxelToCamera(2, 2));
+			const float fx = depthIntrinsic(0, 0), fy = depthIntrinsic(1, 1), mx = depthIntrinsic(0, 2), my = depthIntrinsic(1, 2);
+			const int width = (int)depth.getWidth(), height = (int)depth.getHeight();
+
+			vec3f sliceStart = voxelToCamera.transformAffine(vec3f(blockCoord * Grid::BLOCK_DIM));
+			for (int z = 0; z < Grid::BLOCK_DIM; z++, sliceStart += stepZ) {
+				vec3f rowStart = sliceStart;
+				for (int y = 0; y < Grid::BLOCK_DIM; y++, rowStart += stepY) {
+					vec3f p = rowStart;
+					for (int x = 0; x < Grid::BLOCK_DIM; x++, p += stepX) {
+						if (p.z <= 0.0f) continue;
+						const int u = math::round(fx * p.x / p.z + mx), v = math::round(fy * p.y / p.z + my);
+						if (u < 0 || u >= width || v < 0 || v >= height) continue;
+						const float d = depth((unsigned int)u, (unsigned int)v);
+						if (!(d >= minDepth && d <= maxDepth)) continue;
+
+						const float sdf = d - p.z;
+						if (sdf < -m_truncation) continue;
+						const float tsdf = std::min(sdf, m_truncation);
+
+						const UINT i = (UINT)((z * Grid::BLOCK_DIM + y) * Grid::BLOCK_DIM + x);
+						Voxel& voxel = block.values[i];
+						const float weight = voxel.weight + 1.0f;
+						voxel.sdf = (voxel.sdf * voxel.weight + tsdf) / weight;
+						if (color && std::abs(sdf) < m_truncation) {
+							const vec3f pc = depthToColor.transformAffine(p);
+							const int cu = math::round(colorIntrinsic(0, 0) * pc.x / pc.z + colorIntrinsic(0, 2));
+							const int cv = math::round(colorIntrinsic(1, 1) * pc.y / pc.z + colorIntrinsic(1, 2));
+							if (pc.z > 0.0f && cu >= 0 && cu < (int)color->getWidth() && cv >= 0 && cv < (int)color->getHeight()) {
+								const vec3uc& c = (*color)((unsigned int)cu, (unsigned int)cv);
+								const vec3f blended = (vec3f(voxel.color) * voxel.weight + vec3f(c)) / weight;
+								voxel.color = vec3uc((unsigned char)math::round(blended.x), (unsigned char)math::round(blended.y), (unsigned char)math::round(blended.z));
+							}
+						}
+						voxel.weight = std::min(weight, m_maxWeight);
+						block.setActive(i);
+					}
+				}
+			}
+		}
+
+		//! central differences of the trilinear distance
+		bool sampleGradient(Grid::ConstAccessor& accessor, const vec3f& p, vec3f& gradient) const {
+			for (int a = 0; a < 3; a++) {
+				vec3f offset = vec3f::origin;
+				offset[a] = 0.5f;
+				float s0, s1;
+				if (!sampleSDF(accessor, p - offset, s0) || !sampleSDF(accessor, p + offset, s1)) return false;
+				gradient[a] = s1 - s0;
+			}
+			return gradient.lengthSq() > 0.0f;
+		}
+
+		//! ray parameter at which p + dir * (t - tCurrent) leaves the block
+		static float distanceToBlockExit(const vec3f& p, const vec3f& dir, const vec3i& blockCoord, float tCurrent) {
+			float tExit = std::numeric_limits<float>::infinity();
+			for (int a = 0; a < 3; a++) {
+				if (dir[a] == 0.0f) continue;
+				const float boundary = (float)((blockCoord[a] + (dir[a] > 0.0f ? 1 : 0)) * Grid::BLOCK_DIM);
+				tExit = std::min(tExit, (boundary - p[a]) / dir[a]);
+			}
+			return tCurrent + tExit;
+		}
+
+		//! marching cubes over the cells starting at the voxels of the block (9^3 samples, including the first voxels of the upper neighbors)
+		void meshBlock(const vec3i& blockCoord, Grid3f& sdf, Grid3<vec4f>& colors, TriMeshf& mesh) const {
+			const vec3i origin = blockCoord * Grid::BLOCK_DIM;
+			Grid::ConstAccessor accessor = m_grid.getAccessor();
+			for (size_t z = 0; z < sdf.getDimZ(); z++) {
+				for (size_t y = 0; y < sdf.getDimY(); y++) {
+					for (size_t x = 0; x < sdf.getDimX(); x++) {
+						const Voxel& voxel = accessor.getValue(origin + vec3i((int)x, (int)y, (int)z));
+						sdf(x, y, z) = voxel.weight > 0.0f ? voxel.sdf : std::numeric_limits<float>::infinity();
+						colors(x, y, z) = vec4f(vec3f(voxel.color) / 255.0f, 1.0f);
+					}
+				}
+			}
+			const mat4f blockToWorld = getVoxelToWorld() * mat4f::translation(vec3f(origin));
+			mesh = GridMesher<float>::marchingCubes(sdf, 0.0f, blockToWorld, true, &colors);
+		}
+
+		static bool lessBlock(const vec3i& a, const vec3i& b) {
+			if (a.z != b.z) return a.z < b.z;
+			if (a.y != b.y) return a.y < b.y;
+			return a.x < b.x;
+		}
+
+		float m_voxelSize;
+		float m_truncation;
+		float m_maxWeight;
+
+		Grid m_grid;
+		std::unordered_set<vec3i> m_dirtyBlocks;
+		std::unordered_map<vec3i, TriMeshf> m_blockMeshes;
+	};
+
+}  // namespace ml
+
+#endif  // EXT_DEPTHCAMERA_TSDFVOLUME_H_
@@ -77,12 +77,34 @@ namespace ml
 			memcpy(m_queryStorage.ptr(), query, m_dimension * sizeof(FloatType));
 			int res = m_FLANNIndex->knnSearch(m_queryStorage, m_indicesStorage, m_distsStorage, k, flann::SearchParams((int)m_checkCount));
 
-			result.resize(res);
-			for (size_t i = 0; i < result.size(); i++) {
+			//k entries as in the other backends; missing neighbors are (UINT)-1
+			result.assign(k, (UINT)-1);
+			for (int i = 0; i < res; i++) {
 				result[i] = m_indicesStorage[0][i];
 			}
 		}
 
+		void kNearestBatchInternal(const FloatType* queries, size_t numQueries, UINT k, FloatType epsilon, UINT* outIdx, FloatType* outDist) const
+		{
+			//does not touch the (shared) single-query storage; FLANN distributes the query rows over all cores (cores = 0)
+			flann::Matrix<FloatType> queryMatrix(const_cast<FloatType*>(queries), numQueries, m_dimension);
+			flann::Matrix<int> indicesMatrix((int*)outIdx, numQueries, k);
+			std::vector<FloatType> distsStorage(outDist ? 0 : numQueries * k);
+			flann::Matrix<FloatType> distsMatrix(outDist ? outDist : distsStorage.data(), numQueries, k);
+
+			flann::SearchParams params((int)m_checkCount);
+			params.eps = (float)epsilon;
+			params.cores = 0;
+			m_FLANNIndex->knnSearch(queryMatrix, indicesMatrix, distsMatrix, k, params);
+
+			//FLANN reports squared distances and -1 for missing neighbors
+			if (outDist) {
+				for (size_t i = 0; i < numQueries * k; i++) {
+					outDist[i] = outIdx[i] == (UINT)-1 ? std::numeric_limits<FloatType>::max() : std::sqrt(outDist[i]);
+				}
+			}
+		}
+
 		void fixedRadiusInternal(const FloatType* query, UINT k, FloatType radius, FloatType epsilon, std::vector<UINT> &result) const
 		{
 			memcpy(m_queryStorage.ptr(), query, m_dimension * sizeof(FloatType));
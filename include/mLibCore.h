@@ -35,12 +35,15 @@
 #include "core-math/matrix3x3.h"
 #include "core-math/matrix4x4.h"
 #include "core-math/quaternion.h"
+#include "core-math/batchTransform.h"
 #include "core-math/mathVector.h"
 #include "core-math/sparseMatrix.h"
 #include "core-math/denseMatrix.h"
 #include "core-math/linearSolver.h"
 #include "core-math/eigenSolver.h"
 #include "core-math/rng.h"
+#include "core-math/counterRNG.h"
+#include "core-math/aliasTable.h"
 #include "core-math/kMeansClustering.h"
 #include "core-math/sampling.h"
 #include "core-math/mathUtil.h"
@@ -137,6 +140,7 @@ namespace ml
 //
 #include "core-base/grid2.h"
 #include "core-base/grid3.h"
+#include "core-base/grid3Sampler.h"
 
 //
 // core-util headers
@@ -145,6 +149,7 @@ namespace ml
 #include "core-util/directory.h"
 #include "core-util/timer.h"
 #include "core-util/nearestNeighborSearch.h"
+#include "core-util/nearestNeighborSearchKdTree.h"
 #include "core-util/commandLineReader.h"
 #include "core-util/parameterFile.h"
 #include "core-util/keycodes.h"
@@ -153,6 +158,7 @@ namespace ml
 #include "core-util/eventMap.h"
 #include "core-util/sparseGrid3.h"
 #include "core-base/binaryGrid3.h"
+#include "core-base/sparseBlockGrid3.h"
 
 //
 // core-multithreading headers
@@ -182,6 +188,7 @@ namespace ml
 #include "core-graphics/dist.h"
 #include "core-base/distanceField3.h"
 #include "core-util/uniformAccelerator.h"
+#include "core-util/uniformPointGrid.h"
 #include "core-base/baseImage.h"
 #include "core-util/colorGradient.h"
 #include "core-util/textWriter.h"
@@ -191,20 +198,29 @@ namespace ml
 // core-mesh headers
 //
 #include "core-mesh/material.h"
+#include "core-mesh/meshNormals.h"
 #include "core-mesh/meshData.h"
 #include "core-mesh/plyHeader.h"
 #include "core-mesh/meshIO.h"
+#include "core-mesh/pointCloudNormals.h"
+#include "core-mesh/pointCloudFilter.h"
 #include "core-mesh/pointCloud.h"
 #include "core-mesh/pointCloudIO.h"
+#include "core-mesh/pointCloudOctree.h"
 
 #include "core-mesh/triMesh.h"
+#include "core-mesh/triMeshSoA.h"
+#include "core-mesh/triMeshBuilder.h"
+#include "core-mesh/gridMesher.h"
 #include "core-mesh/triMeshSampler.h"
+#include "core-mesh/pointCloudICP.h"
 
 #include "core-mesh/triMeshAccelerator.h"
 #include "core-mesh/triMeshRayAccelerator.h"
 #include "core-mesh/triMeshCollisionAccelerator.h"
 #include "core-mesh/triMeshAcceleratorBruteForce.h"
 #include "core-mesh/triMeshAcceleratorBVH.h"
+#include "core-mesh/meshVoxelizer.h"
 
 #include "core-mesh/meshUtil.h"
 #include "core-mesh/meshShapes.h"
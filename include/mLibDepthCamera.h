@@ -4,4 +4,5 @@
 // ext-depthcamera headers
 //
 #include "ext-depthcamera/calibratedSensorData.h"	//this is obsolete
-#include "ext-depthcamera/sensorData.h"
\ No newline at end of file
+#include "ext-depthcamera/sensorData.h"
+#include "ext-depthcamera/tsdfVolume.h"
\ No newline at end of file
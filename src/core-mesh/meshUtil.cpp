@@ -1,69 +1,41 @@
 
 namespace ml {
 
-	//
-	// TODO: really, the TriMeshf version should be the one that calls the TriMesh* version!!!
-	//
 	TriMeshf meshutil::createUnifiedMesh(const std::vector< std::pair<const TriMeshf*, mat4f> >& meshes) {
-		std::vector< std::pair<TriMeshf, mat4f> > meshList;
-
-		for (const auto &m : meshes)
-		{
-			meshList.push_back(std::make_pair(*m.first, m.second));
+		TriMeshBuilderf builder;
+		builder.reserve(meshes.size());
+		for (const auto& m : meshes) {
+			builder.append(*m.first, m.second);
 		}
 
-		return createUnifiedMesh(meshList);
+		TriMeshf result = builder.finalize();
+		result.m_bHasNormals = result.m_bHasColors = result.m_bHasTexCoords = false;
+		return result;
 	}
 
 	TriMeshf meshutil::createUnifiedMesh(const std::vector< std::pair<TriMeshf, mat4f> >& meshes) {
-		auto lambdaVertices = [](size_t total, const std::pair<TriMeshf, mat4f>& t) { return t.first.getVertices().size() + total; };
-		const size_t totalPoints = std::accumulate(meshes.begin(), meshes.end(), static_cast<size_t>(0), lambdaVertices);
-		auto lambdaIndices = [](size_t total, const std::pair<TriMeshf, mat4f>& t) { return t.first.getIndices().size() + total; };
-		const size_t totalIndices = std::accumulate(meshes.begin(), meshes.end(), static_cast<size_t>(0), lambdaIndices);
-
-		std::vector<TriMeshf::Vertex> vertices(totalPoints);
-		std::vector<vec3ui> indices(totalIndices);
-
-		UINT vIndex = 0, iIndex = 0;
+		TriMeshBuilderf builder;
+		builder.reserve(meshes.size());
 		for (const auto& m : meshes) {
-			const UINT baseVertexIndex = vIndex;
-
-			for (UINT vertexIndex = 0; vertexIndex < m.first.getVertices().size(); vertexIndex++) {
-				TriMeshf::Vertex& v = vertices[vIndex++];
-				v = m.first.getVertices()[vertexIndex];
-				v.position = m.second * v.position;
-			}
-			for (UINT indexIndex = 0; indexIndex < m.first.getIndices().size(); indexIndex++) {
-				indices[iIndex++] = m.first.getIndices()[indexIndex] + vec3ui(baseVertexIndex, baseVertexIndex, baseVertexIndex);
-			}
+			builder.append(m.first, m.second);
 		}
 
-		return TriMeshf(vertices, indices);
+		TriMeshf result = builder.finalize();
+		result.m_bHasNormals = result.m_bHasColors = result.m_bHasTexCoords = false;
+		return result;
 	}
 
 	TriMeshf meshutil::createUnifiedMesh(const std::vector<TriMeshf>& meshes) {
-		auto lambdaVertices = [](size_t total, const TriMeshf& t) { return t.getVertices().size() + total; };
-		const size_t totalPoints = std::accumulate(meshes.begin(), meshes.end(), static_cast<size_t>(0), lambdaVertices);
-		auto lambdaIndices = [](size_t total, const TriMeshf& t) { return t.getIndices().size() + total; };
-		const size_t totalIndices = std::accumulate(meshes.begin(), meshes.end(), static_cast<size_t>(0), lambdaIndices);
-
-		std::vector<TriMeshf::Vertex> vertices(totalPoints);
-		std::vector<vec3ui> indices(totalIndices);
-
-		UINT vIndex = 0, iIndex = 0;
+		TriMeshBuilderf builder;
+		builder.reserve(meshes.size());
 		for (const auto& m : meshes) {
-			const UINT baseVertexIndex = vIndex;
-
-			for (UINT vertexIndex = 0; vertexIndex < m.getVertices().size(); vertexIndex++) {
-				TriMeshf::Vertex& v = vertices[vIndex++];
-				v = m.getVertices()[vertexIndex];
-			}
-			for (UINT indexIndex = 0; indexIndex < m.getIndices().size(); indexIndex++) {
-				indices[iIndex++] = m.getIndices()[indexIndex] + vec3ui(baseVertexIndex, baseVertexIndex, baseVertexIndex);
-			}
+			builder.append(m);
 		}
 
-		return TriMeshf(vertices, indices, false, false, false, true);
+		TriMeshf result = builder.finalize();
+		result.m_bHasNormals = result.m_bHasTexCoords = false;
+		result.m_bHasColors = true;
+		return result;
 	}
 
 	TriMeshf meshutil::createPointCloudTemplate(const TriMeshf& templateMesh,
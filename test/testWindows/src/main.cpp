@@ -13,6 +13,12 @@ public:
 	void go() {
 		m_grid.run();
 		m_binaryStream.run();
+		m_triMesh.run();
+		m_pointCloud.run();
+		m_distanceField.run();
+		m_sparseGrid.run();
+		m_tsdfVolume.run();
+		m_nearestNeighbor.run();
 
 		//m_box.run();
 		//m_cgal.run();
@@ -33,6 +39,12 @@ private:
 	TestLodePNG m_lodePNG;
 	TestBinaryStream m_binaryStream;
 	TestOpenMesh m_openMesh;
+	TestTriMesh m_triMesh;
+	TestPointCloud m_pointCloud;
+	TestDistanceField m_distanceField;
+	TestSparseGrid m_sparseGrid;
+	TestTSDFVolume m_tsdfVolume;
+	TestNearestNeighbor m_nearestNeighbor;
 };
 
 int main()
@@ -10,4 +10,10 @@
 #include "testBinaryStream.h"
 #include "testGrid.h"
 #include "testOpenMesh.h"
-#include "testCGAL.h"
\ No newline at end of file
+#include "testCGAL.h"
+#include "testTriMesh.h"
+#include "testPointCloud.h"
+#include "testDistanceField.h"
+#include "testSparseGrid.h"
+#include "testTSDFVolume.h"
+#include "testNearestNeighbor.h"
\ No newline at end of file
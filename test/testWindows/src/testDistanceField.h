@@ -0,0 +1,298 @@
+
+class TestDistanceField : public Test {
+public:
+	void test0()
+	{
+		//exact distance transform against brute force, unsigned and signed, with truncation
+		BinaryGrid3 grid(13, 9, 11);
+		for (size_t z = 0; z < grid.getDimZ(); z++) {
+			for (size_t y = 0; y < grid.getDimY(); y++) {
+				for (size_t x = 0; x < grid.getDimX(); x++) {
+					if (math::randomUniform(0.0f, 1.0f) < 0.05f) grid.setVoxel(x, y, z);
+				}
+			}
+		}
+		const float inf = std::numeric_limits<float>::infinity();
+
+		DistanceField3f df;
+		df.generateFromBinaryGridExact(grid);
+		DistanceField3f signedDF;
+		signedDF.generateFromBinaryGridExact(grid, 2.5f, true);
+		for (size_t z = 0; z < grid.getDimZ(); z++) {
+			for (size_t y = 0; y < grid.getDimY(); y++) {
+				for (size_t x = 0; x < grid.getDimX(); x++) {
+					const bool set = grid.isVoxelSet(x, y, z);
+					const float outside = bruteForceDist(grid, x, y, z, true);
+					MLIB_ASSERT_STR(math::floatEqual(df(x, y, z), outside, 1e-5f), "exact distance transform differs from brute force");
+
+					float expected = set ? -bruteForceDist(grid, x, y, z, false) : outside;
+					if (std::abs(expected) > 2.5f) expected = expected < 0.0f ? -inf : inf;
+					MLIB_ASSERT_STR(signedDF(x, y, z) == expected || math::floatEqual(signedDF(x, y, z), expected, 1e-5f), "signed distance transform differs from brute force");
+				}
+			}
+		}
+		MLIB_ASSERT_STR(df.getNumZeroVoxels() == grid.getNumOccupiedEntries(), "wrong number of zero voxels");
+
+		//an empty grid gives an empty field, also when the field was allocated before
+		const BinaryGrid3 empty;
+		DistanceField3f emptyDF;
+		emptyDF.generateFromBinaryGridExact(empty);
+		df.generateFromBinaryGridExact(empty, 2.5f, true);
+		MLIB_ASSERT_STR(emptyDF.getNumElements() == 0 && df.getNumElements() == 0 && df.getNumZeroVoxels() == 0, "empty grid gives a non-empty distance field");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test1()
+	{
+		//evaluation of a truncated signed field skips the voxels beyond the truncation (also the negative ones)
+		BinaryGrid3 cube(20, 20, 20);
+		for (size_t z = 4; z < 16; z++) {
+			for (size_t y = 4; y < 16; y++) {
+				for (size_t x = 4; x < 16; x++) {
+					cube.setVoxel(x, y, z);
+				}
+			}
+		}
+		DistanceField3f df;
+		df.generateFromBinaryGridExact(cube, 3.0f, true);
+
+		const mat4f transform = mat4f::translation(1.0f, 0.0f, 0.0f);
+		const std::pair<float, size_t> setVoxels = df.evalDistOfSetVoxels(cube, transform);
+		const std::pair<float, size_t> all = df.evalDist(cube, transform);
+		MLIB_ASSERT_STR(std::isfinite(setVoxels.first) && std::isfinite(all.first), "evaluation sums voxels beyond the truncation");
+
+		//reference: sum of the absolute distances below the truncation at the shifted set voxels
+		float expected = 0.0f;
+		size_t expectedCount = 0;
+		for (size_t z = 0; z < cube.getDimZ(); z++) {
+			for (size_t y = 0; y < cube.getDimY(); y++) {
+				for (size_t x = 0; x + 1 < cube.getDimX(); x++) {
+					if (!cube.isVoxelSet(x, y, z)) continue;
+					const float d = std::abs(df(x + 1, y, z));
+					if (d < df.getTruncation()) {
+						expected += d;
+						expectedCount++;
+					}
+				}
+			}
+		}
+		MLIB_ASSERT_STR(setVoxels.second == expectedCount && math::floatEqual(setVoxels.first, expected, 1e-3f), "evalDistOfSetVoxels is wrong");
+
+		std::vector<mat4f> transforms(3, transform);
+		transforms[0] = mat4f::identity();
+		const std::vector<std::pair<float, size_t>> batch = df.evalDistOfSetVoxels(cube, transforms);
+		MLIB_ASSERT_STR(batch[1] == setVoxels && batch[2] == setVoxels, "batched evaluation differs");
+		MLIB_ASSERT_STR(std::isfinite(batch[0].first), "evaluation sums voxels beyond the truncation");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test2()
+	{
+		//signed distance field of a voxelized mesh (negative infinity inside, beyond the band) through the evaluators
+		const TriMeshf box = Shapesf::box(2.0f);
+		const mat4f worldToVoxel = mat4f::translation(10.0f, 10.0f, 10.0f) * mat4f::scale(4.0f);
+		DistanceField3f df(20, 20, 20);
+		MeshVoxelizerf::computeDistanceField(box, df, 2.0f, worldToVoxel);
+		MLIB_ASSERT_STR(df(10, 10, 10) == -std::numeric_limits<float>::infinity() && df(0, 0, 0) == std::numeric_limits<float>::infinity(), "voxels beyond the band are not infinite");
+		MLIB_ASSERT_STR(math::floatEqual(df(10, 10, 7), -1.0f, 1e-5f) && math::floatEqual(df(10, 10, 5), 1.0f, 1e-5f), "wrong distance inside the band");
+
+		BinaryGrid3 solid(20, 20, 20);
+		MeshVoxelizerf::voxelizeSolid(box, solid, worldToVoxel);
+		MLIB_ASSERT_STR(solid.isVoxelSet(10, 10, 10) && !solid.isVoxelSet(2, 2, 2), "solid voxelization failed");
+		const mat4f transform = mat4f::translation(0.0f, 1.0f, 0.0f);
+		const std::pair<float, size_t> setVoxels = df.evalDistOfSetVoxels(solid, transform);
+		const std::pair<float, size_t> all = df.evalDist(solid, transform);
+		MLIB_ASSERT_STR(std::isfinite(setVoxels.first) && std::isfinite(all.first), "evaluation sums voxels beyond the truncation");
+		MLIB_ASSERT_STR(setVoxels.second > 0 && setVoxels.second < solid.getNumOccupiedEntries(), "evaluation does not skip voxels beyond the truncation");
+
+		//zero-area triangles (repeated or collinear vertices) on the surface change no distance
+		TriMeshf degenerate = box;
+		const vec3ui face = degenerate.getIndices()[0];
+		degenerate.getIndices().push_back(vec3ui(face.x, face.x, face.y));
+		degenerate.getVertices().push_back(degenerate.getVertices()[face.x]);
+		degenerate.getVertices().back().position = (degenerate.getVertices()[face.x].position + degenerate.getVertices()[face.y].position) * 0.5f;
+		degenerate.getIndices().push_back(vec3ui(face.x, (unsigned int)degenerate.getVertices().size() - 1, face.y));
+		DistanceField3f degenerateDF(20, 20, 20);
+		MeshVoxelizerf::computeDistanceField(degenerate, degenerateDF, 2.0f, worldToVoxel);
+		for (size_t i = 0; i < df.getNumElements(); i++) {
+			MLIB_ASSERT_STR(degenerateDF.getData()[i] == df.getData()[i] || math::floatEqual(degenerateDF.getData()[i], df.getData()[i], 1e-5f), "degenerate triangle changed the distance field");
+		}
+		const vec3f onSegment = closestPointOnTriangle(vec3f(1.0f, 2.0f, 0.0f), vec3f(0.0f, 0.0f, 0.0f), vec3f(2.0f, 0.0f, 0.0f), vec3f(4.0f, 0.0f, 0.0f));
+		MLIB_ASSERT_STR(vec3f::dist(onSegment, vec3f(1.0f, 0.0f, 0.0f)) < 1e-6f, "wrong closest point on a collinear triangle");
+
+		//an empty mesh sets nothing and yields an infinite distance field
+		const TriMeshf empty;
+		BinaryGrid3 emptyGrid(8, 8, 8);
+		MeshVoxelizerf::voxelizeSolid(empty, emptyGrid);
+		MLIB_ASSERT_STR(emptyGrid.getNumOccupiedEntries() == 0, "empty mesh set voxels");
+		DistanceField3f emptyDF(8, 8, 8);
+		MeshVoxelizerf::computeDistanceField(empty, emptyDF, 2.0f);
+		MLIB_ASSERT_STR(emptyDF(3, 4, 5) == std::numeric_limits<float>::infinity(), "distance field of an empty mesh is not infinite");
+		TriMeshAcceleratorBVHf bvh(empty);
+		float t, u, v;
+		MLIB_ASSERT_STR(bvh.intersect(Rayf(vec3f(0.0f, 0.0f, -5.0f), vec3f(0.0f, 0.0f, 1.0f)), t, u, v) == nullptr, "ray hit an empty mesh");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test3()
+	{
+		//continuous sampling: linear fields are exact, gradients match finite differences, the border is clamped
+		Grid3f linear(9, 7, 6);
+		auto linearField = [](const vec3f& p) { return 1.0f + 2.0f * p.x - 3.0f * p.y + 0.5f * p.z; };
+		for (size_t z = 0; z < linear.getDimZ(); z++) {
+			for (size_t y = 0; y < linear.getDimY(); y++) {
+				for (size_t x = 0; x < linear.getDimX(); x++) linear(x, y, z) = linearField(vec3f((float)x, (float)y, (float)z));
+			}
+		}
+		for (int i = 0; i < 1000; i++) {
+			const vec3f p(math::randomUniform(0.0f, 8.0f), math::randomUniform(0.0f, 6.0f), math::randomUniform(0.0f, 5.0f));
+			vec3f gLinear, gCubic;
+			MLIB_ASSERT_STR(math::floatEqual(Grid3Samplerf::trilinear(linear, p, gLinear), linearField(p), 1e-4f), "trilinear does not reproduce a linear field");
+			MLIB_ASSERT_STR(math::floatEqual(Grid3Samplerf::tricubic(linear, p, gCubic), linearField(p), 1e-4f), "tricubic does not reproduce a linear field");
+			MLIB_ASSERT_STR((gLinear - vec3f(2.0f, -3.0f, 0.5f)).length() < 1e-4f && (gCubic - vec3f(2.0f, -3.0f, 0.5f)).length() < 1e-4f, "wrong gradient of a linear field");
+		}
+
+		//outside the grid, the value is that of the clamped position and the gradient across the border is zero
+		vec3f g;
+		MLIB_ASSERT_STR(Grid3Samplerf::trilinear(linear, vec3f(-2.0f, 3.5f, 9.0f), g) == Grid3Samplerf::trilinear(linear, vec3f(0.0f, 3.5f, 5.0f)), "trilinear does not clamp");
+		MLIB_ASSERT_STR(g.x == 0.0f && math::floatEqual(g.y, -3.0f, 1e-4f) && g.z == 0.0f, "gradient across the border is not zero");
+		MLIB_ASSERT_STR(Grid3Samplerf::tricubic(linear, vec3f(10.0f, -1.0f, 2.5f), g) == Grid3Samplerf::tricubic(linear, vec3f(8.0f, 0.0f, 2.5f)), "tricubic does not clamp");
+		MLIB_ASSERT_STR(g.x == 0.0f && g.y == 0.0f && math::floatEqual(g.z, 0.5f, 1e-4f), "gradient across the border is not zero");
+
+		//random field: both interpolate the voxels, gradients match central differences (trilinear: away from the cell faces)
+		Grid3f random(8, 8, 8);
+		for (size_t i = 0; i < random.getNumElements(); i++) random.getData()[i] = math::randomUniform(-1.0f, 1.0f);
+		for (int i = 0; i < 1000; i++) {
+			const vec3ul v(math::randomUniform(0, 7), math::randomUniform(0, 7), math::randomUniform(0, 7));
+			const vec3f p((float)v.x, (float)v.y, (float)v.z);
+			MLIB_ASSERT_STR(math::floatEqual(Grid3Samplerf::trilinear(random, p), random(v), 1e-5f) && math::floatEqual(Grid3Samplerf::tricubic(random, p), random(v), 1e-5f), "sampling at a voxel does not return the voxel");
+
+			const vec3f cell(math::randomUniform(0.0f, 6.0f), math::randomUniform(0.0f, 6.0f), math::randomUniform(0.0f, 6.0f));
+			const vec3f q = vec3f(std::floor(cell.x), std::floor(cell.y), std::floor(cell.z)) + vec3f(math::randomUniform(0.1f, 0.9f), math::randomUniform(0.1f, 0.9f), math::randomUniform(0.1f, 0.9f));
+			vec3f gLinear, gCubic;
+			Grid3Samplerf::trilinear(random, q, gLinear);
+			Grid3Samplerf::tricubic(random, q, gCubic);
+			const float h = 1e-2f;
+			for (unsigned int a = 0; a < 3; a++) {
+				vec3f d = vec3f::origin;
+				d[a] = h;
+				const float fdLinear = (Grid3Samplerf::trilinear(random, q + d) - Grid3Samplerf::trilinear(random, q - d)) / (2.0f * h);
+				const float fdCubic = (Grid3Samplerf::tricubic(random, q + d) - Grid3Samplerf::tricubic(random, q - d)) / (2.0f * h);
+				MLIB_ASSERT_STR(std::abs(gLinear[a] - fdLinear) < 1e-3f, "trilinear gradient differs from finite differences");
+				MLIB_ASSERT_STR(std::abs(gCubic[a] - fdCubic) < 1e-2f, "tricubic gradient differs from finite differences");
+			}
+		}
+
+		//batches match single samples at the transformed points
+		const mat4f pointToVoxel = mat4f::translation(3.5f, 3.5f, 3.5f) * mat4f::scale(2.0f);
+		std::vector<vec3f> points;
+		for (int i = 0; i < 5000; i++) points.push_back(vec3f(math::randomUniform(-2.0f, 2.0f), math::randomUniform(-2.0f, 2.0f), math::randomUniform(-2.0f, 2.0f)));
+		std::vector<float> linearValues, cubicValues;
+		std::vector<vec3f> linearGradients, cubicGradients;
+		Grid3Samplerf::trilinear(random, points, linearValues, &linearGradients, pointToVoxel);
+		Grid3Samplerf::tricubic(random, points, cubicValues, &cubicGradients, pointToVoxel);
+		for (size_t i = 0; i < points.size(); i++) {
+			const vec3f p = pointToVoxel.transformAffine(points[i]);
+			vec3f gLinear, gCubic;
+			MLIB_ASSERT_STR(linearValues[i] == Grid3Samplerf::trilinear(random, p, gLinear) && linearGradients[i] == gLinear, "batched trilinear sampling differs");
+			MLIB_ASSERT_STR(cubicValues[i] == Grid3Samplerf::tricubic(random, p, gCubic) && cubicGradients[i] == gCubic, "batched tricubic sampling differs");
+		}
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test4()
+	{
+		//bit-scanning evaluator against a voxel-by-voxel reference; the transform has dyadic entries, so stepping is exact
+		BinaryGrid3 grid(45, 13, 9), shape(45, 13, 9);
+		for (size_t z = 0; z < grid.getDimZ(); z++) {
+			for (size_t y = 0; y < grid.getDimY(); y++) {
+				for (size_t x = 0; x < grid.getDimX(); x++) {
+					if (math::randomUniform(0.0f, 1.0f) < 0.2f) grid.setVoxel(x, y, z);
+					if (math::randomUniform(0.0f, 1.0f) < 0.05f) shape.setVoxel(x, y, z);
+				}
+			}
+		}
+		for (size_t z = 0; z < grid.getDimZ(); z++) {
+			for (size_t y = 0; y < grid.getDimY(); y++) {
+				std::vector<size_t> row;
+				grid.forEachSetVoxelInRow(y, z, [&](size_t x) { row.push_back(x); });
+				std::vector<size_t> expected;
+				for (size_t x = 0; x < grid.getDimX(); x++) {
+					if (grid.isVoxelSet(x, y, z)) expected.push_back(x);
+				}
+				MLIB_ASSERT_STR(row == expected, "row scan differs");
+			}
+		}
+
+		DistanceField3f df;
+		df.generateFromBinaryGridExact(shape, 3.0f, true);
+		std::vector<mat4f> transforms;
+		transforms.push_back(mat4f::identity());
+		transforms.push_back(mat4f(0.0f, -0.75f, 0.0f, 20.25f, 1.0f, 0.0f, 0.0f, -3.5f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f));
+		transforms.push_back(mat4f(0.5f, 0.0f, 0.25f, -2.0f, 0.0f, -1.0f, 0.0f, 12.0f, 0.0f, 0.0f, 0.5f, 0.75f, 0.0f, 0.0f, 0.0f, 1.0f));
+		const std::vector<std::pair<float, size_t>> batch = df.evalDistOfSetVoxels(grid, transforms, true);
+		for (size_t t = 0; t < transforms.size(); t++) {
+			float expected = 0.0f, expectedSquared = 0.0f;
+			size_t expectedCount = 0;
+			for (size_t z = 0; z < grid.getDimZ(); z++) {
+				for (size_t y = 0; y < grid.getDimY(); y++) {
+					for (size_t x = 0; x < grid.getDimX(); x++) {
+						if (!grid.isVoxelSet(x, y, z)) continue;
+						const vec3f p = transforms[t].transformAffine(vec3f((float)x, (float)y, (float)z));
+						const vec3f q(std::floor(p.x + 0.5f), std::floor(p.y + 0.5f), std::floor(p.z + 0.5f));
+						if (q.x < 0.0f || q.y < 0.0f || q.z < 0.0f || q.x >= (float)df.getDimX() || q.y >= (float)df.getDimY() || q.z >= (float)df.getDimZ()) continue;
+						const float d = std::abs(df((size_t)q.x, (size_t)q.y, (size_t)q.z));
+						if (d >= df.getTruncation()) continue;
+						expected += d;
+						expectedSquared += d * d;
+						expectedCount++;
+					}
+				}
+			}
+			const std::pair<float, size_t> single = df.evalDistOfSetVoxels(grid, transforms[t]);
+			MLIB_ASSERT_STR(single.second == expectedCount && math::floatEqual(single.first, expected, 1e-2f), "evalDistOfSetVoxels differs from the reference");
+			MLIB_ASSERT_STR(batch[t].second == expectedCount && math::floatEqual(batch[t].first, expectedSquared, 1e-2f), "batched squared evaluation differs from the reference");
+		}
+
+		//evalDist visits every voxel in the bounding box of the transformed grid, also at x below its min z
+		const mat4f shift = mat4f::translation(0.0f, 0.0f, -3.0f);
+		float expected = 0.0f;
+		size_t expectedCount = 0;
+		for (size_t z = 3; z < grid.getDimZ(); z++) {
+			for (size_t y = 0; y < grid.getDimY(); y++) {
+				for (size_t x = 0; x < grid.getDimX(); x++) {
+					const float d = std::abs(df(x, y, z - 3));
+					if (d >= df.getTruncation()) continue;
+					expected += d;
+					expectedCount++;
+				}
+			}
+		}
+		const std::pair<float, size_t> all = df.evalDist(grid, shift);
+		MLIB_ASSERT_STR(all.second == expectedCount && math::floatEqual(all.first, expected, 1e-2f), "evalDist differs from the reference");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	std::string getName() {
+		return "distanceField";
+	}
+
+private:
+	static float bruteForceDist(const BinaryGrid3& grid, size_t x, size_t y, size_t z, bool target) {
+		float best = std::numeric_limits<float>::infinity();
+		for (size_t k = 0; k < grid.getDimZ(); k++) {
+			for (size_t j = 0; j < grid.getDimY(); j++) {
+				for (size_t i = 0; i < grid.getDimX(); i++) {
+					if (grid.isVoxelSet(i, j, k) != target) continue;
+					best = std::min(best, vec3f((float)i - x, (float)j - y, (float)k - z).length());
+				}
+			}
+		}
+		return best;
+	}
+};
@@ -216,11 +216,175 @@ public:
 		std::cout << __FUNCTION__ << " passed" << std::endl;
 	}
 
+	void test8()
+	{
+		//tiled layout: same voxels as the linear one, including the cell offsets across brick borders and the sampled values
+		Grid3f linear(19, 9, 17);
+		linear.fill([](size_t, size_t, size_t) { return math::randomUniform(-1.0f, 1.0f); });
+		TiledGrid3f tiled(linear);
+		MLIB_ASSERT_STR(tiled.getStorageSize() == 24 * 16 * 24 && tiled.getNumElements() == linear.getNumElements(), "wrong storage size of the tiled grid");
+
+		for (size_t z = 0; z < linear.getDimZ(); z++) {
+			for (size_t y = 0; y < linear.getDimY(); y++) {
+				for (size_t x = 0; x < linear.getDimX(); x++) {
+					MLIB_ASSERT_STR(tiled(x, y, z) == linear(x, y, z), "tiled grid differs from the linear one");
+					const size_t cx[2] = { x, std::min(x + 1, linear.getDimX() - 1) };
+					const size_t cy[2] = { y, std::min(y + 1, linear.getDimY() - 1) };
+					const size_t cz[2] = { z, std::min(z + 1, linear.getDimZ() - 1) };
+					size_t tiledCell[8], linearCell[8];
+					tiled.getCellIndices(cx, cy, cz, tiledCell);
+					linear.getCellIndices(cx, cy, cz, linearCell);
+					for (int c = 0; c < 8; c++) {
+						MLIB_ASSERT_STR(tiledCell[c] == tiled.getIndex(cx[c & 1], cy[(c >> 1) & 1], cz[c >> 2]), "wrong tiled cell offset");
+						MLIB_ASSERT_STR(linearCell[c] == linear.getIndex(cx[c & 1], cy[(c >> 1) & 1], cz[c >> 2]), "wrong linear cell offset");
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < 1000; i++) {
+			const vec3f p(math::randomUniform(-1.0f, 20.0f), math::randomUniform(-1.0f, 10.0f), math::randomUniform(-1.0f, 18.0f));
+			vec3f gTiled, gLinear;
+			MLIB_ASSERT_STR(Grid3Samplerf::trilinear(tiled, p, gTiled) == Grid3Samplerf::trilinear(linear, p, gLinear) && gTiled == gLinear, "trilinear sampling depends on the layout");
+			MLIB_ASSERT_STR(Grid3Samplerf::tricubic(tiled, p) == Grid3Samplerf::tricubic(linear, p), "tricubic sampling depends on the layout");
+		}
+
+		//conversion back and serialization keep the voxels
+		Grid3f back(tiled);
+		MLIB_ASSERT_STR(back == linear, "conversion of the tiled grid failed");
+		BinaryDataStreamFile out("tmp.bin", true);
+		out << tiled;
+		out.close();
+		BinaryDataStreamFile in("tmp.bin", false);
+		TiledGrid3f re;
+		in >> re;
+		MLIB_ASSERT_STR(Grid3f(re) == linear, "binary stream of the tiled grid failed");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test9()
+	{
+		//word-parallel morphology, boolean ops, slice counts and flood fill against voxel-by-voxel references;
+		//the dimensions make rows and slices start at every position within a word
+		const vec3ul dims[] = { vec3ul(37, 11, 5), vec3ul(5, 3, 70), vec3ul(32, 2, 3), vec3ul(1, 1, 100), vec3ul(70, 1, 1) };
+		for (const vec3ul& dim : dims) {
+			BinaryGrid3 grid(dim), other(dim);
+			for (size_t z = 0; z < dim.z; z++) {
+				for (size_t y = 0; y < dim.y; y++) {
+					for (size_t x = 0; x < dim.x; x++) {
+						if (math::randomUniform(0.0f, 1.0f) < 0.3f) grid.setVoxel(x, y, z);
+						if (math::randomUniform(0.0f, 1.0f) < 0.5f) other.setVoxel(x, y, z);
+					}
+				}
+			}
+
+			BinaryGrid3 result = grid;
+			result.dilate(2);
+			MLIB_ASSERT_STR(result == morphologyReference(morphologyReference(grid, true, false), true, false), "dilation differs");
+			result = grid;
+			result.erode();
+			MLIB_ASSERT_STR(result == morphologyReference(grid, false, false), "erosion differs");
+			result = grid;
+			result.erode(1, true);
+			MLIB_ASSERT_STR(result == morphologyReference(grid, false, true), "erosion with a set outside differs");
+			result = grid;
+			result.open();
+			MLIB_ASSERT_STR(result == morphologyReference(morphologyReference(grid, false, false), true, false), "opening differs");
+			result = grid;
+			result.close();
+			MLIB_ASSERT_STR(result == morphologyReference(morphologyReference(grid, true, false), false, true), "closing differs");
+			MLIB_ASSERT_STR((result & grid) == grid, "closing cleared voxels");
+
+			const BinaryGrid3 andGrid = grid & other, orGrid = grid | other, xorGrid = grid ^ other;
+			BinaryGrid3 inverted = grid;
+			inverted.invert();
+			std::vector<size_t> perSlice(dim.z, 0);
+			for (size_t z = 0; z < dim.z; z++) {
+				for (size_t y = 0; y < dim.y; y++) {
+					for (size_t x = 0; x < dim.x; x++) {
+						const bool a = grid.isVoxelSet(x, y, z), b = other.isVoxelSet(x, y, z);
+						MLIB_ASSERT_STR(andGrid.isVoxelSet(x, y, z) == (a && b) && orGrid.isVoxelSet(x, y, z) == (a || b) && xorGrid.isVoxelSet(x, y, z) == (a != b), "boolean op differs");
+						MLIB_ASSERT_STR(inverted.isVoxelSet(x, y, z) == !a, "inversion differs");
+						if (a) perSlice[z]++;
+					}
+				}
+			}
+			MLIB_ASSERT_STR(inverted.getNumOccupiedEntries() == dim.x * dim.y * dim.z - grid.getNumOccupiedEntries(), "inversion set bits behind the last voxel");
+			MLIB_ASSERT_STR(grid.getNumOccupiedEntriesPerSlice() == perSlice, "slice counts differ");
+
+			//flood fill from an unset voxel sets exactly its 6-connected component of unset voxels
+			vec3ul seed(0, 0, 0);
+			while (grid.isVoxelSet(seed) && seed.x + 1 < dim.x) seed.x++;
+			if (grid.isVoxelSet(seed)) continue;
+			BinaryGrid3 filled = grid;
+			const size_t numFilled = filled.floodFill(seed);
+			const BinaryGrid3 expected = floodFillReference(grid, seed);
+			MLIB_ASSERT_STR(filled == expected && numFilled == expected.getNumOccupiedEntries() - grid.getNumOccupiedEntries(), "flood fill differs");
+			MLIB_ASSERT_STR(filled.floodFill(seed) == 0, "flood fill of a set voxel set voxels");
+		}
+
+		//ops on grids of different dimensions throw
+		bool thrown = false;
+		try {
+			BinaryGrid3 a(4, 4, 4), b(4, 4, 5);
+			a |= b;
+		}
+		catch (const MLibException&) {
+			thrown = true;
+		}
+		MLIB_ASSERT_STR(thrown, "grids of different dimensions were combined");
+
+		MLIB_ASSERT_STR(math::lowestSetBit(0x80000000u) == 31 && math::lowestSetBit(12u) == 2 && math::highestSetBit(12u) == 3 && math::highestSetBit(1u) == 0, "bit scan failed");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
 	std::string getName() {
 		return "grid";
 	}
 private:
 
+	//! one dilation or erosion step with the 6-neighborhood, voxel by voxel
+	static BinaryGrid3 morphologyReference(const BinaryGrid3& grid, bool dilation, bool outsideIsSet) {
+		BinaryGrid3 result(grid.getDimensions());
+		const int offsets[7][3] = { { 0, 0, 0 }, { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 } };
+		for (size_t z = 0; z < grid.getDimZ(); z++) {
+			for (size_t y = 0; y < grid.getDimY(); y++) {
+				for (size_t x = 0; x < grid.getDimX(); x++) {
+					bool value = !dilation;
+					for (int n = 0; n < 7; n++) {
+						const long long nx = (long long)x + offsets[n][0], ny = (long long)y + offsets[n][1], nz = (long long)z + offsets[n][2];
+						const bool inside = nx >= 0 && ny >= 0 && nz >= 0 && nx < (long long)grid.getDimX() && ny < (long long)grid.getDimY() && nz < (long long)grid.getDimZ();
+						const bool set = inside ? grid.isVoxelSet((size_t)nx, (size_t)ny, (size_t)nz) : (!dilation && outsideIsSet);
+						if (dilation) value = value || set;
+						else value = value && set;
+					}
+					if (value) result.setVoxel(x, y, z);
+				}
+			}
+		}
+		return result;
+	}
+
+	static BinaryGrid3 floodFillReference(const BinaryGrid3& grid, const vec3ul& seed) {
+		BinaryGrid3 result = grid;
+		std::vector<vec3ul> stack(1, seed);
+		result.setVoxel(seed);
+		while (!stack.empty()) {
+			const vec3ul c = stack.back();
+			stack.pop_back();
+			const int offsets[6][3] = { { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 } };
+			for (int n = 0; n < 6; n++) {
+				const vec3ul neighbor(c.x + offsets[n][0], c.y + offsets[n][1], c.z + offsets[n][2]);
+				if (!result.isValidCoordinate(neighbor.x, neighbor.y, neighbor.z) || result.isVoxelSet(neighbor)) continue;
+				result.setVoxel(neighbor);
+				stack.push_back(neighbor);
+			}
+		}
+		return result;
+	}
+
 	bool checkIfAllOtherAreZero(const ml::BinaryGrid3& grid, unsigned int _i, unsigned int _j, unsigned int _k) {
 		for (unsigned int i = 0; i < grid.getDimX(); i++) {
 			if (i == _i) continue;
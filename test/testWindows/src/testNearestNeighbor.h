@@ -0,0 +1,187 @@
+
+class TestNearestNeighbor : public Test {
+public:
+	void test0()
+	{
+		//k-d tree against a sorted scan: exact kNN and radius queries in several dimensions, approximate kNN within (1 + epsilon)
+		for (UINT dimension : { 3u, 8u, 16u }) {
+			const std::vector<float> points = randomPoints(2000, dimension);
+			NearestNeighborSearchKdTreef kdTree;
+			kdTree.init(points.data(), 2000, dimension, 10);
+			MLIB_ASSERT_STR(kdTree.getNumPoints() == 2000 && kdTree.getDimension() == dimension, "wrong k-d tree size");
+
+			const std::vector<float> queries = randomPoints(100, dimension);
+			for (UINT q = 0; q < 100; q++) {
+				const float* query = &queries[q * dimension];
+				const std::vector<std::pair<UINT, float>> expected = sortedScan(points, dimension, query);
+
+				const std::vector<UINT> knn = kdTree.kNearest(query, 10, 0.0f);
+				MLIB_ASSERT_STR(knn.size() == 10, "wrong number of neighbors");
+				for (UINT i = 0; i < 10; i++) {
+					MLIB_ASSERT_STR(knn[i] == expected[i].first, "k-d tree neighbor differs from the scan");
+				}
+
+				const float radius = 0.5f * (expected[25].second + expected[26].second);
+				const std::vector<std::pair<UINT, float>> inRadius = kdTree.fixedRadiusDist(query, 0, radius);
+				MLIB_ASSERT_STR(inRadius.size() == 26, "wrong number of points within the radius");
+				for (size_t i = 0; i < inRadius.size(); i++) {
+					MLIB_ASSERT_STR(inRadius[i].first == expected[i].first && math::floatEqual(inRadius[i].second, expected[i].second, 1e-4f), "radius query differs from the scan");
+				}
+				MLIB_ASSERT_STR(kdTree.fixedRadius(query, 5, radius) == std::vector<UINT>({ expected[0].first, expected[1].first, expected[2].first, expected[3].first, expected[4].first }), "radius query ignores k");
+
+				const std::vector<UINT> approximate = kdTree.kNearest(query, 10, 0.5f);
+				MLIB_ASSERT_STR(approximate.size() == 10, "wrong number of approximate neighbors");
+				for (UINT i = 0; i < 10; i++) {
+					MLIB_ASSERT_STR(dist(&points[approximate[i] * dimension], query, dimension) <= 1.5f * expected[i].second + 1e-5f, "approximate neighbor is too far away");
+				}
+			}
+		}
+
+		//fewer points than requested neighbors
+		const std::vector<float> few = randomPoints(5, 3);
+		NearestNeighborSearchKdTreef kdTree;
+		kdTree.init(few.data(), 5, 3, 10);
+		NearestNeighborSearchBruteForce<float> bruteForce;
+		bruteForce.init(few.data(), 5, 3, 10);
+		const std::vector<UINT> kdFew = kdTree.kNearest(few.data(), 10, 0.0f), bruteForceFew = bruteForce.kNearest(few.data(), 10, 0.0f);
+		MLIB_ASSERT_STR(kdFew.size() == 10 && kdFew == bruteForceFew, "backends return different neighbors for a small point set");
+		MLIB_ASSERT_STR(std::count(kdFew.begin(), kdFew.end(), (UINT)-1) == 5 && kdFew[4] != (UINT)-1, "missing neighbors are not padded");
+		MLIB_ASSERT_STR(kdTree.kNearest(few.data(), 0, 0.0f).empty(), "k = 0 returned neighbors");
+		kdTree.kNearestBatchInRadius(few.data(), 1, 0, 1.0f, nullptr, nullptr);
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test1()
+	{
+		//batched queries (both backends) against the scan; concurrent single queries on one search structure
+		const UINT dimension = 6, k = 7;
+		const std::vector<float> points = randomPoints(3000, dimension);
+		const std::vector<float> queries = randomPoints(500, dimension);
+		NearestNeighborSearchKdTreef kdTree;
+		NearestNeighborSearchBruteForce<float> bruteForce;
+		kdTree.init(points.data(), 3000, dimension, k);
+		bruteForce.init(points.data(), 3000, dimension, k);
+
+		NearestNeighborSearch<float>* searches[2] = { &kdTree, &bruteForce };
+		for (NearestNeighborSearch<float>* search : searches) {
+			std::vector<UINT> indices(500 * k);
+			std::vector<float> dists(500 * k);
+			search->kNearestBatch(queries.data(), 500, k, indices.data(), dists.data());
+			std::vector<std::vector<UINT>> single(500);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int q = 0; q < 500; q++) {
+				single[q] = search->kNearest(&queries[q * dimension], k, 0.0f);
+			}
+			for (UINT q = 0; q < 500; q++) {
+				const std::vector<std::pair<UINT, float>> expected = sortedScan(points, dimension, &queries[q * dimension]);
+				for (UINT i = 0; i < k; i++) {
+					MLIB_ASSERT_STR(indices[q * k + i] == expected[i].first && math::floatEqual(dists[q * k + i], expected[i].second, 1e-4f), "batched neighbor differs from the scan");
+					MLIB_ASSERT_STR(single[q][i] == expected[i].first, "concurrent single query differs from the scan");
+				}
+			}
+		}
+
+		//restricted to a radius: missing neighbors are marked
+		const float maxDist = 0.3f;
+		std::vector<UINT> indices(500 * k);
+		std::vector<float> dists(500 * k);
+		kdTree.kNearestBatchInRadius(queries.data(), 500, k, maxDist, indices.data(), dists.data());
+		for (UINT q = 0; q < 500; q++) {
+			const std::vector<std::pair<UINT, float>> expected = sortedScan(points, dimension, &queries[q * dimension]);
+			for (UINT i = 0; i < k; i++) {
+				if (expected[i].second < maxDist) {
+					MLIB_ASSERT_STR(indices[q * k + i] == expected[i].first, "neighbor within the radius is missing");
+				}
+				else if (expected[i].second > maxDist) {
+					MLIB_ASSERT_STR(indices[q * k + i] == (UINT)-1 && dists[q * k + i] == std::numeric_limits<float>::max(), "neighbor beyond the radius is not marked as missing");
+				}
+			}
+		}
+
+		//fewer points than neighbors
+		for (NearestNeighborSearch<float>* search : searches) {
+			search->init(points.data(), 3, dimension, k);
+			search->kNearestBatch(queries.data(), 2, k, indices.data(), dists.data());
+			for (UINT q = 0; q < 2; q++) {
+				for (UINT i = 3; i < k; i++) {
+					MLIB_ASSERT_STR(indices[q * k + i] == (UINT)-1 && dists[q * k + i] == std::numeric_limits<float>::max(), "missing neighbor is not marked");
+				}
+			}
+		}
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test2()
+	{
+		//blocked brute force with high-dimensional descriptors: partial point and query blocks, ties broken by index
+		const UINT dimension = 128, numPoints = 1000, numQueries = 37, k = 5;
+		std::vector<float> points = randomPoints(numPoints, dimension);
+		for (UINT d = 0; d < dimension; d++) {
+			points[500 * dimension + d] = points[d];
+			points[999 * dimension + d] = points[d];
+		}
+		NearestNeighborSearchBruteForce<float> bruteForce;
+		bruteForce.init(points.data(), numPoints, dimension, k);
+
+		std::vector<float> queries = randomPoints(numQueries, dimension);
+		for (UINT d = 0; d < dimension; d++) queries[d] = points[d];
+		std::vector<UINT> indices(numQueries * k);
+		std::vector<float> dists(numQueries * k);
+		bruteForce.kNearestBatch(queries.data(), numQueries, k, indices.data(), dists.data());
+		MLIB_ASSERT_STR(indices[0] == 0 && indices[1] == 500 && indices[2] == 999 && dists[0] == 0.0f, "ties are not broken by index");
+
+		for (UINT q = 0; q < numQueries; q++) {
+			const float* query = &queries[q * dimension];
+			std::vector<std::pair<UINT, float>> expected;
+			for (UINT i = 0; i < numPoints; i++) {
+				//the kernel accumulates the squared differences in the same order, so the distances are identical
+				float d = 0.0f;
+				for (UINT j = 0; j < dimension; j++) d += (points[i * dimension + j] - query[j]) * (points[i * dimension + j] - query[j]);
+				expected.push_back(std::make_pair(i, d));
+			}
+			std::sort(expected.begin(), expected.end(), [](const std::pair<UINT, float>& a, const std::pair<UINT, float>& b) { return a.second < b.second || (a.second == b.second && a.first < b.first); });
+			for (UINT i = 0; i < k; i++) {
+				MLIB_ASSERT_STR(indices[q * k + i] == expected[i].first && dists[q * k + i] == std::sqrt(expected[i].second), "blocked brute force differs from the scalar scan");
+			}
+			MLIB_ASSERT_STR(bruteForce.kNearest(query, k, 0.0f) == std::vector<UINT>(indices.begin() + q * k, indices.begin() + (q + 1) * k), "single query differs from the batch");
+
+			const float radius = std::sqrt(0.5f * (expected[10].second + expected[11].second));
+			const std::vector<std::pair<UINT, float>> inRadius = bruteForce.fixedRadiusDist(query, 0, radius);
+			MLIB_ASSERT_STR(inRadius.size() == 11, "wrong number of points within the radius");
+			for (size_t i = 0; i < inRadius.size(); i++) {
+				MLIB_ASSERT_STR(inRadius[i].first == expected[i].first, "brute-force radius query differs from the scan");
+			}
+		}
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	std::string getName() {
+		return "nearestNeighbor";
+	}
+
+private:
+	static std::vector<float> randomPoints(UINT numPoints, UINT dimension) {
+		std::vector<float> points(numPoints * dimension);
+		for (float& p : points) p = math::randomUniform(-1.0f, 1.0f);
+		return points;
+	}
+
+	static float dist(const float* a, const float* b, UINT dimension) {
+		double d = 0.0;
+		for (UINT i = 0; i < dimension; i++) d += ((double)a[i] - b[i]) * ((double)a[i] - b[i]);
+		return (float)std::sqrt(d);
+	}
+
+	//! all points sorted by their distance to the query (ties by index)
+	static std::vector<std::pair<UINT, float>> sortedScan(const std::vector<float>& points, UINT dimension, const float* query) {
+		std::vector<std::pair<UINT, float>> result;
+		for (UINT i = 0; i < points.size() / dimension; i++) result.push_back(std::make_pair(i, dist(&points[i * dimension], query, dimension)));
+		std::sort(result.begin(), result.end(), [](const std::pair<UINT, float>& a, const std::pair<UINT, float>& b) { return a.second < b.second || (a.second == b.second && a.first < b.first); });
+		return result;
+	}
+};
@@ -0,0 +1,412 @@
+
+class TestPointCloud : public Test {
+public:
+	void test0()
+	{
+		//farthest point sampling never keeps a point twice, also when there are fewer distinct points than requested
+		{
+			PointCloudf pc;
+			for (int i = 0; i < 5; i++) pc.m_points.push_back(vec3f(0.0f, 0.0f, 0.0f));
+			pc.m_points.push_back(vec3f(1.0f, 0.0f, 0.0f));
+			pc.m_points.push_back(vec3f(2.0f, 0.0f, 0.0f));
+			const size_t n = pc.downsampleFarthestPoint(5);
+			MLIB_ASSERT_STR(n == 3 && pc.m_points.size() == 3, "duplicate points were kept");
+			MLIB_ASSERT_STR(pc.m_points[0] == vec3f(0.0f, 0.0f, 0.0f) && pc.m_points[1] == vec3f(2.0f, 0.0f, 0.0f) && pc.m_points[2] == vec3f(1.0f, 0.0f, 0.0f), "wrong selection order");
+		}
+		{
+			//points on a line: each step keeps the point farthest from the kept ones, no point is kept twice
+			PointCloudf pc;
+			for (int i = 0; i <= 16; i++) pc.m_points.push_back(vec3f((float)i, 0.0f, 0.0f));
+			pc.downsampleFarthestPoint(5);
+			MLIB_ASSERT_STR(pc.m_points.size() == 5, "wrong number of points");
+			std::set<float> xs;
+			for (const vec3f& p : pc.m_points) xs.insert(p.x);
+			MLIB_ASSERT_STR(xs == std::set<float>({ 0.0f, 4.0f, 8.0f, 12.0f, 16.0f }), "farthest point sampling on a line failed");
+		}
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test1()
+	{
+		//out-of-core octree: a dense cluster in a single cell of the counting grid must not exceed the memory budget
+		PointCloudf pc;
+		for (int i = 0; i < 29990; i++) pc.m_points.push_back(vec3f(math::randomUniform(0.0f, 0.001f), math::randomUniform(0.0f, 0.001f), math::randomUniform(0.0f, 0.001f)));
+		for (int i = 0; i < 10; i++) pc.m_points.push_back(vec3f(math::randomUniform(0.0f, 100.0f), math::randomUniform(0.0f, 100.0f), math::randomUniform(0.0f, 100.0f)));
+		PointCloudIOf::saveToPLY("octreeInput.ply", pc);
+
+		PointCloudOctreeBuilderf::Params params;
+		params.maxPointsPerNode = 500;
+		params.lodResolution = 16;
+		params.memoryBudget = 2000 * (sizeof(vec3f) + 64);		//chunks of at most 2000 points
+		PointCloudOctreeBuilderf::build("octreeInput.ply", "octree.oct", params);
+
+		{
+			PointCloudOctreef octree("octree.oct", 20000);
+			for (UINT n = 0; n < octree.getNumNodes(); n++) {
+				if (octree.getNode(n).isLeaf()) MLIB_ASSERT_STR(octree.getNode(n).numPoints <= params.maxPointsPerNode, "leaf is too large");
+			}
+
+			//full detail returns every point exactly once
+			PointCloudf result;
+			octree.query(BoundingBox3f(vec3f(-1.0f, -1.0f, -1.0f), vec3f(101.0f, 101.0f, 101.0f)), 0.0f, result);
+			MLIB_ASSERT_STR(result.m_points.size() == pc.m_points.size(), "octree lost points");
+			auto less = [](const vec3f& a, const vec3f& b) { return a.x < b.x || (a.x == b.x && (a.y < b.y || (a.y == b.y && a.z < b.z))); };
+			std::sort(result.m_points.begin(), result.m_points.end(), less);
+			std::sort(pc.m_points.begin(), pc.m_points.end(), less);
+			MLIB_ASSERT_STR(result.m_points == pc.m_points, "octree points do not match the input");
+			MLIB_ASSERT_STR(octree.getCacheSize() <= 20000, "cache exceeds its budget");
+
+			//a node that is larger than the budget is not cached
+			octree.setCacheBudget(1000);
+			MLIB_ASSERT_STR(octree.getCacheSize() <= 1000, "cache exceeds its budget");
+			for (UINT n = 0; n < octree.getNumNodes(); n++) {
+				std::shared_ptr<const PointCloudf> points = octree.loadNode(n);
+				MLIB_ASSERT_STR(points->m_points.size() == octree.getNode(n).numPoints, "wrong number of points in node");
+				MLIB_ASSERT_STR(octree.getCacheSize() <= 1000, "cache exceeds its budget");
+			}
+		}
+		util::deleteFile("octreeInput.ply");
+		util::deleteFile("octree.oct");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test2()
+	{
+		//uniform point grid in every mode against a scan: radius queries (single and batched) and kNN, also from far outside
+		std::vector<vec3f> points;
+		for (int i = 0; i < 3000; i++) points.push_back(vec3f(math::randomUniform(-2.0f, 1.0f), math::randomUniform(0.0f, 1.0f), math::randomUniform(-1.0f, -0.5f)));
+		points.push_back(vec3f(50.0f, -40.0f, 30.0f));
+		std::vector<vec3f> queries;
+		for (int i = 0; i < 200; i++) queries.push_back(vec3f(math::randomUniform(-2.5f, 1.5f), math::randomUniform(-0.5f, 1.5f), math::randomUniform(-1.5f, 0.0f)));
+		queries.push_back(vec3f(100.0f, 100.0f, 100.0f));
+
+		const UniformPointGridf::Mode modes[3] = { UniformPointGridf::MODE_AUTO, UniformPointGridf::MODE_DENSE, UniformPointGridf::MODE_HASHED };
+		for (UniformPointGridf::Mode mode : modes) {
+			UniformPointGridf grid;
+			grid.build(points, 0.1f, mode);
+			MLIB_ASSERT_STR(grid.getNumPoints() == points.size() && grid.isHashed() == (mode != UniformPointGridf::MODE_DENSE), "wrong grid mode or size");	//the outlier makes the bounding box too sparse
+			for (size_t i = 0; i < points.size(); i++) {
+				MLIB_ASSERT_STR(grid.getSortedPoints()[i] == points[grid.getSortedIndices()[i]], "sorted points do not match their indices");
+			}
+
+			const float radius = 0.15f;
+			std::vector<UINT> offsets, neighbors;
+			grid.radiusSearchBatch(queries.data(), queries.size(), radius, offsets, neighbors);
+			const UINT k = 6;
+			std::vector<UINT> knnIdx(queries.size() * k);
+			std::vector<float> knnDist(queries.size() * k);
+			grid.kNearestBatch(queries.data(), queries.size(), k, knnIdx.data(), knnDist.data());
+			for (size_t q = 0; q < queries.size(); q++) {
+				std::vector<std::pair<float, UINT>> expected;
+				for (UINT i = 0; i < points.size(); i++) expected.push_back(std::make_pair(vec3f::distSq(points[i], queries[q]), i));
+				std::sort(expected.begin(), expected.end());
+
+				std::set<UINT> inRadius;
+				for (const auto& e : expected) {
+					if (e.first <= radius * radius) inRadius.insert(e.second);
+				}
+				std::vector<std::pair<UINT, float>> result;
+				grid.radiusSearch(queries[q], radius, result);
+				std::set<UINT> found;
+				for (const auto& r : result) found.insert(r.first);
+				MLIB_ASSERT_STR(result.size() == found.size() && found == inRadius, "radius query differs from the scan");
+				MLIB_ASSERT_STR(std::set<UINT>(neighbors.begin() + offsets[q], neighbors.begin() + offsets[q + 1]) == inRadius, "batched radius query differs from the scan");
+
+				for (UINT i = 0; i < k; i++) {
+					MLIB_ASSERT_STR(knnIdx[q * k + i] == expected[i].second && math::floatEqual(knnDist[q * k + i], std::sqrt(expected[i].first), 1e-5f), "kNN differs from the scan");
+				}
+			}
+		}
+
+		//fewer points than neighbors
+		UniformPointGridf small;
+		small.build(std::vector<vec3f>(points.begin(), points.begin() + 3), 0.1f);
+		UINT idx[5];
+		float dist[5];
+		small.kNearest(vec3f::origin, 5, idx, dist);
+		MLIB_ASSERT_STR(idx[2] != (UINT)-1 && idx[3] == (UINT)-1 && idx[4] == (UINT)-1 && dist[4] == std::numeric_limits<float>::max(), "missing neighbors are not marked");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test3()
+	{
+		//PCA normals of a sphere (kNN and radius neighborhoods), their orientation, and the closed-form eigensolver
+		PointCloudf sphere;
+		for (int i = 0; i < 5000; i++) {
+			vec3f p(math::randomNormal(0.0f, 1.0f), math::randomNormal(0.0f, 1.0f), math::randomNormal(0.0f, 1.0f));
+			sphere.m_points.push_back(p.getNormalized());
+		}
+		sphere.computeNormals(16);
+		for (size_t i = 0; i < sphere.m_points.size(); i++) {
+			MLIB_ASSERT_STR(std::abs(sphere.m_normals[i] | sphere.m_points[i]) > 0.99f, "kNN normal is not perpendicular to the sphere");
+		}
+		sphere.orientNormals(vec3f::origin);
+		for (size_t i = 0; i < sphere.m_points.size(); i++) {
+			MLIB_ASSERT_STR((sphere.m_normals[i] | sphere.m_points[i]) < 0.0f, "normal does not face the viewpoint");
+		}
+		sphere.orientNormalsMST();
+		for (size_t i = 0; i < sphere.m_points.size(); i++) {
+			MLIB_ASSERT_STR((sphere.m_normals[i] | sphere.m_points[i]) > 0.0f, "MST orientation is inconsistent");
+		}
+
+		//a plane has no surface variation; an isolated point has too few neighbors
+		std::vector<vec3f> plane, normals;
+		for (int i = 0; i < 1000; i++) plane.push_back(vec3f(math::randomUniform(0.0f, 1.0f), math::randomUniform(0.0f, 1.0f), 0.5f));
+		plane.push_back(vec3f(5.0f, 5.0f, 5.0f));
+		std::vector<float> curvature;
+		PointCloudNormalsf::computeInRadius(plane, normals, 0.1f, &curvature);
+		for (size_t i = 0; i + 1 < plane.size(); i++) {
+			MLIB_ASSERT_STR(std::abs(normals[i].z) > 0.9999f && curvature[i] < 1e-6f, "plane normal is wrong");
+		}
+		MLIB_ASSERT_STR(normals.back() == vec3f::origin, "isolated point has a normal");
+
+		const mat3f rotation = mat3f::rotation(vec3f(1.0f, -2.0f, 0.5f).getNormalized(), 35.0f);
+		const mat3f m = rotation * mat3f::diag(3.0f, 1.0f, 2.0f) * rotation.getTranspose();
+		vec3f eigenValues, eigenVectors[3];
+		PointCloudNormalsf::eigenSymmetric3x3(m, eigenValues, eigenVectors);
+		MLIB_ASSERT_STR(vec3f::dist(eigenValues, vec3f(1.0f, 2.0f, 3.0f)) < 1e-4f, "wrong eigenvalues");
+		for (int i = 0; i < 3; i++) {
+			MLIB_ASSERT_STR(vec3f::dist(m * eigenVectors[i], eigenVectors[i] * eigenValues[i]) < 1e-4f && math::floatEqual(eigenVectors[i].length(), 1.0f, 1e-5f), "wrong eigenvector");
+		}
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test4()
+	{
+		//outlier removal against brute force; compact keeps the attributes of the remaining points together
+		PointCloudf pc;
+		for (int i = 0; i < 2000; i++) pc.m_points.push_back(vec3f(math::randomUniform(0.0f, 1.0f), math::randomUniform(0.0f, 1.0f), math::randomUniform(0.0f, 1.0f)));
+		for (int i = 0; i < 10; i++) pc.m_points.push_back(vec3f(5.0f + 3.0f * i, -4.0f, 2.0f));
+		for (size_t i = 0; i < pc.m_points.size(); i++) pc.m_colors.push_back(vec4f((float)i, 0.0f, 0.0f, 1.0f));
+		const std::vector<vec3f> original = pc.m_points;
+
+		//statistical: mean distance to the 8 nearest other points, threshold mean + 2 sigma
+		std::vector<BYTE> keep;
+		const size_t numInliers = PointCloudFilterf::statisticalOutlierMask(original, keep, 8, 2.0f);
+		std::vector<double> meanDist(original.size());
+		double sum = 0.0, sumSq = 0.0;
+		for (size_t i = 0; i < original.size(); i++) {
+			std::vector<float> d;
+			for (size_t j = 0; j < original.size(); j++) {
+				if (j != i) d.push_back(vec3f::dist(original[i], original[j]));
+			}
+			std::partial_sort(d.begin(), d.begin() + 8, d.end());
+			meanDist[i] = std::accumulate(d.begin(), d.begin() + 8, 0.0) / 8.0;
+			sum += meanDist[i];
+			sumSq += meanDist[i] * meanDist[i];
+		}
+		const double mean = sum / original.size(), thresh = mean + 2.0 * std::sqrt(sumSq / original.size() - mean * mean);
+		for (size_t i = 0; i < original.size(); i++) {
+			if (std::abs(meanDist[i] - thresh) > 1e-4) MLIB_ASSERT_STR(keep[i] == (meanDist[i] <= thresh ? 1 : 0), "statistical outlier mask differs from brute force");
+		}
+		for (size_t i = 2000; i < original.size(); i++) MLIB_ASSERT_STR(!keep[i], "outlier was kept");
+		MLIB_ASSERT_STR(numInliers == (size_t)std::count(keep.begin(), keep.end(), 1), "wrong number of inliers");
+
+		MLIB_ASSERT_STR(pc.removeStatisticalOutliers(8, 2.0f) == numInliers && pc.m_points.size() == numInliers && pc.m_colors.size() == numInliers, "statistical outlier removal failed");
+		for (size_t i = 0; i < pc.m_points.size(); i++) {
+			const size_t index = (size_t)pc.m_colors[i].x;
+			MLIB_ASSERT_STR(keep[index] && pc.m_points[i] == original[index] && (i == 0 || index > (size_t)pc.m_colors[i - 1].x), "compact lost the order or the attributes");
+		}
+
+		//radius: at least 3 other points within 0.1
+		const size_t numRadiusInliers = PointCloudFilterf::radiusOutlierMask(original, keep, 0.1f, 3);
+		for (size_t i = 0; i < original.size(); i++) {
+			UINT count = 0;
+			for (size_t j = 0; j < original.size(); j++) {
+				if (j != i && vec3f::distSq(original[i], original[j]) <= 0.1f * 0.1f) count++;
+			}
+			MLIB_ASSERT_STR(keep[i] == (count >= 3 ? 1 : 0), "radius outlier mask differs from brute force");
+		}
+		PointCloudf radiusFiltered;
+		radiusFiltered.m_points = original;
+		MLIB_ASSERT_STR(radiusFiltered.removeRadiusOutliers(0.1f, 3) == numRadiusInliers && radiusFiltered.m_points.size() == numRadiusInliers, "radius outlier removal failed");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test5()
+	{
+		//binary and ascii round trips through PLY and PCD, with and without normals and colors (colors are stored as bytes)
+		PointCloudf pc;
+		for (int i = 0; i < 5000; i++) {
+			pc.m_points.push_back(vec3f(math::randomUniform(-10.0f, 10.0f), math::randomUniform(-10.0f, 10.0f), math::randomUniform(-10.0f, 10.0f)));
+			pc.m_normals.push_back(vec3f(math::randomUniform(-1.0f, 1.0f), math::randomUniform(-1.0f, 1.0f), math::randomUniform(-1.0f, 1.0f)).getNormalized());
+			pc.m_colors.push_back(vec4f((float)(i % 256), (float)((i * 7) % 256), (float)((i * 13) % 256), (float)(255 - i % 256)) / 255.0f);
+		}
+		PointCloudf pointsOnly;
+		pointsOnly.m_points = pc.m_points;
+		PointCloudf withNormals;
+		withNormals.m_points = pc.m_points;
+		withNormals.m_normals = pc.m_normals;
+
+		for (const PointCloudf* input : { &pointsOnly, &withNormals, &pc }) {
+			PointCloudIOf::saveToPLY("roundTrip.ply", *input);
+			checkRoundTrip(*input, PointCloudIOf::loadFromFile("roundTrip.ply"), 0.0f);
+			PointCloudIOf::saveToPCD("roundTrip.pcd", *input);
+			checkRoundTrip(*input, PointCloudIOf::loadFromFile("roundTrip.pcd"), 0.0f);
+			PointCloudIOf::saveToPCD("roundTrip.pcd", *input, false);
+			checkRoundTrip(*input, PointCloudIOf::loadFromFile("roundTrip.pcd"), 1e-6f);
+		}
+
+		//double precision PCD files keep the full precision
+		PointCloudd pcd;
+		for (int i = 0; i < 100; i++) pcd.m_points.push_back(vec3d(math::randomUniform(-1.0, 1.0), math::randomUniform(-1.0, 1.0), 1.0 + 1e-12 * i));
+		PointCloudIOd::saveToPCD("roundTrip.pcd", pcd);
+		MLIB_ASSERT_STR(PointCloudIOd::loadFromFile("roundTrip.pcd").m_points == pcd.m_points, "double precision PCD round trip failed");
+
+		//more points than fit into one staging chunk
+		PointCloudf large;
+		for (int i = 0; i < (1 << 20) + 1000; i++) large.m_points.push_back(vec3f((float)i, (float)-i, 0.5f * i));
+		PointCloudIOf::saveToPCD("roundTrip.pcd", large);
+		MLIB_ASSERT_STR(PointCloudIOf::loadFromFile("roundTrip.pcd").m_points == large.m_points, "PCD round trip over several chunks failed");
+		PointCloudIOf::saveToPLY("roundTrip.ply", large);
+		MLIB_ASSERT_STR(PointCloudIOf::loadFromFile("roundTrip.ply").m_points == large.m_points, "PLY round trip over several chunks failed");
+
+		util::deleteFile("roundTrip.ply");
+		util::deleteFile("roundTrip.pcd");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test6()
+	{
+		//ICP recovers a known rigid transform of a curved surface with both metrics, with outliers and coarse-to-fine
+		PointCloudf target;
+		for (int j = 0; j < 60; j++) {
+			for (int i = 0; i < 60; i++) {
+				const float x = -1.5f + 0.05f * i, y = -1.5f + 0.05f * j;
+				target.m_points.push_back(vec3f(x, y, 0.3f * std::sin(2.0f * x) * std::cos(3.0f * y) + 0.2f * x * x));
+			}
+		}
+		const mat4f expected = mat4f::translation(0.05f, -0.03f, 0.04f) * mat4f::rotation(5.0f, -3.0f, 4.0f);
+		const mat4f toSource = expected.getInverse();
+		PointCloudf source;
+		for (const vec3f& p : target.m_points) source.m_points.push_back(toSource * p);
+
+		PointCloudICPf icp;
+		icp.setTarget(target);
+		PointCloudICPf::Params params;
+		params.weighting = PointCloudICPf::WEIGHT_NONE;
+		PointCloudICPf::Result result = icp.align(source, mat4f::identity(), params);
+		MLIB_ASSERT_STR(result.converged && result.rmse < 1e-3f && result.numCorrespondences == source.m_points.size(), "point-to-plane ICP did not converge");
+		checkTransform(result.transform, expected, 1e-3f);
+
+		params.metric = PointCloudICPf::METRIC_POINT_TO_POINT;
+		params.weighting = PointCloudICPf::WEIGHT_HUBER;
+		params.maxIterations = 200;
+		result = icp.align(source.m_points, mat4f::identity(), params);
+		checkTransform(result.transform, expected, 1e-3f);
+
+		//far outliers are either outside the correspondence distance or rejected by the Tukey weights
+		PointCloudf noisy;
+		noisy.m_points = source.m_points;
+		for (int i = 0; i < 300; i++) noisy.m_points.push_back(vec3f(math::randomUniform(-1.5f, 1.5f), math::randomUniform(-1.5f, 1.5f), math::randomUniform(0.5f, 1.5f)));
+		params = PointCloudICPf::Params();
+		params.weighting = PointCloudICPf::WEIGHT_TUKEY;
+		params.maxCorrespondenceDist = 0.4f;
+		result = icp.align(noisy, mat4f::identity(), params);
+		checkTransform(result.transform, expected, 1e-3f);
+		MLIB_ASSERT_STR(result.numCorrespondences >= source.m_points.size() && result.numCorrespondences < noisy.m_points.size(), "correspondence distance was ignored");
+
+		//coarse-to-fine on voxel-grid subsamples; the result is reproducible
+		params = PointCloudICPf::Params();
+		params.voxelSize = 0.05f;
+		params.numLevels = 3;
+		result = icp.align(source, mat4f::identity(), params);
+		checkTransform(result.transform, expected, 1e-2f);
+		MLIB_ASSERT_STR(icp.align(source, mat4f::identity(), params).transform == result.transform, "ICP is not reproducible");
+
+		bool thrown = false;
+		try {
+			params.voxelSize = 0.0f;
+			icp.align(source, mat4f::identity(), params);
+		}
+		catch (const MLibException&) {
+			thrown = true;
+		}
+		MLIB_ASSERT_STR(thrown, "coarse-to-fine alignment without a voxel size was accepted");
+		thrown = false;
+		try {
+			PointCloudICPf empty;
+			empty.align(source);
+		}
+		catch (const MLibException&) {
+			thrown = true;
+		}
+		MLIB_ASSERT_STR(thrown, "alignment without a target was accepted");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test7()
+	{
+		//voxel-grid downsampling against a std::map of the voxels; the points lie away from the voxel faces
+		PointCloudf pc;
+		std::map<std::tuple<int, int, int>, std::vector<size_t>> voxels;
+		for (int i = 0; i < 20000; i++) {
+			const int x = math::randomUniform(-10, 9), y = math::randomUniform(-5, 4), z = math::randomUniform(0, 7);
+			const vec3f p = (vec3f((float)x, (float)y, (float)z) + vec3f(math::randomUniform(0.1f, 0.9f), math::randomUniform(0.1f, 0.9f), math::randomUniform(0.1f, 0.9f))) * 0.5f;
+			voxels[std::make_tuple(z, y, x)].push_back(pc.m_points.size());
+			pc.m_points.push_back(p);
+			pc.m_normals.push_back(vec3f(math::randomUniform(0.5f, 1.0f), math::randomUniform(-0.5f, 0.5f), 0.0f).getNormalized());
+			pc.m_colors.push_back(vec4f(math::randomUniform(0.0f, 1.0f), 0.0f, 1.0f, 1.0f));
+		}
+		const std::vector<vec3f> points = pc.m_points, normals = pc.m_normals;
+		const std::vector<vec4f> colors = pc.m_colors;
+
+		MLIB_ASSERT_STR(pc.downsampleVoxelGrid(0.5f) == voxels.size() && pc.m_normals.size() == voxels.size() && pc.m_colors.size() == voxels.size(), "wrong number of voxels");
+		size_t v = 0;
+		for (const auto& voxel : voxels) {
+			vec3f p = vec3f::origin, n = vec3f::origin;
+			vec4f c(0.0f, 0.0f, 0.0f, 0.0f);
+			for (size_t i : voxel.second) {
+				p += points[i];
+				n += normals[i];
+				c += colors[i];
+			}
+			p /= (float)voxel.second.size();
+			c /= (float)voxel.second.size();
+			MLIB_ASSERT_STR((pc.m_points[v] - p).length() < 1e-4f, "voxel centroid differs (or voxels are not ordered)");
+			MLIB_ASSERT_STR((pc.m_normals[v] - n.getNormalized()).length() < 1e-4f, "voxel normal differs");
+			MLIB_ASSERT_STR((pc.m_colors[v] - c).length() < 1e-4f, "voxel color differs");
+			v++;
+		}
+
+		bool thrown = false;
+		try {
+			pc.downsampleVoxelGrid(0.0f);
+		}
+		catch (const MLibException&) {
+			thrown = true;
+		}
+		MLIB_ASSERT_STR(thrown, "invalid voxel size was accepted");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	std::string getName() {
+		return "pointCloud";
+	}
+
+private:
+	static void checkTransform(const mat4f& m, const mat4f& expected, float eps) {
+		for (unsigned int i = 0; i < 16; i++) MLIB_ASSERT_STR(std::abs(m[i] - expected[i]) < eps, "ICP did not recover the transform");
+	}
+
+	//! compares the attributes of a loaded point cloud; eps is relative to the magnitude of the values
+	static void checkRoundTrip(const PointCloudf& expected, const PointCloudf& loaded, float eps) {
+		MLIB_ASSERT_STR(loaded.m_points.size() == expected.m_points.size() && loaded.m_normals.size() == expected.m_normals.size() && loaded.m_colors.size() == expected.m_colors.size(), "round trip changed the attributes");
+		auto equal = [eps](float a, float b) { return std::abs(a - b) <= eps * std::max(1.0f, std::abs(b)); };
+		for (size_t i = 0; i < expected.m_points.size(); i++) {
+			for (unsigned int d = 0; d < 3; d++) {
+				MLIB_ASSERT_STR(equal(loaded.m_points[i][d], expected.m_points[i][d]), "round trip changed a point");
+				if (expected.hasNormals()) MLIB_ASSERT_STR(equal(loaded.m_normals[i][d], expected.m_normals[i][d]), "round trip changed a normal");
+			}
+			if (expected.hasColors()) MLIB_ASSERT_STR((loaded.m_colors[i] - expected.m_colors[i]).length() < 1e-6f, "round trip changed a color");
+		}
+	}
+};
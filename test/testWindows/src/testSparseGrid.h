@@ -0,0 +1,270 @@
+
+class TestSparseGrid : public Test {
+public:
+	void test0()
+	{
+		//random inserts, overwrites and erases against std::map
+		SparseGrid3<int> grid;
+		std::map<vec3i, int, KeyLess> reference;
+		for (int i = 0; i < 20000; i++) {
+			const vec3i key(math::randomUniform(-20, 20), math::randomUniform(-20, 20), math::randomUniform(-20, 20));
+			const int op = math::randomUniform(0, 3);
+			if (op == 0) {
+				grid.insert(key, i);
+				reference[key] = i;
+			}
+			else if (op == 1) {
+				grid(key) += 1;
+				reference[key] += 1;
+			}
+			else {
+				MLIB_ASSERT_STR(grid.erase(key) == (reference.erase(key) == 1), "erase differs from std::map");
+			}
+		}
+
+		//bulk insert
+		std::vector<vec3i> keys;
+		std::vector<int> values;
+		for (int i = 0; i < 5000; i++) {
+			keys.push_back(vec3i(math::randomUniform(-30, 30), math::randomUniform(-30, 30), math::randomUniform(-30, 30)));
+			values.push_back(-i);
+			reference[keys.back()] = -i;
+		}
+		grid.insert(keys, values);
+
+		checkEqual(grid, reference);
+		SparseGrid3<int> copy = grid;
+		checkEqual(copy, reference);
+		SparseGrid3<int> assigned;
+		assigned = copy;
+		checkEqual(assigned, reference);
+
+		//the keys cannot be modified through the iterators (which would corrupt the table)
+		static_assert(std::is_const<decltype(grid.begin()->first)>::value, "keys of the sparse grid must be const");
+		static_assert(std::is_same<SparseGrid3<int>::Entry, std::pair<const vec3i, int>>::value, "elements of the sparse grid must be pairs with a const key");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test1()
+	{
+		//concurrent insertion with many duplicate keys; existing elements are kept
+		SparseGrid3<int> grid;
+		std::map<vec3i, int, KeyLess> reference;
+		for (int i = 0; i < 1000; i++) {
+			const vec3i key(i % 10, (i / 10) % 10, i / 100);
+			grid.insert(key, -1);
+			reference[key] = -1;
+		}
+
+		const int numInsertions = 200000;
+		std::vector<vec3i> keys(numInsertions);
+		for (int i = 0; i < numInsertions; i++) {
+			keys[i] = vec3i(math::randomUniform(0, 40), math::randomUniform(0, 40), math::randomUniform(0, 40));
+		}
+		std::vector<BYTE> inserted(numInsertions);
+		{
+			SparseGrid3<int>::ConcurrentInserter inserter(grid, numInsertions);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < numInsertions; i++) {
+				inserted[i] = inserter.insert(keys[i], i) ? 1 : 0;
+			}
+			inserter.finish();
+		}
+
+		//every new key is inserted exactly once, by one of its insertions
+		std::map<vec3i, int, KeyLess> numInserted;
+		for (int i = 0; i < numInsertions; i++) {
+			if (reference.find(keys[i]) == reference.end()) numInserted[keys[i]] += inserted[i];
+			else MLIB_ASSERT_STR(!inserted[i], "existing key was inserted again");
+		}
+		for (const auto& k : numInserted) {
+			MLIB_ASSERT_STR(k.second == 1, "key was not inserted exactly once");
+			MLIB_ASSERT_STR(grid.exists(k.first) && keys[grid(k.first)] == k.first && inserted[grid(k.first)], "value of the winning insertion is not stored");
+		}
+		MLIB_ASSERT_STR(grid.size() == reference.size() + numInserted.size(), "wrong number of elements after concurrent insertion");
+		for (const auto& r : reference) {
+			MLIB_ASSERT_STR(grid(r.first) == -1, "existing element was overwritten");
+		}
+
+		//duplicate insertions do not use up the capacity: exactly as many slots as there are distinct new keys suffice
+		{
+			SparseGrid3<int> tight;
+			tight.insert(vec3i(0, 0, 0), -1);
+			SparseGrid3<int>::ConcurrentInserter inserter(tight, 63);
+#ifdef MLIB_OPENMP
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < 10000; i++) {
+				inserter.insert(vec3i(i % 4, (i / 4) % 4, (i / 16) % 4), i);
+			}
+			MLIB_ASSERT_STR(inserter.finish() == 63 && tight.size() == 64 && tight(0, 0, 0) == -1, "duplicate insertions exhausted the capacity");
+		}
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test2()
+	{
+		//block grid against std::map, with negative coordinates, accessors, prune and copies
+		SparseBlockGrid3f grid(-1.0f);
+		std::map<vec3i, float, KeyLess> reference;
+		for (int i = 0; i < 20000; i++) {
+			const vec3i c(math::randomUniform(-20, 20), math::randomUniform(-20, 20), math::randomUniform(-20, 20));
+			if (math::randomUniform(0, 4) == 0) {
+				grid.setInactive(c);
+				reference.erase(c);
+			}
+			else {
+				grid.setValue(c, (float)i);
+				reference[c] = (float)i;
+			}
+		}
+		checkEqual(grid, reference);
+
+		//accessors cache blocks along a line that crosses several blocks
+		{
+			SparseBlockGrid3f::Accessor accessor = grid.getAccessor();
+			for (int x = -30; x < 30; x++) {
+				accessor(vec3i(x, 3, -5)) = 0.5f * x;
+				reference[vec3i(x, 3, -5)] = 0.5f * x;
+				MLIB_ASSERT_STR(accessor.getValue(vec3i(x, 3, -5)) == 0.5f * x && accessor.isActive(vec3i(x, 3, -5)), "accessor read differs");
+				MLIB_ASSERT_STR(accessor.getValue(vec3i(x, 100, 0)) == -1.0f && !accessor.isActive(vec3i(x, 100, 0)), "accessor read outside the allocated blocks");
+			}
+
+			//a block allocated through the grid after a missed lookup is visible to the accessors
+			SparseBlockGrid3f::ConstAccessor constAccessor = ((const SparseBlockGrid3f&)grid).getAccessor();
+			MLIB_ASSERT_STR(!accessor.isActive(vec3i(200, 0, 0)) && !constAccessor.isActive(vec3i(200, 0, 0)), "block was allocated by a read");
+			grid.setValue(vec3i(200, 0, 0), 2.0f);
+			reference[vec3i(200, 0, 0)] = 2.0f;
+			MLIB_ASSERT_STR(accessor.getValue(vec3i(200, 0, 0)) == 2.0f && accessor.isActive(vec3i(200, 0, 0)), "accessor cached a missing block");
+			MLIB_ASSERT_STR(constAccessor.getValue(vec3i(200, 0, 0)) == 2.0f && constAccessor.isActive(vec3i(200, 0, 0)), "const accessor cached a missing block");
+		}
+		checkEqual(grid, reference);
+
+		//parallel update of the active voxels
+		grid.applyActiveParallel([](const vec3i& c, float& v) { v += (float)c.x; });
+		for (auto& r : reference) r.second += (float)r.first.x;
+		checkEqual(grid, reference);
+
+		//copies are independent
+		SparseBlockGrid3f copy = grid;
+		copy.setValue(vec3i(1000, 1000, 1000), 1.0f);
+		MLIB_ASSERT_STR(!grid.isActive(vec3i(1000, 1000, 1000)) && copy.getNumBlocks() == grid.getNumBlocks() + 1, "copy shares blocks");
+		checkEqual(grid, reference);
+
+		//prune keeps the voxels and removes the blocks without active voxels
+		for (int z = 64; z < 72; z++) {
+			grid.setValue(vec3i(64, 64, z), 1.0f);
+			grid.setInactive(vec3i(64, 64, z));
+		}
+		const size_t numBlocks = grid.getNumBlocks();
+		MLIB_ASSERT_STR(grid.findBlock(vec3i(8, 8, 8)) != nullptr, "block was not allocated");
+		grid.prune();
+		MLIB_ASSERT_STR(grid.getNumBlocks() == numBlocks - 1 && grid.findBlock(vec3i(8, 8, 8)) == nullptr, "prune failed");
+		for (size_t b = 0; b < grid.getNumBlocks(); b++) {
+			MLIB_ASSERT_STR(grid.getBlockIndex(grid.getBlockCoord(b)) == b, "block index is stale after prune");
+		}
+		checkEqual(grid, reference);
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test3()
+	{
+		//conversions to and from dense grids with an offset that is not aligned to the blocks
+		Grid3f dense(21, 13, 17);
+		dense.setValues(0.0f);
+		BinaryGrid3 binary(21, 13, 17);
+		for (size_t z = 0; z < dense.getDimZ(); z++) {
+			for (size_t y = 0; y < dense.getDimY(); y++) {
+				for (size_t x = 0; x < dense.getDimX(); x++) {
+					if (math::randomUniform(0.0f, 1.0f) < 0.1f) {
+						dense(x, y, z) = (float)(x + 100 * y + 10000 * z) + 1.0f;
+						binary.setVoxel(x, y, z);
+					}
+				}
+			}
+		}
+		dense(0, 0, 0) = 1.0f;
+		dense(20, 12, 16) = 2.0f;
+		binary.setVoxel(0, 0, 0);
+		binary.setVoxel(20, 12, 16);
+
+		const vec3i offset(-11, 5, -3);
+		SparseBlockGrid3f grid(dense, 0.0f, offset);
+		MLIB_ASSERT_STR(grid.getNumActiveVoxels() == binary.getNumOccupiedEntries(), "wrong number of active voxels");
+		for (size_t z = 0; z < dense.getDimZ(); z++) {
+			for (size_t y = 0; y < dense.getDimY(); y++) {
+				for (size_t x = 0; x < dense.getDimX(); x++) {
+					const vec3i c = offset + vec3i((int)x, (int)y, (int)z);
+					MLIB_ASSERT_STR(grid.getValue(c) == dense(x, y, z) && grid.isActive(c) == binary.isVoxelSet(x, y, z), "conversion from Grid3 failed");
+				}
+			}
+		}
+		vec3i minCoord, maxCoord;
+		MLIB_ASSERT_STR(grid.getActiveBounds(minCoord, maxCoord) && minCoord == offset && maxCoord == offset + vec3i(20, 12, 16), "wrong active bounds");
+
+		vec3i denseOffset;
+		const Grid3f back = grid.toGrid3(denseOffset);
+		MLIB_ASSERT_STR(denseOffset == offset && back.getDimensions() == dense.getDimensions(), "wrong dense bounds");
+		for (size_t i = 0; i < dense.getNumElements(); i++) MLIB_ASSERT_STR(back.getData()[i] == dense.getData()[i], "conversion to Grid3 failed");
+
+		SparseBlockGrid3f fromBinary;
+		fromBinary.fromBinaryGrid(binary, 3.0f, offset);
+		MLIB_ASSERT_STR(fromBinary.getNumActiveVoxels() == binary.getNumOccupiedEntries() && fromBinary.getValue(offset) == 3.0f, "conversion from BinaryGrid3 failed");
+		vec3i binaryOffset;
+		MLIB_ASSERT_STR(fromBinary.toBinaryGrid(binaryOffset) == binary && binaryOffset == offset, "conversion to BinaryGrid3 failed");
+
+		//empty grids convert to empty grids
+		SparseBlockGrid3f empty;
+		MLIB_ASSERT_STR(empty.toGrid3(denseOffset).getNumElements() == 0 && !empty.getActiveBounds(minCoord, maxCoord), "empty grid has active voxels");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	std::string getName() {
+		return "sparseGrid";
+	}
+
+private:
+	struct KeyLess {
+		bool operator()(const vec3i& a, const vec3i& b) const {
+			return a.x < b.x || (a.x == b.x && (a.y < b.y || (a.y == b.y && a.z < b.z)));
+		}
+	};
+
+	static void checkEqual(const SparseBlockGrid3f& grid, const std::map<vec3i, float, KeyLess>& reference) {
+		MLIB_ASSERT_STR(grid.getNumActiveVoxels() == reference.size(), "number of active voxels differs from std::map");
+		SparseBlockGrid3f::ConstAccessor accessor = grid.getAccessor();
+		for (const auto& r : reference) {
+			MLIB_ASSERT_STR(grid.isActive(r.first) && grid.getValue(r.first) == r.second, "voxel differs from std::map");
+			MLIB_ASSERT_STR(accessor.isActive(r.first) && accessor.getValue(r.first) == r.second, "accessor differs from std::map");
+		}
+		size_t count = 0;
+		grid.forEachActiveVoxel([&](const vec3i& c, const float& v) {
+			auto it = reference.find(c);
+			MLIB_ASSERT_STR(it != reference.end() && it->second == v, "iteration differs from std::map");
+			count++;
+		});
+		MLIB_ASSERT_STR(count == reference.size(), "iteration differs from std::map");
+		MLIB_ASSERT_STR(grid.getValue(vec3i(-1000, 0, 0)) == grid.getBackground(), "unallocated voxel is not the background");
+	}
+
+	static void checkEqual(const SparseGrid3<int>& grid, const std::map<vec3i, int, KeyLess>& reference) {
+		MLIB_ASSERT_STR(grid.size() == reference.size(), "size differs from std::map");
+		for (const auto& r : reference) {
+			const int* v = grid.find(r.first);
+			MLIB_ASSERT_STR(v && *v == r.second, "element differs from std::map");
+		}
+		size_t count = 0;
+		for (const auto& e : grid) {
+			auto it = reference.find(e.first);
+			MLIB_ASSERT_STR(it != reference.end() && it->second == e.second, "iteration differs from std::map");
+			count++;
+		}
+		MLIB_ASSERT_STR(count == reference.size(), "iteration differs from std::map");
+	}
+};
@@ -0,0 +1,41 @@
+
+class TestTSDFVolume : public Test {
+public:
+	void test0()
+	{
+		//fusion of a fronto-parallel plane: the extracted mesh and the raycast depth lie on it
+		const unsigned int width = 64, height = 48;
+		const mat4f intrinsic(
+			40.0f, 0.0f, 31.5f, 0.0f,
+			0.0f, 40.0f, 23.5f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+		DepthImage32 depth(width, height);
+		depth.setPixels(1.0f);
+
+		TSDFVolume volume(0.02f);
+		volume.integrate(depth, intrinsic, mat4f::identity());
+		volume.integrate(depth, intrinsic, mat4f::identity());
+
+		//the blocks are meshed in parallel (the marching cubes tables must be initialized before)
+		const TriMeshf mesh = volume.extractMesh();
+		MLIB_ASSERT_STR(mesh.getIndices().size() > 0, "no surface extracted");
+		for (const auto& v : mesh.getVertices()) {
+			MLIB_ASSERT_STR(std::abs(v.position.z - 1.0f) < 0.01f, "mesh vertex is not on the plane");
+		}
+		MLIB_ASSERT_STR(volume.extractMesh().getVertices().size() == mesh.getVertices().size(), "unchanged blocks were not reused");
+
+		DepthImage32 raycastDepth;
+		PointImage normals;
+		volume.raycast(mat4f::identity(), intrinsic, width, height, raycastDepth, &normals);
+		const float d = raycastDepth(width / 2, height / 2);
+		MLIB_ASSERT_STR(std::abs(d - 1.0f) < 0.01f, "raycast depth is not on the plane");
+		MLIB_ASSERT_STR(vec3f::dist(normals(width / 2, height / 2), vec3f(0.0f, 0.0f, -1.0f)) < 0.05f, "raycast normal does not face the camera");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	std::string getName() {
+		return "tsdfVolume";
+	}
+};
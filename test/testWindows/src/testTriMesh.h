@@ -0,0 +1,403 @@
+
+class TestTriMesh : public Test {
+public:
+	void test0()
+	{
+		//parallel surface sampling: both overloads, determinism and the density cutoff
+		typedef TriMeshSampler<float> Sampler;
+		TriMeshf box = Shapesf::box(2.0f);
+		std::vector<Sampler::MeshData> meshes(1, std::make_pair(&box, mat4f::identity()));
+		Sampler::SurfaceDistribution distribution(meshes);
+		MLIB_ASSERT_STR(math::floatEqual((float)distribution.getTotalArea(), 24.0f, 1e-4f), "surface area of the box is wrong");
+
+		std::vector<Sampler::Sample> a = Sampler::sampleParallelByCount(distribution, 100, 5);
+		std::vector<Sampler::Sample> b = Sampler::sampleParallelByCount(distribution, 100, 5);
+		MLIB_ASSERT_STR(a.size() == 100, "wrong number of samples");
+		for (size_t i = 0; i < a.size(); i++) {
+			MLIB_ASSERT_STR(a[i].pos == b[i].pos, "sampling with the same seed is not deterministic");
+			const vec3f p = math::abs(a[i].pos);
+			MLIB_ASSERT_STR(math::floatEqual(std::max(std::max(p.x, p.y), p.z), 1.0f, 1e-5f), "sample is not on the surface");
+		}
+
+		MLIB_ASSERT_STR(Sampler::sampleParallelByDensity(distribution, 10.0f, 1000, 5).size() == 240, "wrong number of samples for the density");
+		MLIB_ASSERT_STR(Sampler::sampleParallelByDensity(distribution, 10.0f, 50, 5).size() == 50, "maxSampleCount is ignored");
+		MLIB_ASSERT_STR(Sampler::sampleParallelByDensity(meshes, 10.0f, 1000, [](const vec3f& n) { return n.z > 0.5f; }).size() == 40, "normal predicate is ignored");
+
+		std::vector<Sampler::Sample> disk = Sampler::sampleParallelByCount(distribution, 100, 5, Sampler::MODE_POISSON_DISK, 0.3f);
+		for (size_t i = 0; i < disk.size(); i++) {
+			for (size_t j = i + 1; j < disk.size(); j++) {
+				MLIB_ASSERT_STR(vec3f::dist(disk[i].pos, disk[j].pos) >= 0.3f, "poisson disk samples are too close");
+			}
+		}
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test1()
+	{
+		//marching cubes of a random field (all ambiguous cases occur) is closed and consistently oriented, if the border is outside
+		Grid3f grid(17, 13, 15);
+		grid.fill([&](size_t x, size_t y, size_t z) {
+			const bool border = x == 0 || y == 0 || z == 0 || x + 1 == grid.getDimX() || y + 1 == grid.getDimY() || z + 1 == grid.getDimZ();
+			return border ? 1.0f : math::randomUniform(-1.0f, 1.0f);
+		});
+		TriMeshf mesh = GridMesherf::marchingCubes(grid);
+		MLIB_ASSERT_STR(mesh.getIndices().size() > 0, "no surface extracted");
+		MLIB_ASSERT_STR(isWatertight(mesh), "marching cubes mesh is not watertight");
+
+		//the sparse version yields the same surface
+		SparseBlockGrid3<float> sparse(grid, std::numeric_limits<float>::infinity());
+		TriMeshf sparseMesh = GridMesherf::marchingCubes(sparse);
+		MLIB_ASSERT_STR(sparseMesh.getIndices().size() == mesh.getIndices().size() && sparseMesh.getVertices().size() == mesh.getVertices().size(), "sparse marching cubes differs from the dense one");
+		MLIB_ASSERT_STR(isWatertight(sparseMesh), "sparse marching cubes mesh is not watertight");
+
+		//the vertices of a sphere's distance field lie on the sphere; triangles face outwards
+		Grid3f sphere(32, 32, 32);
+		const vec3f center(15.3f, 16.1f, 15.7f);
+		sphere.fill([&](size_t x, size_t y, size_t z) { return vec3f::dist(vec3f((float)x, (float)y, (float)z), center) - 10.0f; });
+		TriMeshf sphereMesh = GridMesherf::marchingCubes(sphere);
+		MLIB_ASSERT_STR(isWatertight(sphereMesh), "sphere is not watertight");
+		for (const auto& v : sphereMesh.getVertices()) {
+			MLIB_ASSERT_STR(std::abs(vec3f::dist(v.position, center) - 10.0f) < 0.05f, "vertex is not on the sphere");
+		}
+		MLIB_ASSERT_STR(std::abs(signedVolume(sphereMesh) - 4.0f / 3.0f * math::PIf * 1000.0f) < 0.02f * 4.0f / 3.0f * math::PIf * 1000.0f, "wrong volume or orientation");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test2()
+	{
+		//greedy meshing covers the same surface as one cube per voxel: same area and enclosed volume
+		BinaryGrid3 grid(12, 10, 9);
+		for (size_t z = 0; z < grid.getDimZ(); z++) {
+			for (size_t y = 0; y < grid.getDimY(); y++) {
+				for (size_t x = 0; x < grid.getDimX(); x++) {
+					if (math::randomUniform(0.0f, 1.0f) < 0.4f) grid.setVoxel(x, y, z);
+				}
+			}
+		}
+		size_t numFaces = 0;
+		for (size_t z = 0; z < grid.getDimZ(); z++) {
+			for (size_t y = 0; y < grid.getDimY(); y++) {
+				for (size_t x = 0; x < grid.getDimX(); x++) {
+					if (!grid.isVoxelSet(x, y, z)) continue;
+					const vec3i c((int)x, (int)y, (int)z);
+					for (int a = 0; a < 3; a++) {
+						for (int s = -1; s <= 1; s += 2) {
+							vec3i n = c;
+							n[a] += s;
+							if (n[a] < 0 || !grid.isValidCoordinate(vec3ul(n)) || !grid.isVoxelSet(n.x, n.y, n.z)) numFaces++;
+						}
+					}
+				}
+			}
+		}
+		TriMeshf mesh = GridMesherf::greedyMesh(grid);
+		float area = 0.0f;
+		for (const vec3ui& t : mesh.getIndices()) {
+			const auto& v = mesh.getVertices();
+			area += ((v[t.y].position - v[t.x].position) ^ (v[t.z].position - v[t.x].position)).length() * 0.5f;
+		}
+		MLIB_ASSERT_STR(math::floatEqual(area, (float)numFaces, 1e-2f), "greedy mesh has the wrong area");
+		MLIB_ASSERT_STR(math::floatEqual(signedVolume(mesh), (float)grid.getNumOccupiedEntries(), 1e-2f), "greedy mesh has the wrong volume or orientation");
+		MLIB_ASSERT_STR(mesh.getIndices().size() < 2 * numFaces, "greedy mesh merged no faces");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test3()
+	{
+		//parallel vertex normals against a serial scatter of the face normals, for every weighting and data layout
+		TriMeshf mesh = Shapesf::sphere(1.0f, vec3f::origin, 12, 16);
+		for (auto& v : mesh.getVertices()) v.position += vec3f(math::randomUniform(-0.05f, 0.05f), math::randomUniform(-0.05f, 0.05f), math::randomUniform(-0.05f, 0.05f));
+		std::vector<vec3f> positions;
+		for (const auto& v : mesh.getVertices()) positions.push_back(v.position);
+		const std::vector<vec3ui>& faces = mesh.getIndices();
+
+		const MeshNormalsf::VertexFaceAdjacency adjacency(positions.size(), faces.data(), faces.size());
+		const MeshNormalsf::WeightingType weightings[3] = { MeshNormalsf::WEIGHT_UNIFORM, MeshNormalsf::WEIGHT_AREA, MeshNormalsf::WEIGHT_ANGLE };
+		for (MeshNormalsf::WeightingType weighting : weightings) {
+			const std::vector<vec3f> expected = scatterNormals(positions, faces, weighting);
+
+			mesh.computeNormals(weighting);
+			for (size_t i = 0; i < positions.size(); i++) {
+				MLIB_ASSERT_STR(vec3f::dist(mesh.getVertices()[i].normal, expected[i]) < 1e-4f, "vertex normal differs from the serial scatter");
+			}
+			mesh.computeNormals(adjacency, weighting);
+			for (size_t i = 0; i < positions.size(); i++) {
+				MLIB_ASSERT_STR(vec3f::dist(mesh.getVertices()[i].normal, expected[i]) < 1e-4f, "vertex normal with a precomputed adjacency differs");
+			}
+
+			std::vector<float> px, py, pz;
+			for (const vec3f& p : positions) {
+				px.push_back(p.x);	py.push_back(p.y);	pz.push_back(p.z);
+			}
+			std::vector<float> nx(positions.size()), ny(positions.size()), nz(positions.size());
+			MeshNormalsf::computeSoA(positions.size(), px.data(), py.data(), pz.data(), nx.data(), ny.data(), nz.data(), faces.data(), faces.size(), weighting);
+			for (size_t i = 0; i < positions.size(); i++) {
+				MLIB_ASSERT_STR(vec3f::dist(vec3f(nx[i], ny[i], nz[i]), expected[i]) < 1e-4f, "structure-of-arrays vertex normal differs");
+			}
+		}
+
+		MeshDataf meshData = mesh.computeMeshData();
+		meshData.computeVertexNormals();
+		const std::vector<vec3f> uniform = scatterNormals(positions, faces, MeshNormalsf::WEIGHT_UNIFORM);
+		for (size_t i = 0; i < positions.size(); i++) {
+			MLIB_ASSERT_STR(vec3f::dist(meshData.m_Normals[i], uniform[i]) < 1e-4f, "MeshData vertex normal differs");
+		}
+
+		//angle weighting of polygons: the corner angles of planar convex faces add up to those of their fan triangulation
+		MeshDataf prism;
+		prism.m_Vertices = { vec3f(0.0f, 0.0f, 0.0f), vec3f(2.0f, 0.0f, 0.0f), vec3f(0.5f, 1.0f, 0.0f), vec3f(0.0f, 0.0f, 1.5f), vec3f(2.0f, 0.0f, 1.5f), vec3f(0.5f, 1.0f, 1.5f) };
+		const unsigned int prismFaces[5][4] = { { 0, 2, 1, 0 }, { 3, 4, 5, 0 }, { 0, 1, 4, 3 }, { 1, 2, 5, 4 }, { 2, 0, 3, 5 } };
+		for (int f = 0; f < 5; f++) {
+			prism.m_FaceIndicesVertices.push_back(std::vector<unsigned int>(prismFaces[f], prismFaces[f] + (f < 2 ? 3 : 4)));
+		}
+		MeshDataf triangulated = prism;
+		triangulated.makeTriMesh();
+		prism.computeVertexNormals(MeshNormalsf::WEIGHT_ANGLE);
+		triangulated.computeVertexNormals(MeshNormalsf::WEIGHT_ANGLE);
+		for (size_t i = 0; i < prism.m_Vertices.size(); i++) {
+			MLIB_ASSERT_STR(vec3f::dist(prism.m_Normals[i], triangulated.m_Normals[i]) < 1e-4f, "angle-weighted polygon normal differs");
+		}
+
+		//an adjacency of another mesh is rejected
+		bool thrown = false;
+		try {
+			Shapesf::box(1.0f).computeNormals(adjacency);
+		}
+		catch (const MLibException&) {
+			thrown = true;
+		}
+		MLIB_ASSERT_STR(thrown, "mismatching adjacency was accepted");
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test4()
+	{
+		//structure-of-arrays meshes: lossless conversion, and the geometric operations match the interleaved ones
+		TriMeshf mesh = Shapesf::cylinder(0.5f, 2.0f, 4, 12, vec4f(0.2f, 0.4f, 0.6f, 1.0f));
+		mesh.computeNormals();
+		TriMeshSoAf soa(mesh);
+		MLIB_ASSERT_STR(soa.hasNormals() == mesh.hasNormals() && soa.hasColors() == mesh.hasColors() && soa.hasTexCoords() == mesh.hasTexCoords(), "attribute flags were not converted");
+		MLIB_ASSERT_STR(soa.getNumVertices() == mesh.getVertices().size() && soa.getIndices() == mesh.getIndices(), "conversion to structure of arrays failed");
+		checkEqual(soa.toTriMesh(), mesh, 0.0f);
+
+		const mat4f transform = mat4f::translation(1.0f, -2.0f, 0.5f) * mat4f::rotationY(30.0f) * mat4f::scale(1.0f, 2.0f, 0.5f);
+		mesh.transform(transform);
+		soa.transform(transform);
+		checkEqual(soa.toTriMesh(), mesh, 1e-5f);
+		const BoundingBox3f bb = mesh.computeBoundingBox(), soaBB = soa.computeBoundingBox();
+		MLIB_ASSERT_STR(bb.getMin() == soaBB.getMin() && bb.getMax() == soaBB.getMax(), "bounding boxes differ");
+		mesh.computeNormals();
+		soa.computeNormals();
+		checkEqual(soa.toTriMesh(), mesh, 1e-5f);
+
+		BinaryDataStreamFile out("tmp.bin", true);
+		out << soa << mesh;
+		out.close();
+		BinaryDataStreamFile in("tmp.bin", false);
+		TriMeshSoAf re;
+		TriMeshf reMesh;
+		in >> re >> reMesh;
+		checkEqual(re.toTriMesh(), mesh, 1e-5f);
+		checkEqual(reMesh, mesh, 0.0f);
+
+		//accelerators built from either layout hit the same triangles, also with a transform applied during the build
+		const mat4f rotation = mat4f::rotationZ(30.0f);
+		TriMeshAcceleratorBVHf bvh(mesh), soaBVH, rotatedBVH, rotatedSoaBVH;
+		soaBVH.build(soa);
+		rotatedBVH.build(mesh, rotation);
+		rotatedSoaBVH.build(soa, rotation);
+		for (int i = 0; i < 100; i++) {
+			const vec3f origin(math::randomUniform(-4.0f, 4.0f), math::randomUniform(-4.0f, 4.0f), 10.0f);
+			const Rayf ray(origin, (bb.getCenter() - origin).getNormalized() + vec3f(math::randomUniform(-0.1f, 0.1f), math::randomUniform(-0.1f, 0.1f), 0.0f));
+			const TriMeshRayAcceleratorf::Intersection a = bvh.intersect(ray), b = soaBVH.intersect(ray);
+			MLIB_ASSERT_STR(a.valid() == b.valid() && (!a.valid() || math::floatEqual(a.t, b.t, 1e-4f)), "accelerator of the structure-of-arrays mesh differs");
+			const TriMeshRayAcceleratorf::Intersection c = rotatedBVH.intersect(ray), d = rotatedSoaBVH.intersect(ray);
+			MLIB_ASSERT_STR(c.valid() == d.valid() && (!c.valid() || (math::floatEqual(c.t, d.t, 1e-4f) && c.triangle->getIndex() == d.triangle->getIndex())), "transformed accelerator of the structure-of-arrays mesh differs");
+		}
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test5()
+	{
+		//batched transforms against Matrix4x4, with a partial last block, strided data and projective matrices
+		std::vector<vec3f> points(1000), normals(1000);
+		for (size_t i = 0; i < points.size(); i++) {
+			points[i] = vec3f(math::randomUniform(-1.0f, 1.0f), math::randomUniform(-1.0f, 1.0f), math::randomUniform(-1.0f, 1.0f));
+			normals[i] = vec3f(math::randomUniform(-1.0f, 1.0f), math::randomUniform(-1.0f, 1.0f), math::randomUniform(-1.0f, 1.0f)).getNormalized();
+		}
+		normals[7] = vec3f::origin;
+
+		const mat4f affine = mat4f::translation(0.5f, 1.0f, -2.0f) * mat4f::rotation(vec3f(1.0f, 2.0f, 3.0f).getNormalized(), 40.0f) * mat4f::scale(2.0f, 1.0f, 0.5f);
+		mat4f projective = affine;
+		projective(3, 2) = 0.2f;
+		projective(3, 3) = 3.0f;
+		for (const mat4f& m : { affine, projective }) {
+			std::vector<vec3f> p = points;
+			transformPoints(m, p);
+			for (size_t i = 0; i < p.size(); i++) {
+				MLIB_ASSERT_STR(vec3f::dist(p[i], m * points[i]) < 1e-5f, "batched point transform differs");
+			}
+		}
+		const mat4f normalMatrix = affine.getInverse().getTranspose();
+		std::vector<vec3f> n = normals;
+		transformNormals(affine, n);
+		for (size_t i = 0; i < n.size(); i++) {
+			if (i != 7) MLIB_ASSERT_STR(vec3f::dist(n[i], normalMatrix.transformNormalAffine(normals[i]).getNormalized()) < 1e-5f, "batched normal transform differs");
+		}
+		MLIB_ASSERT_STR(n[7] == vec3f::origin, "zero normal did not stay zero");
+
+		//interleaved vertices: TriMesh, and the same points as a MeshData and a PointCloud
+		std::vector<TriMeshf::Vertex> vertices(points.size());
+		for (size_t i = 0; i < points.size(); i++) {
+			vertices[i].position = points[i];
+			vertices[i].normal = normals[i];
+		}
+		std::vector<vec3ui> indices(1, vec3ui(0, 1, 2));
+		TriMeshf mesh(vertices, indices, false, true);
+		mesh.transform(affine);
+		PointCloudf pc;
+		pc.m_points = points;
+		pc.m_normals = normals;
+		pc.applyTransform(affine);
+		MeshDataf meshData;
+		meshData.m_Vertices = points;
+		meshData.m_Normals = normals;
+		meshData.applyTransform(affine);
+		for (size_t i = 0; i < points.size(); i++) {
+			const vec3f p = affine * points[i], np = i == 7 ? vec3f::origin : normalMatrix.transformNormalAffine(normals[i]).getNormalized();
+			MLIB_ASSERT_STR(vec3f::dist(mesh.getVertices()[i].position, p) < 1e-5f && vec3f::dist(mesh.getVertices()[i].normal, np) < 1e-5f, "TriMesh transform differs");
+			MLIB_ASSERT_STR(vec3f::dist(pc.m_points[i], p) < 1e-5f && vec3f::dist(pc.m_normals[i], np) < 1e-5f, "PointCloud transform differs");
+			MLIB_ASSERT_STR(vec3f::dist(meshData.m_Vertices[i], p) < 1e-5f && vec3f::dist(meshData.m_Normals[i], np) < 1e-5f, "MeshData transform differs");
+		}
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	void test6()
+	{
+		//TriMeshBuilder: referenced, transformed and moved-in pieces end up in their own ranges
+		const TriMeshf box = Shapesf::box(1.0f);
+		const TriMeshf cylinder = Shapesf::cylinder(0.5f, 2.0f, 2, 8);
+		const mat4f transform = mat4f::translation(3.0f, 0.0f, 0.0f) * mat4f::rotationZ(90.0f);
+		TriMeshBuilderf builder;
+		builder.append(box);
+		builder.append(cylinder, transform);
+		builder.append(Shapesf::sphere(1.0f, vec3f::origin, 4, 6), transform);
+		MLIB_ASSERT_STR(builder.getNumMeshes() == 3, "wrong number of pieces");
+		const TriMeshf sphere = Shapesf::sphere(1.0f, vec3f::origin, 4, 6);
+		const TriMeshf* pieces[3] = { &box, &cylinder, &sphere };
+
+		const TriMeshf result = builder.finalize();
+		MLIB_ASSERT_STR(builder.getNumMeshes() == 0, "builder was not cleared");
+		size_t vertexOffset = 0, triangleOffset = 0;
+		for (int i = 0; i < 3; i++) {
+			const mat4f m = i == 0 ? mat4f::identity() : transform;
+			for (size_t v = 0; v < pieces[i]->getVertices().size(); v++) {
+				MLIB_ASSERT_STR(vec3f::dist(result.getVertices()[vertexOffset + v].position, m * pieces[i]->getVertices()[v].position) < 1e-5f, "builder vertex is wrong");
+			}
+			for (size_t t = 0; t < pieces[i]->getIndices().size(); t++) {
+				MLIB_ASSERT_STR(result.getIndices()[triangleOffset + t] == pieces[i]->getIndices()[t] + vec3ui((UINT)vertexOffset), "builder triangle is wrong");
+			}
+			vertexOffset += pieces[i]->getVertices().size();
+			triangleOffset += pieces[i]->getIndices().size();
+		}
+		MLIB_ASSERT_STR(result.getVertices().size() == vertexOffset && result.getIndices().size() == triangleOffset, "builder has the wrong size");
+
+		std::vector<std::pair<const TriMeshf*, mat4f>> unified;
+		for (int i = 0; i < 3; i++) unified.push_back(std::make_pair(pieces[i], i == 0 ? mat4f::identity() : transform));
+		const TriMeshf unifiedMesh = meshutil::createUnifiedMesh(unified);
+		MLIB_ASSERT_STR(unifiedMesh.getIndices() == result.getIndices() && unifiedMesh.getVertices().size() == result.getVertices().size(), "unified mesh differs from the builder");
+		for (size_t v = 0; v < result.getVertices().size(); v++) {
+			MLIB_ASSERT_STR(unifiedMesh.getVertices()[v].position == result.getVertices()[v].position, "unified mesh differs from the builder");
+		}
+
+		//many MeshData merges: every face still references the right vertices
+		MeshDataf merged;
+		const MeshDataf boxData = box.computeMeshData();
+		for (int i = 0; i < 300; i++) {
+			MeshDataf piece = boxData;
+			piece.applyTransform(mat4f::translation((float)i, 0.0f, 0.0f));
+			if (i % 2) merged.merge(piece);
+			else merged.merge(std::move(piece));
+		}
+		MLIB_ASSERT_STR(merged.m_Vertices.size() == 300 * boxData.m_Vertices.size() && merged.m_FaceIndicesVertices.size() == 300 * boxData.m_FaceIndicesVertices.size(), "merged mesh has the wrong size");
+		for (size_t f = 0; f < merged.m_FaceIndicesVertices.size(); f++) {
+			const size_t piece = f / boxData.m_FaceIndicesVertices.size(), local = f % boxData.m_FaceIndicesVertices.size();
+			for (unsigned int c = 0; c < 3; c++) {
+				const vec3f expected = boxData.m_Vertices[boxData.m_FaceIndicesVertices[local][c]] + vec3f((float)piece, 0.0f, 0.0f);
+				MLIB_ASSERT_STR(merged.m_Vertices[merged.m_FaceIndicesVertices[f][c]] == expected, "merged face references the wrong vertex");
+			}
+		}
+
+		std::cout << __FUNCTION__ << " passed" << std::endl;
+	}
+
+	std::string getName() {
+		return "triMesh";
+	}
+
+private:
+	//! every directed edge occurs exactly once and its opposite exactly once
+	static bool isWatertight(const TriMeshf& mesh) {
+		std::map<std::pair<UINT, UINT>, int> edges;
+		for (const vec3ui& t : mesh.getIndices()) {
+			if (t.x == t.y || t.y == t.z || t.z == t.x) return false;
+			for (int e = 0; e < 3; e++) edges[std::make_pair(t[e], t[(e + 1) % 3])]++;
+		}
+		for (const auto& e : edges) {
+			if (e.second != 1) return false;
+			auto opposite = edges.find(std::make_pair(e.first.second, e.first.first));
+			if (opposite == edges.end() || opposite->second != 1) return false;
+		}
+		return true;
+	}
+
+	static void checkEqual(const TriMeshf& a, const TriMeshf& b, float eps) {
+		MLIB_ASSERT_STR(a.getVertices().size() == b.getVertices().size() && a.getIndices() == b.getIndices(), "meshes differ");
+		MLIB_ASSERT_STR(a.hasNormals() == b.hasNormals() && a.hasColors() == b.hasColors() && a.hasTexCoords() == b.hasTexCoords(), "attribute flags differ");
+		for (size_t i = 0; i < a.getVertices().size(); i++) {
+			const TriMeshf::Vertex& va = a.getVertices()[i];
+			const TriMeshf::Vertex& vb = b.getVertices()[i];
+			MLIB_ASSERT_STR(vec3f::dist(va.position, vb.position) <= eps, "positions differ");
+			MLIB_ASSERT_STR(!a.hasNormals() || vec3f::dist(va.normal, vb.normal) <= eps, "normals differ");
+			MLIB_ASSERT_STR(!a.hasColors() || va.color == vb.color, "colors differ");
+		}
+	}
+
+	static std::vector<vec3f> scatterNormals(const std::vector<vec3f>& positions, const std::vector<vec3ui>& faces, MeshNormalsf::WeightingType weighting) {
+		std::vector<vec3d> normals(positions.size(), vec3d::origin);
+		for (const vec3ui& f : faces) {
+			vec3d n = vec3d(positions[f.y] - positions[f.x]) ^ vec3d(positions[f.z] - positions[f.x]);
+			if (weighting != MeshNormalsf::WEIGHT_AREA) n.normalize();
+			for (int c = 0; c < 3; c++) {
+				double w = 1.0;
+				if (weighting == MeshNormalsf::WEIGHT_ANGLE) {
+					const vec3d e0 = vec3d(positions[f[(c + 1) % 3]] - positions[f[c]]).getNormalized();
+					const vec3d e1 = vec3d(positions[f[(c + 2) % 3]] - positions[f[c]]).getNormalized();
+					w = std::acos(math::clamp(e0 | e1, -1.0, 1.0));
+				}
+				normals[f[c]] += n * w;
+			}
+		}
+		std::vector<vec3f> result;
+		for (const vec3d& n : normals) result.push_back(vec3f(n.getNormalized()));
+		return result;
+	}
+
+	//! positive for closed meshes whose triangles face outwards
+	static float signedVolume(const TriMeshf& mesh) {
+		double volume = 0.0;
+		for (const vec3ui& t : mesh.getIndices()) {
+			const vec3f& a = mesh.getVertices()[t.x].position;
+			const vec3f& b = mesh.getVertices()[t.y].position;
+			const vec3f& c = mesh.getVertices()[t.z].position;
+			volume += (a | (b ^ c)) / 6.0;
+		}
+		return (float)volume;
+	}
+};